@@ -24,6 +24,7 @@
 #define TINYJAMBU_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 /**
  * \file TinyJAMBU.h
@@ -87,6 +88,82 @@ extern "C" {
  */
 #define TINYJAMBU_PBKDF2_SIZE TINYJAMBU_HASH_SIZE
 
+/**
+ * \brief Output block size for TinyJAMBU-KBKDF.  Key material is
+ * generated in blocks of this size.
+ */
+#define TINYJAMBU_KBKDF_SIZE TINYJAMBU_HMAC_SIZE
+
+/**
+ * \brief Size of the authentication tag for TinyJAMBU-MAC.
+ */
+#define TINYJAMBU_MAC_SIZE TINYJAMBU_TAG_SIZE
+
+/**
+ * \brief Size of the key for TinyJAMBU-PMAC.
+ */
+#define TINYJAMBU_PMAC_KEY_SIZE TINYJAMBU_128_KEY_SIZE
+
+/**
+ * \brief Size of the authentication tag for TinyJAMBU-PMAC.
+ */
+#define TINYJAMBU_PMAC_SIZE 16
+
+/**
+ * \brief Size of the key for TinyJAMBU-PRF64.
+ */
+#define TINYJAMBU_PRF64_KEY_SIZE TINYJAMBU_128_KEY_SIZE
+
+/**
+ * \brief Size of the output from TinyJAMBU-PRF64.
+ */
+#define TINYJAMBU_PRF64_SIZE 8
+
+/**
+ * \brief Size of the header for the TinyJAMBU-STREAM chunked format.
+ */
+#define TINYJAMBU_STREAM_HEADER_SIZE 20
+
+/**
+ * \brief Size of the nonce prefix for the TinyJAMBU-STREAM chunked format.
+ */
+#define TINYJAMBU_STREAM_PREFIX_SIZE 7
+
+/**
+ * \brief Version of the TinyJAMBU-STREAM chunked format.
+ */
+#define TINYJAMBU_STREAM_VERSION 1
+
+/**
+ * \brief Default plaintext chunk size for the TinyJAMBU-STREAM format.
+ */
+#define TINYJAMBU_STREAM_DEFAULT_CHUNK_SIZE 65536
+
+/**
+ * \brief Size of the header for the TinyJAMBU seekable container format.
+ */
+#define TINYJAMBU_SEEKABLE_HEADER_SIZE 32
+
+/**
+ * \brief Size of the file identifier for the TinyJAMBU seekable container.
+ */
+#define TINYJAMBU_SEEKABLE_FILE_ID_SIZE 8
+
+/**
+ * \brief Version of the TinyJAMBU seekable container format.
+ */
+#define TINYJAMBU_SEEKABLE_VERSION 1
+
+/**
+ * \brief Blocks of a seekable container are encrypted with the AEAD mode.
+ */
+#define TINYJAMBU_SEEKABLE_AEAD 0
+
+/**
+ * \brief Blocks of a seekable container are encrypted with the SIV mode.
+ */
+#define TINYJAMBU_SEEKABLE_SIV 1
+
 /**
  * \brief Encrypts and authenticates a packet with TinyJAMBU-128.
  *
@@ -140,11 +217,13 @@ int tinyjambu_128_aead_decrypt
      const unsigned char *k);
 
 /**
- * \brief Encrypts and authenticates a packet with TinyJAMBU-192.
+ * \brief Encrypts and authenticates a packet with TinyJAMBU-128,
+ * with the authentication tag stored separately from the ciphertext.
  *
- * \param c Buffer to receive the output.
- * \param clen On exit, set to the length of the output which includes
- * the ciphertext and the 8 byte authentication tag.
+ * \param c Buffer to receive the ciphertext, which is the same length
+ * as the plaintext.  May be the same as \a m to encrypt in-place.
+ * \param tag Buffer to receive the 8 byte authentication tag.  Must not
+ * overlap with \a c or \a m.
  * \param m Buffer that contains the plaintext message to encrypt.
  * \param mlen Length of the plaintext message in bytes.
  * \param ad Buffer that contains associated data to authenticate
@@ -152,47 +231,52 @@ int tinyjambu_128_aead_decrypt
  * \param adlen Length of the associated data in bytes.
  * \param npub Points to the public nonce for the packet which must
  * be 12 bytes in length.
- * \param k Points to the 24 bytes of the key to use to encrypt the packet.
+ * \param k Points to the 16 bytes of the key to use to encrypt the packet.
  *
- * \sa tinyjambu_192_aead_decrypt()
+ * The output is identical to tinyjambu_128_aead_encrypt() except
+ * that the tag is written to \a tag instead of after the ciphertext.
+ *
+ * \sa tinyjambu_128_aead_decrypt_detached()
  */
-void tinyjambu_192_aead_encrypt
-    (unsigned char *c, size_t *clen,
+void tinyjambu_128_aead_encrypt_detached
+    (unsigned char *c, unsigned char *tag,
      const unsigned char *m, size_t mlen,
      const unsigned char *ad, size_t adlen,
      const unsigned char *npub,
      const unsigned char *k);
 
 /**
- * \brief Decrypts and authenticates a packet with TinyJAMBU-192.
- *
- * \param m Buffer to receive the plaintext message on output.
- * \param mlen Receives the length of the plaintext message on output.
- * \param c Buffer that contains the ciphertext and authentication
- * tag to decrypt.
- * \param clen Length of the input data in bytes, which includes the
- * ciphertext and the 8 byte authentication tag.
+ * \brief Decrypts and authenticates a packet with TinyJAMBU-128,
+ * with the authentication tag stored separately from the ciphertext.
+ *
+ * \param m Buffer to receive the plaintext message, which is the same
+ * length as the ciphertext.  May be the same as \a c to decrypt in-place.
+ * \param c Buffer that contains the ciphertext to decrypt.
+ * \param clen Length of the ciphertext in bytes, not including the tag.
+ * \param tag Points to the 8 byte authentication tag.  Must not overlap
+ * with \a m.
  * \param ad Buffer that contains associated data to authenticate
  * along with the packet but which does not need to be encrypted.
  * \param adlen Length of the associated data in bytes.
  * \param npub Points to the public nonce for the packet which must
  * be 12 bytes in length.
- * \param k Points to the 24 bytes of the key to use to decrypt the packet.
+ * \param k Points to the 16 bytes of the key to use to decrypt the packet.
  *
- * \return 0 on success, -1 if the authentication tag was incorrect,
- * or some other negative number if there was an error in the parameters.
+ * \return 0 on success, or -1 if the authentication tag was incorrect.
+ * If the tag is incorrect, then \a m is set to all-zeroes.
  *
- * \sa tinyjambu_192_aead_encrypt()
+ * \sa tinyjambu_128_aead_encrypt_detached()
  */
-int tinyjambu_192_aead_decrypt
-    (unsigned char *m, size_t *mlen,
+int tinyjambu_128_aead_decrypt_detached
+    (unsigned char *m,
      const unsigned char *c, size_t clen,
+     const unsigned char *tag,
      const unsigned char *ad, size_t adlen,
      const unsigned char *npub,
      const unsigned char *k);
 
 /**
- * \brief Encrypts and authenticates a packet with TinyJAMBU-256.
+ * \brief Encrypts and authenticates a packet with TinyJAMBU-192.
  *
  * \param c Buffer to receive the output.
  * \param clen On exit, set to the length of the output which includes
@@ -204,11 +288,11 @@ int tinyjambu_192_aead_decrypt
  * \param adlen Length of the associated data in bytes.
  * \param npub Points to the public nonce for the packet which must
  * be 12 bytes in length.
- * \param k Points to the 32 bytes of the key to use to encrypt the packet.
+ * \param k Points to the 24 bytes of the key to use to encrypt the packet.
  *
- * \sa tinyjambu_256_aead_decrypt()
+ * \sa tinyjambu_192_aead_decrypt()
  */
-void tinyjambu_256_aead_encrypt
+void tinyjambu_192_aead_encrypt
     (unsigned char *c, size_t *clen,
      const unsigned char *m, size_t mlen,
      const unsigned char *ad, size_t adlen,
@@ -216,7 +300,7 @@ void tinyjambu_256_aead_encrypt
      const unsigned char *k);
 
 /**
- * \brief Decrypts and authenticates a packet with TinyJAMBU-256.
+ * \brief Decrypts and authenticates a packet with TinyJAMBU-192.
  *
  * \param m Buffer to receive the plaintext message on output.
  * \param mlen Receives the length of the plaintext message on output.
@@ -229,14 +313,14 @@ void tinyjambu_256_aead_encrypt
  * \param adlen Length of the associated data in bytes.
  * \param npub Points to the public nonce for the packet which must
  * be 12 bytes in length.
- * \param k Points to the 32 bytes of the key to use to decrypt the packet.
+ * \param k Points to the 24 bytes of the key to use to decrypt the packet.
  *
  * \return 0 on success, -1 if the authentication tag was incorrect,
  * or some other negative number if there was an error in the parameters.
  *
- * \sa tinyjambu_256_aead_encrypt()
+ * \sa tinyjambu_192_aead_encrypt()
  */
-int tinyjambu_256_aead_decrypt
+int tinyjambu_192_aead_decrypt
     (unsigned char *m, size_t *mlen,
      const unsigned char *c, size_t clen,
      const unsigned char *ad, size_t adlen,
@@ -244,11 +328,13 @@ int tinyjambu_256_aead_decrypt
      const unsigned char *k);
 
 /**
- * \brief Encrypts and authenticates a packet with TinyJAMBU-128 in SIV mode.
+ * \brief Encrypts and authenticates a packet with TinyJAMBU-192,
+ * with the authentication tag stored separately from the ciphertext.
  *
- * \param c Buffer to receive the output.
- * \param clen On exit, set to the length of the output which includes
- * the ciphertext and the 8 byte authentication tag.
+ * \param c Buffer to receive the ciphertext, which is the same length
+ * as the plaintext.  May be the same as \a m to encrypt in-place.
+ * \param tag Buffer to receive the 8 byte authentication tag.  Must not
+ * overlap with \a c or \a m.
  * \param m Buffer that contains the plaintext message to encrypt.
  * \param mlen Length of the plaintext message in bytes.
  * \param ad Buffer that contains associated data to authenticate
@@ -256,47 +342,52 @@ int tinyjambu_256_aead_decrypt
  * \param adlen Length of the associated data in bytes.
  * \param npub Points to the public nonce for the packet which must
  * be 12 bytes in length.
- * \param k Points to the 16 bytes of the key to use to encrypt the packet.
+ * \param k Points to the 24 bytes of the key to use to encrypt the packet.
  *
- * \sa tinyjambu_128_siv_decrypt()
+ * The output is identical to tinyjambu_192_aead_encrypt() except
+ * that the tag is written to \a tag instead of after the ciphertext.
+ *
+ * \sa tinyjambu_192_aead_decrypt_detached()
  */
-void tinyjambu_128_siv_encrypt
-    (unsigned char *c, size_t *clen,
+void tinyjambu_192_aead_encrypt_detached
+    (unsigned char *c, unsigned char *tag,
      const unsigned char *m, size_t mlen,
      const unsigned char *ad, size_t adlen,
      const unsigned char *npub,
      const unsigned char *k);
 
 /**
- * \brief Decrypts and authenticates a packet with TinyJAMBU-128 in SIV mode.
- *
- * \param m Buffer to receive the plaintext message on output.
- * \param mlen Receives the length of the plaintext message on output.
- * \param c Buffer that contains the ciphertext and authentication
- * tag to decrypt.
- * \param clen Length of the input data in bytes, which includes the
- * ciphertext and the 8 byte authentication tag.
+ * \brief Decrypts and authenticates a packet with TinyJAMBU-192,
+ * with the authentication tag stored separately from the ciphertext.
+ *
+ * \param m Buffer to receive the plaintext message, which is the same
+ * length as the ciphertext.  May be the same as \a c to decrypt in-place.
+ * \param c Buffer that contains the ciphertext to decrypt.
+ * \param clen Length of the ciphertext in bytes, not including the tag.
+ * \param tag Points to the 8 byte authentication tag.  Must not overlap
+ * with \a m.
  * \param ad Buffer that contains associated data to authenticate
  * along with the packet but which does not need to be encrypted.
  * \param adlen Length of the associated data in bytes.
  * \param npub Points to the public nonce for the packet which must
  * be 12 bytes in length.
- * \param k Points to the 16 bytes of the key to use to decrypt the packet.
+ * \param k Points to the 24 bytes of the key to use to decrypt the packet.
  *
- * \return 0 on success, -1 if the authentication tag was incorrect,
- * or some other negative number if there was an error in the parameters.
+ * \return 0 on success, or -1 if the authentication tag was incorrect.
+ * If the tag is incorrect, then \a m is set to all-zeroes.
  *
- * \sa tinyjambu_128_siv_encrypt()
+ * \sa tinyjambu_192_aead_encrypt_detached()
  */
-int tinyjambu_128_siv_decrypt
-    (unsigned char *m, size_t *mlen,
+int tinyjambu_192_aead_decrypt_detached
+    (unsigned char *m,
      const unsigned char *c, size_t clen,
+     const unsigned char *tag,
      const unsigned char *ad, size_t adlen,
      const unsigned char *npub,
      const unsigned char *k);
 
 /**
- * \brief Encrypts and authenticates a packet with TinyJAMBU-192 in SIV mode.
+ * \brief Encrypts and authenticates a packet with TinyJAMBU-256.
  *
  * \param c Buffer to receive the output.
  * \param clen On exit, set to the length of the output which includes
@@ -308,11 +399,11 @@ int tinyjambu_128_siv_decrypt
  * \param adlen Length of the associated data in bytes.
  * \param npub Points to the public nonce for the packet which must
  * be 12 bytes in length.
- * \param k Points to the 24 bytes of the key to use to encrypt the packet.
+ * \param k Points to the 32 bytes of the key to use to encrypt the packet.
  *
- * \sa tinyjambu_192_siv_decrypt()
+ * \sa tinyjambu_256_aead_decrypt()
  */
-void tinyjambu_192_siv_encrypt
+void tinyjambu_256_aead_encrypt
     (unsigned char *c, size_t *clen,
      const unsigned char *m, size_t mlen,
      const unsigned char *ad, size_t adlen,
@@ -320,7 +411,7 @@ void tinyjambu_192_siv_encrypt
      const unsigned char *k);
 
 /**
- * \brief Decrypts and authenticates a packet with TinyJAMBU-192 in SIV mode.
+ * \brief Decrypts and authenticates a packet with TinyJAMBU-256.
  *
  * \param m Buffer to receive the plaintext message on output.
  * \param mlen Receives the length of the plaintext message on output.
@@ -333,14 +424,14 @@ void tinyjambu_192_siv_encrypt
  * \param adlen Length of the associated data in bytes.
  * \param npub Points to the public nonce for the packet which must
  * be 12 bytes in length.
- * \param k Points to the 24 bytes of the key to use to decrypt the packet.
+ * \param k Points to the 32 bytes of the key to use to decrypt the packet.
  *
  * \return 0 on success, -1 if the authentication tag was incorrect,
  * or some other negative number if there was an error in the parameters.
  *
- * \sa tinyjambu_192_siv_encrypt()
+ * \sa tinyjambu_256_aead_encrypt()
  */
-int tinyjambu_192_siv_decrypt
+int tinyjambu_256_aead_decrypt
     (unsigned char *m, size_t *mlen,
      const unsigned char *c, size_t clen,
      const unsigned char *ad, size_t adlen,
@@ -348,11 +439,13 @@ int tinyjambu_192_siv_decrypt
      const unsigned char *k);
 
 /**
- * \brief Encrypts and authenticates a packet with TinyJAMBU-256 in SIV mode.
+ * \brief Encrypts and authenticates a packet with TinyJAMBU-256,
+ * with the authentication tag stored separately from the ciphertext.
  *
- * \param c Buffer to receive the output.
- * \param clen On exit, set to the length of the output which includes
- * the ciphertext and the 8 byte authentication tag.
+ * \param c Buffer to receive the ciphertext, which is the same length
+ * as the plaintext.  May be the same as \a m to encrypt in-place.
+ * \param tag Buffer to receive the 8 byte authentication tag.  Must not
+ * overlap with \a c or \a m.
  * \param m Buffer that contains the plaintext message to encrypt.
  * \param mlen Length of the plaintext message in bytes.
  * \param ad Buffer that contains associated data to authenticate
@@ -362,24 +455,28 @@ int tinyjambu_192_siv_decrypt
  * be 12 bytes in length.
  * \param k Points to the 32 bytes of the key to use to encrypt the packet.
  *
- * \sa tinyjambu_256_siv_decrypt()
+ * The output is identical to tinyjambu_256_aead_encrypt() except
+ * that the tag is written to \a tag instead of after the ciphertext.
+ *
+ * \sa tinyjambu_256_aead_decrypt_detached()
  */
-void tinyjambu_256_siv_encrypt
-    (unsigned char *c, size_t *clen,
+void tinyjambu_256_aead_encrypt_detached
+    (unsigned char *c, unsigned char *tag,
      const unsigned char *m, size_t mlen,
      const unsigned char *ad, size_t adlen,
      const unsigned char *npub,
      const unsigned char *k);
 
 /**
- * \brief Decrypts and authenticates a packet with TinyJAMBU-256 in SIV mode.
- *
- * \param m Buffer to receive the plaintext message on output.
- * \param mlen Receives the length of the plaintext message on output.
- * \param c Buffer that contains the ciphertext and authentication
- * tag to decrypt.
- * \param clen Length of the input data in bytes, which includes the
- * ciphertext and the 8 byte authentication tag.
+ * \brief Decrypts and authenticates a packet with TinyJAMBU-256,
+ * with the authentication tag stored separately from the ciphertext.
+ *
+ * \param m Buffer to receive the plaintext message, which is the same
+ * length as the ciphertext.  May be the same as \a c to decrypt in-place.
+ * \param c Buffer that contains the ciphertext to decrypt.
+ * \param clen Length of the ciphertext in bytes, not including the tag.
+ * \param tag Points to the 8 byte authentication tag.  Must not overlap
+ * with \a m.
  * \param ad Buffer that contains associated data to authenticate
  * along with the packet but which does not need to be encrypted.
  * \param adlen Length of the associated data in bytes.
@@ -387,136 +484,2387 @@ void tinyjambu_256_siv_encrypt
  * be 12 bytes in length.
  * \param k Points to the 32 bytes of the key to use to decrypt the packet.
  *
- * \return 0 on success, -1 if the authentication tag was incorrect,
- * or some other negative number if there was an error in the parameters.
+ * \return 0 on success, or -1 if the authentication tag was incorrect.
+ * If the tag is incorrect, then \a m is set to all-zeroes.
  *
- * \sa tinyjambu_256_siv_encrypt()
+ * \sa tinyjambu_256_aead_encrypt_detached()
  */
-int tinyjambu_256_siv_decrypt
-    (unsigned char *m, size_t *mlen,
+int tinyjambu_256_aead_decrypt_detached
+    (unsigned char *m,
      const unsigned char *c, size_t clen,
+     const unsigned char *tag,
      const unsigned char *ad, size_t adlen,
      const unsigned char *npub,
      const unsigned char *k);
 
 /**
- * \brief State information for TinyJAMBU-Hash.
+ * \brief Size of an exported incremental TinyJAMBU AEAD state.
+ */
+#define TINYJAMBU_AEAD_EXPORT_SIZE 36
+
+/**
+ * \brief Version of the format for exported incremental TinyJAMBU
+ * AEAD states.
+ */
+#define TINYJAMBU_AEAD_EXPORT_VERSION 1
+
+/**
+ * \brief State information for incremental TinyJAMBU AEAD encryption
+ * and decryption.
  */
 typedef struct
 {
-    /** Private state for the hash.  Must be treated as opaque */
-    unsigned long long s[56 / sizeof(unsigned long long)];
+    /** Private state for the operation.  Must be treated as opaque */
+    unsigned long long s[80 / sizeof(unsigned long long)];
 
-} tinyjambu_hash_state_t;
+} tinyjambu_aead_state_t;
 
 /**
- * \brief Hashes a block of input data with TinyJAMBU-Hash.
+ * \brief Starts an incremental TinyJAMBU-128 AEAD operation.
  *
- * \param out Buffer to receive the hash output which must be at least
- * TINYJAMBU_HASH_SIZE bytes in length.
- * \param in Points to the input data to be hashed.
- * \param inlen Length of the input data in bytes.
+ * \param state The incremental state to initialize.
+ * \param ad Buffer that contains associated data to authenticate
+ * along with the packet but which does not need to be encrypted.
+ * \param adlen Length of the associated data in bytes.
+ * \param npub Points to the public nonce for the packet which must
+ * be 12 bytes in length.
+ * \param k Points to the 16 bytes of the key.
  *
- * \sa tinyjambu_hash_init(), tinyjambu_hash_update(), tinyjambu_hash_finalize()
+ * The output is identical to tinyjambu_128_aead_encrypt_detached().
+ *
+ * \sa tinyjambu_aead_encrypt_update(), tinyjambu_aead_decrypt_update()
  */
-void tinyjambu_hash(unsigned char *out, const unsigned char *in, size_t inlen);
+void tinyjambu_128_aead_start
+    (tinyjambu_aead_state_t *state,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k);
 
 /**
- * \brief Initializes the state for an TinyJAMBU-Hash hashing operation.
+ * \brief Starts an incremental TinyJAMBU-192 AEAD operation.
  *
- * \param state Hash state to be initialized.
+ * \param state The incremental state to initialize.
+ * \param ad Buffer that contains associated data to authenticate
+ * along with the packet but which does not need to be encrypted.
+ * \param adlen Length of the associated data in bytes.
+ * \param npub Points to the public nonce for the packet which must
+ * be 12 bytes in length.
+ * \param k Points to the 24 bytes of the key.
  *
- * \sa tinyjambu_hash_update(), tinyjambu_hash_finalize(), tinyjambu_hash()
+ * The output is identical to tinyjambu_192_aead_encrypt_detached().
+ *
+ * \sa tinyjambu_aead_encrypt_update(), tinyjambu_aead_decrypt_update()
  */
-void tinyjambu_hash_init(tinyjambu_hash_state_t *state);
+void tinyjambu_192_aead_start
+    (tinyjambu_aead_state_t *state,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k);
 
 /**
- * \brief Re-initializes the state for an TinyJAMBU-Hash hashing operation.
+ * \brief Starts an incremental TinyJAMBU-256 AEAD operation.
  *
- * \param state Hash state to be re-initialized.
+ * \param state The incremental state to initialize.
+ * \param ad Buffer that contains associated data to authenticate
+ * along with the packet but which does not need to be encrypted.
+ * \param adlen Length of the associated data in bytes.
+ * \param npub Points to the public nonce for the packet which must
+ * be 12 bytes in length.
+ * \param k Points to the 32 bytes of the key.
  *
- * This function is equivalent to calling tinyjambu_hash_free() and then
- * tinyjambu_hash_init() to restart the hashing process.
+ * The output is identical to tinyjambu_256_aead_encrypt_detached().
  *
- * \sa tinyjambu_hash_init()
+ * \sa tinyjambu_aead_encrypt_update(), tinyjambu_aead_decrypt_update()
  */
-void tinyjambu_hash_reinit(tinyjambu_hash_state_t *state);
+void tinyjambu_256_aead_start
+    (tinyjambu_aead_state_t *state,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k);
 
 /**
- * \brief Frees the TinyJAMBU-Hash state and destroys any sensitive material.
+ * \brief Encrypts more plaintext in an incremental TinyJAMBU AEAD operation.
  *
- * \param state Hash state to be freed.
+ * \param state The incremental state.
+ * \param c Buffer to receive the ciphertext, which is the same length as
+ * the plaintext.  May be the same as \a m to encrypt in-place.
+ * \param m Buffer that contains the plaintext to encrypt.
+ * \param len Length of the plaintext in bytes, which can be anything.
  */
-void tinyjambu_hash_free(tinyjambu_hash_state_t *state);
+void tinyjambu_aead_encrypt_update
+    (tinyjambu_aead_state_t *state, unsigned char *c,
+     const unsigned char *m, size_t len);
 
 /**
- * \brief Updates an TinyJAMBU-Hash state with more input data.
- *
- * \param state Hash state to be updated.
- * \param in Points to the input data to be incorporated into the state.
- * \param inlen Length of the input data to be incorporated into the state.
+ * \brief Finishes an incremental TinyJAMBU AEAD encryption operation.
  *
- * \sa tinyjambu_hash_init(), tinyjambu_hash_finalize()
+ * \param state The incremental state, which is destroyed on exit.
+ * \param tag Buffer to receive the 8 byte authentication tag.
  */
-void tinyjambu_hash_update
-    (tinyjambu_hash_state_t *state, const unsigned char *in, size_t inlen);
+void tinyjambu_aead_encrypt_finish
+    (tinyjambu_aead_state_t *state, unsigned char *tag);
 
 /**
- * \brief Returns the final hash value from an TinyJAMBU-Hash hashing operation.
+ * \brief Decrypts more ciphertext in an incremental TinyJAMBU AEAD
+ * operation.
+ *
+ * \param state The incremental state.
+ * \param m Buffer to receive the plaintext, which is the same length as
+ * the ciphertext.  May be the same as \a c to decrypt in-place.
+ * \param c Buffer that contains the ciphertext to decrypt.
+ * \param len Length of the ciphertext in bytes, which can be anything.
+ *
+ * The plaintext is returned before the authentication tag has been
+ * checked.  The application must not act upon it until
+ * tinyjambu_aead_decrypt_finish() succeeds.
+ */
+void tinyjambu_aead_decrypt_update
+    (tinyjambu_aead_state_t *state, unsigned char *m,
+     const unsigned char *c, size_t len);
+
+/**
+ * \brief Finishes an incremental TinyJAMBU AEAD decryption operation and
+ * checks the authentication tag.
  *
- * \param state Hash state to be finalized.
- * \param out Points to the output buffer to receive the hash value.
- * Must be at least TINYJAMBU_HASH_SIZE bytes in length.
+ * \param state The incremental state, which is destroyed on exit.
+ * \param tag Points to the 8 byte authentication tag.
  *
- * \sa tinyjambu_hash_init(), tinyjambu_hash_update()
+ * \return 0 if the tag is correct, or -1 if it is not.
  */
-void tinyjambu_hash_finalize(tinyjambu_hash_state_t *state, unsigned char *out);
+int tinyjambu_aead_decrypt_finish
+    (tinyjambu_aead_state_t *state, const unsigned char *tag);
 
 /**
- * \brief State information for the TINYJAMBU-HMAC incremental mode.
+ * \brief Gets the number of message bytes that have been processed by
+ * an incremental TinyJAMBU AEAD operation.
+ *
+ * \param state The incremental state.
+ *
+ * \return The number of plaintext or ciphertext bytes so far.
  */
-typedef struct
-{
-    tinyjambu_hash_state_t hash;    /**< Internal TINYJAMBU-Hash state */
-
-} tinyjambu_hmac_state_t;
+uint64_t tinyjambu_aead_position(const tinyjambu_aead_state_t *state);
 
 /**
- * \brief Computes a HMAC value using TINYJAMBU-HASH.
- *
- * \param out Buffer to receive the output HMAC value; must be at least
- * TINYJAMBU_HMAC_SIZE bytes in length.
- * \param key Points to the key.
- * \param keylen Number of bytes in the key.
- * \param in Points to the data to authenticate.
- * \param inlen Number of bytes of data to authenticate.
+ * \brief Exports an incremental TinyJAMBU AEAD state so that the
+ * operation can be resumed later.
+ *
+ * \param state The incremental state.
+ * \param out Buffer to receive the TINYJAMBU_AEAD_EXPORT_SIZE bytes of
+ * the exported state.
+ *
+ * The exported state contains the permutation state, the message position,
+ * and any bytes of a partial word, but not the key.  It reveals enough to
+ * continue the operation with the key, so it should be stored as securely
+ * as the data that is being encrypted.
+ *
+ * \warning An exported encryption state must only be resumed with the
+ * same remaining plaintext that the original operation would have
+ * encrypted, such as when retrying an interrupted upload.  Importing it
+ * twice and continuing with different plaintext reuses the keystream
+ * from that point on, with the same consequences as reusing the nonce.
+ * If the remaining plaintext may change, discard the exported state and
+ * start again with a new nonce.
+ *
+ * \sa tinyjambu_aead_import()
  */
-void tinyjambu_hmac
-    (unsigned char *out,
-     const unsigned char *key, size_t keylen,
-     const unsigned char *in, size_t inlen);
+void tinyjambu_aead_export
+    (const tinyjambu_aead_state_t *state, unsigned char *out);
 
 /**
- * \brief Initializes an incremental HMAC state using TINYJAMBU-HASH.
+ * \brief Imports an incremental TinyJAMBU AEAD state to resume an
+ * operation.
  *
- * \param state Points to the state to be initialized.
- * \param key Points to the key.
- * \param keylen Number of bytes in the key.
+ * \param state The incremental state to initialize.
+ * \param in Points to the TINYJAMBU_AEAD_EXPORT_SIZE bytes of the
+ * exported state.
+ * \param k Points to the key that was used to start the operation.
+ * \param keylen Length of the key in bytes.
  *
- * The \a key needs to be preserved until the tinyjambu_hmac_finalize() call
- * to provide the outer HMAC hashing key.
+ * \return 0 on success, or -1 if the exported state is not valid, has an
+ * unsupported version, or was exported with a different key size.
  *
- * \sa tinyjambu_hmac_update(), tinyjambu_hmac_finalize()
+ * The operation continues from tinyjambu_aead_position(), so only the
+ * remaining bytes of the message need to be processed.  Resuming with
+ * the wrong key is not detected until the tag is checked.
+ *
+ * \warning When encrypting, see the warning for tinyjambu_aead_export()
+ * about resuming the same exported state with different plaintext.
  */
-void tinyjambu_hmac_init
-    (tinyjambu_hmac_state_t *state, const unsigned char *key, size_t keylen);
+int tinyjambu_aead_import
+    (tinyjambu_aead_state_t *state, const unsigned char *in,
+     const unsigned char *k, size_t keylen);
 
 /**
- * \brief Re-initializes an incremental HMAC state using TinyJAMBU-Hash.
+ * \brief Destroys an incremental TinyJAMBU AEAD state.
  *
- * \param state Points to the state to be re-initialized.
- * \param key Points to the key.
- * \param keylen Number of bytes in the key.
+ * \param state The incremental state to destroy.
+ */
+void tinyjambu_aead_free(tinyjambu_aead_state_t *state);
+
+/**
+ * \brief Encrypts and authenticates a packet with TinyJAMBU-128 in SIV mode.
+ *
+ * \param c Buffer to receive the output.
+ * \param clen On exit, set to the length of the output which includes
+ * the ciphertext and the 8 byte authentication tag.
+ * \param m Buffer that contains the plaintext message to encrypt.
+ * \param mlen Length of the plaintext message in bytes.
+ * \param ad Buffer that contains associated data to authenticate
+ * along with the packet but which does not need to be encrypted.
+ * \param adlen Length of the associated data in bytes.
+ * \param npub Points to the public nonce for the packet which must
+ * be 12 bytes in length.
+ * \param k Points to the 16 bytes of the key to use to encrypt the packet.
+ *
+ * \sa tinyjambu_128_siv_decrypt()
+ */
+void tinyjambu_128_siv_encrypt
+    (unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k);
+
+/**
+ * \brief Decrypts and authenticates a packet with TinyJAMBU-128 in SIV mode.
+ *
+ * \param m Buffer to receive the plaintext message on output.
+ * \param mlen Receives the length of the plaintext message on output.
+ * \param c Buffer that contains the ciphertext and authentication
+ * tag to decrypt.
+ * \param clen Length of the input data in bytes, which includes the
+ * ciphertext and the 8 byte authentication tag.
+ * \param ad Buffer that contains associated data to authenticate
+ * along with the packet but which does not need to be encrypted.
+ * \param adlen Length of the associated data in bytes.
+ * \param npub Points to the public nonce for the packet which must
+ * be 12 bytes in length.
+ * \param k Points to the 16 bytes of the key to use to decrypt the packet.
+ *
+ * \return 0 on success, -1 if the authentication tag was incorrect,
+ * or some other negative number if there was an error in the parameters.
+ *
+ * \sa tinyjambu_128_siv_encrypt()
+ */
+int tinyjambu_128_siv_decrypt
+    (unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k);
+
+/**
+ * \brief Encrypts and authenticates a packet with TinyJAMBU-128-SIV,
+ * with the authentication tag stored separately from the ciphertext.
+ *
+ * \param c Buffer to receive the ciphertext, which is the same length
+ * as the plaintext.  May be the same as \a m to encrypt in-place.
+ * \param tag Buffer to receive the 8 byte authentication tag.  Must not
+ * overlap with \a c or \a m.
+ * \param m Buffer that contains the plaintext message to encrypt.
+ * \param mlen Length of the plaintext message in bytes.
+ * \param ad Buffer that contains associated data to authenticate
+ * along with the packet but which does not need to be encrypted.
+ * \param adlen Length of the associated data in bytes.
+ * \param npub Points to the public nonce for the packet which must
+ * be 12 bytes in length.
+ * \param k Points to the 16 bytes of the key to use to encrypt the packet.
+ *
+ * The output is identical to tinyjambu_128_siv_encrypt() except
+ * that the tag is written to \a tag instead of after the ciphertext.
+ *
+ * \sa tinyjambu_128_siv_decrypt_detached()
+ */
+void tinyjambu_128_siv_encrypt_detached
+    (unsigned char *c, unsigned char *tag,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k);
+
+/**
+ * \brief Decrypts and authenticates a packet with TinyJAMBU-128-SIV,
+ * with the authentication tag stored separately from the ciphertext.
+ *
+ * \param m Buffer to receive the plaintext message, which is the same
+ * length as the ciphertext.  May be the same as \a c to decrypt in-place.
+ * \param c Buffer that contains the ciphertext to decrypt.
+ * \param clen Length of the ciphertext in bytes, not including the tag.
+ * \param tag Points to the 8 byte authentication tag.  Must not overlap
+ * with \a m.
+ * \param ad Buffer that contains associated data to authenticate
+ * along with the packet but which does not need to be encrypted.
+ * \param adlen Length of the associated data in bytes.
+ * \param npub Points to the public nonce for the packet which must
+ * be 12 bytes in length.
+ * \param k Points to the 16 bytes of the key to use to decrypt the packet.
+ *
+ * \return 0 on success, or -1 if the authentication tag was incorrect.
+ * If the tag is incorrect, then \a m is set to all-zeroes.
+ *
+ * The \a tag is read before decryption starts because it also forms
+ * part of the nonce for the decryption pass.
+ *
+ * \sa tinyjambu_128_siv_encrypt_detached()
+ */
+int tinyjambu_128_siv_decrypt_detached
+    (unsigned char *m,
+     const unsigned char *c, size_t clen,
+     const unsigned char *tag,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k);
+
+/**
+ * \brief Formats the TinyJAMBU-128-SIV nonce for a storage sector.
+ *
+ * \param npub Buffer to receive the 12 byte nonce.
+ * \param sector Number of the sector, or its address.
+ *
+ * The nonce consists of the 64-bit sector number in little-endian
+ * byte order followed by four zero bytes.  The low 32 bits of the
+ * sector number are carried into the nonce for the encryption pass of
+ * SIV mode, as described for tinyjambu_128_siv_encrypt().
+ */
+void tinyjambu_128_siv_sector_nonce(unsigned char *npub, uint64_t sector);
+
+/**
+ * \brief Encrypts a batch of consecutive storage sectors or pages with
+ * TinyJAMBU-128-SIV.
+ *
+ * \param c Buffer to receive the encrypted sectors, which is
+ * \a count * \a sector_size bytes in length.  May be the same as \a m
+ * to encrypt in-place.
+ * \param tags Buffer to receive the 8 byte authentication tag for each
+ * sector, which is \a count * 8 bytes in length.
+ * \param m Buffer that contains the plaintext sectors.
+ * \param sector_size Size of each sector in bytes, which must be a
+ * non-zero multiple of 4; typically between 512 and 4096.
+ * \param sector Number of the first sector.
+ * \param count Number of sectors to encrypt.
+ * \param k Points to the 16 bytes of the key.
+ * \param threads Maximum number of threads to use, or 1 to encrypt
+ * on the calling thread.
+ *
+ * \return 0 on success, or -1 if \a sector_size is invalid.
+ *
+ * Each sector is encrypted as a separate SIV packet with no associated
+ * data and the nonce from tinyjambu_128_siv_sector_nonce().  The output
+ * for each sector is identical to tinyjambu_128_siv_encrypt_detached()
+ * but groups of four sectors are processed together in separate lanes.
+ * The tags are kept apart from the ciphertext so that the encrypted
+ * sectors stay the same size and alignment as the plaintext.
+ *
+ * \sa tinyjambu_128_siv_decrypt_sectors()
+ */
+int tinyjambu_128_siv_encrypt_sectors
+    (unsigned char *c, unsigned char *tags,
+     const unsigned char *m, size_t sector_size,
+     uint64_t sector, size_t count,
+     const unsigned char *k, unsigned threads);
+
+/**
+ * \brief Decrypts a batch of consecutive storage sectors or pages with
+ * TinyJAMBU-128-SIV.
+ *
+ * \param m Buffer to receive the plaintext sectors, which is
+ * \a count * \a sector_size bytes in length.  May be the same as \a c
+ * to decrypt in-place.
+ * \param c Buffer that contains the encrypted sectors.
+ * \param tags Points to the 8 byte authentication tag for each sector.
+ * \param sector_size Size of each sector in bytes, which must be a
+ * non-zero multiple of 4; typically between 512 and 4096.
+ * \param sector Number of the first sector.
+ * \param count Number of sectors to decrypt.
+ * \param k Points to the 16 bytes of the key.
+ * \param threads Maximum number of threads to use, or 1 to decrypt
+ * on the calling thread.
+ *
+ * \return 0 on success, or -1 if \a sector_size is invalid or any
+ * of the sectors failed to authenticate.  Sectors that fail to
+ * authenticate are set to all-zeroes in \a m; the other sectors are
+ * still decrypted.
+ *
+ * \sa tinyjambu_128_siv_encrypt_sectors()
+ */
+int tinyjambu_128_siv_decrypt_sectors
+    (unsigned char *m, const unsigned char *c,
+     const unsigned char *tags, size_t sector_size,
+     uint64_t sector, size_t count,
+     const unsigned char *k, unsigned threads);
+
+/**
+ * \brief Encrypts and authenticates a packet with TinyJAMBU-192 in SIV mode.
+ *
+ * \param c Buffer to receive the output.
+ * \param clen On exit, set to the length of the output which includes
+ * the ciphertext and the 8 byte authentication tag.
+ * \param m Buffer that contains the plaintext message to encrypt.
+ * \param mlen Length of the plaintext message in bytes.
+ * \param ad Buffer that contains associated data to authenticate
+ * along with the packet but which does not need to be encrypted.
+ * \param adlen Length of the associated data in bytes.
+ * \param npub Points to the public nonce for the packet which must
+ * be 12 bytes in length.
+ * \param k Points to the 24 bytes of the key to use to encrypt the packet.
+ *
+ * \sa tinyjambu_192_siv_decrypt()
+ */
+void tinyjambu_192_siv_encrypt
+    (unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k);
+
+/**
+ * \brief Decrypts and authenticates a packet with TinyJAMBU-192 in SIV mode.
+ *
+ * \param m Buffer to receive the plaintext message on output.
+ * \param mlen Receives the length of the plaintext message on output.
+ * \param c Buffer that contains the ciphertext and authentication
+ * tag to decrypt.
+ * \param clen Length of the input data in bytes, which includes the
+ * ciphertext and the 8 byte authentication tag.
+ * \param ad Buffer that contains associated data to authenticate
+ * along with the packet but which does not need to be encrypted.
+ * \param adlen Length of the associated data in bytes.
+ * \param npub Points to the public nonce for the packet which must
+ * be 12 bytes in length.
+ * \param k Points to the 24 bytes of the key to use to decrypt the packet.
+ *
+ * \return 0 on success, -1 if the authentication tag was incorrect,
+ * or some other negative number if there was an error in the parameters.
+ *
+ * \sa tinyjambu_192_siv_encrypt()
+ */
+int tinyjambu_192_siv_decrypt
+    (unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k);
+
+/**
+ * \brief Encrypts and authenticates a packet with TinyJAMBU-192-SIV,
+ * with the authentication tag stored separately from the ciphertext.
+ *
+ * \param c Buffer to receive the ciphertext, which is the same length
+ * as the plaintext.  May be the same as \a m to encrypt in-place.
+ * \param tag Buffer to receive the 8 byte authentication tag.  Must not
+ * overlap with \a c or \a m.
+ * \param m Buffer that contains the plaintext message to encrypt.
+ * \param mlen Length of the plaintext message in bytes.
+ * \param ad Buffer that contains associated data to authenticate
+ * along with the packet but which does not need to be encrypted.
+ * \param adlen Length of the associated data in bytes.
+ * \param npub Points to the public nonce for the packet which must
+ * be 12 bytes in length.
+ * \param k Points to the 24 bytes of the key to use to encrypt the packet.
+ *
+ * The output is identical to tinyjambu_192_siv_encrypt() except
+ * that the tag is written to \a tag instead of after the ciphertext.
+ *
+ * \sa tinyjambu_192_siv_decrypt_detached()
+ */
+void tinyjambu_192_siv_encrypt_detached
+    (unsigned char *c, unsigned char *tag,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k);
+
+/**
+ * \brief Decrypts and authenticates a packet with TinyJAMBU-192-SIV,
+ * with the authentication tag stored separately from the ciphertext.
+ *
+ * \param m Buffer to receive the plaintext message, which is the same
+ * length as the ciphertext.  May be the same as \a c to decrypt in-place.
+ * \param c Buffer that contains the ciphertext to decrypt.
+ * \param clen Length of the ciphertext in bytes, not including the tag.
+ * \param tag Points to the 8 byte authentication tag.  Must not overlap
+ * with \a m.
+ * \param ad Buffer that contains associated data to authenticate
+ * along with the packet but which does not need to be encrypted.
+ * \param adlen Length of the associated data in bytes.
+ * \param npub Points to the public nonce for the packet which must
+ * be 12 bytes in length.
+ * \param k Points to the 24 bytes of the key to use to decrypt the packet.
+ *
+ * \return 0 on success, or -1 if the authentication tag was incorrect.
+ * If the tag is incorrect, then \a m is set to all-zeroes.
+ *
+ * The \a tag is read before decryption starts because it also forms
+ * part of the nonce for the decryption pass.
+ *
+ * \sa tinyjambu_192_siv_encrypt_detached()
+ */
+int tinyjambu_192_siv_decrypt_detached
+    (unsigned char *m,
+     const unsigned char *c, size_t clen,
+     const unsigned char *tag,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k);
+
+/**
+ * \brief Encrypts and authenticates a packet with TinyJAMBU-256 in SIV mode.
+ *
+ * \param c Buffer to receive the output.
+ * \param clen On exit, set to the length of the output which includes
+ * the ciphertext and the 8 byte authentication tag.
+ * \param m Buffer that contains the plaintext message to encrypt.
+ * \param mlen Length of the plaintext message in bytes.
+ * \param ad Buffer that contains associated data to authenticate
+ * along with the packet but which does not need to be encrypted.
+ * \param adlen Length of the associated data in bytes.
+ * \param npub Points to the public nonce for the packet which must
+ * be 12 bytes in length.
+ * \param k Points to the 32 bytes of the key to use to encrypt the packet.
+ *
+ * \sa tinyjambu_256_siv_decrypt()
+ */
+void tinyjambu_256_siv_encrypt
+    (unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k);
+
+/**
+ * \brief Decrypts and authenticates a packet with TinyJAMBU-256 in SIV mode.
+ *
+ * \param m Buffer to receive the plaintext message on output.
+ * \param mlen Receives the length of the plaintext message on output.
+ * \param c Buffer that contains the ciphertext and authentication
+ * tag to decrypt.
+ * \param clen Length of the input data in bytes, which includes the
+ * ciphertext and the 8 byte authentication tag.
+ * \param ad Buffer that contains associated data to authenticate
+ * along with the packet but which does not need to be encrypted.
+ * \param adlen Length of the associated data in bytes.
+ * \param npub Points to the public nonce for the packet which must
+ * be 12 bytes in length.
+ * \param k Points to the 32 bytes of the key to use to decrypt the packet.
+ *
+ * \return 0 on success, -1 if the authentication tag was incorrect,
+ * or some other negative number if there was an error in the parameters.
+ *
+ * \sa tinyjambu_256_siv_encrypt()
+ */
+int tinyjambu_256_siv_decrypt
+    (unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k);
+
+/**
+ * \brief Encrypts and authenticates a packet with TinyJAMBU-256-SIV,
+ * with the authentication tag stored separately from the ciphertext.
+ *
+ * \param c Buffer to receive the ciphertext, which is the same length
+ * as the plaintext.  May be the same as \a m to encrypt in-place.
+ * \param tag Buffer to receive the 8 byte authentication tag.  Must not
+ * overlap with \a c or \a m.
+ * \param m Buffer that contains the plaintext message to encrypt.
+ * \param mlen Length of the plaintext message in bytes.
+ * \param ad Buffer that contains associated data to authenticate
+ * along with the packet but which does not need to be encrypted.
+ * \param adlen Length of the associated data in bytes.
+ * \param npub Points to the public nonce for the packet which must
+ * be 12 bytes in length.
+ * \param k Points to the 32 bytes of the key to use to encrypt the packet.
+ *
+ * The output is identical to tinyjambu_256_siv_encrypt() except
+ * that the tag is written to \a tag instead of after the ciphertext.
+ *
+ * \sa tinyjambu_256_siv_decrypt_detached()
+ */
+void tinyjambu_256_siv_encrypt_detached
+    (unsigned char *c, unsigned char *tag,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k);
+
+/**
+ * \brief Decrypts and authenticates a packet with TinyJAMBU-256-SIV,
+ * with the authentication tag stored separately from the ciphertext.
+ *
+ * \param m Buffer to receive the plaintext message, which is the same
+ * length as the ciphertext.  May be the same as \a c to decrypt in-place.
+ * \param c Buffer that contains the ciphertext to decrypt.
+ * \param clen Length of the ciphertext in bytes, not including the tag.
+ * \param tag Points to the 8 byte authentication tag.  Must not overlap
+ * with \a m.
+ * \param ad Buffer that contains associated data to authenticate
+ * along with the packet but which does not need to be encrypted.
+ * \param adlen Length of the associated data in bytes.
+ * \param npub Points to the public nonce for the packet which must
+ * be 12 bytes in length.
+ * \param k Points to the 32 bytes of the key to use to decrypt the packet.
+ *
+ * \return 0 on success, or -1 if the authentication tag was incorrect.
+ * If the tag is incorrect, then \a m is set to all-zeroes.
+ *
+ * The \a tag is read before decryption starts because it also forms
+ * part of the nonce for the decryption pass.
+ *
+ * \sa tinyjambu_256_siv_encrypt_detached()
+ */
+int tinyjambu_256_siv_decrypt_detached
+    (unsigned char *m,
+     const unsigned char *c, size_t clen,
+     const unsigned char *tag,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k);
+
+/**
+ * \brief Role of the party that started a TinyJAMBU session.
+ */
+#define TINYJAMBU_SESSION_INITIATOR 1
+
+/**
+ * \brief Role of the party that accepted a TinyJAMBU session.
+ */
+#define TINYJAMBU_SESSION_RESPONDER 0
+
+/**
+ * \brief State for a TinyJAMBU duplex session.
+ *
+ * A session carries the TinyJAMBU state over from one message to the
+ * next, so that only the first message pays for the key and nonce setup.
+ */
+typedef struct
+{
+    /** Private state for the session.  Must be treated as opaque */
+    unsigned long long s[112 / sizeof(unsigned long long)];
+
+} tinyjambu_session_t;
+
+/**
+ * \brief Starts a TinyJAMBU duplex session with a 128-bit key.
+ *
+ * \param session The session state to initialize.
+ * \param k Points to the 16 bytes of the key.
+ * \param npub Points to the 12 bytes of the nonce, which must be unique
+ * for every session that uses the same key.
+ * \param role TINYJAMBU_SESSION_INITIATOR or TINYJAMBU_SESSION_RESPONDER.
+ *
+ * The two parties must use the same key and nonce but opposite roles.
+ *
+ * \sa tinyjambu_session_encrypt(), tinyjambu_session_decrypt()
+ */
+void tinyjambu_128_session_init
+    (tinyjambu_session_t *session, const unsigned char *k,
+     const unsigned char *npub, int role);
+
+/**
+ * \brief Starts a TinyJAMBU duplex session with a 192-bit key.
+ *
+ * \param session The session state to initialize.
+ * \param k Points to the 24 bytes of the key.
+ * \param npub Points to the 12 bytes of the nonce, which must be unique
+ * for every session that uses the same key.
+ * \param role TINYJAMBU_SESSION_INITIATOR or TINYJAMBU_SESSION_RESPONDER.
+ *
+ * The two parties must use the same key and nonce but opposite roles.
+ *
+ * \sa tinyjambu_session_encrypt(), tinyjambu_session_decrypt()
+ */
+void tinyjambu_192_session_init
+    (tinyjambu_session_t *session, const unsigned char *k,
+     const unsigned char *npub, int role);
+
+/**
+ * \brief Starts a TinyJAMBU duplex session with a 256-bit key.
+ *
+ * \param session The session state to initialize.
+ * \param k Points to the 32 bytes of the key.
+ * \param npub Points to the 12 bytes of the nonce, which must be unique
+ * for every session that uses the same key.
+ * \param role TINYJAMBU_SESSION_INITIATOR or TINYJAMBU_SESSION_RESPONDER.
+ *
+ * The two parties must use the same key and nonce but opposite roles.
+ *
+ * \sa tinyjambu_session_encrypt(), tinyjambu_session_decrypt()
+ */
+void tinyjambu_256_session_init
+    (tinyjambu_session_t *session, const unsigned char *k,
+     const unsigned char *npub, int role);
+
+/**
+ * \brief Encrypts and authenticates the next message to send in a
+ * TinyJAMBU duplex session.
+ *
+ * \param session The session state.
+ * \param c Buffer to receive the output.  May be the same as \a m to
+ * encrypt in-place.
+ * \param clen On exit, set to the length of the output which includes
+ * the ciphertext and the 8 byte authentication tag.
+ * \param m Buffer that contains the plaintext message to encrypt.
+ * \param mlen Length of the plaintext message in bytes.
+ * \param ad Buffer that contains associated data to authenticate
+ * along with the message but which does not need to be encrypted.
+ * \param adlen Length of the associated data in bytes.
+ *
+ * The tag authenticates this message and every message that was sent
+ * before it in the same direction.  Messages must be decrypted by the
+ * other party in the order that they were encrypted.
+ */
+void tinyjambu_session_encrypt
+    (tinyjambu_session_t *session, unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen);
+
+/**
+ * \brief Decrypts and authenticates the next message to be received in
+ * a TinyJAMBU duplex session.
+ *
+ * \param session The session state.
+ * \param m Buffer to receive the plaintext message on output.  May be the
+ * same as \a c to decrypt in-place.
+ * \param mlen Receives the length of the plaintext message on output.
+ * \param c Buffer that contains the ciphertext and authentication
+ * tag to decrypt.
+ * \param clen Length of the input data in bytes, which includes the
+ * ciphertext and the 8 byte authentication tag.
+ * \param ad Buffer that contains associated data to authenticate
+ * along with the message but which does not need to be encrypted.
+ * \param adlen Length of the associated data in bytes.
+ *
+ * \return 0 on success, or -1 if the authentication tag was incorrect.
+ * If the tag is incorrect, then \a m is set to all-zeroes and the session
+ * state is left unchanged, so that forged messages can be discarded
+ * without breaking the session.
+ */
+int tinyjambu_session_decrypt
+    (tinyjambu_session_t *session, unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen,
+     const unsigned char *ad, size_t adlen);
+
+/**
+ * \brief Ends a TinyJAMBU duplex session and destroys its state.
+ *
+ * \param session The session state to destroy.
+ */
+void tinyjambu_session_free(tinyjambu_session_t *session);
+
+/**
+ * \brief Gets the size of a TinyJAMBU-STREAM ciphertext.
+ *
+ * \param mlen Length of the plaintext in bytes.
+ * \param chunk_size Size of the plaintext in each chunk.
+ *
+ * \return The size of the header, the encrypted chunks, and their tags.
+ */
+size_t tinyjambu_stream_encrypted_size(size_t mlen, size_t chunk_size);
+
+/**
+ * \brief Encrypts a message with the TinyJAMBU-STREAM chunked format.
+ *
+ * \param c Buffer to receive the output, which must be at least
+ * tinyjambu_stream_encrypted_size() bytes in length.
+ * \param clen On exit, set to the length of the output.
+ * \param m Buffer that contains the plaintext message to encrypt.
+ * \param mlen Length of the plaintext message in bytes.
+ * \param prefix Points to the TINYJAMBU_STREAM_PREFIX_SIZE bytes of the
+ * nonce prefix, which must be unique for each message with the same key.
+ * \param k Points to the bytes of the key.
+ * \param keylen Length of the key, which selects TinyJAMBU-128, 192, or 256.
+ * \param chunk_size Size of the plaintext in each chunk.
+ * \param threads Maximum number of threads to use, including the
+ * calling thread.
+ *
+ * \return 0 on success, or -1 if the key length or chunk size is invalid,
+ * or the message has more than 2^32 chunks.
+ *
+ * The output starts with a TINYJAMBU_STREAM_HEADER_SIZE byte header:
+ * the magic bytes "TJST", the format version, the key length, the 32-bit
+ * little-endian chunk size, the nonce prefix, and three zero bytes.
+ *
+ * The message is then split into chunks of \a chunk_size bytes, with the
+ * final chunk holding between 0 and \a chunk_size bytes.  Each chunk is
+ * encrypted as an independent TinyJAMBU AEAD message with the header as
+ * associated data and the nonce set to the prefix, the 32-bit
+ * little-endian chunk index, and 1 for the final chunk or 0 otherwise.
+ * This prevents chunks from being reordered, truncated, or moved to
+ * another message.
+ *
+ * Encryption can be performed in-place with \a c equal to \a m.
+ * If threads are not supported on the platform, then \a threads is ignored.
+ *
+ * \sa tinyjambu_stream_decrypt()
+ */
+int tinyjambu_stream_encrypt
+    (unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *prefix,
+     const unsigned char *k, size_t keylen,
+     size_t chunk_size, unsigned threads);
+
+/**
+ * \brief Decrypts a message with the TinyJAMBU-STREAM chunked format.
+ *
+ * \param m Buffer to receive the plaintext message on output, which must
+ * be at least \a clen - TINYJAMBU_STREAM_HEADER_SIZE - TINYJAMBU_TAG_SIZE
+ * bytes in length.
+ * \param mlen On exit, set to the length of the plaintext.
+ * \param c Buffer that contains the header and the encrypted chunks.
+ * \param clen Length of the input data in bytes.
+ * \param k Points to the bytes of the key.
+ * \param keylen Length of the key in bytes.
+ * \param threads Maximum number of threads to use, including the
+ * calling thread.
+ *
+ * \return 0 on success, or -1 if the header is invalid or any chunk
+ * failed to authenticate.  The plaintext is set to all zeroes on failure.
+ *
+ * Decryption can be performed in-place with \a m equal to \a c,
+ * but only the calling thread will be used in that case.
+ *
+ * \sa tinyjambu_stream_encrypt(), tinyjambu_stream_decrypt_init()
+ */
+int tinyjambu_stream_decrypt
+    (unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen,
+     const unsigned char *k, size_t keylen,
+     unsigned threads);
+
+/**
+ * \brief State information for incremental TinyJAMBU-STREAM decryption.
+ */
+typedef struct
+{
+    /** Private state for the decryptor.  Must be treated as opaque */
+    unsigned long long s[96 / sizeof(unsigned long long)];
+
+} tinyjambu_stream_decryptor_t;
+
+/**
+ * \brief Initializes a TinyJAMBU-STREAM decryptor from the header.
+ *
+ * \param dec The decryptor to initialize.
+ * \param header Points to the TINYJAMBU_STREAM_HEADER_SIZE bytes of the
+ * header at the start of the ciphertext.
+ * \param k Points to the bytes of the key.
+ * \param keylen Length of the key in bytes.
+ *
+ * \return 0 on success, or -1 if the header is invalid or does not
+ * match the key length.
+ *
+ * The chunks can then be decrypted one at a time, and each chunk's
+ * plaintext can be released as soon as it has been verified.
+ *
+ * \sa tinyjambu_stream_decrypt_chunk(), tinyjambu_stream_decrypt_finish()
+ */
+int tinyjambu_stream_decrypt_init
+    (tinyjambu_stream_decryptor_t *dec, const unsigned char *header,
+     const unsigned char *k, size_t keylen);
+
+/**
+ * \brief Gets the size of a full encrypted chunk for a TinyJAMBU-STREAM
+ * decryptor, including the tag.
+ *
+ * \param dec The decryptor.
+ *
+ * \return The size of each chunk except the last.
+ */
+size_t tinyjambu_stream_decrypt_chunk_size
+    (const tinyjambu_stream_decryptor_t *dec);
+
+/**
+ * \brief Decrypts and verifies the next chunk of a TinyJAMBU-STREAM
+ * message.
+ *
+ * \param dec The decryptor.
+ * \param m Buffer to receive the plaintext of the chunk.
+ * \param mlen On exit, set to the length of the plaintext in the chunk.
+ * \param c Points to the encrypted chunk, including its tag.
+ * \param clen Length of the encrypted chunk.
+ * \param last Non-zero if this is the final chunk of the message.
+ *
+ * \return 0 on success, or -1 if the chunk failed to authenticate or has
+ * the wrong length.  The plaintext of the chunk is set to all zeroes on
+ * failure, and all further chunks will also fail.
+ */
+int tinyjambu_stream_decrypt_chunk
+    (tinyjambu_stream_decryptor_t *dec, unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen, int last);
+
+/**
+ * \brief Checks that a TinyJAMBU-STREAM message was complete.
+ *
+ * \param dec The decryptor.
+ *
+ * \return 0 if the final chunk was decrypted successfully, or -1 if the
+ * message was truncated or a chunk failed to authenticate.
+ */
+int tinyjambu_stream_decrypt_finish(const tinyjambu_stream_decryptor_t *dec);
+
+/**
+ * \brief Frees a TinyJAMBU-STREAM decryptor.
+ *
+ * \param dec The decryptor to free.
+ */
+void tinyjambu_stream_decrypt_free(tinyjambu_stream_decryptor_t *dec);
+
+/**
+ * \brief Gets the total size of a TinyJAMBU seekable container.
+ *
+ * \param length Length of the plaintext in bytes.
+ * \param block_size Size of the plaintext in each block.
+ *
+ * \return The size of the header and all of the block records.
+ */
+uint64_t tinyjambu_seekable_size(uint64_t length, size_t block_size);
+
+/**
+ * \brief Formats the header for a TinyJAMBU seekable container.
+ *
+ * \param header Buffer to receive the TINYJAMBU_SEEKABLE_HEADER_SIZE bytes
+ * of the header.
+ * \param mode TINYJAMBU_SEEKABLE_AEAD or TINYJAMBU_SEEKABLE_SIV.
+ * \param keylen Length of the key, which selects TinyJAMBU-128, 192, or 256.
+ * \param block_size Size of the plaintext in each block.
+ * \param length Total length of the plaintext in bytes.
+ * \param file_id Points to the TINYJAMBU_SEEKABLE_FILE_ID_SIZE bytes of
+ * the file identifier, which must be unique for each container that is
+ * encrypted with the same key.
+ *
+ * \return 0 on success, or -1 if a parameter is invalid or the container
+ * would have more than 2^32 blocks.
+ *
+ * The header consists of the magic bytes "TJSK", the format version,
+ * the key length, the mode, a zero byte, the 32-bit block size, the
+ * 64-bit plaintext length, the file identifier, and four zero bytes.
+ * All integers are little-endian.
+ *
+ * The header is followed by one record for each block, consisting of the
+ * encrypted block and its tag.  Every block except the last is full, so
+ * the record for block i starts at offset header + i * (block_size + 8).
+ * Each block is encrypted with the header as associated data and a nonce
+ * made up of the 32-bit block index followed by the file identifier.
+ * With SIV mode, the block index takes the place of the memory address
+ * in the nonce and individual blocks can be safely rewritten with
+ * tinyjambu_seekable_rewrite_block().  With AEAD mode, each block must
+ * be sealed only once for a given file identifier, because sealing
+ * different data for the same block would reuse its nonce.
+ *
+ * \sa tinyjambu_seekable_seal_block()
+ */
+int tinyjambu_seekable_init_header
+    (unsigned char *header, int mode, size_t keylen, size_t block_size,
+     uint64_t length, const unsigned char *file_id);
+
+/**
+ * \brief Encrypts a single block of a TinyJAMBU seekable container.
+ *
+ * \param record Buffer to receive the encrypted block and its tag.
+ * \param reclen On exit, set to the length of the record.
+ * \param header Points to the header of the container.
+ * \param index Index of the block to encrypt.
+ * \param data Points to the plaintext for the block, which must be
+ * block_size bytes in length except for the last block.
+ * \param k Points to the bytes of the key.
+ *
+ * \return 0 on success, or -1 if the header or block index is invalid.
+ *
+ * The record can be written to the container at the offset given by
+ * tinyjambu_seekable_block_offset().
+ *
+ * This function is for writing a new container.  In AEAD mode, it must
+ * not be called again for a block that has already been written under
+ * the same header, as that would reuse the block's nonce.  Use
+ * tinyjambu_seekable_rewrite_block() to update a block in place.
+ */
+int tinyjambu_seekable_seal_block
+    (unsigned char *record, size_t *reclen, const unsigned char *header,
+     uint64_t index, const unsigned char *data, const unsigned char *k);
+
+/**
+ * \brief Re-encrypts a single block of an existing TinyJAMBU seekable
+ * container with new data.
+ *
+ * \param record Buffer to receive the encrypted block and its tag.
+ * \param reclen On exit, set to the length of the record.
+ * \param header Points to the header of the container.
+ * \param index Index of the block to encrypt.
+ * \param data Points to the new plaintext for the block, which must be
+ * block_size bytes in length except for the last block.
+ * \param k Points to the bytes of the key.
+ *
+ * \return 0 on success, or -1 if the header or block index is invalid
+ * or the container uses AEAD mode.
+ *
+ * Rewrites are only permitted in SIV mode, where encrypting different
+ * data under the same nonce does not reveal anything beyond whether the
+ * block has changed.  AEAD containers must be rewritten in full with a
+ * new file identifier instead.
+ */
+int tinyjambu_seekable_rewrite_block
+    (unsigned char *record, size_t *reclen, const unsigned char *header,
+     uint64_t index, const unsigned char *data, const unsigned char *k);
+
+/**
+ * \brief Gets the offset of a block record in a TinyJAMBU seekable
+ * container.
+ *
+ * \param header Points to the header of the container.
+ * \param index Index of the block.
+ *
+ * \return The offset of the record from the start of the container.
+ */
+uint64_t tinyjambu_seekable_block_offset
+    (const unsigned char *header, uint64_t index);
+
+/**
+ * \brief Callback that reads bytes from a TinyJAMBU seekable container.
+ *
+ * \param ctx Context pointer that was supplied to
+ * tinyjambu_seekable_open().
+ * \param buf Buffer to receive the bytes.
+ * \param len Number of bytes to read.
+ * \param offset Offset within the container to read from.
+ *
+ * \return 0 if all \a len bytes were read, or -1 on error.
+ *
+ * This has the same shape as the POSIX pread() function so that it
+ * can be implemented by a thin wrapper around pread() for files.
+ */
+typedef int (*tinyjambu_seekable_read_t)
+    (void *ctx, unsigned char *buf, size_t len, uint64_t offset);
+
+/**
+ * \brief Random-access reader for a TinyJAMBU seekable container.
+ */
+typedef struct
+{
+    /** Private state for the reader.  Must be treated as opaque */
+    unsigned long long s[176 / sizeof(unsigned long long)];
+
+} tinyjambu_seekable_reader_t;
+
+/**
+ * \brief Opens a TinyJAMBU seekable container for reading.
+ *
+ * \param reader The reader to initialize.
+ * \param read Callback for reading bytes from the container.
+ * \param ctx Context pointer to pass to \a read.
+ * \param k Points to the bytes of the key.
+ * \param keylen Length of the key in bytes.
+ * \param cache Points to caller-supplied memory for the block cache.
+ * \param cache_size Size of the cache memory in bytes.
+ *
+ * \return 0 on success, or -1 if the header could not be read, is
+ * invalid, does not match the key length, or the cache is too small
+ * to hold at least one block.
+ *
+ * Verified plaintext blocks are kept in the cache, and the least recently
+ * used block is replaced when the cache is full.  The number of cached
+ * blocks is approximately \a cache_size / (block_size + 8 + 24).
+ * The cache memory must remain valid until tinyjambu_seekable_close().
+ */
+int tinyjambu_seekable_open
+    (tinyjambu_seekable_reader_t *reader,
+     tinyjambu_seekable_read_t read, void *ctx,
+     const unsigned char *k, size_t keylen,
+     void *cache, size_t cache_size);
+
+/**
+ * \brief Reads and decrypts a range of plaintext from a TinyJAMBU
+ * seekable container.
+ *
+ * \param reader The reader.
+ * \param buf Buffer to receive the plaintext.
+ * \param len Number of bytes to read.
+ * \param offset Offset within the plaintext to read from.
+ * \param nread On exit, set to the number of bytes that were read,
+ * which is less than \a len if the range extends past the end.
+ *
+ * \return 0 on success, or -1 if a block could not be read or failed
+ * to authenticate.  On failure, the first \a len bytes of \a buf are
+ * set to zero and \a nread is set to zero.
+ *
+ * Only the blocks that overlap the requested range are read and
+ * decrypted, and blocks that are in the cache are not read again.
+ */
+int tinyjambu_seekable_pread
+    (tinyjambu_seekable_reader_t *reader, unsigned char *buf, size_t len,
+     uint64_t offset, size_t *nread);
+
+/**
+ * \brief Gets the length of the plaintext in a TinyJAMBU seekable
+ * container.
+ *
+ * \param reader The reader.
+ *
+ * \return The length of the plaintext in bytes.
+ */
+uint64_t tinyjambu_seekable_length(const tinyjambu_seekable_reader_t *reader);
+
+/**
+ * \brief Gets the cache statistics for a TinyJAMBU seekable reader.
+ *
+ * \param reader The reader.
+ * \param hits Set to the number of block lookups that hit the cache.
+ * \param misses Set to the number of blocks that were read and decrypted.
+ */
+void tinyjambu_seekable_cache_stats
+    (const tinyjambu_seekable_reader_t *reader,
+     uint64_t *hits, uint64_t *misses);
+
+/**
+ * \brief Closes a TinyJAMBU seekable reader and destroys the cached
+ * plaintext.
+ *
+ * \param reader The reader to close.
+ */
+void tinyjambu_seekable_close(tinyjambu_seekable_reader_t *reader);
+
+/**
+ * \brief Pre-computed key for TinyJAMBU-128.
+ *
+ * The key context caches the inverted key words and the state after the
+ * initial key setup permutation, which saves 1024 steps per packet.
+ */
+typedef struct
+{
+    /** Private state for the key.  Must be treated as opaque */
+    unsigned long long s[32 / sizeof(unsigned long long)];
+
+} tinyjambu_128_key_t;
+
+/**
+ * \brief Sets up a pre-computed key for TinyJAMBU-128.
+ *
+ * \param key Points to the pre-computed key to set up.
+ * \param k Points to the 16 bytes of the key.
+ */
+void tinyjambu_128_key_init(tinyjambu_128_key_t *key, const unsigned char *k);
+
+/**
+ * \brief Frees a pre-computed key for TinyJAMBU-128.
+ *
+ * \param key Points to the pre-computed key to destroy.
+ */
+void tinyjambu_128_key_free(tinyjambu_128_key_t *key);
+
+/**
+ * \brief Callback that fetches a TinyJAMBU-128 key on a cache miss.
+ *
+ * \param ctx User-supplied context pointer.
+ * \param key_id Identifier of the key to fetch.
+ * \param k Buffer that receives the 16 bytes of the key.
+ *
+ * \return 0 if the key was fetched, or -1 if there is no such key.
+ *
+ * The callback may be called from several threads at once.
+ */
+typedef int (*tinyjambu_128_keycache_fetch_t)
+    (void *ctx, uint64_t key_id, unsigned char *k);
+
+/**
+ * \brief Cache of pre-computed TinyJAMBU-128 keys, indexed by key
+ * identifier.
+ */
+typedef struct tinyjambu_128_keycache_s tinyjambu_128_keycache_t;
+
+/**
+ * \brief Creates a cache of pre-computed TinyJAMBU-128 keys.
+ *
+ * \param capacity Maximum number of keys to hold in the cache, which
+ * is rounded up to a multiple of 8.
+ * \param shards Number of shards to split the cache into, which is
+ * rounded up to a power of two.  Zero selects a default of 16.
+ * \param fetch Callback for fetching keys that are not in the cache,
+ * or NULL if keys will only be added with tinyjambu_128_keycache_insert().
+ * \param ctx Context pointer to pass to \a fetch.
+ *
+ * \return The new cache, or NULL if there is insufficient memory.
+ *
+ * Lookups do not take any locks; each entry is protected by a sequence
+ * counter and readers retry if they race with an update.  Updates lock
+ * the shard that owns the entry.  When the cache is full, an entry is
+ * chosen for eviction with the CLOCK algorithm and its key is destroyed.
+ *
+ * \sa tinyjambu_128_keycache_get(), tinyjambu_128_keycache_destroy()
+ */
+tinyjambu_128_keycache_t *tinyjambu_128_keycache_create
+    (size_t capacity, unsigned shards,
+     tinyjambu_128_keycache_fetch_t fetch, void *ctx);
+
+/**
+ * \brief Destroys a cache of pre-computed TinyJAMBU-128 keys.
+ *
+ * \param cache The cache to destroy, which may be NULL.
+ *
+ * All keys in the cache are destroyed.  No other thread may be using
+ * the cache when this function is called.
+ */
+void tinyjambu_128_keycache_destroy(tinyjambu_128_keycache_t *cache);
+
+/**
+ * \brief Gets a pre-computed TinyJAMBU-128 key from a cache.
+ *
+ * \param cache The cache.
+ * \param key_id Identifier of the key.
+ * \param key Returns a copy of the pre-computed key.
+ *
+ * \return 0 if the key was found or fetched, or -1 if the key is not in
+ * the cache and could not be fetched.
+ *
+ * The copy in \a key remains valid if the entry is later evicted, and
+ * should be destroyed with tinyjambu_128_key_free() after use.
+ */
+int tinyjambu_128_keycache_get
+    (tinyjambu_128_keycache_t *cache, uint64_t key_id,
+     tinyjambu_128_key_t *key);
+
+/**
+ * \brief Inserts a TinyJAMBU-128 key into a cache, or replaces the key
+ * if the identifier is already present.
+ *
+ * \param cache The cache.
+ * \param key_id Identifier of the key.
+ * \param k Points to the 16 bytes of the key.
+ */
+void tinyjambu_128_keycache_insert
+    (tinyjambu_128_keycache_t *cache, uint64_t key_id,
+     const unsigned char *k);
+
+/**
+ * \brief Removes a TinyJAMBU-128 key from a cache and destroys it.
+ *
+ * \param cache The cache.
+ * \param key_id Identifier of the key.
+ *
+ * \return 0 if the key was removed, or -1 if it was not in the cache.
+ *
+ * This should be called when a key is revoked or rotated.
+ */
+int tinyjambu_128_keycache_remove
+    (tinyjambu_128_keycache_t *cache, uint64_t key_id);
+
+/**
+ * \brief Gets the statistics for a cache of TinyJAMBU-128 keys.
+ *
+ * \param cache The cache.
+ * \param hits Returns the number of lookups that found the key in the
+ * cache.  May be NULL.
+ * \param misses Returns the number of lookups that did not find the key
+ * in the cache.  May be NULL.
+ * \param evictions Returns the number of keys that were evicted to make
+ * room for other keys.  May be NULL.
+ *
+ * The counters are updated without locking, so the values are only
+ * approximate while other threads are using the cache.
+ */
+void tinyjambu_128_keycache_stats
+    (const tinyjambu_128_keycache_t *cache, uint64_t *hits,
+     uint64_t *misses, uint64_t *evictions);
+
+/**
+ * \brief Key context with TinyJAMBU code that is specialised for the key.
+ */
+typedef struct tinyjambu_jit_key_s tinyjambu_jit_key_t;
+
+/**
+ * \brief Creates a key context and generates code that is specialised
+ * for the key.
+ *
+ * \param k Points to the bytes of the key.
+ * \param klen Length of the key; 16, 24, or 32 bytes for TinyJAMBU-128,
+ * TinyJAMBU-192, or TinyJAMBU-256.
+ *
+ * \return The new key context, or NULL if \a klen is invalid or there
+ * is insufficient memory.
+ *
+ * On x86-64, the permutation is generated as straight-line code with
+ * the key words encoded into the instructions, together with loops that
+ * process whole words of the nonce, associated data, and message without
+ * leaving the generated code.  The generated code uses 8K to 12K of memory
+ * per key, which is written and then made executable but read-only.
+ *
+ * If code generation is not supported on this platform, or the platform
+ * does not allow executable memory to be allocated, then the key context
+ * uses the portable backend instead.  The results are the same either way.
+ *
+ * \sa tinyjambu_jit_key_is_native(), tinyjambu_jit_aead_encrypt()
+ */
+tinyjambu_jit_key_t *tinyjambu_jit_key_create
+    (const unsigned char *k, size_t klen);
+
+/**
+ * \brief Destroys a key context and its generated code.
+ *
+ * \param key The key context to destroy, which may be NULL.
+ */
+void tinyjambu_jit_key_destroy(tinyjambu_jit_key_t *key);
+
+/**
+ * \brief Determine if a key context is using generated code.
+ *
+ * \param key The key context.
+ *
+ * \return Non-zero if the key context is using generated code, or zero
+ * if it is using the portable backend.
+ */
+int tinyjambu_jit_key_is_native(const tinyjambu_jit_key_t *key);
+
+/**
+ * \brief Encrypts and authenticates a packet with TinyJAMBU using a
+ * key context.
+ *
+ * \param key The key context.
+ * \param c Buffer to receive the output.
+ * \param clen On exit, set to the length of the output which includes
+ * the ciphertext and the 8 byte authentication tag.
+ * \param m Buffer that contains the plaintext message to encrypt.
+ * \param mlen Length of the plaintext message in bytes.
+ * \param ad Buffer that contains associated data to authenticate
+ * along with the packet but which does not need to be encrypted.
+ * \param adlen Length of the associated data in bytes.
+ * \param npub Points to the public nonce for the packet which must
+ * be 12 bytes in length.
+ *
+ * The output is the same as tinyjambu_128_aead_encrypt(),
+ * tinyjambu_192_aead_encrypt(), or tinyjambu_256_aead_encrypt(),
+ * depending upon the size of the key.
+ *
+ * \sa tinyjambu_jit_aead_decrypt()
+ */
+void tinyjambu_jit_aead_encrypt
+    (const tinyjambu_jit_key_t *key, unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub);
+
+/**
+ * \brief Decrypts and authenticates a packet with TinyJAMBU using a
+ * key context.
+ *
+ * \param key The key context.
+ * \param m Buffer to receive the plaintext message on output.
+ * \param mlen Receives the length of the plaintext message on output.
+ * \param c Buffer that contains the ciphertext and authentication
+ * tag to decrypt.
+ * \param clen Length of the input data in bytes, which includes the
+ * ciphertext and the 8 byte authentication tag.
+ * \param ad Buffer that contains associated data to authenticate
+ * along with the packet but which does not need to be encrypted.
+ * \param adlen Length of the associated data in bytes.
+ * \param npub Points to the public nonce for the packet which must
+ * be 12 bytes in length.
+ *
+ * \return 0 on success, -1 if the authentication tag was incorrect,
+ * or some other negative number if there was an error in the parameters.
+ *
+ * \sa tinyjambu_jit_aead_encrypt()
+ */
+int tinyjambu_jit_aead_decrypt
+    (const tinyjambu_jit_key_t *key, unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub);
+
+/**
+ * \brief Job for the TinyJAMBU-128 lane scheduler.
+ *
+ * The fields up to and including \a user_data are filled in by the caller
+ * before the job is submitted.  The job, and all of the buffers that it
+ * refers to, must remain valid until the job completes.
+ */
+typedef struct tinyjambu_128_aead_job_s
+{
+    /** Pre-computed key to use for this job */
+    const tinyjambu_128_key_t *key;
+
+    /** Points to the 12 bytes of the nonce */
+    const unsigned char *npub;
+
+    /** Points to the associated data */
+    const unsigned char *ad;
+
+    /** Length of the associated data in bytes */
+    size_t adlen;
+
+    /** Points to the plaintext to encrypt or the ciphertext to decrypt */
+    const unsigned char *in;
+
+    /** Length of the input in bytes, not including the tag */
+    size_t inlen;
+
+    /** Buffer that receives the output, which may be the same as \a in */
+    unsigned char *out;
+
+    /** Buffer that receives the 8 byte tag when encrypting, or contains
+     *  the expected tag when decrypting.  Must not overlap \a out */
+    unsigned char *tag;
+
+    /** Non-zero to decrypt, or zero to encrypt */
+    int decrypt;
+
+    /** User data for the completion callback */
+    void *user_data;
+
+    /** Result of the job on completion: 0 on success, or -1 if the
+     *  authentication tag was incorrect when decrypting */
+    int result;
+
+    /** Internal link for the scheduler queues */
+    struct tinyjambu_128_aead_job_s *next;
+
+} tinyjambu_128_aead_job_t;
+
+/**
+ * \brief Callback that is invoked when a scheduled job completes.
+ *
+ * \param job The job that has completed.
+ */
+typedef void (*tinyjambu_128_sched_callback_t)(tinyjambu_128_aead_job_t *job);
+
+/**
+ * \brief Lane scheduler for TinyJAMBU-128 AEAD jobs.
+ */
+typedef struct
+{
+    /** Private state for the scheduler.  Must be treated as opaque */
+    unsigned long long s[320 / sizeof(unsigned long long)];
+
+} tinyjambu_128_sched_t;
+
+/**
+ * \brief Initializes a TinyJAMBU-128 lane scheduler.
+ *
+ * \param sched The scheduler to initialize.
+ * \param callback Function to call when each job completes, or NULL
+ * to collect the completed jobs with tinyjambu_128_sched_poll() instead.
+ *
+ * The scheduler runs up to four jobs at once in parallel lanes.  The jobs
+ * may use different keys and different lengths.  When a job finishes,
+ * its lane is immediately refilled with the next job in the queue.
+ *
+ * \sa tinyjambu_128_sched_submit(), tinyjambu_128_sched_run()
+ */
+void tinyjambu_128_sched_init
+    (tinyjambu_128_sched_t *sched, tinyjambu_128_sched_callback_t callback);
+
+/**
+ * \brief Frees a TinyJAMBU-128 lane scheduler.
+ *
+ * \param sched The scheduler to free.
+ *
+ * Jobs that are still queued or running are abandoned.
+ */
+void tinyjambu_128_sched_free(tinyjambu_128_sched_t *sched);
+
+/**
+ * \brief Submits a job to a TinyJAMBU-128 lane scheduler.
+ *
+ * \param sched The scheduler.
+ * \param job The job to submit.
+ *
+ * Jobs are started in the order that they are submitted, but may
+ * complete in a different order.
+ */
+void tinyjambu_128_sched_submit
+    (tinyjambu_128_sched_t *sched, tinyjambu_128_aead_job_t *job);
+
+/**
+ * \brief Runs a TinyJAMBU-128 lane scheduler until all submitted jobs
+ * have completed.
+ *
+ * \param sched The scheduler.
+ *
+ * \return The number of jobs that completed.
+ *
+ * Jobs may be submitted from the completion callback, and they will
+ * be run before this function returns.
+ */
+size_t tinyjambu_128_sched_run(tinyjambu_128_sched_t *sched);
+
+/**
+ * \brief Polls a TinyJAMBU-128 lane scheduler for a completed job.
+ *
+ * \param sched The scheduler.
+ *
+ * \return The next completed job, or NULL if there are no more completed
+ * jobs.  Always returns NULL if the scheduler has a completion callback.
+ */
+tinyjambu_128_aead_job_t *tinyjambu_128_sched_poll
+    (tinyjambu_128_sched_t *sched);
+
+/**
+ * \brief Flag for tinyjambu_128_session_table_create() that caches the
+ * state after the key setup for every session.
+ *
+ * Caching saves 1024 steps of the permutation for every message at the
+ * cost of another 16 bytes per session.
+ */
+#define TINYJAMBU_SESSION_TABLE_CACHE_SETUP 0x01
+
+/**
+ * \brief Table of TinyJAMBU-128 AEAD sessions.
+ *
+ * Each session has a key and a counter that is used to generate nonces.
+ * The table stores each field in a separate array, so that batch
+ * operations read the fields for consecutive sessions with unit stride
+ * and there is no per-session allocation overhead.
+ */
+typedef struct tinyjambu_128_session_table_s tinyjambu_128_session_table_t;
+
+/**
+ * \brief Message for a bulk operation on a TinyJAMBU-128 session table.
+ */
+typedef struct
+{
+    /** Points to the plaintext to seal or the ciphertext to open */
+    const unsigned char *in;
+
+    /** Length of the input in bytes, not including the tag */
+    size_t inlen;
+
+    /** Buffer that receives the output, which may be the same as \a in */
+    unsigned char *out;
+
+    /** Buffer that receives the 8 byte tag when sealing, or contains the
+     *  expected tag when opening.  Must not overlap \a out */
+    unsigned char *tag;
+
+    /** Points to the associated data */
+    const unsigned char *ad;
+
+    /** Length of the associated data in bytes */
+    size_t adlen;
+
+    /** Nonce counter; set on output when sealing, and supplied by the
+     *  caller when opening */
+    uint64_t counter;
+
+    /** Result of the operation: 0 on success, or -1 if the authentication
+     *  tag was incorrect when opening */
+    int result;
+
+} tinyjambu_128_session_msg_t;
+
+/**
+ * \brief Creates a table of TinyJAMBU-128 AEAD sessions.
+ *
+ * \param capacity Number of sessions in the table.
+ * \param nonce_prefix Value that forms the first 4 bytes of every nonce
+ * for sessions in this table.  The two ends of a connection must use
+ * different prefixes if they share a key.
+ * \param flags Zero or TINYJAMBU_SESSION_TABLE_CACHE_SETUP.
+ *
+ * \return The new table, or NULL if there is insufficient memory.
+ *
+ * All sessions start out empty.  Sessions are identified by their index
+ * in the table, from 0 to \a capacity - 1.
+ */
+tinyjambu_128_session_table_t *tinyjambu_128_session_table_create
+    (uint32_t capacity, uint32_t nonce_prefix, unsigned flags);
+
+/**
+ * \brief Destroys a table of TinyJAMBU-128 AEAD sessions and all keys
+ * that it contains.
+ *
+ * \param table The table to destroy, which may be NULL.
+ */
+void tinyjambu_128_session_table_destroy
+    (tinyjambu_128_session_table_t *table);
+
+/**
+ * \brief Gets the number of bytes of memory that a table of TinyJAMBU-128
+ * AEAD sessions uses for each session.
+ *
+ * \param flags Flags that will be passed to
+ * tinyjambu_128_session_table_create().
+ *
+ * \return The number of bytes per session.
+ */
+size_t tinyjambu_128_session_table_session_size(unsigned flags);
+
+/**
+ * \brief Sets the key for a session in a TinyJAMBU-128 session table.
+ *
+ * \param table The session table.
+ * \param session Index of the session.
+ * \param k Points to the 16 bytes of the key.
+ * \param counter Initial value of the nonce counter.
+ */
+void tinyjambu_128_session_table_set
+    (tinyjambu_128_session_table_t *table, uint32_t session,
+     const unsigned char *k, uint64_t counter);
+
+/**
+ * \brief Destroys the key for a session in a TinyJAMBU-128 session table.
+ *
+ * \param table The session table.
+ * \param session Index of the session.
+ */
+void tinyjambu_128_session_table_clear
+    (tinyjambu_128_session_table_t *table, uint32_t session);
+
+/**
+ * \brief Gets the next value of the nonce counter for a session in a
+ * TinyJAMBU-128 session table.
+ *
+ * \param table The session table.
+ * \param session Index of the session.
+ *
+ * \return The counter value for the next message that is sealed.
+ */
+uint64_t tinyjambu_128_session_table_counter
+    (const tinyjambu_128_session_table_t *table, uint32_t session);
+
+/**
+ * \brief Formats the nonce that a TinyJAMBU-128 session table uses for
+ * a specific counter value.
+ *
+ * \param table The session table.
+ * \param npub Buffer that receives the 12 bytes of the nonce.
+ * \param counter The counter value.
+ *
+ * The nonce is the table's 4-byte prefix in little-endian byte order,
+ * followed by the counter in little-endian byte order.  The nonce can be
+ * used with tinyjambu_128_aead_decrypt() to open a single message.
+ */
+void tinyjambu_128_session_table_nonce
+    (const tinyjambu_128_session_table_t *table, unsigned char *npub,
+     uint64_t counter);
+
+/**
+ * \brief Seals a batch of messages for sessions in a TinyJAMBU-128
+ * session table.
+ *
+ * \param table The session table.
+ * \param sessions Array of session indexes, one for each message.
+ * \param msgs Array of messages to seal.
+ * \param count Number of messages.
+ *
+ * Each message is encrypted with the session's key and the next value
+ * of its nonce counter, which is returned in the \a counter field.
+ * The same session may appear more than once in a batch, in which case
+ * its messages use consecutive counter values.
+ *
+ * The messages are processed across the lanes of the TinyJAMBU-128
+ * lane scheduler.
+ */
+void tinyjambu_128_session_table_seal
+    (tinyjambu_128_session_table_t *table, const uint32_t *sessions,
+     tinyjambu_128_session_msg_t *msgs, size_t count);
+
+/**
+ * \brief Opens a batch of messages for sessions in a TinyJAMBU-128
+ * session table.
+ *
+ * \param table The session table.
+ * \param sessions Array of session indexes, one for each message.
+ * \param msgs Array of messages to open, with the \a counter field set
+ * to the nonce counter that was used to seal each message.
+ * \param count Number of messages.
+ *
+ * \return 0 if all messages were opened, or -1 if the authentication tag
+ * was incorrect for at least one message.  The \a result field of each
+ * message indicates which ones failed, and the output for failed messages
+ * is set to all-zeroes.
+ *
+ * The nonce counters of the sessions are not modified.  Detecting replayed
+ * messages is left to the application.
+ */
+int tinyjambu_128_session_table_open
+    (tinyjambu_128_session_table_t *table, const uint32_t *sessions,
+     tinyjambu_128_session_msg_t *msgs, size_t count);
+
+/**
+ * \brief Value that indicates that a row was not found in an equality
+ * index.
+ */
+#define TINYJAMBU_EQINDEX_NOT_FOUND (~((uint64_t)0))
+
+/**
+ * \brief Key context for deterministic encryption of a table column
+ * with TinyJAMBU-128-SIV.
+ *
+ * The context caches the state after the key, an all-zero nonce, and the
+ * column name have been absorbed.  Encrypting a value with the context
+ * only needs to process the value itself.
+ */
+typedef struct
+{
+    /** Private state for the column.  Must be treated as opaque */
+    unsigned long long s[32 / sizeof(unsigned long long)];
+
+} tinyjambu_128_column_t;
+
+/**
+ * \brief Sets up a key context for deterministic encryption of a column.
+ *
+ * \param column The column context to set up.
+ * \param k Points to the 16 bytes of the key.
+ * \param name Points to the name of the column.
+ * \param namelen Length of the column name in bytes.
+ *
+ * Values that are encrypted with the same key but different column names
+ * cannot be compared with each other.
+ */
+void tinyjambu_128_column_init
+    (tinyjambu_128_column_t *column, const unsigned char *k,
+     const unsigned char *name, size_t namelen);
+
+/**
+ * \brief Frees a key context for deterministic encryption of a column.
+ *
+ * \param column The column context to destroy.
+ */
+void tinyjambu_128_column_free(tinyjambu_128_column_t *column);
+
+/**
+ * \brief Deterministically encrypts a value for a column.
+ *
+ * \param column The column context.
+ * \param c Buffer to receive the ciphertext and the 8 byte tag.
+ * \param clen On exit, set to the length of the output.
+ * \param m Buffer that contains the value to encrypt.
+ * \param mlen Length of the value in bytes.
+ *
+ * The output is identical to tinyjambu_128_siv_encrypt() with the column
+ * name as the associated data and an all-zero nonce.  Equal values
+ * produce equal ciphertexts, which reveals which rows of the column are
+ * equal but nothing else about the values.
+ */
+void tinyjambu_128_column_encrypt
+    (const tinyjambu_128_column_t *column,
+     unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen);
+
+/**
+ * \brief Decrypts a value for a column.
+ *
+ * \param column The column context.
+ * \param m Buffer to receive the value.
+ * \param mlen On exit, set to the length of the value.
+ * \param c Buffer that contains the ciphertext and the 8 byte tag.
+ * \param clen Length of the ciphertext in bytes, including the tag.
+ *
+ * \return 0 on success, or -1 if the tag was incorrect.
+ */
+int tinyjambu_128_column_decrypt
+    (const tinyjambu_128_column_t *column,
+     unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen);
+
+/**
+ * \brief Computes the deterministic tags for a batch of column values.
+ *
+ * \param column The column context.
+ * \param tags Buffer to receive the 8 byte tag for each value.
+ * \param values Array of pointers to the values.
+ * \param lens Array of lengths of the values.
+ * \param count Number of values in the batch.
+ *
+ * Each tag is the same as the last 8 bytes of the output from
+ * tinyjambu_128_column_encrypt().  Only the authentication pass of SIV
+ * is needed to compute the tag, and the values are spread across the
+ * permutation lanes four at a time.
+ */
+void tinyjambu_128_column_tags
+    (const tinyjambu_128_column_t *column, unsigned char *tags,
+     const unsigned char * const *values, const size_t *lens, size_t count);
+
+/**
+ * \brief Equality index for a column that is deterministically encrypted
+ * with TinyJAMBU-128-SIV.
+ */
+typedef struct
+{
+    /** Private state for the index.  Must be treated as opaque */
+    unsigned long long s[64 / sizeof(unsigned long long)];
+
+} tinyjambu_128_eqindex_t;
+
+/**
+ * \brief Initializes an equality index for an encrypted column.
+ *
+ * \param index The index to initialize.
+ * \param column The column context, which must remain valid for the
+ * lifetime of the index.
+ * \param table Points to caller-supplied memory for the hash table.
+ * \param table_size Size of the table memory in bytes.
+ *
+ * \return 0 on success, or -1 if the table memory is too small.
+ *
+ * The index is an open-addressing hash table with linear probing.
+ * Each slot holds a 64-bit tag and a 64-bit row number, so four slots
+ * fit in a typical cache line.  The number of slots is the largest power
+ * of two that fits in \a table_size, and should be at least twice the
+ * number of rows to keep the probe sequences short.
+ *
+ * The index maps the tag of each value to a single row, so it is only
+ * suitable for columns whose values are unique.  If the same value is
+ * inserted for several rows, then only the row from the last insert is
+ * kept and the earlier rows can no longer be found.  As tags are 64 bits in size, unrelated values may collide
+ * with a very small probability; callers that cannot tolerate this should
+ * compare the stored ciphertext of the row after a successful lookup.
+ */
+int tinyjambu_128_eqindex_init
+    (tinyjambu_128_eqindex_t *index, const tinyjambu_128_column_t *column,
+     void *table, size_t table_size);
+
+/**
+ * \brief Inserts a batch of values into an equality index.
+ *
+ * \param index The index.
+ * \param values Array of pointers to the plaintext values.
+ * \param lens Array of lengths of the values.
+ * \param rows Array of row numbers for the values, none of which may be
+ * TINYJAMBU_EQINDEX_NOT_FOUND.
+ * \param count Number of values to insert.
+ *
+ * \return The number of values that were inserted, which is less than
+ * \a count if the table became full.
+ *
+ * If a value is already in the index, then its row number is replaced
+ * and the previous row is lost.  Columns with duplicate values need an
+ * index of their own that maps each value to a list of rows.
+ */
+size_t tinyjambu_128_eqindex_insert
+    (tinyjambu_128_eqindex_t *index, const unsigned char * const *values,
+     const size_t *lens, const uint64_t *rows, size_t count);
+
+/**
+ * \brief Looks up a batch of values in an equality index.
+ *
+ * \param index The index.
+ * \param rows Array that receives the row number for each value, or
+ * TINYJAMBU_EQINDEX_NOT_FOUND if the value is not in the index.
+ * \param values Array of pointers to the plaintext values.
+ * \param lens Array of lengths of the values.
+ * \param count Number of values to look up.
+ *
+ * \return The number of values that were found.
+ */
+size_t tinyjambu_128_eqindex_lookup
+    (const tinyjambu_128_eqindex_t *index, uint64_t *rows,
+     const unsigned char * const *values, const size_t *lens, size_t count);
+
+/**
+ * \brief Looks up the row for a deterministically encrypted value.
+ *
+ * \param index The index.
+ * \param c Points to the output of tinyjambu_128_column_encrypt().
+ * \param clen Length of the ciphertext in bytes, including the tag.
+ *
+ * \return The row number, or TINYJAMBU_EQINDEX_NOT_FOUND if the value
+ * is not in the index.
+ *
+ * This allows queries that were encrypted elsewhere to be looked up
+ * without access to the plaintext.
+ */
+uint64_t tinyjambu_128_eqindex_lookup_ciphertext
+    (const tinyjambu_128_eqindex_t *index,
+     const unsigned char *c, size_t clen);
+
+/**
+ * \brief Removes a value from an equality index.
+ *
+ * \param index The index.
+ * \param value Points to the plaintext value.
+ * \param len Length of the value in bytes.
+ *
+ * \return 0 if the value was removed, or -1 if it was not in the index.
+ */
+int tinyjambu_128_eqindex_remove
+    (tinyjambu_128_eqindex_t *index, const unsigned char *value, size_t len);
+
+/**
+ * \brief Gets the number of values in an equality index.
+ *
+ * \param index The index.
+ *
+ * \return The number of values.
+ */
+size_t tinyjambu_128_eqindex_count(const tinyjambu_128_eqindex_t *index);
+
+/**
+ * \brief Pre-computed key for TinyJAMBU-MAC.
+ */
+typedef struct
+{
+    /** Private state for the key.  Must be treated as opaque */
+    unsigned long long s[80 / sizeof(unsigned long long)];
+
+} tinyjambu_mac_key_t;
+
+/**
+ * \brief State information for incremental TinyJAMBU-MAC.
+ */
+typedef struct
+{
+    /** Private state for the MAC.  Must be treated as opaque */
+    unsigned long long s[64 / sizeof(unsigned long long)];
+
+} tinyjambu_mac_state_t;
+
+/**
+ * \brief Sets up a pre-computed key for TinyJAMBU-128-MAC.
+ *
+ * \param key Points to the pre-computed key to set up.
+ * \param k Points to the 16 bytes of the key.
+ *
+ * \sa tinyjambu_mac(), tinyjambu_mac_init()
+ */
+void tinyjambu_128_mac_init_key
+    (tinyjambu_mac_key_t *key, const unsigned char *k);
+
+/**
+ * \brief Sets up a pre-computed key for TinyJAMBU-192-MAC.
+ *
+ * \param key Points to the pre-computed key to set up.
+ * \param k Points to the 24 bytes of the key.
+ *
+ * \sa tinyjambu_mac(), tinyjambu_mac_init()
+ */
+void tinyjambu_192_mac_init_key
+    (tinyjambu_mac_key_t *key, const unsigned char *k);
+
+/**
+ * \brief Sets up a pre-computed key for TinyJAMBU-256-MAC.
+ *
+ * \param key Points to the pre-computed key to set up.
+ * \param k Points to the 32 bytes of the key.
+ *
+ * \sa tinyjambu_mac(), tinyjambu_mac_init()
+ */
+void tinyjambu_256_mac_init_key
+    (tinyjambu_mac_key_t *key, const unsigned char *k);
+
+/**
+ * \brief Frees a pre-computed key for TinyJAMBU-MAC.
+ *
+ * \param key Points to the pre-computed key to destroy.
+ */
+void tinyjambu_mac_free_key(tinyjambu_mac_key_t *key);
+
+/**
+ * \brief Computes a TinyJAMBU-MAC authentication tag for a message.
+ *
+ * \param tag Buffer to receive the TINYJAMBU_MAC_SIZE bytes of the tag.
+ * \param key Points to the pre-computed key.
+ * \param nonce Points to the TINYJAMBU_NONCE_SIZE bytes of the nonce,
+ * or NULL to use a fixed IV instead of a nonce.
+ * \param data Points to the data to authenticate.
+ * \param size Number of bytes of data to authenticate.
+ *
+ * The fixed IV variant is slightly faster because the state after the IV
+ * has been absorbed is pre-computed by the key setup.  A nonce should be
+ * used when the same message may be authenticated more than once and
+ * the tags must not be linkable.
+ *
+ * \sa tinyjambu_mac_verify(), tinyjambu_mac_init()
+ */
+void tinyjambu_mac
+    (unsigned char *tag, const tinyjambu_mac_key_t *key,
+     const unsigned char *nonce, const unsigned char *data, size_t size);
+
+/**
+ * \brief Verifies a TinyJAMBU-MAC authentication tag for a message.
+ *
+ * \param tag Points to the TINYJAMBU_MAC_SIZE bytes of the tag to verify.
+ * \param key Points to the pre-computed key.
+ * \param nonce Points to the TINYJAMBU_NONCE_SIZE bytes of the nonce,
+ * or NULL to use a fixed IV instead of a nonce.
+ * \param data Points to the data to authenticate.
+ * \param size Number of bytes of data to authenticate.
+ *
+ * \return 0 if the tag is valid, or -1 if the tag is invalid.
+ *
+ * \sa tinyjambu_mac()
+ */
+int tinyjambu_mac_verify
+    (const unsigned char *tag, const tinyjambu_mac_key_t *key,
+     const unsigned char *nonce, const unsigned char *data, size_t size);
+
+/**
+ * \brief Initializes the state for an incremental TinyJAMBU-MAC operation.
+ *
+ * \param state MAC state to be initialized.
+ * \param key Points to the pre-computed key.
+ * \param nonce Points to the TINYJAMBU_NONCE_SIZE bytes of the nonce,
+ * or NULL to use a fixed IV instead of a nonce.
+ *
+ * \sa tinyjambu_mac_update(), tinyjambu_mac_finalize()
+ */
+void tinyjambu_mac_init
+    (tinyjambu_mac_state_t *state, const tinyjambu_mac_key_t *key,
+     const unsigned char *nonce);
+
+/**
+ * \brief Updates an incremental TinyJAMBU-MAC state with more data.
+ *
+ * \param state MAC state to be updated.
+ * \param data Points to the data to authenticate.
+ * \param size Number of bytes of data to authenticate.
+ *
+ * \sa tinyjambu_mac_init(), tinyjambu_mac_finalize()
+ */
+void tinyjambu_mac_update
+    (tinyjambu_mac_state_t *state, const unsigned char *data, size_t size);
+
+/**
+ * \brief Finalizes an incremental TinyJAMBU-MAC operation.
+ *
+ * \param state MAC state to be finalized.
+ * \param tag Buffer to receive the TINYJAMBU_MAC_SIZE bytes of the tag.
+ *
+ * The \a state is destroyed by this function.
+ *
+ * \sa tinyjambu_mac_init(), tinyjambu_mac_update()
+ */
+void tinyjambu_mac_finalize(tinyjambu_mac_state_t *state, unsigned char *tag);
+
+/**
+ * \brief Finalizes an incremental TinyJAMBU-MAC operation and checks
+ * the result against an expected tag.
+ *
+ * \param state MAC state to be finalized.
+ * \param tag Points to the TINYJAMBU_MAC_SIZE bytes of the expected tag.
+ *
+ * \return 0 if the tag is valid, or -1 if the tag is invalid.
+ *
+ * The \a state is destroyed by this function.
+ */
+int tinyjambu_mac_check_finalize
+    (tinyjambu_mac_state_t *state, const unsigned char *tag);
+
+/**
+ * \brief Frees an incremental TinyJAMBU-MAC state.
+ *
+ * \param state MAC state to be freed.
+ */
+void tinyjambu_mac_free(tinyjambu_mac_state_t *state);
+
+/**
+ * \brief Pre-computed key for TinyJAMBU-PMAC.
+ */
+typedef struct
+{
+    /** Private state for the key.  Must be treated as opaque */
+    unsigned long long s[576 / sizeof(unsigned long long)];
+
+} tinyjambu_pmac_key_t;
+
+/**
+ * \brief State information for incremental TinyJAMBU-PMAC.
+ */
+typedef struct
+{
+    /** Private state for the MAC.  Must be treated as opaque */
+    unsigned long long s[80 / sizeof(unsigned long long)];
+
+} tinyjambu_pmac_state_t;
+
+/**
+ * \brief Sets up a pre-computed key for TinyJAMBU-PMAC.
+ *
+ * \param key Points to the pre-computed key to set up.
+ * \param k Points to the TINYJAMBU_PMAC_KEY_SIZE bytes of the key.
+ *
+ * The key should not be shared with other TinyJAMBU modes.
+ *
+ * \sa tinyjambu_pmac(), tinyjambu_pmac_init()
+ */
+void tinyjambu_pmac_init_key(tinyjambu_pmac_key_t *key, const unsigned char *k);
+
+/**
+ * \brief Frees a pre-computed key for TinyJAMBU-PMAC.
+ *
+ * \param key Points to the pre-computed key to destroy.
+ */
+void tinyjambu_pmac_free_key(tinyjambu_pmac_key_t *key);
+
+/**
+ * \brief Computes a TinyJAMBU-PMAC authentication tag for a message.
+ *
+ * \param tag Buffer to receive the TINYJAMBU_PMAC_SIZE bytes of the tag.
+ * \param key Points to the pre-computed key.
+ * \param data Points to the data to authenticate.
+ * \param size Number of bytes of data to authenticate.
+ *
+ * \sa tinyjambu_pmac_parallel(), tinyjambu_pmac_verify()
+ */
+void tinyjambu_pmac
+    (unsigned char *tag, const tinyjambu_pmac_key_t *key,
+     const unsigned char *data, size_t size);
+
+/**
+ * \brief Computes a TinyJAMBU-PMAC authentication tag for a message
+ * using multiple threads.
+ *
+ * \param tag Buffer to receive the TINYJAMBU_PMAC_SIZE bytes of the tag.
+ * \param key Points to the pre-computed key.
+ * \param data Points to the data to authenticate.
+ * \param size Number of bytes of data to authenticate.
+ * \param threads Maximum number of threads to use, including the
+ * calling thread.
+ *
+ * The result is identical to tinyjambu_pmac().  Fewer than \a threads
+ * threads will be used if the message is short.  If threads are not
+ * supported on the platform, then this is equivalent to tinyjambu_pmac().
+ *
+ * \sa tinyjambu_pmac()
+ */
+void tinyjambu_pmac_parallel
+    (unsigned char *tag, const tinyjambu_pmac_key_t *key,
+     const unsigned char *data, size_t size, unsigned threads);
+
+/**
+ * \brief Verifies a TinyJAMBU-PMAC authentication tag for a message.
+ *
+ * \param tag Points to the TINYJAMBU_PMAC_SIZE bytes of the tag to verify.
+ * \param key Points to the pre-computed key.
+ * \param data Points to the data to authenticate.
+ * \param size Number of bytes of data to authenticate.
+ *
+ * \return 0 if the tag is valid, or -1 if the tag is invalid.
+ *
+ * \sa tinyjambu_pmac()
+ */
+int tinyjambu_pmac_verify
+    (const unsigned char *tag, const tinyjambu_pmac_key_t *key,
+     const unsigned char *data, size_t size);
+
+/**
+ * \brief Initializes the state for an incremental TinyJAMBU-PMAC operation.
+ *
+ * \param state PMAC state to be initialized.
+ * \param key Points to the pre-computed key.
+ *
+ * The \a key needs to be preserved until the tinyjambu_pmac_finalize() call
+ * because the state refers to the key rather than copying it.
+ *
+ * \sa tinyjambu_pmac_update(), tinyjambu_pmac_finalize()
+ */
+void tinyjambu_pmac_init
+    (tinyjambu_pmac_state_t *state, const tinyjambu_pmac_key_t *key);
+
+/**
+ * \brief Updates an incremental TinyJAMBU-PMAC state with more data.
+ *
+ * \param state PMAC state to be updated.
+ * \param data Points to the data to authenticate.
+ * \param size Number of bytes of data to authenticate.
+ *
+ * \sa tinyjambu_pmac_init(), tinyjambu_pmac_finalize()
+ */
+void tinyjambu_pmac_update
+    (tinyjambu_pmac_state_t *state, const unsigned char *data, size_t size);
+
+/**
+ * \brief Finalizes an incremental TinyJAMBU-PMAC operation.
+ *
+ * \param state PMAC state to be finalized.
+ * \param tag Buffer to receive the TINYJAMBU_PMAC_SIZE bytes of the tag.
+ *
+ * The \a state is destroyed by this function.
+ *
+ * \sa tinyjambu_pmac_init(), tinyjambu_pmac_update()
+ */
+void tinyjambu_pmac_finalize
+    (tinyjambu_pmac_state_t *state, unsigned char *tag);
+
+/**
+ * \brief Frees an incremental TinyJAMBU-PMAC state.
+ *
+ * \param state PMAC state to be freed.
+ */
+void tinyjambu_pmac_free(tinyjambu_pmac_state_t *state);
+
+/**
+ * \brief Pre-computed key for TinyJAMBU-PRF64.
+ */
+typedef struct
+{
+    /** Private state for the key.  Must be treated as opaque */
+    unsigned long long s[48 / sizeof(unsigned long long)];
+
+} tinyjambu_prf64_key_t;
+
+/**
+ * \brief Sets up a pre-computed key for TinyJAMBU-PRF64.
+ *
+ * \param key Points to the pre-computed key to set up.
+ * \param k Points to the TINYJAMBU_PRF64_KEY_SIZE bytes of the key.
+ *
+ * \sa tinyjambu_prf64()
+ */
+void tinyjambu_prf64_init_key
+    (tinyjambu_prf64_key_t *key, const unsigned char *k);
+
+/**
+ * \brief Frees a pre-computed key for TinyJAMBU-PRF64.
+ *
+ * \param key Points to the pre-computed key to destroy.
+ */
+void tinyjambu_prf64_free_key(tinyjambu_prf64_key_t *key);
+
+/**
+ * \brief Computes the keyed TinyJAMBU-PRF64 function of a short input.
+ *
+ * \param key Points to the pre-computed key.
+ * \param data Points to the input data.
+ * \param size Number of bytes of input data.
+ *
+ * \return The 64-bit output of the function.
+ *
+ * This function is intended for hash tables and load balancing where
+ * the inputs are short and an attacker should not be able to predict
+ * which inputs will collide.  Inputs of up to 16 bytes require a single
+ * call on the permutation, and inputs of up to 32 bytes require two.
+ *
+ * \sa tinyjambu_prf64_batch()
+ */
+uint64_t tinyjambu_prf64
+    (const tinyjambu_prf64_key_t *key, const unsigned char *data, size_t size);
+
+/**
+ * \brief Computes the keyed TinyJAMBU-PRF64 function of multiple inputs.
+ *
+ * \param key Points to the pre-computed key.
+ * \param out Points to the array that receives the outputs.
+ * \param data Array of pointers to the input data.
+ * \param sizes Array of the number of bytes in each input.
+ * \param count Number of inputs to process.
+ *
+ * The result for each input is the same as for tinyjambu_prf64().
+ * Inputs are processed in groups of four, in parallel where possible.
+ * This is faster for bulk operations such as rehashing a table.
+ */
+void tinyjambu_prf64_batch
+    (const tinyjambu_prf64_key_t *key, uint64_t *out,
+     const unsigned char * const *data, const size_t *sizes, size_t count);
+
+/**
+ * \brief State information for TinyJAMBU-Hash.
+ */
+typedef struct
+{
+    /** Private state for the hash.  Must be treated as opaque */
+    unsigned long long s[56 / sizeof(unsigned long long)];
+
+} tinyjambu_hash_state_t;
+
+/**
+ * \brief Hashes a block of input data with TinyJAMBU-Hash.
+ *
+ * \param out Buffer to receive the hash output which must be at least
+ * TINYJAMBU_HASH_SIZE bytes in length.
+ * \param in Points to the input data to be hashed.
+ * \param inlen Length of the input data in bytes.
+ *
+ * \sa tinyjambu_hash_init(), tinyjambu_hash_update(), tinyjambu_hash_finalize()
+ */
+void tinyjambu_hash(unsigned char *out, const unsigned char *in, size_t inlen);
+
+/**
+ * \brief Initializes the state for an TinyJAMBU-Hash hashing operation.
+ *
+ * \param state Hash state to be initialized.
+ *
+ * \sa tinyjambu_hash_update(), tinyjambu_hash_finalize(), tinyjambu_hash()
+ */
+void tinyjambu_hash_init(tinyjambu_hash_state_t *state);
+
+/**
+ * \brief Re-initializes the state for an TinyJAMBU-Hash hashing operation.
+ *
+ * \param state Hash state to be re-initialized.
+ *
+ * This function is equivalent to calling tinyjambu_hash_free() and then
+ * tinyjambu_hash_init() to restart the hashing process.
+ *
+ * \sa tinyjambu_hash_init()
+ */
+void tinyjambu_hash_reinit(tinyjambu_hash_state_t *state);
+
+/**
+ * \brief Frees the TinyJAMBU-Hash state and destroys any sensitive material.
+ *
+ * \param state Hash state to be freed.
+ */
+void tinyjambu_hash_free(tinyjambu_hash_state_t *state);
+
+/**
+ * \brief Updates an TinyJAMBU-Hash state with more input data.
+ *
+ * \param state Hash state to be updated.
+ * \param in Points to the input data to be incorporated into the state.
+ * \param inlen Length of the input data to be incorporated into the state.
+ *
+ * \sa tinyjambu_hash_init(), tinyjambu_hash_finalize()
+ */
+void tinyjambu_hash_update
+    (tinyjambu_hash_state_t *state, const unsigned char *in, size_t inlen);
+
+/**
+ * \brief Returns the final hash value from an TinyJAMBU-Hash hashing operation.
+ *
+ * \param state Hash state to be finalized.
+ * \param out Points to the output buffer to receive the hash value.
+ * Must be at least TINYJAMBU_HASH_SIZE bytes in length.
+ *
+ * \sa tinyjambu_hash_init(), tinyjambu_hash_update()
+ */
+void tinyjambu_hash_finalize(tinyjambu_hash_state_t *state, unsigned char *out);
+
+/**
+ * \brief State information for the TINYJAMBU-HMAC incremental mode.
+ */
+typedef struct
+{
+    tinyjambu_hash_state_t hash;    /**< Internal TINYJAMBU-Hash state */
+
+} tinyjambu_hmac_state_t;
+
+/**
+ * \brief Computes a HMAC value using TINYJAMBU-HASH.
+ *
+ * \param out Buffer to receive the output HMAC value; must be at least
+ * TINYJAMBU_HMAC_SIZE bytes in length.
+ * \param key Points to the key.
+ * \param keylen Number of bytes in the key.
+ * \param in Points to the data to authenticate.
+ * \param inlen Number of bytes of data to authenticate.
+ */
+void tinyjambu_hmac
+    (unsigned char *out,
+     const unsigned char *key, size_t keylen,
+     const unsigned char *in, size_t inlen);
+
+/**
+ * \brief Initializes an incremental HMAC state using TINYJAMBU-HASH.
+ *
+ * \param state Points to the state to be initialized.
+ * \param key Points to the key.
+ * \param keylen Number of bytes in the key.
+ *
+ * The \a key needs to be preserved until the tinyjambu_hmac_finalize() call
+ * to provide the outer HMAC hashing key.
+ *
+ * \sa tinyjambu_hmac_update(), tinyjambu_hmac_finalize()
+ */
+void tinyjambu_hmac_init
+    (tinyjambu_hmac_state_t *state, const unsigned char *key, size_t keylen);
+
+/**
+ * \brief Re-initializes an incremental HMAC state using TinyJAMBU-Hash.
+ *
+ * \param state Points to the state to be re-initialized.
+ * \param key Points to the key.
+ * \param keylen Number of bytes in the key.
  *
  * The \a key needs to be preserved until the tinyjambu_hmac_finalize() call
  * to provide the outer HMAC hashing key.
@@ -574,7 +2922,7 @@ void tinyjambu_hmac_finalize
 typedef struct
 {
     /** Private state for the PRNG.  Must be treated as opaque */
-    unsigned long long s[96 / sizeof(unsigned long long)];
+    unsigned long long s[192 / sizeof(unsigned long long)];
 
 } tinyjambu_prng_state_t;
 
@@ -585,123 +2933,443 @@ typedef struct
  * \param buf Points to the buffer to fill with random data.
  * \param size Number of bytes that are requested.
  *
- * \return The number of bytes that were returned, or zero if the
- * system random number source has failed.
+ * \return The number of bytes that were returned, or zero if the
+ * system random number source has failed.
+ *
+ * The callback should consult the system random number source
+ * to obtain \a size bytes of new entropy.  It is allowed to return
+ * less than \a size bytes but the callback should try very hard to
+ * retrieve all requested bytes.
+ */
+typedef size_t (*tinyjambu_prng_callback_t)
+    (void *user_data, unsigned char *buf, size_t size);
+
+/**
+ * \brief Initializes a TinyJAMBU-based PRNG and seeds it from the
+ * default system random number source.
+ *
+ * \param state Points to the PRNG state to be initialized.
+ * \param custom Points to a customization string to make this
+ * instantiation of the PRNG unique.
+ * \param custom_len Length of the customization string.
+ *
+ * \return Non-zero if enough data was obtained from the system random
+ * number source to seed the PRNG; or zero otherwise.
+ */
+int tinyjambu_prng_init
+    (tinyjambu_prng_state_t *state,
+     const unsigned char *custom, size_t custom_len);
+
+/**
+ * \brief Initializes a TinyJAMBU-based PRNG with a user-supplied callback
+ * to access the system random number source.
+ *
+ * \param state Points to the PRNG state to be initialized.
+ * \param callback Callback for obtaining entropy from the system
+ * random number source.
+ * \param user_data User data pointer to supply to \a callback.
+ * \param custom Points to a customization string to make this
+ * instantiation of the PRNG unique.
+ * \param custom_len Length of the customization string.
+ *
+ * \return Non-zero if enough data was obtained from the system random
+ * number source to seed the PRNG; or zero otherwise.
+ *
+ * If \a callback is NULL, then a default source will be used.
+ */
+int tinyjambu_prng_init_user
+    (tinyjambu_prng_state_t *state, tinyjambu_prng_callback_t callback,
+     void *user_data, const unsigned char *custom, size_t custom_len);
+
+/**
+ * \brief Frees a TinyJAMBU-based PRNG and destroys all sensitive material.
+ *
+ * \param state Points to the PRNG state to be freed.
+ */
+void tinyjambu_prng_free(tinyjambu_prng_state_t *state);
+
+/**
+ * \brief Generates random bytes with a TinyJAMBU-based PRNG.
+ *
+ * \param state Points to the PRNG state to be used.
+ * \param data Points to the data buffer to fill with random bytes.
+ * \param size Number of bytes to be generated.
+ *
+ * This function generates data based on the random entropy that has
+ * already been incorporated into the PRNG state.
+ *
+ * This function will automatically reseed after every 1K of output.
+ *
+ * It is recommended that tinyjambu_prng_reseed() be called regularly by
+ * the application at other times when random numbers are not needed.
+ * This will ensure that fresh entropy is mixed in regularly to improve
+ * forward security.
+ */
+void tinyjambu_prng_generate
+    (tinyjambu_prng_state_t *state, unsigned char *data, size_t size);
+
+/**
+ * \brief Generates random bytes with a TinyJAMBU-based PRNG using the
+ * Hashgen process from SP 800-90Ar1.
+ *
+ * \param state Points to the PRNG state to be used.
+ * \param data Points to the data buffer to fill with random bytes.
+ * \param size Number of bytes to be generated.
+ *
+ * tinyjambu_prng_generate() updates the internal state after every
+ * 32-byte block of output, which deviates slightly from SP 800-90Ar1.
+ * This function instead generates the output blocks Hash(V), Hash(V + 1),
+ * Hash(V + 2), etc and then updates the internal state once per request,
+ * as specified.  This is almost twice as fast for large requests.
+ *
+ * Requests larger than 64K are split into multiple requests.  Each
+ * request counts as a single block for the purposes of the limit
+ * from tinyjambu_prng_set_reseed_limit().
+ */
+void tinyjambu_prng_generate_hashgen
+    (tinyjambu_prng_state_t *state, unsigned char *data, size_t size);
+
+/**
+ * \brief Generates bulk random bytes with a TinyJAMBU-based PRNG.
+ *
+ * \param state Points to the PRNG state to be used.
+ * \param data Points to the data buffer to fill with random bytes.
+ * \param size Number of bytes to be generated.
+ *
+ * This function derives a TinyJAMBU-128 key from the PRNG state and then
+ * uses it to generate keystream with the TinyJAMBU-128 AEAD encryption
+ * process.  This is much faster than tinyjambu_prng_generate() for large
+ * amounts of data such as nonces, padding, or test data.
+ *
+ * The key is replaced with the first 16 bytes of keystream before
+ * any output is returned, so a later compromise of the state will not
+ * reveal previous output.  Every 4K of output is generated with a new key.
+ *
+ * Each 4K chunk counts as a single block for the purposes of the limit
+ * from tinyjambu_prng_set_reseed_limit().  The key is discarded and
+ * derived again after tinyjambu_prng_reseed() or tinyjambu_prng_feed().
+ */
+void tinyjambu_prng_generate_bulk
+    (tinyjambu_prng_state_t *state, unsigned char *data, size_t size);
+
+/**
+ * \brief Feeds additional data into a TinyJAMBU-based PRNG.
+ *
+ * \param state Points to the PRNG state to be used.
+ * \param data Points to the additional data to feed into the state.
+ * \param size Number of bytes to feed into the state.
+ *
+ * This function can be used to add other sources of entropy to the
+ * PRNG state.  Or to feed in serial numbers or other unique values
+ * that will make the data generated by this device different from the
+ * data generated by other devices.
+ *
+ * The PRNG is rekeyed after the data is fed in to improve forward
+ * security.  If \a size is zero, then this function will just rekey.
+ */
+void tinyjambu_prng_feed
+    (tinyjambu_prng_state_t *state, const unsigned char *data, size_t size);
+
+/**
+ * \brief Reseeds a TinyJAMBU-based PRNG from the system random number source.
+ *
+ * \param state Points to the PRNG state to be reseeded.
+ *
+ * \return Non-zero if it was possible to obtain all requested seed
+ * material from the system random number source, or zero if the request
+ * could not be accomodated.
+ */
+int tinyjambu_prng_reseed(tinyjambu_prng_state_t *state);
+
+/**
+ * \brief Sets the reseeding limit for a TinyJAMBU-based PRNG.
+ *
+ * \param state Points to the PRNG state to be updated.
+ * \param limit Number of bytes to generate, after which the PRNG
+ * will be automatically reseeded.  Maximum of 1M, default is 1K.
+ *
+ * The \a limit will be rounded up to the next block size if it is not a
+ * multiple of 32.  Setting \a limit to zero will force the PRNG to be
+ * reseeded every time tinyjambu_prng_generate() is called.
+ */
+void tinyjambu_prng_set_reseed_limit
+    (tinyjambu_prng_state_t *state, size_t limit);
+
+/**
+ * \brief Enables or disables asynchronous reseeding for a TinyJAMBU-based
+ * PRNG.
+ *
+ * \param state Points to the PRNG state to be updated.
+ * \param enable Non-zero to enable asynchronous reseeding, or zero to
+ * go back to reseeding synchronously.
+ *
+ * In asynchronous mode, the generate functions never call the entropy
+ * callback.  Instead, fresh entropy is collected ahead of time by calling
+ * tinyjambu_prng_prefetch() from a background thread or when the
+ * application is idle.  When the reseed limit is reached, the prefetched
+ * entropy is mixed into the state without blocking.  If no prefetched
+ * entropy is available, then generation continues with the current state
+ * and the reseed happens as soon as prefetched entropy becomes available.
+ *
+ * Explicit calls to tinyjambu_prng_reseed() are always synchronous.
+ */
+void tinyjambu_prng_set_async_reseed
+    (tinyjambu_prng_state_t *state, int enable);
+
+/**
+ * \brief Prefetches entropy for the next asynchronous reseed of a
+ * TinyJAMBU-based PRNG.
+ *
+ * \param state Points to the PRNG state.
+ *
+ * \return Non-zero if prefetched entropy is ready for the next reseed,
+ * or zero if the system random number source has failed.
+ *
+ * This function calls the entropy callback and expands the result with
+ * Hash_df, without reading or modifying the main PRNG state.  It may be
+ * called on a different thread to the one that is generating data.
+ * It must not be called on more than one thread at a time.
+ *
+ * If the previous prefetched entropy has not been used yet, then this
+ * function returns immediately without calling the entropy callback.
+ *
+ * \sa tinyjambu_prng_set_async_reseed()
+ */
+int tinyjambu_prng_prefetch(tinyjambu_prng_state_t *state);
+
+/**
+ * \brief Buffered front-end for a TinyJAMBU-based PRNG that makes
+ * small random draws cheaper.
+ */
+typedef struct
+{
+    /** Private state for the buffer.  Must be treated as opaque */
+    unsigned long long s[272 / sizeof(unsigned long long)];
+
+} tinyjambu_prng_buffer_t;
+
+/**
+ * \brief Initializes a buffered front-end for a TinyJAMBU-based PRNG.
+ *
+ * \param buffer Points to the buffer state to be initialized.
+ * \param prng Points to the PRNG to use to refill the buffer, which
+ * must remain valid until tinyjambu_prng_buffer_free() is called.
+ *
+ * The buffer is refilled 256 bytes at a time using
+ * tinyjambu_prng_generate_bulk().  Bytes are erased from the buffer
+ * as they are handed out.  Bytes that are already in the buffer are not
+ * affected when the PRNG is reseeded.
+ */
+void tinyjambu_prng_buffer_init
+    (tinyjambu_prng_buffer_t *buffer, tinyjambu_prng_state_t *prng);
+
+/**
+ * \brief Frees a buffered front-end for a TinyJAMBU-based PRNG and
+ * destroys all unused random data.
+ *
+ * \param buffer Points to the buffer state to be freed.
+ *
+ * The underlying PRNG is not freed.
+ */
+void tinyjambu_prng_buffer_free(tinyjambu_prng_buffer_t *buffer);
+
+/**
+ * \brief Generates random bytes from a buffered PRNG front-end.
+ *
+ * \param buffer Points to the buffer state.
+ * \param data Points to the data buffer to fill with random bytes.
+ * \param size Number of bytes to be generated.
+ */
+void tinyjambu_prng_buffer_bytes
+    (tinyjambu_prng_buffer_t *buffer, unsigned char *data, size_t size);
+
+/**
+ * \brief Generates a random 32-bit value from a buffered PRNG front-end.
+ *
+ * \param buffer Points to the buffer state.
+ *
+ * \return The random value.
+ */
+uint32_t tinyjambu_prng_buffer_u32(tinyjambu_prng_buffer_t *buffer);
+
+/**
+ * \brief Generates a random 64-bit value from a buffered PRNG front-end.
+ *
+ * \param buffer Points to the buffer state.
+ *
+ * \return The random value.
+ */
+uint64_t tinyjambu_prng_buffer_u64(tinyjambu_prng_buffer_t *buffer);
+
+/**
+ * \brief Generates a uniformly-distributed random integer in a range
+ * from a buffered PRNG front-end.
+ *
+ * \param buffer Points to the buffer state.
+ * \param bound Upper bound on the range, which is exclusive.
+ *
+ * \return A random value between 0 and \a bound - 1, or zero if
+ * \a bound is zero.
+ *
+ * The result is unbiased.  Lemire's multiply-and-reject method is used,
+ * which almost never needs more than one 32-bit draw or a division.
+ */
+uint32_t tinyjambu_prng_buffer_uniform
+    (tinyjambu_prng_buffer_t *buffer, uint32_t bound);
+
+/**
+ * \brief Generates a random double-precision value from a buffered
+ * PRNG front-end.
+ *
+ * \param buffer Points to the buffer state.
+ *
+ * \return A random value between 0 (inclusive) and 1 (exclusive)
+ * with 53 bits of precision.
+ */
+double tinyjambu_prng_buffer_double(tinyjambu_prng_buffer_t *buffer);
+
+/**
+ * \brief Randomly shuffles an array using a buffered PRNG front-end.
+ *
+ * \param buffer Points to the buffer state.
+ * \param array Points to the array to be shuffled.
+ * \param count Number of elements in the array.
+ * \param size Size of each element in bytes.
+ *
+ * The Fisher-Yates shuffle is used, which makes every permutation of
+ * the array equally likely.
+ */
+void tinyjambu_prng_buffer_shuffle
+    (tinyjambu_prng_buffer_t *buffer, void *array, size_t count, size_t size);
+
+/**
+ * \brief Generates random bytes from the process-wide random number
+ * generator.
+ *
+ * \param data Points to the data buffer to fill with random bytes.
+ * \param size Number of bytes to be generated.
+ *
+ * The process-wide generator is a convenience wrapper around the
+ * TinyJAMBU-based PRNG that saves the application from creating and
+ * reseeding its own tinyjambu_prng_state_t.
+ *
+ * On systems with POSIX threads, every thread has its own PRNG state
+ * that is seeded from the system random number source on first use.
+ * No locks are taken when generating data.  The state is re-created
+ * in the child process after fork() so that the child does not repeat
+ * the output of the parent.
+ *
+ * On systems without POSIX threads, a single global PRNG state is used
+ * and this function is not thread-safe.
  *
- * The callback should consult the system random number source
- * to obtain \a size bytes of new entropy.  It is allowed to return
- * less than \a size bytes but the callback should try very hard to
- * retrieve all requested bytes.
+ * \warning This function cannot report errors.  If the system random
+ * number source fails when the thread's state is created, then the output
+ * is predictable until a later call manages to reseed the state from the
+ * system.  Applications that must detect this should use
+ * tinyjambu_prng_init() and check its return value instead.
+ *
+ * \sa tinyjambu_random_u32()
  */
-typedef size_t (*tinyjambu_prng_callback_t)
-    (void *user_data, unsigned char *buf, size_t size);
+void tinyjambu_random_bytes(unsigned char *data, size_t size);
 
 /**
- * \brief Initializes a TinyJAMBU-based PRNG and seeds it from the
- * default system random number source.
+ * \brief Generates a random 32-bit value from the process-wide random
+ * number generator.
  *
- * \param state Points to the PRNG state to be initialized.
- * \param custom Points to a customization string to make this
- * instantiation of the PRNG unique.
- * \param custom_len Length of the customization string.
+ * \return The random value.
  *
- * \return Non-zero if enough data was obtained from the system random
- * number source to seed the PRNG; or zero otherwise.
+ * \warning The output is predictable if the system random number source
+ * has failed; see tinyjambu_random_bytes() for details.
+ *
+ * \sa tinyjambu_random_bytes()
  */
-int tinyjambu_prng_init
-    (tinyjambu_prng_state_t *state,
-     const unsigned char *custom, size_t custom_len);
+uint32_t tinyjambu_random_u32(void);
 
 /**
- * \brief Initializes a TinyJAMBU-based PRNG with a user-supplied callback
- * to access the system random number source.
- *
- * \param state Points to the PRNG state to be initialized.
- * \param callback Callback for obtaining entropy from the system
- * random number source.
- * \param user_data User data pointer to supply to \a callback.
- * \param custom Points to a customization string to make this
- * instantiation of the PRNG unique.
- * \param custom_len Length of the customization string.
+ * \brief Size of the seed for the TinyJAMBU counter-based PRNG.
+ */
+#define TINYJAMBU_CTR_PRNG_SEED_SIZE 16
+
+/**
+ * \brief State information for a TinyJAMBU counter-based PRNG stream.
+ *
+ * A counter-based PRNG produces a reproducible stream of random data
+ * from a seed and a stream identifier.  Any position in the stream can
+ * be reached in constant time, and different stream identifiers with the
+ * same seed produce independent streams.  This is intended for
+ * simulations and test data, where reproducibility is more important
+ * than forward security.  Use tinyjambu_prng_state_t for keys and nonces.
+ */
+typedef struct
+{
+    /** Private state for the PRNG.  Must be treated as opaque */
+    unsigned long long s[32 / sizeof(unsigned long long)];
+
+} tinyjambu_ctr_prng_t;
+
+/**
+ * \brief Initializes a TinyJAMBU counter-based PRNG stream.
  *
- * \return Non-zero if enough data was obtained from the system random
- * number source to seed the PRNG; or zero otherwise.
+ * \param ctx Points to the stream state to be initialized.
+ * \param seed Points to the TINYJAMBU_CTR_PRNG_SEED_SIZE bytes of the seed.
+ * \param stream Identifier for the stream.
  *
- * If \a callback is NULL, then a default source will be used.
+ * The stream starts at position zero.
  */
-int tinyjambu_prng_init_user
-    (tinyjambu_prng_state_t *state, tinyjambu_prng_callback_t callback,
-     void *user_data, const unsigned char *custom, size_t custom_len);
+void tinyjambu_ctr_prng_init
+    (tinyjambu_ctr_prng_t *ctx, const unsigned char *seed, uint64_t stream);
 
 /**
- * \brief Frees a TinyJAMBU-based PRNG and destroys all sensitive material.
+ * \brief Frees a TinyJAMBU counter-based PRNG stream.
  *
- * \param state Points to the PRNG state to be freed.
+ * \param ctx Points to the stream state to be freed.
  */
-void tinyjambu_prng_free(tinyjambu_prng_state_t *state);
+void tinyjambu_ctr_prng_free(tinyjambu_ctr_prng_t *ctx);
 
 /**
- * \brief Generates random bytes with a TinyJAMBU-based PRNG.
+ * \brief Generates random bytes from the current position of a
+ * TinyJAMBU counter-based PRNG stream.
  *
- * \param state Points to the PRNG state to be used.
+ * \param ctx Points to the stream state.
  * \param data Points to the data buffer to fill with random bytes.
  * \param size Number of bytes to be generated.
  *
- * This function generates data based on the random entropy that has
- * already been incorporated into the PRNG state.
- *
- * This function will automatically reseed after every 1K of output.
- *
- * It is recommended that tinyjambu_prng_reseed() be called regularly by
- * the application at other times when random numbers are not needed.
- * This will ensure that fresh entropy is mixed in regularly to improve
- * forward security.
+ * The position of the stream is advanced by \a size bytes.
  */
-void tinyjambu_prng_generate
-    (tinyjambu_prng_state_t *state, unsigned char *data, size_t size);
+void tinyjambu_ctr_prng_generate
+    (tinyjambu_ctr_prng_t *ctx, unsigned char *data, size_t size);
 
 /**
- * \brief Feeds additional data into a TinyJAMBU-based PRNG.
+ * \brief Generates random bytes from a specific position in a
+ * TinyJAMBU counter-based PRNG stream.
  *
- * \param state Points to the PRNG state to be used.
- * \param data Points to the additional data to feed into the state.
- * \param size Number of bytes to feed into the state.
- *
- * This function can be used to add other sources of entropy to the
- * PRNG state.  Or to feed in serial numbers or other unique values
- * that will make the data generated by this device different from the
- * data generated by other devices.
+ * \param ctx Points to the stream state, which is not modified.
+ * \param posn Byte position in the stream to start generating from.
+ * \param data Points to the data buffer to fill with random bytes.
+ * \param size Number of bytes to be generated.
  *
- * The PRNG is rekeyed after the data is fed in to improve forward
- * security.  If \a size is zero, then this function will just rekey.
+ * Because \a ctx is not modified, this function can be called on the
+ * same stream from multiple threads at once without locking.
  */
-void tinyjambu_prng_feed
-    (tinyjambu_prng_state_t *state, const unsigned char *data, size_t size);
+void tinyjambu_ctr_prng_generate_at
+    (const tinyjambu_ctr_prng_t *ctx, uint64_t posn,
+     unsigned char *data, size_t size);
 
 /**
- * \brief Reseeds a TinyJAMBU-based PRNG from the system random number source.
- *
- * \param state Points to the PRNG state to be reseeded.
+ * \brief Skips ahead in a TinyJAMBU counter-based PRNG stream.
  *
- * \return Non-zero if it was possible to obtain all requested seed
- * material from the system random number source, or zero if the request
- * could not be accomodated.
+ * \param ctx Points to the stream state.
+ * \param n Number of bytes to skip.
  */
-int tinyjambu_prng_reseed(tinyjambu_prng_state_t *state);
+void tinyjambu_ctr_prng_skip(tinyjambu_ctr_prng_t *ctx, uint64_t n);
 
 /**
- * \brief Sets the reseeding limit for a TinyJAMBU-based PRNG.
- *
- * \param state Points to the PRNG state to be updated.
- * \param limit Number of bytes to generate, after which the PRNG
- * will be automatically reseeded.  Maximum of 1M, default is 1K.
+ * \brief Sets the position of a TinyJAMBU counter-based PRNG stream.
  *
- * The \a limit will be rounded up to the next block size if it is not a
- * multiple of 32.  Setting \a limit to zero will force the PRNG to be
- * reseeded every time tinyjambu_prng_generate() is called.
+ * \param ctx Points to the stream state.
+ * \param posn Byte position of the next data to generate.
  */
-void tinyjambu_prng_set_reseed_limit
-    (tinyjambu_prng_state_t *state, size_t limit);
+void tinyjambu_ctr_prng_seek(tinyjambu_ctr_prng_t *ctx, uint64_t posn);
 
 /**
  * \brief Derives key material using TinyJAMBU-PBKDF2.
@@ -798,6 +3466,400 @@ int tinyjambu_hkdf_expand
  */
 void tinyjambu_hkdf_free(tinyjambu_hkdf_state_t *state);
 
+/**
+ * \brief State for random-access generation of key material from
+ * TinyJAMBU-KBKDF.
+ */
+typedef struct
+{
+    /** Private state for the KBKDF algorithm.  Must be treated as opaque */
+    unsigned long long s[120 / sizeof(unsigned long long)];
+
+} tinyjambu_kbkdf_state_t;
+
+/**
+ * \brief Derives key material using TinyJAMBU-KBKDF, a counter mode
+ * key derivation function based on NIST SP 800-108r1.
+ *
+ * \param out Points to the output buffer to receive the key material.
+ * \param outlen Number of bytes of key material to generate.
+ * \param key Points to the bytes of the key.
+ * \param keylen Number of bytes in the key.
+ * \param label Points to the label that identifies the purpose of
+ * the derived key material.
+ * \param labellen Number of bytes in the label.
+ * \param context Points to the context information for the derivation.
+ * \param contextlen Number of bytes in the context information.
+ *
+ * \return Zero on success or -1 if \a outlen is out of range.
+ * The maximum is (2^32 - 1) * TINYJAMBU_KBKDF_SIZE bytes.
+ *
+ * \sa tinyjambu_kbkdf_init(), tinyjambu_kbkdf_expand()
+ */
+int tinyjambu_kbkdf
+    (unsigned char *out, size_t outlen,
+     const unsigned char *key, size_t keylen,
+     const unsigned char *label, size_t labellen,
+     const unsigned char *context, size_t contextlen);
+
+/**
+ * \brief Initializes a TinyJAMBU-KBKDF state for random-access generation
+ * of key material.
+ *
+ * \param state KBKDF state to be initialized.
+ * \param key Points to the bytes of the key.
+ * \param keylen Number of bytes in the key.
+ * \param label Points to the label that identifies the purpose of
+ * the derived key material.
+ * \param labellen Number of bytes in the label.
+ * \param context Points to the context information for the derivation.
+ * \param contextlen Number of bytes in the context information.
+ * \param outlen Total number of bytes of key material that will be
+ * derived with this state.
+ *
+ * \return Zero on success or -1 if \a outlen is out of range.
+ *
+ * The \a outlen value is part of the derivation, so the same blocks
+ * will only be produced again for the same total output length.
+ *
+ * \sa tinyjambu_kbkdf_expand(), tinyjambu_kbkdf()
+ */
+int tinyjambu_kbkdf_init
+    (tinyjambu_kbkdf_state_t *state,
+     const unsigned char *key, size_t keylen,
+     const unsigned char *label, size_t labellen,
+     const unsigned char *context, size_t contextlen,
+     size_t outlen);
+
+/**
+ * \brief Generates key material from a TinyJAMBU-KBKDF state, starting at
+ * a specific output block.
+ *
+ * \param state KBKDF state to use to generate key material.
+ * \param block Index of the first output block to generate, starting at 0.
+ * \param out Points to the output buffer to receive the key material.
+ * \param outlen Number of bytes of key material to generate.
+ *
+ * \return Zero on success or -1 if the request extends past the
+ * total output length that was supplied to tinyjambu_kbkdf_init().
+ *
+ * Block \a block starts at byte offset \a block * TINYJAMBU_KBKDF_SIZE
+ * within the key material.  Each block is computed independently, so this
+ * function may be called for any block in any order.  The \a state is
+ * not modified, which allows it to be shared between multiple threads.
+ */
+int tinyjambu_kbkdf_expand
+    (const tinyjambu_kbkdf_state_t *state, unsigned long block,
+     unsigned char *out, size_t outlen);
+
+/**
+ * \brief Frees all sensitive material in a TinyJAMBU-KBKDF state.
+ *
+ * \param state Points to the KBKDF state.
+ */
+void tinyjambu_kbkdf_free(tinyjambu_kbkdf_state_t *state);
+
+/**
+ * \brief Asynchronous job that encrypts with a TinyJAMBU AEAD mode.
+ */
+#define TINYJAMBU_ASYNC_AEAD_ENCRYPT 0
+
+/**
+ * \brief Asynchronous job that decrypts with a TinyJAMBU AEAD mode.
+ */
+#define TINYJAMBU_ASYNC_AEAD_DECRYPT 1
+
+/**
+ * \brief Asynchronous job that encrypts with a TinyJAMBU SIV mode.
+ */
+#define TINYJAMBU_ASYNC_SIV_ENCRYPT 2
+
+/**
+ * \brief Asynchronous job that decrypts with a TinyJAMBU SIV mode.
+ */
+#define TINYJAMBU_ASYNC_SIV_DECRYPT 3
+
+/**
+ * \brief Asynchronous job that hashes with TinyJAMBU-Hash.
+ */
+#define TINYJAMBU_ASYNC_HASH 4
+
+/**
+ * \brief Asynchronous job that authenticates with TinyJAMBU-HMAC.
+ */
+#define TINYJAMBU_ASYNC_HMAC 5
+
+/**
+ * \brief Job for the asynchronous TinyJAMBU worker pool.
+ *
+ * The fields up to and including \a user_data are filled in by the caller
+ * before the job is submitted.  The job, and all of the buffers that it
+ * refers to, must remain valid until the job completes.
+ *
+ * The AEAD and SIV variant is selected by \a keylen, which must be 16,
+ * 24, or 32.  Encryption jobs write the ciphertext followed by the tag
+ * to \a out, and decryption jobs expect the tag at the end of \a in.
+ * Hash and HMAC jobs write TINYJAMBU_HASH_SIZE bytes to \a out.
+ */
+typedef struct tinyjambu_async_job_s
+{
+    /** Operation to perform; e.g. TINYJAMBU_ASYNC_AEAD_ENCRYPT */
+    int op;
+
+    /** Points to the key; not used for hash jobs */
+    const unsigned char *key;
+
+    /** Length of the key in bytes */
+    size_t keylen;
+
+    /** Points to the 12 bytes of the nonce for AEAD and SIV jobs */
+    const unsigned char *npub;
+
+    /** Points to the associated data for AEAD and SIV jobs */
+    const unsigned char *ad;
+
+    /** Length of the associated data in bytes */
+    size_t adlen;
+
+    /** Points to the input data */
+    const unsigned char *in;
+
+    /** Length of the input data in bytes */
+    size_t inlen;
+
+    /** Buffer that receives the output */
+    unsigned char *out;
+
+    /** User data for the completion callback */
+    void *user_data;
+
+    /** Length of the output in bytes on completion */
+    size_t outlen;
+
+    /** Result of the job on completion: 0 on success, or -1 if the
+     *  authentication tag was incorrect or the job was invalid */
+    int result;
+
+    /** Internal link for the worker pool */
+    struct tinyjambu_async_job_s *next;
+
+} tinyjambu_async_job_t;
+
+/**
+ * \brief Callback that is invoked when an asynchronous job completes.
+ *
+ * \param job The job that has completed.
+ *
+ * The callback is invoked on the worker thread that ran the job, so it
+ * must be thread-safe.  It should hand the job back to the application's
+ * event loop quickly rather than doing a lot of work itself.
+ */
+typedef void (*tinyjambu_async_callback_t)(tinyjambu_async_job_t *job);
+
+/**
+ * \brief Pool of worker threads for asynchronous TinyJAMBU jobs.
+ */
+typedef struct tinyjambu_async_pool_s tinyjambu_async_pool_t;
+
+/**
+ * \brief Creates a pool of worker threads for asynchronous jobs.
+ *
+ * \param workers Number of worker threads to create.
+ * \param max_pending Maximum number of jobs that may be outstanding at
+ * once, or zero for a default of 1024.
+ * \param callback Function to call when each job completes, or NULL
+ * to collect the completed jobs with tinyjambu_async_poll() instead.
+ *
+ * \return The new pool, or NULL if there is insufficient memory.
+ *
+ * Each worker has its own queue, and submitted jobs are distributed
+ * between the queues in turn.  A worker that runs out of jobs steals
+ * them from the other queues.
+ *
+ * If \a workers is zero, or threads are not supported on the platform,
+ * then jobs are run synchronously by tinyjambu_async_submit().
+ *
+ * \sa tinyjambu_async_submit(), tinyjambu_async_destroy()
+ */
+tinyjambu_async_pool_t *tinyjambu_async_create
+    (unsigned workers, size_t max_pending, tinyjambu_async_callback_t callback);
+
+/**
+ * \brief Destroys a pool of worker threads.
+ *
+ * \param pool The pool to destroy, which may be NULL.
+ *
+ * This function waits for all submitted jobs to complete before stopping
+ * the workers.  Completed jobs that have not been polled are abandoned.
+ */
+void tinyjambu_async_destroy(tinyjambu_async_pool_t *pool);
+
+/**
+ * \brief Submits a job to a pool of worker threads.
+ *
+ * \param pool The pool.
+ * \param job The job to submit.
+ *
+ * \return 0 if the job was submitted, or -1 if the pool already has
+ * the maximum number of outstanding jobs.
+ *
+ * A job is outstanding from when it is submitted until the completion
+ * callback returns or it is returned by tinyjambu_async_poll().  The
+ * -1 return provides backpressure; the caller should retry once some
+ * of its outstanding jobs have completed.  This function never blocks.
+ */
+int tinyjambu_async_submit
+    (tinyjambu_async_pool_t *pool, tinyjambu_async_job_t *job);
+
+/**
+ * \brief Polls a pool of worker threads for a completed job.
+ *
+ * \param pool The pool.
+ *
+ * \return The next completed job, or NULL if no jobs have completed yet.
+ * Always returns NULL if the pool has a completion callback.
+ */
+tinyjambu_async_job_t *tinyjambu_async_poll(tinyjambu_async_pool_t *pool);
+
+/**
+ * \brief Waits for a job to complete in a pool of worker threads.
+ *
+ * \param pool The pool.
+ *
+ * \return The next completed job, or NULL if there are no outstanding jobs.
+ * Always returns NULL if the pool has a completion callback.
+ */
+tinyjambu_async_job_t *tinyjambu_async_wait(tinyjambu_async_pool_t *pool);
+
+/**
+ * \brief Waits for all submitted jobs in a pool of worker threads
+ * to complete.
+ *
+ * \param pool The pool.
+ *
+ * If the pool does not have a completion callback, then the completed
+ * jobs are still available from tinyjambu_async_poll().
+ */
+void tinyjambu_async_drain(tinyjambu_async_pool_t *pool);
+
+/**
+ * \brief Gets the number of outstanding jobs in a pool of worker threads.
+ *
+ * \param pool The pool.
+ *
+ * \return The number of outstanding jobs.
+ */
+size_t tinyjambu_async_pending(tinyjambu_async_pool_t *pool);
+
+/**
+ * \brief Memory mapping of an encrypted file that decrypts each page
+ * the first time that it is accessed.
+ */
+typedef struct tinyjambu_lazymap_s tinyjambu_lazymap_t;
+
+/**
+ * \brief Recommended sector size for files that are decrypted with
+ * tinyjambu_lazymap_open().
+ *
+ * This divides the page size of all common platforms, including those
+ * with 16K or 64K pages, so files that are encrypted with this sector
+ * size can be mapped anywhere.
+ */
+#define TINYJAMBU_LAZYMAP_SECTOR_SIZE 4096
+
+/**
+ * \brief Gets the page size for lazily-decrypted memory mappings.
+ *
+ * \return The size of a memory page in bytes, or zero if lazy decryption
+ * is not supported on this platform.
+ *
+ * The page size varies between machines, so it is not suitable as the
+ * sector size of an encrypted file.  Use TINYJAMBU_LAZYMAP_SECTOR_SIZE
+ * or another sector size that divides the page size instead.
+ */
+size_t tinyjambu_lazymap_page_size(void);
+
+/**
+ * \brief Maps an encrypted file into memory and decrypts its pages on
+ * demand.
+ *
+ * \param fd File descriptor for the encrypted file, which must support
+ * pread().  The file is not closed by tinyjambu_lazymap_close().
+ * \param length Length of the plaintext in bytes.  The file contains
+ * the ciphertext for a whole number of sectors, with the plaintext padded
+ * out to the end of the last sector.
+ * \param tags Points to the 8 byte authentication tag for each sector,
+ * which must remain valid until the mapping is closed.
+ * \param sector_size Size of each sector in the file, which must be a
+ * multiple of 4 that divides the page size.
+ * \param k Points to the 16 bytes of the key.
+ * \param readahead Maximum number of pages to decrypt in advance when
+ * the pages are accessed sequentially, or zero for a default of 32.
+ *
+ * \return The mapping, or NULL if lazy decryption is not supported,
+ * \a sector_size is not valid for this platform's page size, or the
+ * mapping could not be created.
+ *
+ * The file must be encrypted with tinyjambu_128_siv_encrypt_sectors()
+ * using \a sector_size and zero as the first sector number.  The sector
+ * size is not recorded in the file, so the application must use the
+ * same value when encrypting and mapping the file.
+ *
+ * On Linux, the mapping is backed by userfaultfd.  A helper thread reads,
+ * verifies, and decrypts the sectors of each page when it is first
+ * touched.  When pages are touched in order, the number of pages that are
+ * decrypted ahead of the access is doubled on every fault, up to
+ * \a readahead.
+ *
+ * If any sector of a page fails to authenticate, then the page is made
+ * inaccessible and the thread that touched it receives SIGSEGV.
+ * Plaintext from a page that has been tampered with is never made visible.
+ *
+ * If the process can only use userfaultfd for user-mode faults, then
+ * pages must be touched before being passed to system calls such
+ * as write().
+ */
+tinyjambu_lazymap_t *tinyjambu_lazymap_open
+    (int fd, size_t length, const unsigned char *tags, size_t sector_size,
+     const unsigned char *k, size_t readahead);
+
+/**
+ * \brief Gets a pointer to the plaintext of a lazily-decrypted mapping.
+ *
+ * \param map The mapping.
+ *
+ * \return Pointer to the start of the plaintext.
+ */
+const void *tinyjambu_lazymap_data(const tinyjambu_lazymap_t *map);
+
+/**
+ * \brief Determine if any page of a lazily-decrypted mapping has failed
+ * to read or authenticate.
+ *
+ * \param map The mapping.
+ *
+ * \return Non-zero if a page has failed, or zero otherwise.
+ */
+int tinyjambu_lazymap_failed(tinyjambu_lazymap_t *map);
+
+/**
+ * \brief Gets the number of pages that have been decrypted for a
+ * lazily-decrypted mapping.
+ *
+ * \param map The mapping.
+ *
+ * \return The number of pages that have been decrypted so far,
+ * including pages that were read ahead.
+ */
+size_t tinyjambu_lazymap_pages_decrypted(tinyjambu_lazymap_t *map);
+
+/**
+ * \brief Closes a lazily-decrypted mapping and destroys the plaintext.
+ *
+ * \param map The mapping to close, which may be NULL.
+ */
+void tinyjambu_lazymap_close(tinyjambu_lazymap_t *map);
+
 /**
  * \brief Cleans a buffer that contains sensitive material.
  *
@@ -21,6 +21,7 @@
  */
 
 #include "tinyjambu-aead-common.h"
+#include <string.h>
 
 void tinyjambu_setup_128
     (tinyjambu_128_state_t *state, const unsigned char *nonce,
@@ -85,3 +86,185 @@ void tinyjambu_generate_tag_128
     tinyjambu_permutation_128(state, TINYJAMBU_ROUNDS(640));
     le_store_word32(tag + 4, tinyjambu_squeeze(state));
 }
+
+void tinyjambu_setup_128_x4
+    (tinyjambu_128_state_t states[4], const tinyjambu_128_state_t *key,
+     const unsigned char *nonces, const unsigned char domains[4])
+{
+    unsigned lane, word;
+
+    /* The key permutation is the same for every state */
+    memcpy(states[0].k, key->k, sizeof(key->k));
+    tinyjambu_init_state(&(states[0]));
+    tinyjambu_permutation_128(&(states[0]), TINYJAMBU_ROUNDS(1024));
+    for (lane = 1; lane < 4; ++lane)
+        states[lane] = states[0];
+
+    /* Absorb the three 32-bit words of each state's nonce */
+    for (word = 0; word < 3; ++word) {
+        for (lane = 0; lane < 4; ++lane)
+            tinyjambu_add_domain(&(states[lane]), domains[lane]);
+        tinyjambu_permutation_128_x4(states, TINYJAMBU_ROUNDS(640));
+        for (lane = 0; lane < 4; ++lane) {
+            tinyjambu_absorb
+                (&(states[lane]), le_load_word32
+                    (nonces + lane * 12 + word * 4));
+        }
+    }
+}
+
+void tinyjambu_absorb_128_x4
+    (tinyjambu_128_state_t states[4], const unsigned char * const data[4],
+     size_t size, unsigned char domain, unsigned rounds)
+{
+    size_t posn;
+    unsigned lane;
+    for (posn = 0; posn < size; posn += 4) {
+        for (lane = 0; lane < 4; ++lane)
+            tinyjambu_add_domain(&(states[lane]), domain);
+        tinyjambu_permutation_128_x4(states, rounds);
+        for (lane = 0; lane < 4; ++lane)
+            tinyjambu_absorb
+                (&(states[lane]), le_load_word32(data[lane] + posn));
+    }
+}
+
+void tinyjambu_generate_tag_128_x4
+    (tinyjambu_128_state_t states[4], unsigned char *tags)
+{
+    unsigned lane;
+    for (lane = 0; lane < 4; ++lane)
+        tinyjambu_add_domain(&(states[lane]), 0x70);
+    tinyjambu_permutation_128_x4(states, TINYJAMBU_ROUNDS(1024));
+    for (lane = 0; lane < 4; ++lane) {
+        le_store_word32(tags + lane * 8,
+                        tinyjambu_squeeze(&(states[lane])));
+        tinyjambu_add_domain(&(states[lane]), 0x70);
+    }
+    tinyjambu_permutation_128_x4(states, TINYJAMBU_ROUNDS(640));
+    for (lane = 0; lane < 4; ++lane)
+        le_store_word32(tags + lane * 8 + 4,
+                        tinyjambu_squeeze(&(states[lane])));
+}
+
+void tinyjambu_siv_setup_128
+    (tinyjambu_128_state_t *state, const unsigned char *npub,
+     const unsigned char *tag)
+{
+    /* The new nonce is the first 32 bits of the original nonce
+     * followed by the 64 bits of the authentication tag */
+    unsigned char nonce[12];
+    memcpy(nonce, npub, 4);
+    memcpy(nonce + 4, tag, 8);
+    tinyjambu_setup_128(state, nonce, 0xB0);
+}
+
+void tinyjambu_siv_encrypt_128
+    (tinyjambu_128_state_t *state, unsigned char *c,
+     const unsigned char *m, size_t mlen)
+{
+    uint32_t data;
+    while (mlen >= 4) {
+        tinyjambu_add_domain(state, 0xD0); /* Domain sep for message data */
+        tinyjambu_permutation_128(state, TINYJAMBU_ROUNDS(1024));
+        data = le_load_word32(m);
+        data ^= tinyjambu_squeeze(state);
+        le_store_word32(c, data);
+        c += 4;
+        m += 4;
+        mlen -= 4;
+    }
+    if (mlen > 0) {
+        tinyjambu_add_domain(state, 0xD0);
+        tinyjambu_permutation_128(state, TINYJAMBU_ROUNDS(1024));
+        data = tinyjambu_squeeze(state);
+        c[0] = m[0] ^ (uint8_t)data;
+        if (mlen > 1)
+            c[1] = m[1] ^ (uint8_t)(data >> 8);
+        if (mlen > 2)
+            c[2] = m[2] ^ (uint8_t)(data >> 16);
+    }
+}
+
+void tinyjambu_siv_encrypt_128_x4
+    (tinyjambu_128_state_t states[4], unsigned char *c,
+     const unsigned char *m, size_t size)
+{
+    size_t posn;
+    unsigned lane;
+    for (posn = 0; posn < size; posn += 4) {
+        for (lane = 0; lane < 4; ++lane)
+            tinyjambu_add_domain(&(states[lane]), 0xD0);
+        tinyjambu_permutation_128_x4(states, TINYJAMBU_ROUNDS(1024));
+        for (lane = 0; lane < 4; ++lane) {
+            le_store_word32
+                (c + lane * size + posn,
+                 le_load_word32(m + lane * size + posn) ^
+                    tinyjambu_squeeze(&(states[lane])));
+        }
+    }
+}
+
+void tinyjambu_siv_decrypt_128
+    (tinyjambu_128_state_t *state, tinyjambu_128_state_t *auth,
+     unsigned char *m, const unsigned char *c, size_t clen)
+{
+    uint32_t data;
+
+    /* The two states are independent until the plaintext word is
+     * absorbed, so the permutations can be interleaved */
+    while (clen >= 4) {
+        tinyjambu_add_domain(state, 0xD0); /* Domain sep for message data */
+        tinyjambu_add_domain(auth, 0x50);
+        tinyjambu_permutation_128_x2(state, auth, TINYJAMBU_ROUNDS(1024));
+        data = le_load_word32(c) ^ tinyjambu_squeeze(state);
+        tinyjambu_absorb(auth, data);
+        le_store_word32(m, data);
+        c += 4;
+        m += 4;
+        clen -= 4;
+    }
+    if (clen > 0) {
+        tinyjambu_add_domain(state, 0xD0);
+        tinyjambu_add_domain(auth, 0x50);
+        tinyjambu_permutation_128_x2(state, auth, TINYJAMBU_ROUNDS(1024));
+        if (clen == 1) {
+            data = (c[0] ^ tinyjambu_squeeze(state)) & 0xFFU;
+            m[0] = (uint8_t)data;
+        } else if (clen == 2) {
+            data = (le_load_word16(c) ^ tinyjambu_squeeze(state)) & 0xFFFFU;
+            m[0] = (uint8_t)data;
+            m[1] = (uint8_t)(data >> 8);
+        } else {
+            data = le_load_word16(c) | (((uint32_t)(c[2])) << 16);
+            data = (data ^ tinyjambu_squeeze(state)) & 0xFFFFFFU;
+            m[0] = (uint8_t)data;
+            m[1] = (uint8_t)(data >> 8);
+            m[2] = (uint8_t)(data >> 16);
+        }
+        tinyjambu_absorb(auth, data);
+        tinyjambu_add_domain(auth, (uint32_t)clen);
+    }
+}
+
+void tinyjambu_siv_decrypt_128_x2
+    (tinyjambu_128_state_t states[4], unsigned char *m,
+     const unsigned char *c, size_t size)
+{
+    uint32_t data;
+    size_t posn;
+    unsigned lane;
+    for (posn = 0; posn < size; posn += 4) {
+        for (lane = 0; lane < 4; lane += 2) {
+            tinyjambu_add_domain(&(states[lane]), 0xD0);
+            tinyjambu_add_domain(&(states[lane + 1]), 0x50);
+        }
+        tinyjambu_permutation_128_x4(states, TINYJAMBU_ROUNDS(1024));
+        for (lane = 0; lane < 4; lane += 2) {
+            data = le_load_word32(c + (lane / 2) * size + posn) ^
+                   tinyjambu_squeeze(&(states[lane]));
+            tinyjambu_absorb(&(states[lane + 1]), data);
+            le_store_word32(m + (lane / 2) * size + posn, data);
+        }
+    }
+}
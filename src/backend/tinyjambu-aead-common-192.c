@@ -21,6 +21,7 @@
  */
 
 #include "tinyjambu-aead-common.h"
+#include <string.h>
 
 void tinyjambu_setup_192
     (tinyjambu_192_state_t *state, const unsigned char *nonce,
@@ -85,3 +86,84 @@ void tinyjambu_generate_tag_192
     tinyjambu_permutation_192(state, TINYJAMBU_ROUNDS(640));
     le_store_word32(tag + 4, tinyjambu_squeeze(state));
 }
+
+void tinyjambu_siv_setup_192
+    (tinyjambu_192_state_t *state, const unsigned char *npub,
+     const unsigned char *tag)
+{
+    /* The new nonce is the first 32 bits of the original nonce
+     * followed by the 64 bits of the authentication tag */
+    unsigned char nonce[12];
+    memcpy(nonce, npub, 4);
+    memcpy(nonce + 4, tag, 8);
+    tinyjambu_setup_192(state, nonce, 0xB0);
+}
+
+void tinyjambu_siv_encrypt_192
+    (tinyjambu_192_state_t *state, unsigned char *c,
+     const unsigned char *m, size_t mlen)
+{
+    uint32_t data;
+    while (mlen >= 4) {
+        tinyjambu_add_domain(state, 0xD0); /* Domain sep for message data */
+        tinyjambu_permutation_192(state, TINYJAMBU_ROUNDS(1152));
+        data = le_load_word32(m);
+        data ^= tinyjambu_squeeze(state);
+        le_store_word32(c, data);
+        c += 4;
+        m += 4;
+        mlen -= 4;
+    }
+    if (mlen > 0) {
+        tinyjambu_add_domain(state, 0xD0);
+        tinyjambu_permutation_192(state, TINYJAMBU_ROUNDS(1152));
+        data = tinyjambu_squeeze(state);
+        c[0] = m[0] ^ (uint8_t)data;
+        if (mlen > 1)
+            c[1] = m[1] ^ (uint8_t)(data >> 8);
+        if (mlen > 2)
+            c[2] = m[2] ^ (uint8_t)(data >> 16);
+    }
+}
+
+void tinyjambu_siv_decrypt_192
+    (tinyjambu_192_state_t *state, tinyjambu_192_state_t *auth,
+     unsigned char *m, const unsigned char *c, size_t clen)
+{
+    uint32_t data;
+
+    /* The two states are independent until the plaintext word is
+     * absorbed, so the permutations can be interleaved */
+    while (clen >= 4) {
+        tinyjambu_add_domain(state, 0xD0); /* Domain sep for message data */
+        tinyjambu_add_domain(auth, 0x50);
+        tinyjambu_permutation_192_x2(state, auth, TINYJAMBU_ROUNDS(1152));
+        data = le_load_word32(c) ^ tinyjambu_squeeze(state);
+        tinyjambu_absorb(auth, data);
+        le_store_word32(m, data);
+        c += 4;
+        m += 4;
+        clen -= 4;
+    }
+    if (clen > 0) {
+        tinyjambu_add_domain(state, 0xD0);
+        tinyjambu_add_domain(auth, 0x50);
+        tinyjambu_permutation_192_x2(state, auth, TINYJAMBU_ROUNDS(1152));
+        if (clen == 1) {
+            data = (c[0] ^ tinyjambu_squeeze(state)) & 0xFFU;
+            m[0] = (uint8_t)data;
+        } else if (clen == 2) {
+            data = (le_load_word16(c) ^ tinyjambu_squeeze(state)) & 0xFFFFU;
+            m[0] = (uint8_t)data;
+            m[1] = (uint8_t)(data >> 8);
+        } else {
+            data = le_load_word16(c) | (((uint32_t)(c[2])) << 16);
+            data = (data ^ tinyjambu_squeeze(state)) & 0xFFFFFFU;
+            m[0] = (uint8_t)data;
+            m[1] = (uint8_t)(data >> 8);
+            m[2] = (uint8_t)(data >> 16);
+        }
+        tinyjambu_absorb(auth, data);
+        tinyjambu_add_domain(auth, (uint32_t)clen);
+    }
+}
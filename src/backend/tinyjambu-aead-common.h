@@ -30,6 +30,16 @@
 extern "C" {
 #endif
 
+/**
+ * \brief Private state information for a pre-computed TinyJAMBU-128 key.
+ */
+typedef struct
+{
+    /** State after the key setup permutation, and the inverted key */
+    tinyjambu_128_state_t init;
+
+} tinyjambu_128_key_p_t;
+
 /**
  * \brief Set up the TinyJAMBU-128 state with the key and the nonce.
  *
@@ -63,6 +73,119 @@ void tinyjambu_absorb_128
 void tinyjambu_generate_tag_128
     (tinyjambu_128_state_t *state, unsigned char *tag);
 
+/**
+ * \brief Set up four TinyJAMBU-128 states with a shared key and
+ * individual nonces.
+ *
+ * \param states The four states to set up.
+ * \param key State containing the key words; the rest is ignored.
+ * \param nonces Points to four 96-bit nonces, one after the other.
+ * \param domains Domain separator values for the nonce of each state.
+ *
+ * The result is the same as calling tinyjambu_setup_128() on each state,
+ * but the key permutation is only performed once.
+ */
+void tinyjambu_setup_128_x4
+    (tinyjambu_128_state_t states[4], const tinyjambu_128_state_t *key,
+     const unsigned char *nonces, const unsigned char domains[4]);
+
+/**
+ * \brief Absorbs whole words of data into four TinyJAMBU-128 states.
+ *
+ * \param states The four states to absorb into.
+ * \param data Points to the data to absorb into each state.
+ * \param size Number of bytes to absorb into each state, which must be
+ * a multiple of 4.
+ * \param domain Domain separator value for the absorb operation.
+ * \param rounds Number of TinyJAMBU rounds to perform.
+ */
+void tinyjambu_absorb_128_x4
+    (tinyjambu_128_state_t states[4], const unsigned char * const data[4],
+     size_t size, unsigned char domain, unsigned rounds);
+
+/**
+ * \brief Generates the final authentication tags for four TinyJAMBU-128
+ * states.
+ *
+ * \param states The four states to generate tags for.
+ * \param tags Buffer to receive the four tags, one after the other.
+ */
+void tinyjambu_generate_tag_128_x4
+    (tinyjambu_128_state_t states[4], unsigned char *tags);
+
+/**
+ * \brief Sets up the TinyJAMBU-128 state for the encryption pass of SIV.
+ *
+ * \param state TinyJAMBU state containing the key.
+ * \param npub Points to the original nonce; only the first 32 bits are used.
+ * \param tag Points to the authentication tag from the first pass.
+ */
+void tinyjambu_siv_setup_128
+    (tinyjambu_128_state_t *state, const unsigned char *npub,
+     const unsigned char *tag);
+
+/**
+ * \brief Performs the encryption pass of TinyJAMBU-128-SIV.
+ *
+ * \param state TinyJAMBU state that was prepared with
+ * tinyjambu_siv_setup_128().
+ * \param c Buffer to receive the ciphertext.
+ * \param m Points to the plaintext to be encrypted.
+ * \param mlen Length of the plaintext in bytes.
+ */
+void tinyjambu_siv_encrypt_128
+    (tinyjambu_128_state_t *state, unsigned char *c,
+     const unsigned char *m, size_t mlen);
+
+/**
+ * \brief Performs the encryption pass of TinyJAMBU-128-SIV on four
+ * blocks of data at once.
+ *
+ * \param states Four states that were prepared for the encryption pass.
+ * \param c Buffer to receive the four blocks of ciphertext.
+ * \param m Points to the four blocks of plaintext.
+ * \param size Size of each block in bytes, which must be a multiple of 4.
+ *
+ * The blocks are laid out one after the other, \a size bytes apart.
+ */
+void tinyjambu_siv_encrypt_128_x4
+    (tinyjambu_128_state_t states[4], unsigned char *c,
+     const unsigned char *m, size_t size);
+
+/**
+ * \brief Decrypts the ciphertext for TinyJAMBU-128-SIV and authenticates
+ * the plaintext in a single pass.
+ *
+ * \param state TinyJAMBU state that was prepared with
+ * tinyjambu_siv_setup_128().
+ * \param auth TinyJAMBU state for the authentication pass, which has
+ * already absorbed the nonce and the associated data.
+ * \param m Buffer to receive the plaintext.
+ * \param c Points to the ciphertext to be decrypted.
+ * \param clen Length of the ciphertext in bytes.
+ *
+ * The caller generates the tag from \a auth afterwards.
+ */
+void tinyjambu_siv_decrypt_128
+    (tinyjambu_128_state_t *state, tinyjambu_128_state_t *auth,
+     unsigned char *m, const unsigned char *c, size_t clen);
+
+/**
+ * \brief Decrypts and authenticates two blocks of TinyJAMBU-128-SIV
+ * ciphertext at once.
+ *
+ * \param states Four states: lanes 0 and 2 were prepared for the
+ * encryption pass and lanes 1 and 3 for the authentication pass.
+ * \param m Buffer to receive the two blocks of plaintext.
+ * \param c Points to the two blocks of ciphertext.
+ * \param size Size of each block in bytes, which must be a multiple of 4.
+ *
+ * The caller generates the tags from lanes 1 and 3 afterwards.
+ */
+void tinyjambu_siv_decrypt_128_x2
+    (tinyjambu_128_state_t states[4], unsigned char *m,
+     const unsigned char *c, size_t size);
+
 /**
  * \brief Set up the TinyJAMBU-192 state with the key and the nonce.
  *
@@ -96,6 +219,49 @@ void tinyjambu_absorb_192
 void tinyjambu_generate_tag_192
     (tinyjambu_192_state_t *state, unsigned char *tag);
 
+/**
+ * \brief Sets up the TinyJAMBU-192 state for the encryption pass of SIV.
+ *
+ * \param state TinyJAMBU state containing the key.
+ * \param npub Points to the original nonce; only the first 32 bits are used.
+ * \param tag Points to the authentication tag from the first pass.
+ */
+void tinyjambu_siv_setup_192
+    (tinyjambu_192_state_t *state, const unsigned char *npub,
+     const unsigned char *tag);
+
+/**
+ * \brief Performs the encryption pass of TinyJAMBU-192-SIV.
+ *
+ * \param state TinyJAMBU state that was prepared with
+ * tinyjambu_siv_setup_192().
+ * \param c Buffer to receive the ciphertext.
+ * \param m Points to the plaintext to be encrypted.
+ * \param mlen Length of the plaintext in bytes.
+ */
+void tinyjambu_siv_encrypt_192
+    (tinyjambu_192_state_t *state, unsigned char *c,
+     const unsigned char *m, size_t mlen);
+
+/**
+ * \brief Decrypts the ciphertext for TinyJAMBU-192-SIV and authenticates
+ * the plaintext in a single pass.
+ *
+ * \param state TinyJAMBU state that was prepared with
+ * tinyjambu_siv_setup_192().
+ * \param auth TinyJAMBU state for the authentication pass, which has
+ * already absorbed the nonce and the associated data.
+ * \param m Buffer to receive the plaintext.
+ * \param c Points to the ciphertext to be decrypted.
+ * \param clen Length of the ciphertext in bytes.
+ *
+ * The caller generates the tag from \a auth afterwards.
+ */
+void tinyjambu_siv_decrypt_192
+    (tinyjambu_192_state_t *state, tinyjambu_192_state_t *auth,
+     unsigned char *m, const unsigned char *c, size_t clen);
+
+
 /**
  * \brief Set up the TinyJAMBU-256 state with the key and the nonce.
  *
@@ -129,6 +295,49 @@ void tinyjambu_absorb_256
 void tinyjambu_generate_tag_256
     (tinyjambu_256_state_t *state, unsigned char *tag);
 
+/**
+ * \brief Sets up the TinyJAMBU-256 state for the encryption pass of SIV.
+ *
+ * \param state TinyJAMBU state containing the key.
+ * \param npub Points to the original nonce; only the first 32 bits are used.
+ * \param tag Points to the authentication tag from the first pass.
+ */
+void tinyjambu_siv_setup_256
+    (tinyjambu_256_state_t *state, const unsigned char *npub,
+     const unsigned char *tag);
+
+/**
+ * \brief Performs the encryption pass of TinyJAMBU-256-SIV.
+ *
+ * \param state TinyJAMBU state that was prepared with
+ * tinyjambu_siv_setup_256().
+ * \param c Buffer to receive the ciphertext.
+ * \param m Points to the plaintext to be encrypted.
+ * \param mlen Length of the plaintext in bytes.
+ */
+void tinyjambu_siv_encrypt_256
+    (tinyjambu_256_state_t *state, unsigned char *c,
+     const unsigned char *m, size_t mlen);
+
+/**
+ * \brief Decrypts the ciphertext for TinyJAMBU-256-SIV and authenticates
+ * the plaintext in a single pass.
+ *
+ * \param state TinyJAMBU state that was prepared with
+ * tinyjambu_siv_setup_256().
+ * \param auth TinyJAMBU state for the authentication pass, which has
+ * already absorbed the nonce and the associated data.
+ * \param m Buffer to receive the plaintext.
+ * \param c Points to the ciphertext to be decrypted.
+ * \param clen Length of the ciphertext in bytes.
+ *
+ * The caller generates the tag from \a auth afterwards.
+ */
+void tinyjambu_siv_decrypt_256
+    (tinyjambu_256_state_t *state, tinyjambu_256_state_t *auth,
+     unsigned char *m, const unsigned char *c, size_t clen);
+
+
 #ifdef __cplusplus
 }
 #endif
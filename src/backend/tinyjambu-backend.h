@@ -154,6 +154,53 @@ void tinyjambu_permutation_192(tinyjambu_192_state_t *state, unsigned rounds);
  */
 void tinyjambu_permutation_256(tinyjambu_256_state_t *state, unsigned rounds);
 
+/**
+ * \brief Perform the TinyJAMBU-128 permutation on two independent states.
+ *
+ * \param state1 First TinyJAMBU-128 state to be permuted, including the key.
+ * \param state2 Second TinyJAMBU-128 state to be permuted, including the key.
+ * \param rounds The number of rounds to perform on both states.
+ *
+ * The two states may have different keys.  On backends that support it,
+ * the steps of the two permutations are interleaved for better
+ * instruction-level parallelism.
+ */
+void tinyjambu_permutation_128_x2
+    (tinyjambu_128_state_t *state1, tinyjambu_128_state_t *state2,
+     unsigned rounds);
+
+/**
+ * \brief Perform the TinyJAMBU-128 permutation on four independent states.
+ *
+ * \param states Array of four TinyJAMBU-128 states to be permuted,
+ * each of which includes its own key.
+ * \param rounds The number of rounds to perform on all states.
+ */
+void tinyjambu_permutation_128_x4
+    (tinyjambu_128_state_t states[4], unsigned rounds);
+
+/**
+ * \brief Perform the TinyJAMBU-192 permutation on two independent states.
+ *
+ * \param state1 First TinyJAMBU-192 state to be permuted, including the key.
+ * \param state2 Second TinyJAMBU-192 state to be permuted, including the key.
+ * \param rounds The number of rounds to perform on both states.
+ */
+void tinyjambu_permutation_192_x2
+    (tinyjambu_192_state_t *state1, tinyjambu_192_state_t *state2,
+     unsigned rounds);
+
+/**
+ * \brief Perform the TinyJAMBU-256 permutation on two independent states.
+ *
+ * \param state1 First TinyJAMBU-256 state to be permuted, including the key.
+ * \param state2 Second TinyJAMBU-256 state to be permuted, including the key.
+ * \param rounds The number of rounds to perform on both states.
+ */
+void tinyjambu_permutation_256_x2
+    (tinyjambu_256_state_t *state1, tinyjambu_256_state_t *state2,
+     unsigned rounds);
+
 /* Note: The last line should contain ~(t2 & t3) according to the
  * specification but we can avoid the NOT by inverting the words
  * of the key ahead of time. */
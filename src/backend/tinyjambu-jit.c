@@ -0,0 +1,596 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#if defined(HAVE_CONFIG_H)
+#include <config.h>
+#endif
+#include "tinyjambu-jit.h"
+#include "TinyJAMBU.h"
+#include <string.h>
+#if defined(__x86_64__) && !defined(_WIN32) && !defined(TINYJAMBU_NO_JIT) && \
+        defined(HAVE_SYS_MMAN_H) && defined(HAVE_UNISTD_H)
+#include <sys/mman.h>
+#include <unistd.h>
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#if defined(MAP_ANONYMOUS)
+#define TINYJAMBU_JIT_X86_64 1
+#endif
+#endif
+
+/* Runs the permutation using the portable backend */
+static void tinyjambu_jit_portable_permute
+    (const tinyjambu_jit_ctx_t *ctx, uint32_t *s, unsigned rounds)
+{
+    if (ctx->key_words == 4) {
+        tinyjambu_128_state_t state;
+        memcpy(state.s, s, sizeof(state.s));
+        memcpy(state.k, ctx->k, sizeof(state.k));
+        tinyjambu_permutation_128(&state, rounds);
+        memcpy(s, state.s, sizeof(state.s));
+    } else if (ctx->key_words == 6) {
+        tinyjambu_192_state_t state;
+        memcpy(state.s, s, sizeof(state.s));
+        memcpy(state.k, ctx->k, sizeof(state.k));
+        tinyjambu_permutation_192(&state, rounds);
+        memcpy(s, state.s, sizeof(state.s));
+    } else {
+        tinyjambu_256_state_t state;
+        memcpy(state.s, s, sizeof(state.s));
+        memcpy(state.k, ctx->k, sizeof(state.k));
+        tinyjambu_permutation_256(&state, rounds);
+        memcpy(s, state.s, sizeof(state.s));
+    }
+}
+
+#if defined(TINYJAMBU_JIT_X86_64)
+
+/*
+ * The generated code keeps the four state words in registers and runs
+ * the permutation as straight-line code, 32 steps at a time, with the
+ * inverted key words encoded as immediate operands.  This removes the
+ * loads of the key words from memory on every group of steps and frees
+ * up the registers that would otherwise hold them.  Each group of 32
+ * steps for the words (s0, s1, s2, s3) and key word k is:
+ *
+ *      xor     s0, k
+ *      mov     t1, s1
+ *      shrd    t1, s2, 15
+ *      xor     s0, t1              ; s0 ^= (s1 >> 15) | (s2 << 17)
+ *      mov     t2, s3
+ *      shl     t2q, 32
+ *      or      t2q, s2q            ; t2q = (s3 << 32) | s2
+ *      mov     t1q, t2q
+ *      shr     t1q, 27
+ *      xor     s0, t1              ; s0 ^= (s2 >> 27) | (s3 << 5)
+ *      mov     t1q, t2q
+ *      shr     t1q, 6              ; t1 = (s2 >> 6) | (s3 << 26)
+ *      shr     t2q, 21             ; t2 = (s2 >> 21) | (s3 << 11)
+ *      and     t1, t2
+ *      xor     s0, t1
+ *
+ * s3 is the word that was updated by the previous group, so it is
+ * combined with s2 into a 64-bit register once and then the three terms
+ * that depend upon it are extracted with single 64-bit shifts.  The
+ * upper halves of the state registers are always zero because every
+ * instruction that writes to them is a 32-bit operation.  The term that
+ * does not depend upon s3 uses "shrd", which has a longer latency but
+ * is off the critical path from one group to the next.
+ *
+ * The message kernels fuse the loop over the words of the message with
+ * the permutation so that the state stays in registers from the first
+ * word to the last.  All kernels use the System V calling convention.
+ *
+ * The code is generated into a private anonymous mapping that is
+ * writable but not executable, and then the mapping is switched to
+ * executable but not writable before it is used.  x86-64 keeps the
+ * instruction cache coherent with data writes, so no explicit flush
+ * is required.  If either step fails, for example because the system
+ * security policy forbids executable mappings, then the key context
+ * falls back to the portable backend.
+ */
+
+/* Register numbers in the x86-64 instruction encoding */
+#define JIT_RAX 0
+#define JIT_RCX 1
+#define JIT_RDX 2
+#define JIT_RBX 3
+#define JIT_RBP 5
+#define JIT_RSI 6
+#define JIT_RDI 7
+#define JIT_R9  9
+#define JIT_R10 10
+#define JIT_R11 11
+
+/* Register assignments for the state words and temporaries */
+#define JIT_S0 JIT_RAX
+#define JIT_S1 JIT_RBX
+#define JIT_S2 JIT_RBP
+#define JIT_S3 JIT_R9
+#define JIT_T1 JIT_R10
+#define JIT_T2 JIT_R11
+
+/* Opcodes for "op r/m, reg" instructions */
+#define JIT_OP_MOV 0x89
+#define JIT_OP_XOR 0x31
+#define JIT_OP_AND 0x21
+#define JIT_OP_OR  0x09
+
+/* Opcode extensions for "shl r/m64, imm8" and "shr r/m64, imm8" */
+#define JIT_SHL 4
+#define JIT_SHR 5
+
+/* Kinds of message kernel */
+#define JIT_KERNEL_ABSORB 0
+#define JIT_KERNEL_ENCRYPT 1
+#define JIT_KERNEL_DECRYPT 2
+
+/* Alignment for the start of each kernel */
+#define JIT_ALIGN 16
+
+/**
+ * \brief Output buffer for the code generator.
+ *
+ * If \a buf is NULL, then the code is measured but not written.
+ */
+typedef struct
+{
+    unsigned char *buf;     /**< Buffer to write the code to */
+    size_t posn;            /**< Current position in the buffer */
+
+} tinyjambu_jit_emit_t;
+
+/* Emits a single byte of code */
+static void jit_byte(tinyjambu_jit_emit_t *e, unsigned char b)
+{
+    if (e->buf)
+        e->buf[e->posn] = b;
+    ++(e->posn);
+}
+
+/* Emits a 32-bit little-endian value */
+static void jit_word32(tinyjambu_jit_emit_t *e, uint32_t value)
+{
+    jit_byte(e, (unsigned char)value);
+    jit_byte(e, (unsigned char)(value >> 8));
+    jit_byte(e, (unsigned char)(value >> 16));
+    jit_byte(e, (unsigned char)(value >> 24));
+}
+
+/* Emits a REX prefix for the "reg" and "r/m" fields if one is needed */
+static void jit_rex
+    (tinyjambu_jit_emit_t *e, int wide, unsigned reg, unsigned rm)
+{
+    unsigned char rex = 0x40;
+    if (wide)
+        rex |= 0x08;
+    if (reg & 8)
+        rex |= 0x04;
+    if (rm & 8)
+        rex |= 0x01;
+    if (rex != 0x40)
+        jit_byte(e, rex);
+}
+
+/* Emits "op dst, src" for 32-bit registers */
+static void jit_op_rr
+    (tinyjambu_jit_emit_t *e, unsigned char op, unsigned dst, unsigned src)
+{
+    jit_rex(e, 0, src, dst);
+    jit_byte(e, op);
+    jit_byte(e, 0xC0 | ((src & 7) << 3) | (dst & 7));
+}
+
+/* Emits "op dst, src" for 64-bit registers */
+static void jit_op_rr64
+    (tinyjambu_jit_emit_t *e, unsigned char op, unsigned dst, unsigned src)
+{
+    jit_rex(e, 1, src, dst);
+    jit_byte(e, op);
+    jit_byte(e, 0xC0 | ((src & 7) << 3) | (dst & 7));
+}
+
+/* Emits "shl dst, shift" or "shr dst, shift" for a 64-bit register */
+static void jit_shift64
+    (tinyjambu_jit_emit_t *e, unsigned op, unsigned dst, unsigned shift)
+{
+    jit_rex(e, 1, 0, dst);
+    jit_byte(e, 0xC1);
+    jit_byte(e, 0xC0 | (op << 3) | (dst & 7));
+    jit_byte(e, (unsigned char)shift);
+}
+
+/* Emits "shrd dst, src, shift" for 32-bit registers */
+static void jit_shrd
+    (tinyjambu_jit_emit_t *e, unsigned dst, unsigned src, unsigned shift)
+{
+    jit_rex(e, 0, src, dst);
+    jit_byte(e, 0x0F);
+    jit_byte(e, 0xAC);
+    jit_byte(e, 0xC0 | ((src & 7) << 3) | (dst & 7));
+    jit_byte(e, (unsigned char)shift);
+}
+
+/* Emits "xor dst, imm32" for a 32-bit register */
+static void jit_xor_imm(tinyjambu_jit_emit_t *e, unsigned dst, uint32_t imm)
+{
+    jit_rex(e, 0, 0, dst);
+    if (imm < 0x80) {
+        jit_byte(e, 0x83);
+        jit_byte(e, 0xF0 | (dst & 7));
+        jit_byte(e, (unsigned char)imm);
+    } else {
+        jit_byte(e, 0x81);
+        jit_byte(e, 0xF0 | (dst & 7));
+        jit_word32(e, imm);
+    }
+}
+
+/* Emits "mov reg, [base + disp]" or "mov [base + disp], reg" for a
+ * 32-bit register.  The base cannot be rsp, rbp, r12, or r13 */
+static void jit_mem
+    (tinyjambu_jit_emit_t *e, unsigned char op, unsigned reg,
+     unsigned base, unsigned disp)
+{
+    jit_rex(e, 0, reg, base);
+    jit_byte(e, op);
+    jit_byte(e, 0x40 | ((reg & 7) << 3) | (base & 7));
+    jit_byte(e, (unsigned char)disp);
+}
+#define jit_load(e, reg, base, disp) jit_mem((e), 0x8B, (reg), (base), (disp))
+#define jit_store(e, base, disp, reg) jit_mem((e), 0x89, (reg), (base), (disp))
+
+/* Emits "add reg, imm8" for a 64-bit register */
+static void jit_add64(tinyjambu_jit_emit_t *e, unsigned reg, unsigned imm)
+{
+    jit_rex(e, 1, 0, reg);
+    jit_byte(e, 0x83);
+    jit_byte(e, 0xC0 | (reg & 7));
+    jit_byte(e, (unsigned char)imm);
+}
+
+/* Emits "sub reg, 1" for a 64-bit register */
+static void jit_dec64(tinyjambu_jit_emit_t *e, unsigned reg)
+{
+    jit_rex(e, 1, 0, reg);
+    jit_byte(e, 0x83);
+    jit_byte(e, 0xE8 | (reg & 7));
+    jit_byte(e, 1);
+}
+
+/* Emits "test reg, reg" for a 64-bit register */
+static void jit_test64(tinyjambu_jit_emit_t *e, unsigned reg)
+{
+    jit_rex(e, 1, reg, reg);
+    jit_byte(e, 0x85);
+    jit_byte(e, 0xC0 | ((reg & 7) << 3) | (reg & 7));
+}
+
+/* Emits a conditional jump with a 32-bit displacement and returns the
+ * position of the displacement so that it can be patched later */
+static size_t jit_jcc(tinyjambu_jit_emit_t *e, unsigned char cc, size_t target)
+{
+    size_t posn;
+    jit_byte(e, 0x0F);
+    jit_byte(e, 0x80 | cc);
+    posn = e->posn;
+    jit_word32(e, (uint32_t)(target - (posn + 4)));
+    return posn;
+}
+#define JIT_CC_Z  0x04
+#define JIT_CC_NZ 0x05
+
+/* Patches the displacement of a forward jump to point at the current
+ * position in the code */
+static void jit_patch(tinyjambu_jit_emit_t *e, size_t posn)
+{
+    uint32_t disp = (uint32_t)(e->posn - (posn + 4));
+    if (e->buf) {
+        e->buf[posn]     = (unsigned char)disp;
+        e->buf[posn + 1] = (unsigned char)(disp >> 8);
+        e->buf[posn + 2] = (unsigned char)(disp >> 16);
+        e->buf[posn + 3] = (unsigned char)(disp >> 24);
+    }
+}
+
+/* Pads the code with "int3" up to the next kernel boundary */
+static void jit_align(tinyjambu_jit_emit_t *e)
+{
+    while ((e->posn % JIT_ALIGN) != 0)
+        jit_byte(e, 0xCC);
+}
+
+/* Emits 32 steps of the permutation */
+static void jit_steps_32
+    (tinyjambu_jit_emit_t *e, unsigned s0, unsigned s1,
+     unsigned s2, unsigned s3, uint32_t kword)
+{
+    if (kword != 0)
+        jit_xor_imm(e, s0, kword);
+    jit_op_rr(e, JIT_OP_MOV, JIT_T1, s1);
+    jit_shrd(e, JIT_T1, s2, 15);
+    jit_op_rr(e, JIT_OP_XOR, s0, JIT_T1);
+    jit_op_rr(e, JIT_OP_MOV, JIT_T2, s3);
+    jit_shift64(e, JIT_SHL, JIT_T2, 32);
+    jit_op_rr64(e, JIT_OP_OR, JIT_T2, s2);
+    jit_op_rr64(e, JIT_OP_MOV, JIT_T1, JIT_T2);
+    jit_shift64(e, JIT_SHR, JIT_T1, 27);
+    jit_op_rr(e, JIT_OP_XOR, s0, JIT_T1);
+    jit_op_rr64(e, JIT_OP_MOV, JIT_T1, JIT_T2);
+    jit_shift64(e, JIT_SHR, JIT_T1, 6);
+    jit_shift64(e, JIT_SHR, JIT_T2, 21);
+    jit_op_rr(e, JIT_OP_AND, JIT_T1, JIT_T2);
+    jit_op_rr(e, JIT_OP_XOR, s0, JIT_T1);
+}
+
+/* Emits the permutation for a number of rounds, fully unrolled */
+static void jit_permutation
+    (tinyjambu_jit_emit_t *e, const tinyjambu_jit_ctx_t *ctx, unsigned rounds)
+{
+    static unsigned char const regs[4] = {JIT_S0, JIT_S1, JIT_S2, JIT_S3};
+    unsigned group;
+    for (group = 0; group < rounds * 4; ++group) {
+        jit_steps_32(e, regs[group % 4], regs[(group + 1) % 4],
+                     regs[(group + 2) % 4], regs[(group + 3) % 4],
+                     ctx->k[group % ctx->key_words]);
+    }
+}
+
+/* Emits the entry code to load the state from [rdi] */
+static void jit_prologue(tinyjambu_jit_emit_t *e)
+{
+    jit_byte(e, 0x53); /* push rbx */
+    jit_byte(e, 0x55); /* push rbp */
+    jit_load(e, JIT_S0, JIT_RDI, 0);
+    jit_load(e, JIT_S1, JIT_RDI, 4);
+    jit_load(e, JIT_S2, JIT_RDI, 8);
+    jit_load(e, JIT_S3, JIT_RDI, 12);
+}
+
+/* Emits the exit code to store the state back to [rdi] */
+static void jit_epilogue(tinyjambu_jit_emit_t *e)
+{
+    jit_store(e, JIT_RDI, 0, JIT_S0);
+    jit_store(e, JIT_RDI, 4, JIT_S1);
+    jit_store(e, JIT_RDI, 8, JIT_S2);
+    jit_store(e, JIT_RDI, 12, JIT_S3);
+    jit_byte(e, 0x5D); /* pop rbp */
+    jit_byte(e, 0x5B); /* pop rbx */
+    jit_byte(e, 0xC3); /* ret */
+}
+
+/* Emits a kernel for a fixed number of permutation rounds */
+static size_t jit_permute_kernel
+    (tinyjambu_jit_emit_t *e, const tinyjambu_jit_ctx_t *ctx, unsigned rounds)
+{
+    size_t start;
+    jit_align(e);
+    start = e->posn;
+    jit_prologue(e);
+    jit_permutation(e, ctx, rounds);
+    jit_epilogue(e);
+    return start;
+}
+
+/* Emits a kernel that loops over the words of a message.  The absorb
+ * kernel has the arguments (s, data, nwords, domain) and the others
+ * have the arguments (s, out, in, nwords) */
+static size_t jit_message_kernel
+    (tinyjambu_jit_emit_t *e, const tinyjambu_jit_ctx_t *ctx, int kind)
+{
+    unsigned in = (kind == JIT_KERNEL_ABSORB) ? JIT_RSI : JIT_RDX;
+    unsigned count = (kind == JIT_KERNEL_ABSORB) ? JIT_RDX : JIT_RCX;
+    size_t start, loop, done;
+    jit_align(e);
+    start = e->posn;
+    jit_prologue(e);
+    jit_test64(e, count);
+    done = jit_jcc(e, JIT_CC_Z, e->posn);
+    loop = e->posn;
+    if (kind == JIT_KERNEL_ABSORB) {
+        jit_op_rr(e, JIT_OP_XOR, JIT_S1, JIT_RCX);
+        jit_permutation(e, ctx, TINYJAMBU_ROUNDS(640));
+        jit_load(e, JIT_T1, in, 0);
+        jit_op_rr(e, JIT_OP_XOR, JIT_S3, JIT_T1);
+    } else {
+        jit_xor_imm(e, JIT_S1, 0x50);
+        jit_permutation(e, ctx, ctx->long_rounds);
+        jit_load(e, JIT_T1, in, 0);
+        if (kind == JIT_KERNEL_ENCRYPT)
+            jit_op_rr(e, JIT_OP_XOR, JIT_S3, JIT_T1);
+        jit_op_rr(e, JIT_OP_XOR, JIT_T1, JIT_S2);
+        if (kind == JIT_KERNEL_DECRYPT)
+            jit_op_rr(e, JIT_OP_XOR, JIT_S3, JIT_T1);
+        jit_store(e, JIT_RSI, 0, JIT_T1);
+        jit_add64(e, JIT_RSI, 4);
+    }
+    jit_add64(e, in, 4);
+    jit_dec64(e, count);
+    jit_jcc(e, JIT_CC_NZ, loop);
+    jit_patch(e, done);
+    jit_epilogue(e);
+    return start;
+}
+
+/* Emits all of the kernels for a key and returns their offsets */
+static void jit_kernels
+    (tinyjambu_jit_emit_t *e, const tinyjambu_jit_ctx_t *ctx,
+     size_t offsets[5])
+{
+    offsets[0] = jit_permute_kernel(e, ctx, TINYJAMBU_ROUNDS(640));
+    offsets[1] = jit_permute_kernel(e, ctx, ctx->long_rounds);
+    offsets[2] = jit_message_kernel(e, ctx, JIT_KERNEL_ABSORB);
+    offsets[3] = jit_message_kernel(e, ctx, JIT_KERNEL_ENCRYPT);
+    offsets[4] = jit_message_kernel(e, ctx, JIT_KERNEL_DECRYPT);
+}
+
+/* Generates the code for a key context */
+static void tinyjambu_jit_compile(tinyjambu_jit_ctx_t *ctx)
+{
+    tinyjambu_jit_emit_t e;
+    size_t offsets[5];
+    long page_size;
+    size_t size;
+    void *code;
+
+    /* Measure the size of the code and round up to a whole page */
+    e.buf = 0;
+    e.posn = 0;
+    jit_kernels(&e, ctx, offsets);
+    page_size = sysconf(_SC_PAGESIZE);
+    if (page_size <= 0)
+        return;
+    size = (e.posn + (size_t)page_size - 1) & ~((size_t)page_size - 1);
+
+    /* Generate the code into writable memory */
+    code = mmap(0, size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (code == MAP_FAILED)
+        return;
+    e.buf = (unsigned char *)code;
+    e.posn = 0;
+    jit_kernels(&e, ctx, offsets);
+
+    /* Make the memory executable and read-only */
+    if (mprotect(code, size, PROT_READ | PROT_EXEC) != 0) {
+        tinyjambu_clean(code, (unsigned)size);
+        munmap(code, size);
+        return;
+    }
+
+    /* Record the entry points for the kernels */
+    ctx->code = e.buf;
+    ctx->code_size = size;
+    ctx->permute_short = (tinyjambu_jit_permute_fn_t)(e.buf + offsets[0]);
+    ctx->permute_long = (tinyjambu_jit_permute_fn_t)(e.buf + offsets[1]);
+    ctx->absorb = (tinyjambu_jit_absorb_fn_t)(e.buf + offsets[2]);
+    ctx->encrypt = (tinyjambu_jit_crypt_fn_t)(e.buf + offsets[3]);
+    ctx->decrypt = (tinyjambu_jit_crypt_fn_t)(e.buf + offsets[4]);
+}
+
+/* Destroys the generated code for a key context */
+static void tinyjambu_jit_release(tinyjambu_jit_ctx_t *ctx)
+{
+    /* The immediate operands contain the key, so scrub the code if
+     * the memory can be made writable again before unmapping it */
+    if (mprotect(ctx->code, ctx->code_size, PROT_READ | PROT_WRITE) == 0)
+        tinyjambu_clean(ctx->code, (unsigned)(ctx->code_size));
+    munmap(ctx->code, ctx->code_size);
+}
+
+#endif /* TINYJAMBU_JIT_X86_64 */
+
+void tinyjambu_jit_ctx_init
+    (tinyjambu_jit_ctx_t *ctx, const unsigned char *k, size_t klen)
+{
+    unsigned index;
+    memset(ctx, 0, sizeof(tinyjambu_jit_ctx_t));
+    ctx->key_words = (unsigned)(klen / 4);
+    ctx->long_rounds = TINYJAMBU_ROUNDS(1024 + (ctx->key_words - 4) * 64);
+    for (index = 0; index < ctx->key_words; index += 2) {
+        ctx->k[index] = tinyjambu_key_load_even(k + index * 4);
+        ctx->k[index + 1] = tinyjambu_key_load_odd(k + index * 4 + 4);
+    }
+#if defined(TINYJAMBU_JIT_X86_64)
+    tinyjambu_jit_compile(ctx);
+#endif
+}
+
+void tinyjambu_jit_ctx_free(tinyjambu_jit_ctx_t *ctx)
+{
+#if defined(TINYJAMBU_JIT_X86_64)
+    if (ctx->code)
+        tinyjambu_jit_release(ctx);
+#endif
+    tinyjambu_clean(ctx, sizeof(tinyjambu_jit_ctx_t));
+}
+
+void tinyjambu_jit_permute
+    (const tinyjambu_jit_ctx_t *ctx, uint32_t *s, unsigned rounds)
+{
+    if (ctx->code && rounds == TINYJAMBU_ROUNDS(640))
+        (*(ctx->permute_short))(s);
+    else if (ctx->code && rounds == ctx->long_rounds)
+        (*(ctx->permute_long))(s);
+    else
+        tinyjambu_jit_portable_permute(ctx, s, rounds);
+}
+
+void tinyjambu_jit_absorb
+    (const tinyjambu_jit_ctx_t *ctx, uint32_t *s,
+     const unsigned char *data, size_t nwords, uint32_t domain)
+{
+    if (ctx->code) {
+        (*(ctx->absorb))(s, data, nwords, domain);
+        return;
+    }
+    while (nwords > 0) {
+        s[1] ^= domain;
+        tinyjambu_jit_portable_permute(ctx, s, TINYJAMBU_ROUNDS(640));
+        s[3] ^= le_load_word32(data);
+        data += 4;
+        --nwords;
+    }
+}
+
+void tinyjambu_jit_encrypt
+    (const tinyjambu_jit_ctx_t *ctx, uint32_t *s,
+     unsigned char *c, const unsigned char *m, size_t nwords)
+{
+    uint32_t data;
+    if (ctx->code) {
+        (*(ctx->encrypt))(s, c, m, nwords);
+        return;
+    }
+    while (nwords > 0) {
+        s[1] ^= 0x50;
+        tinyjambu_jit_portable_permute(ctx, s, ctx->long_rounds);
+        data = le_load_word32(m);
+        s[3] ^= data;
+        le_store_word32(c, data ^ s[2]);
+        c += 4;
+        m += 4;
+        --nwords;
+    }
+}
+
+void tinyjambu_jit_decrypt
+    (const tinyjambu_jit_ctx_t *ctx, uint32_t *s,
+     unsigned char *m, const unsigned char *c, size_t nwords)
+{
+    uint32_t data;
+    if (ctx->code) {
+        (*(ctx->decrypt))(s, m, c, nwords);
+        return;
+    }
+    while (nwords > 0) {
+        s[1] ^= 0x50;
+        tinyjambu_jit_portable_permute(ctx, s, ctx->long_rounds);
+        data = le_load_word32(c) ^ s[2];
+        s[3] ^= data;
+        le_store_word32(m, data);
+        c += 4;
+        m += 4;
+        --nwords;
+    }
+}
@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef TINYJAMBU_JIT_H
+#define TINYJAMBU_JIT_H
+
+#include "tinyjambu-backend.h"
+
+/**
+ * \file tinyjambu-jit.h
+ * \brief Key-specialised TinyJAMBU permutation code generated at runtime.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Generated kernel that runs a fixed number of permutation rounds.
+ *
+ * \param s The four words of the permutation state.
+ */
+typedef void (*tinyjambu_jit_permute_fn_t)(uint32_t *s);
+
+/**
+ * \brief Generated kernel that absorbs whole words of data with the
+ * 640-step permutation.
+ *
+ * \param s The four words of the permutation state.
+ * \param data Points to the data to absorb.
+ * \param nwords Number of 32-bit words to absorb.
+ * \param domain Domain separator to add before each word.
+ */
+typedef void (*tinyjambu_jit_absorb_fn_t)
+    (uint32_t *s, const unsigned char *data, size_t nwords, uint32_t domain);
+
+/**
+ * \brief Generated kernel that encrypts or decrypts whole words of
+ * message data with the longer permutation.
+ *
+ * \param s The four words of the permutation state.
+ * \param out Points to the output buffer.
+ * \param in Points to the input buffer.
+ * \param nwords Number of 32-bit words to encrypt or decrypt.
+ */
+typedef void (*tinyjambu_jit_crypt_fn_t)
+    (uint32_t *s, unsigned char *out, const unsigned char *in, size_t nwords);
+
+/**
+ * \brief Key context for the TinyJAMBU code generator.
+ */
+typedef struct
+{
+    /** Words of the key, pre-inverted */
+    uint32_t k[8];
+
+    /** Number of words in the key; 4, 6, or 8 */
+    unsigned key_words;
+
+    /** Number of rounds in the longer permutation; 8, 9, or 10 */
+    unsigned long_rounds;
+
+    /** Executable memory that holds the generated code, or NULL if the
+     *  portable backend is being used instead */
+    unsigned char *code;
+
+    /** Size of the executable memory in bytes */
+    size_t code_size;
+
+    /** Generated kernel for the 640-step permutation */
+    tinyjambu_jit_permute_fn_t permute_short;
+
+    /** Generated kernel for the longer permutation */
+    tinyjambu_jit_permute_fn_t permute_long;
+
+    /** Generated kernel for absorbing nonce and associated data words */
+    tinyjambu_jit_absorb_fn_t absorb;
+
+    /** Generated kernel for encrypting message words */
+    tinyjambu_jit_crypt_fn_t encrypt;
+
+    /** Generated kernel for decrypting message words */
+    tinyjambu_jit_crypt_fn_t decrypt;
+
+} tinyjambu_jit_ctx_t;
+
+/**
+ * \brief Initializes a key context and generates the code for the key.
+ *
+ * \param ctx The key context to initialize.
+ * \param k Points to the bytes of the key.
+ * \param klen Length of the key; 16, 24, or 32 bytes.
+ *
+ * If code cannot be generated on this platform, or the executable
+ * memory cannot be allocated, then \a ctx falls back to the portable
+ * backend and tinyjambu_jit_ctx_is_native() will return zero.
+ */
+void tinyjambu_jit_ctx_init
+    (tinyjambu_jit_ctx_t *ctx, const unsigned char *k, size_t klen);
+
+/**
+ * \brief Frees a key context and destroys the generated code.
+ *
+ * \param ctx The key context to free.
+ */
+void tinyjambu_jit_ctx_free(tinyjambu_jit_ctx_t *ctx);
+
+/**
+ * \brief Determine if a key context is using generated code.
+ *
+ * \param ctx The key context.
+ *
+ * \return Non-zero if the generated code is in use, or zero if the
+ * portable backend is in use.
+ */
+#define tinyjambu_jit_ctx_is_native(ctx) ((ctx)->code != 0)
+
+/**
+ * \brief Runs the TinyJAMBU permutation with the key from a key context.
+ *
+ * \param ctx The key context.
+ * \param s The four words of the permutation state.
+ * \param rounds The number of 128-step rounds to perform.
+ *
+ * Generated code is only used for 640 steps and for the longer
+ * permutation for the key size.  Other round counts are performed
+ * with the portable backend.
+ */
+void tinyjambu_jit_permute
+    (const tinyjambu_jit_ctx_t *ctx, uint32_t *s, unsigned rounds);
+
+/**
+ * \brief Absorbs whole words of data into the permutation state.
+ *
+ * \param ctx The key context.
+ * \param s The four words of the permutation state.
+ * \param data Points to the data to absorb.
+ * \param nwords Number of 32-bit words to absorb.
+ * \param domain Domain separator to add before each word.
+ */
+void tinyjambu_jit_absorb
+    (const tinyjambu_jit_ctx_t *ctx, uint32_t *s,
+     const unsigned char *data, size_t nwords, uint32_t domain);
+
+/**
+ * \brief Encrypts whole words of message data.
+ *
+ * \param ctx The key context.
+ * \param s The four words of the permutation state.
+ * \param c Points to the output buffer for the ciphertext.
+ * \param m Points to the input buffer for the plaintext.
+ * \param nwords Number of 32-bit words to encrypt.
+ */
+void tinyjambu_jit_encrypt
+    (const tinyjambu_jit_ctx_t *ctx, uint32_t *s,
+     unsigned char *c, const unsigned char *m, size_t nwords);
+
+/**
+ * \brief Decrypts whole words of message data.
+ *
+ * \param ctx The key context.
+ * \param s The four words of the permutation state.
+ * \param m Points to the output buffer for the plaintext.
+ * \param c Points to the input buffer for the ciphertext.
+ * \param nwords Number of 32-bit words to decrypt.
+ */
+void tinyjambu_jit_decrypt
+    (const tinyjambu_jit_ctx_t *ctx, uint32_t *s,
+     unsigned char *m, const unsigned char *c, size_t nwords);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,277 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "tinyjambu-backend.h"
+#include "tinyjambu-util.h"
+
+/*
+ * Each TinyJAMBU step depends upon the result of the previous step, so a
+ * single permutation cannot make use of the multiple execution units in
+ * modern CPU's.  Interleaving the steps of several independent states
+ * allows the compiler to schedule them in parallel.
+ *
+ * The assembly code backends are designed for small embedded CPU's that
+ * will not benefit from interleaving, so they process the lanes one after
+ * the other instead.
+ */
+
+#if defined(TINYJAMBU_BACKEND_C32)
+
+void tinyjambu_permutation_128_x2
+    (tinyjambu_128_state_t *state1, tinyjambu_128_state_t *state2,
+     unsigned rounds)
+{
+    uint32_t t1, t2, t3, t4;
+
+    /* Load the states into local variables */
+    uint32_t a0 = state1->s[0];
+    uint32_t a1 = state1->s[1];
+    uint32_t a2 = state1->s[2];
+    uint32_t a3 = state1->s[3];
+    uint32_t b0 = state2->s[0];
+    uint32_t b1 = state2->s[1];
+    uint32_t b2 = state2->s[2];
+    uint32_t b3 = state2->s[3];
+
+    /* Perform all permutation rounds 128 steps at a time */
+    for (; rounds > 0; --rounds) {
+        tinyjambu_steps_32(a0, a1, a2, a3, state1->k[0]);
+        tinyjambu_steps_32(b0, b1, b2, b3, state2->k[0]);
+        tinyjambu_steps_32(a1, a2, a3, a0, state1->k[1]);
+        tinyjambu_steps_32(b1, b2, b3, b0, state2->k[1]);
+        tinyjambu_steps_32(a2, a3, a0, a1, state1->k[2]);
+        tinyjambu_steps_32(b2, b3, b0, b1, state2->k[2]);
+        tinyjambu_steps_32(a3, a0, a1, a2, state1->k[3]);
+        tinyjambu_steps_32(b3, b0, b1, b2, state2->k[3]);
+    }
+
+    /* Store the local variables back to the states */
+    state1->s[0] = a0;
+    state1->s[1] = a1;
+    state1->s[2] = a2;
+    state1->s[3] = a3;
+    state2->s[0] = b0;
+    state2->s[1] = b1;
+    state2->s[2] = b2;
+    state2->s[3] = b3;
+}
+
+void tinyjambu_permutation_128_x4
+    (tinyjambu_128_state_t states[4], unsigned rounds)
+{
+    uint32_t t1, t2, t3, t4;
+
+    /* Load the states into local variables */
+    uint32_t a0 = states[0].s[0];
+    uint32_t a1 = states[0].s[1];
+    uint32_t a2 = states[0].s[2];
+    uint32_t a3 = states[0].s[3];
+    uint32_t b0 = states[1].s[0];
+    uint32_t b1 = states[1].s[1];
+    uint32_t b2 = states[1].s[2];
+    uint32_t b3 = states[1].s[3];
+    uint32_t c0 = states[2].s[0];
+    uint32_t c1 = states[2].s[1];
+    uint32_t c2 = states[2].s[2];
+    uint32_t c3 = states[2].s[3];
+    uint32_t d0 = states[3].s[0];
+    uint32_t d1 = states[3].s[1];
+    uint32_t d2 = states[3].s[2];
+    uint32_t d3 = states[3].s[3];
+
+    /* Perform all permutation rounds 128 steps at a time */
+    for (; rounds > 0; --rounds) {
+        tinyjambu_steps_32(a0, a1, a2, a3, states[0].k[0]);
+        tinyjambu_steps_32(b0, b1, b2, b3, states[1].k[0]);
+        tinyjambu_steps_32(c0, c1, c2, c3, states[2].k[0]);
+        tinyjambu_steps_32(d0, d1, d2, d3, states[3].k[0]);
+        tinyjambu_steps_32(a1, a2, a3, a0, states[0].k[1]);
+        tinyjambu_steps_32(b1, b2, b3, b0, states[1].k[1]);
+        tinyjambu_steps_32(c1, c2, c3, c0, states[2].k[1]);
+        tinyjambu_steps_32(d1, d2, d3, d0, states[3].k[1]);
+        tinyjambu_steps_32(a2, a3, a0, a1, states[0].k[2]);
+        tinyjambu_steps_32(b2, b3, b0, b1, states[1].k[2]);
+        tinyjambu_steps_32(c2, c3, c0, c1, states[2].k[2]);
+        tinyjambu_steps_32(d2, d3, d0, d1, states[3].k[2]);
+        tinyjambu_steps_32(a3, a0, a1, a2, states[0].k[3]);
+        tinyjambu_steps_32(b3, b0, b1, b2, states[1].k[3]);
+        tinyjambu_steps_32(c3, c0, c1, c2, states[2].k[3]);
+        tinyjambu_steps_32(d3, d0, d1, d2, states[3].k[3]);
+    }
+
+    /* Store the local variables back to the states */
+    states[0].s[0] = a0;
+    states[0].s[1] = a1;
+    states[0].s[2] = a2;
+    states[0].s[3] = a3;
+    states[1].s[0] = b0;
+    states[1].s[1] = b1;
+    states[1].s[2] = b2;
+    states[1].s[3] = b3;
+    states[2].s[0] = c0;
+    states[2].s[1] = c1;
+    states[2].s[2] = c2;
+    states[2].s[3] = c3;
+    states[3].s[0] = d0;
+    states[3].s[1] = d1;
+    states[3].s[2] = d2;
+    states[3].s[3] = d3;
+}
+
+/* Performs 128 steps on two interleaved states, a0..a3 and b0..b3,
+ * with the key words k0..k3 from the key schedules ka and kb */
+#define tinyjambu_steps_128_x2(ka, kb, k0, k1, k2, k3) \
+    do { \
+        tinyjambu_steps_32(a0, a1, a2, a3, (ka)[(k0)]); \
+        tinyjambu_steps_32(b0, b1, b2, b3, (kb)[(k0)]); \
+        tinyjambu_steps_32(a1, a2, a3, a0, (ka)[(k1)]); \
+        tinyjambu_steps_32(b1, b2, b3, b0, (kb)[(k1)]); \
+        tinyjambu_steps_32(a2, a3, a0, a1, (ka)[(k2)]); \
+        tinyjambu_steps_32(b2, b3, b0, b1, (kb)[(k2)]); \
+        tinyjambu_steps_32(a3, a0, a1, a2, (ka)[(k3)]); \
+        tinyjambu_steps_32(b3, b0, b1, b2, (kb)[(k3)]); \
+    } while (0)
+
+void tinyjambu_permutation_192_x2
+    (tinyjambu_192_state_t *state1, tinyjambu_192_state_t *state2,
+     unsigned rounds)
+{
+    uint32_t t1, t2, t3, t4;
+
+    /* Load the states into local variables */
+    uint32_t a0 = state1->s[0];
+    uint32_t a1 = state1->s[1];
+    uint32_t a2 = state1->s[2];
+    uint32_t a3 = state1->s[3];
+    uint32_t b0 = state2->s[0];
+    uint32_t b1 = state2->s[1];
+    uint32_t b2 = state2->s[2];
+    uint32_t b3 = state2->s[3];
+
+    /* Perform all permutation rounds 128 steps at a time */
+    for (; rounds > 0; --rounds) {
+        /* Perform the first set of 128 steps */
+        tinyjambu_steps_128_x2(state1->k, state2->k, 0, 1, 2, 3);
+
+        /* Bail out if this is the last round */
+        if ((--rounds) == 0)
+            break;
+
+        /* Perform the second set of 128 steps */
+        tinyjambu_steps_128_x2(state1->k, state2->k, 4, 5, 0, 1);
+
+        /* Bail out if this is the last round */
+        if ((--rounds) == 0)
+            break;
+
+        /* Perform the third set of 128 steps */
+        tinyjambu_steps_128_x2(state1->k, state2->k, 2, 3, 4, 5);
+    }
+
+    /* Store the local variables back to the states */
+    state1->s[0] = a0;
+    state1->s[1] = a1;
+    state1->s[2] = a2;
+    state1->s[3] = a3;
+    state2->s[0] = b0;
+    state2->s[1] = b1;
+    state2->s[2] = b2;
+    state2->s[3] = b3;
+}
+
+void tinyjambu_permutation_256_x2
+    (tinyjambu_256_state_t *state1, tinyjambu_256_state_t *state2,
+     unsigned rounds)
+{
+    uint32_t t1, t2, t3, t4;
+
+    /* Load the states into local variables */
+    uint32_t a0 = state1->s[0];
+    uint32_t a1 = state1->s[1];
+    uint32_t a2 = state1->s[2];
+    uint32_t a3 = state1->s[3];
+    uint32_t b0 = state2->s[0];
+    uint32_t b1 = state2->s[1];
+    uint32_t b2 = state2->s[2];
+    uint32_t b3 = state2->s[3];
+
+    /* Perform all permutation rounds 128 steps at a time */
+    for (; rounds > 0; --rounds) {
+        /* Perform the first set of 128 steps */
+        tinyjambu_steps_128_x2(state1->k, state2->k, 0, 1, 2, 3);
+
+        /* Bail out if this is the last round */
+        if ((--rounds) == 0)
+            break;
+
+        /* Perform the second set of 128 steps */
+        tinyjambu_steps_128_x2(state1->k, state2->k, 4, 5, 6, 7);
+    }
+
+    /* Store the local variables back to the states */
+    state1->s[0] = a0;
+    state1->s[1] = a1;
+    state1->s[2] = a2;
+    state1->s[3] = a3;
+    state2->s[0] = b0;
+    state2->s[1] = b1;
+    state2->s[2] = b2;
+    state2->s[3] = b3;
+}
+
+#else /* !TINYJAMBU_BACKEND_C32 */
+
+void tinyjambu_permutation_128_x2
+    (tinyjambu_128_state_t *state1, tinyjambu_128_state_t *state2,
+     unsigned rounds)
+{
+    tinyjambu_permutation_128(state1, rounds);
+    tinyjambu_permutation_128(state2, rounds);
+}
+
+void tinyjambu_permutation_128_x4
+    (tinyjambu_128_state_t states[4], unsigned rounds)
+{
+    tinyjambu_permutation_128(&(states[0]), rounds);
+    tinyjambu_permutation_128(&(states[1]), rounds);
+    tinyjambu_permutation_128(&(states[2]), rounds);
+    tinyjambu_permutation_128(&(states[3]), rounds);
+}
+
+void tinyjambu_permutation_192_x2
+    (tinyjambu_192_state_t *state1, tinyjambu_192_state_t *state2,
+     unsigned rounds)
+{
+    tinyjambu_permutation_192(state1, rounds);
+    tinyjambu_permutation_192(state2, rounds);
+}
+
+void tinyjambu_permutation_256_x2
+    (tinyjambu_256_state_t *state1, tinyjambu_256_state_t *state2,
+     unsigned rounds)
+{
+    tinyjambu_permutation_256(state1, rounds);
+    tinyjambu_permutation_256(state2, rounds);
+}
+
+#endif /* !TINYJAMBU_BACKEND_C32 */
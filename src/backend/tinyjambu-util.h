@@ -732,4 +732,23 @@ int tinyjambu_aead_check_tag
     (unsigned char *plaintext, size_t plaintext_len,
      const unsigned char *tag1, const unsigned char *tag2, size_t size);
 
+/**
+ * \brief Multiplies a 128-bit value by x in GF(2^128).
+ *
+ * \param out Receives the result.  May be the same as \a in.
+ * \param in The value to double, as four 32-bit words with the least
+ * significant word first.
+ *
+ * The field uses the reduction polynomial x^128 + x^7 + x^2 + x + 1,
+ * which is the same as for CMAC and PMAC.
+ */
+STATIC_INLINE void tinyjambu_gf128_double(uint32_t out[4], const uint32_t in[4])
+{
+    uint32_t carry = in[3] >> 31;
+    out[3] = (in[3] << 1) | (in[2] >> 31);
+    out[2] = (in[2] << 1) | (in[1] >> 31);
+    out[1] = (in[1] << 1) | (in[0] >> 31);
+    out[0] = (in[0] << 1) ^ (0x87U & (0U - carry));
+}
+
 #endif
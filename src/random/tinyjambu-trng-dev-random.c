@@ -33,6 +33,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
@@ -56,10 +57,83 @@
 #define tinyjambu_getrandom(buf, size) syscall(SYS_getrandom, (buf), (size), 0)
 #endif
 
+#if !defined(O_CLOEXEC)
+#define O_CLOEXEC 0
+#endif
+
+/**
+ * \brief Maximum number of times to retry when the random source
+ * reports that it is temporarily unavailable.
+ *
+ * The delay between retries starts at 1 millisecond and doubles each
+ * time, so the total wait is a little over a second before giving up.
+ */
+#define TINYJAMBU_DEV_RANDOM_RETRIES 10
+
+/* Backs off before retrying a read that failed with EAGAIN */
+static int tinyjambu_dev_random_backoff(unsigned *attempt)
+{
+    struct timespec ts;
+    if (*attempt >= TINYJAMBU_DEV_RANDOM_RETRIES)
+        return 0;
+    ts.tv_sec = 0;
+    ts.tv_nsec = 1000000L << *attempt;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec = ts.tv_nsec / 1000000000L;
+        ts.tv_nsec %= 1000000000L;
+    }
+    nanosleep(&ts, 0);
+    ++(*attempt);
+    return 1;
+}
+
 #if !defined(tinyjambu_getrandom)
+/* The file descriptor is opened once and then cached for the life of
+ * the process, to avoid two extra system calls for every request.
+ * O_CLOEXEC stops the descriptor from leaking into child programs.
+ *
+ * The application may close the descriptor behind our back, and the
+ * number may then be reused for some other file.  So the descriptor is
+ * checked with fstat() before every use to make sure that it is still
+ * the same character device, and the device is reopened if it is not. */
+static volatile int tinyjambu_dev_random_fd = -1;
+static dev_t tinyjambu_dev_random_rdev;
+static int tinyjambu_dev_random_is_device(int fd)
+{
+    struct stat st;
+    return fstat(fd, &st) == 0 && S_ISCHR(st.st_mode) &&
+           st.st_rdev == tinyjambu_dev_random_rdev;
+}
 static int tinyjambu_dev_random_open(void)
 {
-    return open(RANDOM_DEVICE, O_RDONLY);
+    int fd = tinyjambu_dev_random_fd;
+    int expected = fd;
+    struct stat st;
+    if (fd >= 0 && tinyjambu_dev_random_is_device(fd))
+        return fd;
+    fd = open(RANDOM_DEVICE, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return fd;
+    if (fstat(fd, &st) != 0 || !S_ISCHR(st.st_mode)) {
+        close(fd);
+        return -1;
+    }
+    /* Every open of the device has the same device number, so it does
+     * not matter if several threads store it at the same time */
+    tinyjambu_dev_random_rdev = st.st_rdev;
+#if defined(__GNUC__) && defined(__ATOMIC_ACQ_REL)
+    /* Another thread may have opened the device at the same time */
+    if (!__atomic_compare_exchange_n
+            ((int *)&tinyjambu_dev_random_fd, &expected, fd, 0,
+             __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        close(fd);
+        fd = expected;
+    }
+#else
+    (void)expected;
+    tinyjambu_dev_random_fd = fd;
+#endif
+    return fd;
 }
 #else
 #define tinyjambu_dev_random_open() -1
@@ -67,8 +141,10 @@ static int tinyjambu_dev_random_open(void)
 
 static int tinyjambu_dev_random_read(int fd, unsigned char *out, size_t outlen)
 {
+    unsigned attempt = 0;
 #if defined(tinyjambu_getrandom)
-    /* Keep looping until we get some data or a permanent error. */
+    /* Keep looping until we get some data or a permanent error.
+     * EAGAIN is retried a limited number of times with a back-off. */
     (void)fd;
     for (;;) {
         int ret = tinyjambu_getrandom(out, outlen);
@@ -76,27 +152,36 @@ static int tinyjambu_dev_random_read(int fd, unsigned char *out, size_t outlen)
             /* getentropy() returns 0 on success, getrandom() returns
              * the number of bytes read on success */
             return 1;
-        } else {
-            if (errno != EINTR && errno != EAGAIN) {
-                /* getrandom() or getentropy() is broken; this is a problem */
-                memset(out, 0, outlen);
+        } else if (errno == EAGAIN) {
+            if (!tinyjambu_dev_random_backoff(&attempt))
                 break;
-            }
+        } else if (errno != EINTR) {
+            /* getrandom() or getentropy() is broken; this is a problem */
+            break;
         }
     }
+    memset(out, 0, outlen);
     return 0;
 #else
+    size_t posn = 0;
     if (fd >= 0) {
-        /* Keep looping until we get some data or a permanent error. */
-        for (;;) {
-            int ret = read(fd, out, outlen);
-            if (ret == (int)outlen) {
-                return 1;
-            } else if (ret < 0) {
-                if (errno != EINTR && errno != EAGAIN)
+        /* Keep looping until we get all of the data or a permanent error.
+         * EAGAIN is retried a limited number of times with a back-off. */
+        while (posn < outlen) {
+            ssize_t ret = read(fd, out + posn, outlen - posn);
+            if (ret > 0) {
+                posn += (size_t)ret;
+            } else if (ret == 0) {
+                break;
+            } else if (errno == EAGAIN) {
+                if (!tinyjambu_dev_random_backoff(&attempt))
                     break;
+            } else if (errno != EINTR) {
+                break;
             }
         }
+        if (posn == outlen)
+            return 1;
     }
     /* /dev/urandom is broken or not open; this is a problem */
     memset(out, 0, outlen);
@@ -106,15 +191,18 @@ static int tinyjambu_dev_random_read(int fd, unsigned char *out, size_t outlen)
 
 int tinyjambu_trng_generate(unsigned char *out)
 {
-#if defined(tinyjambu_getrandom)
-    return tinyjambu_dev_random_read(-1, out, TINYJAMBU_SYSTEM_SEED_SIZE);
-#else
+    /* Read from the operating system's source and then mix in the CPU's
+     * random number instructions as well if we have them and they pass
+     * the health tests.  The hardware output is never used on its own.
+     *
+     * Recent versions of glibc implement getrandom() in the vDSO, which
+     * avoids entering the kernel for every request.  This happens
+     * transparently so no special handling is needed here. */
     int fd = tinyjambu_dev_random_open();
     int ok = tinyjambu_dev_random_read(fd, out, TINYJAMBU_SYSTEM_SEED_SIZE);
-    if (fd >= 0)
-        close(fd);
+    if (ok)
+        tinyjambu_trng_hw_mix(out, TINYJAMBU_SYSTEM_SEED_SIZE);
     return ok;
-#endif
 }
 
 #endif /* TINYJAMBU_TRNG_DEV_RANDOM */
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "tinyjambu-trng.h"
+#include "../TinyJAMBU.h"
+#include <string.h>
+
+#if defined(HAVE_CONFIG_H)
+#include <config.h>
+#endif
+
+/*
+ * Hardware random number instructions are mixed into the output of the
+ * operating system's random number source with XOR.  They are never
+ * used on their own, so a broken or malicious instruction cannot make
+ * the output weaker than the operating system's source.
+ *
+ * The raw output of the instruction is subjected to simplified versions
+ * of the continuous health tests from section 4.4 of NIST SP 800-90B
+ * before it is used:
+ *
+ * Repetition Count Test: fail if two consecutive words are identical,
+ * or if any word is all-zeroes or all-ones.  Some CPU's with faulty
+ * microcode have been known to return the same value forever.
+ *
+ * Adaptive Proportion Test: fail if any byte value occurs
+ * TINYJAMBU_TRNG_APT_CUTOFF or more times in a sample.  For a 32-byte
+ * sample of uniformly random bytes, the probability of a false positive
+ * is about 2^-32.8, or roughly one sample in seven billion.
+ *
+ * If the health tests fail, then the instructions are disabled for the
+ * rest of the life of the process.
+ */
+
+/**
+ * \brief Cutoff value for the adaptive proportion test.
+ */
+#define TINYJAMBU_TRNG_APT_CUTOFF 8
+
+int tinyjambu_trng_health_check(const unsigned char *data, size_t size)
+{
+    unsigned char counts[256];
+    size_t posn, index;
+    int all_zero, all_ones;
+
+    /* Repetition count test, performed on native words */
+    for (posn = 0; (posn + sizeof(size_t)) <= size; posn += sizeof(size_t)) {
+        all_zero = 1;
+        all_ones = 1;
+        for (index = 0; index < sizeof(size_t); ++index) {
+            if (data[posn + index] != 0x00)
+                all_zero = 0;
+            if (data[posn + index] != 0xFF)
+                all_ones = 0;
+        }
+        if (all_zero || all_ones)
+            return 0;
+        if (posn > 0 && !memcmp(data + posn - sizeof(size_t), data + posn,
+                                sizeof(size_t)))
+            return 0;
+    }
+
+    /* Adaptive proportion test */
+    memset(counts, 0, sizeof(counts));
+    for (posn = 0; posn < size; ++posn) {
+        if (++(counts[data[posn]]) >= TINYJAMBU_TRNG_APT_CUTOFF)
+            return 0;
+    }
+    return 1;
+}
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+
+#include <cpuid.h>
+
+/**
+ * \brief Number of times to retry RDSEED or RDRAND before giving up.
+ */
+#define TINYJAMBU_TRNG_HW_RETRIES 16
+
+/** Status of the hardware instructions: 0 = unknown, 1 = RDSEED,
+ * 2 = RDRAND, -1 = not available or failed the health tests */
+static volatile int tinyjambu_trng_hw_status = 0;
+
+/* Determine which hardware random number instruction to use */
+static int tinyjambu_trng_hw_detect(void)
+{
+    unsigned eax, ebx, ecx, edx;
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) &&
+            (ebx & (1U << 18)) != 0) {
+        return 1; /* RDSEED */
+    }
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) &&
+            (ecx & (1U << 30)) != 0) {
+        return 2; /* RDRAND */
+    }
+    return -1;
+}
+
+/* Reads a single word using RDSEED or RDRAND */
+static int tinyjambu_trng_hw_read(int status, unsigned long *value)
+{
+    unsigned char ok;
+    int retry;
+    for (retry = 0; retry < TINYJAMBU_TRNG_HW_RETRIES; ++retry) {
+        if (status == 1) {
+            __asm__ __volatile__ ("rdseed %0; setc %1"
+                                  : "=r"(*value), "=qm"(ok) : : "cc");
+        } else {
+            __asm__ __volatile__ ("rdrand %0; setc %1"
+                                  : "=r"(*value), "=qm"(ok) : : "cc");
+        }
+        if (ok)
+            return 1;
+    }
+    return 0;
+}
+
+int tinyjambu_trng_hw_mix(unsigned char *out, size_t size)
+{
+    unsigned char sample[TINYJAMBU_SYSTEM_SEED_SIZE];
+    unsigned long value;
+    size_t posn;
+    int status = tinyjambu_trng_hw_status;
+
+    /* Is the hardware instruction available and healthy? */
+    if (status == 0) {
+        status = tinyjambu_trng_hw_detect();
+        tinyjambu_trng_hw_status = status;
+    }
+    if (status < 0 || size > sizeof(sample))
+        return 0;
+
+    /* Collect a sample from the hardware */
+    memset(sample, 0, sizeof(sample));
+    for (posn = 0; posn < size; posn += sizeof(value)) {
+        if (!tinyjambu_trng_hw_read(status, &value)) {
+            tinyjambu_clean(sample, sizeof(sample));
+            return 0; /* Temporary failure, possibly contention */
+        }
+        if ((size - posn) >= sizeof(value))
+            memcpy(sample + posn, &value, sizeof(value));
+        else
+            memcpy(sample + posn, &value, size - posn);
+    }
+
+    /* Run the health tests and then mix the sample into the output */
+    if (!tinyjambu_trng_health_check(sample, size)) {
+        tinyjambu_trng_hw_status = -1;
+        tinyjambu_clean(sample, sizeof(sample));
+        return 0;
+    }
+    for (posn = 0; posn < size; ++posn)
+        out[posn] ^= sample[posn];
+    tinyjambu_clean(sample, sizeof(sample));
+    return 1;
+}
+
+#else /* !x86 */
+
+int tinyjambu_trng_hw_mix(unsigned char *out, size_t size)
+{
+    (void)out;
+    (void)size;
+    return 0;
+}
+
+#endif /* !x86 */
@@ -42,6 +42,7 @@
  */
 
 #include "tinyjambu-trng-select.h"
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -66,6 +67,34 @@ extern "C" {
  */
 int tinyjambu_trng_generate(unsigned char *out);
 
+/**
+ * \brief Mixes the output of the CPU's hardware random number instructions
+ * into a buffer, if the CPU has them.
+ *
+ * \param out Buffer to mix the random bytes into with XOR.
+ * \param size Number of bytes to mix in, up to TINYJAMBU_SYSTEM_SEED_SIZE.
+ *
+ * \return Non-zero if the bytes were mixed in; zero if there are no
+ * hardware random number instructions, they are temporarily unavailable,
+ * or their output failed the health tests.
+ *
+ * The \a out buffer is left unchanged if this function returns zero.
+ * This is used on x86 with RDSEED or RDRAND.
+ */
+int tinyjambu_trng_hw_mix(unsigned char *out, size_t size);
+
+/**
+ * \brief Performs continuous health tests on a sample of raw output from
+ * a hardware random number source.
+ *
+ * \param data Points to the sample.
+ * \param size Number of bytes in the sample.
+ *
+ * \return Non-zero if the sample passed the repetition count and
+ * adaptive proportion tests; zero if the sample failed.
+ */
+int tinyjambu_trng_health_check(const unsigned char *data, size_t size);
+
 #ifdef __cplusplus
 }
 #endif
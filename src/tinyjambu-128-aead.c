@@ -23,8 +23,18 @@
 #include "TinyJAMBU.h"
 #include "backend/tinyjambu-aead-common.h"
 
-void tinyjambu_128_aead_encrypt
-    (unsigned char *c, size_t *clen,
+/** @cond */
+
+/* Compile-time check that tinyjambu_128_key_p_t can fit within the
+ * bounds of tinyjambu_128_key_t.  This line of code will fail to
+ * compile if the private structure is too large for the public one. */
+typedef int tinyjambu_128_key_size_check
+    [(sizeof(tinyjambu_128_key_p_t) <= sizeof(tinyjambu_128_key_t)) * 2 - 1];
+
+/** @endcond */
+
+void tinyjambu_128_aead_encrypt_detached
+    (unsigned char *c, unsigned char *tag,
      const unsigned char *m, size_t mlen,
      const unsigned char *ad, size_t adlen,
      const unsigned char *npub,
@@ -33,9 +43,6 @@ void tinyjambu_128_aead_encrypt
     tinyjambu_128_state_t state;
     uint32_t data;
 
-    /* Set the length of the returned ciphertext */
-    *clen = mlen + TINYJAMBU_TAG_SIZE;
-
     /* Unpack the key and invert it for later */
     state.k[0] = tinyjambu_key_load_even(k);
     state.k[1] = tinyjambu_key_load_odd(k + 4);
@@ -87,26 +94,23 @@ void tinyjambu_128_aead_encrypt
     }
 
     /* Generate the authentication tag */
-    tinyjambu_generate_tag_128(&state, c + mlen);
+    tinyjambu_generate_tag_128(&state, tag);
 }
 
-int tinyjambu_128_aead_decrypt
-    (unsigned char *m, size_t *mlen,
+int tinyjambu_128_aead_decrypt_detached
+    (unsigned char *m,
      const unsigned char *c, size_t clen,
+     const unsigned char *tag,
      const unsigned char *ad, size_t adlen,
      const unsigned char *npub,
      const unsigned char *k)
 {
     unsigned char *mtemp = m;
     tinyjambu_128_state_t state;
-    unsigned char tag[TINYJAMBU_TAG_SIZE];
+    size_t mlen = clen;
+    unsigned char computed[TINYJAMBU_TAG_SIZE];
     uint32_t data;
 
-    /* Validate the ciphertext length and set the return "mlen" value */
-    if (clen < TINYJAMBU_TAG_SIZE)
-        return -1;
-    *mlen = clen - TINYJAMBU_TAG_SIZE;
-
     /* Unpack the key and invert it for later */
     state.k[0] = tinyjambu_key_load_even(k);
     state.k[1] = tinyjambu_key_load_odd(k + 4);
@@ -118,7 +122,6 @@ int tinyjambu_128_aead_decrypt
     tinyjambu_absorb_128(&state, ad, adlen, 0x30, TINYJAMBU_ROUNDS(640));
 
     /* Decrypt the ciphertext to produce the plaintext */
-    clen -= TINYJAMBU_TAG_SIZE;
     while (clen >= 4) {
         tinyjambu_add_domain(&state, 0x50); /* Domain sep for message data */
         tinyjambu_permutation_128(&state, TINYJAMBU_ROUNDS(1024));
@@ -136,7 +139,6 @@ int tinyjambu_128_aead_decrypt
         tinyjambu_absorb(&state, data);
         tinyjambu_add_domain(&state, 0x01);
         m[0] = (uint8_t)data;
-        ++c;
     } else if (clen == 2) {
         tinyjambu_add_domain(&state, 0x50);
         tinyjambu_permutation_128(&state, TINYJAMBU_ROUNDS(1024));
@@ -145,7 +147,6 @@ int tinyjambu_128_aead_decrypt
         tinyjambu_add_domain(&state, 0x02);
         m[0] = (uint8_t)data;
         m[1] = (uint8_t)(data >> 8);
-        c += 2;
     } else if (clen == 3) {
         tinyjambu_add_domain(&state, 0x50);
         tinyjambu_permutation_128(&state, TINYJAMBU_ROUNDS(1024));
@@ -156,10 +157,53 @@ int tinyjambu_128_aead_decrypt
         m[0] = (uint8_t)data;
         m[1] = (uint8_t)(data >> 8);
         m[2] = (uint8_t)(data >> 16);
-        c += 3;
     }
 
     /* Check the authentication tag */
-    tinyjambu_generate_tag_128(&state, tag);
-    return tinyjambu_aead_check_tag(mtemp, *mlen, tag, c, TINYJAMBU_TAG_SIZE);
+    tinyjambu_generate_tag_128(&state, computed);
+    return tinyjambu_aead_check_tag
+        (mtemp, mlen, computed, tag, TINYJAMBU_TAG_SIZE);
+}
+
+void tinyjambu_128_aead_encrypt
+    (unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k)
+{
+    *clen = mlen + TINYJAMBU_TAG_SIZE;
+    tinyjambu_128_aead_encrypt_detached
+        (c, c + mlen, m, mlen, ad, adlen, npub, k);
+}
+
+int tinyjambu_128_aead_decrypt
+    (unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k)
+{
+    /* Validate the ciphertext length and set the return "mlen" value */
+    if (clen < TINYJAMBU_TAG_SIZE)
+        return -1;
+    *mlen = clen - TINYJAMBU_TAG_SIZE;
+    return tinyjambu_128_aead_decrypt_detached
+        (m, c, *mlen, c + *mlen, ad, adlen, npub, k);
+}
+
+void tinyjambu_128_key_init(tinyjambu_128_key_t *key, const unsigned char *k)
+{
+    tinyjambu_128_key_p_t *pkey = (tinyjambu_128_key_p_t *)key;
+    pkey->init.k[0] = tinyjambu_key_load_even(k);
+    pkey->init.k[1] = tinyjambu_key_load_odd(k + 4);
+    pkey->init.k[2] = tinyjambu_key_load_even(k + 8);
+    pkey->init.k[3] = tinyjambu_key_load_odd(k + 12);
+    tinyjambu_init_state(&(pkey->init));
+    tinyjambu_permutation_128(&(pkey->init), TINYJAMBU_ROUNDS(1024));
+}
+
+void tinyjambu_128_key_free(tinyjambu_128_key_t *key)
+{
+    tinyjambu_clean(key, sizeof(tinyjambu_128_key_t));
 }
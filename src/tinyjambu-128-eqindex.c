@@ -0,0 +1,410 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TinyJAMBU.h"
+#include "backend/tinyjambu-aead-common.h"
+#include <string.h>
+
+/*
+ * Deterministic encryption uses TinyJAMBU-128-SIV with an all-zero nonce
+ * and the column name as the associated data.  Everything up to the end
+ * of the associated data is the same for every value in the column, so
+ * the column context caches that state and each value starts from a copy.
+ *
+ * Because all values in a batch start from the same state, the first
+ * words of four values can be absorbed in lock-step across the lanes.
+ * Once the shortest value in a group of four runs out, the remaining
+ * words of each value are absorbed one lane at a time.  Column values
+ * tend to be of similar lengths, so most of the work is done in lanes.
+ *
+ * The tag of the value is all that is needed to find it in the index,
+ * so lookups only perform the authentication pass of SIV.
+ */
+
+/**
+ * \brief Number of tags to compute at once when inserting into or
+ * looking up a batch of values in an index.
+ */
+#define TINYJAMBU_EQINDEX_BATCH 64
+
+/**
+ * \brief Private state for a column context.
+ */
+typedef struct
+{
+    /** State after absorbing the key, nonce, and column name */
+    tinyjambu_128_state_t state;
+
+} tinyjambu_128_column_p_t;
+
+/**
+ * \brief Slot in an equality index.
+ */
+typedef struct
+{
+    /** Tag for the value, as a 64-bit integer */
+    uint64_t tag;
+
+    /** Row number for the value, or TINYJAMBU_EQINDEX_NOT_FOUND if empty */
+    uint64_t row;
+
+} tinyjambu_eqindex_slot_t;
+
+/**
+ * \brief Private state for an equality index.
+ */
+typedef struct
+{
+    /** Points to the column context */
+    const tinyjambu_128_column_t *column;
+
+    /** Points to the slots in the hash table */
+    tinyjambu_eqindex_slot_t *slots;
+
+    /** Number of slots minus one */
+    size_t mask;
+
+    /** Number of values in the index */
+    size_t count;
+
+} tinyjambu_128_eqindex_p_t;
+
+/** @cond */
+
+/* Compile-time checks that the private structures can fit within the
+ * bounds of the public ones.  These lines of code will fail to compile
+ * if a private structure is too large for the public one. */
+typedef int tinyjambu_128_column_size_check
+    [(sizeof(tinyjambu_128_column_p_t) <=
+            sizeof(tinyjambu_128_column_t)) * 2 - 1];
+typedef int tinyjambu_128_eqindex_size_check
+    [(sizeof(tinyjambu_128_eqindex_p_t) <=
+            sizeof(tinyjambu_128_eqindex_t)) * 2 - 1];
+
+/** @endcond */
+
+void tinyjambu_128_column_init
+    (tinyjambu_128_column_t *column, const unsigned char *k,
+     const unsigned char *name, size_t namelen)
+{
+    tinyjambu_128_column_p_t *col = (tinyjambu_128_column_p_t *)column;
+    unsigned char nonce[TINYJAMBU_NONCE_SIZE] = {0};
+    col->state.k[0] = tinyjambu_key_load_even(k);
+    col->state.k[1] = tinyjambu_key_load_odd(k + 4);
+    col->state.k[2] = tinyjambu_key_load_even(k + 8);
+    col->state.k[3] = tinyjambu_key_load_odd(k + 12);
+    tinyjambu_setup_128(&(col->state), nonce, 0x90);
+    tinyjambu_absorb_128
+        (&(col->state), name, namelen, 0x30, TINYJAMBU_ROUNDS(640));
+}
+
+void tinyjambu_128_column_free(tinyjambu_128_column_t *column)
+{
+    tinyjambu_clean(column, sizeof(tinyjambu_128_column_t));
+}
+
+/* Sets up the state for the encryption pass from the tag */
+static void tinyjambu_128_column_setup_encrypt
+    (const tinyjambu_128_column_t *column, tinyjambu_128_state_t *state,
+     const unsigned char *tag)
+{
+    static unsigned char const zero_nonce[4] = {0, 0, 0, 0};
+    memcpy(state->k, ((const tinyjambu_128_column_p_t *)column)->state.k,
+           sizeof(state->k));
+    tinyjambu_siv_setup_128(state, zero_nonce, tag);
+}
+
+void tinyjambu_128_column_encrypt
+    (const tinyjambu_128_column_t *column,
+     unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen)
+{
+    tinyjambu_128_state_t state =
+        ((const tinyjambu_128_column_p_t *)column)->state;
+    unsigned char tag[TINYJAMBU_TAG_SIZE];
+
+    /* Authenticate the plaintext to produce the tag */
+    *clen = mlen + TINYJAMBU_TAG_SIZE;
+    tinyjambu_absorb_128(&state, m, mlen, 0x50, TINYJAMBU_ROUNDS(1024));
+    tinyjambu_generate_tag_128(&state, tag);
+
+    /* Encrypt the plaintext with a nonce that is derived from the tag */
+    tinyjambu_128_column_setup_encrypt(column, &state, tag);
+    tinyjambu_siv_encrypt_128(&state, c, m, mlen);
+    memcpy(c + mlen, tag, TINYJAMBU_TAG_SIZE);
+    tinyjambu_clean(&state, sizeof(state));
+}
+
+int tinyjambu_128_column_decrypt
+    (const tinyjambu_128_column_t *column,
+     unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen)
+{
+    tinyjambu_128_state_t state;
+    tinyjambu_128_state_t auth =
+        ((const tinyjambu_128_column_p_t *)column)->state;
+    unsigned char tag[TINYJAMBU_TAG_SIZE];
+    unsigned char computed[TINYJAMBU_TAG_SIZE];
+
+    /* Validate the ciphertext length and set the return "mlen" value */
+    if (clen < TINYJAMBU_TAG_SIZE)
+        return -1;
+    *mlen = clen - TINYJAMBU_TAG_SIZE;
+    clen -= TINYJAMBU_TAG_SIZE;
+    memcpy(tag, c + clen, TINYJAMBU_TAG_SIZE);
+
+    /* Decrypt the ciphertext and authenticate the plaintext in a single
+     * pass, interleaving the permutations for the two states */
+    tinyjambu_128_column_setup_encrypt(column, &state, tag);
+    tinyjambu_siv_decrypt_128(&state, &auth, m, c, clen);
+    tinyjambu_clean(&state, sizeof(state));
+
+    /* Check the authentication tag */
+    tinyjambu_generate_tag_128(&auth, computed);
+    tinyjambu_clean(&auth, sizeof(auth));
+    return tinyjambu_aead_check_tag
+        (m, *mlen, computed, tag, TINYJAMBU_TAG_SIZE);
+}
+
+/* Computes the tags for a group of four values across the lanes */
+static void tinyjambu_128_column_tags_x4
+    (const tinyjambu_128_column_t *column, unsigned char *tags,
+     const unsigned char * const *values, const size_t *lens)
+{
+    tinyjambu_128_state_t states[4];
+    size_t words = lens[0] / 4;
+    size_t posn;
+    unsigned lane;
+
+    /* Absorb the words that all four values have in common */
+    for (lane = 0; lane < 4; ++lane) {
+        states[lane] = ((const tinyjambu_128_column_p_t *)column)->state;
+        if ((lens[lane] / 4) < words)
+            words = lens[lane] / 4;
+    }
+    for (posn = 0; posn < words * 4; posn += 4) {
+        for (lane = 0; lane < 4; ++lane)
+            tinyjambu_add_domain(&(states[lane]), 0x50);
+        tinyjambu_permutation_128_x4(states, TINYJAMBU_ROUNDS(1024));
+        for (lane = 0; lane < 4; ++lane) {
+            tinyjambu_absorb
+                (&(states[lane]), le_load_word32(values[lane] + posn));
+        }
+    }
+
+    /* Finish off each value individually */
+    for (lane = 0; lane < 4; ++lane) {
+        tinyjambu_absorb_128
+            (&(states[lane]), values[lane] + posn, lens[lane] - posn,
+             0x50, TINYJAMBU_ROUNDS(1024));
+        tinyjambu_generate_tag_128
+            (&(states[lane]), tags + lane * TINYJAMBU_TAG_SIZE);
+    }
+    tinyjambu_clean(states, sizeof(states));
+}
+
+void tinyjambu_128_column_tags
+    (const tinyjambu_128_column_t *column, unsigned char *tags,
+     const unsigned char * const *values, const size_t *lens, size_t count)
+{
+    tinyjambu_128_state_t state;
+    while (count >= 4) {
+        tinyjambu_128_column_tags_x4(column, tags, values, lens);
+        tags += 4 * TINYJAMBU_TAG_SIZE;
+        values += 4;
+        lens += 4;
+        count -= 4;
+    }
+    while (count > 0) {
+        state = ((const tinyjambu_128_column_p_t *)column)->state;
+        tinyjambu_absorb_128
+            (&state, values[0], lens[0], 0x50, TINYJAMBU_ROUNDS(1024));
+        tinyjambu_generate_tag_128(&state, tags);
+        tags += TINYJAMBU_TAG_SIZE;
+        ++values;
+        ++lens;
+        --count;
+    }
+    tinyjambu_clean(&state, sizeof(state));
+}
+
+int tinyjambu_128_eqindex_init
+    (tinyjambu_128_eqindex_t *index, const tinyjambu_128_column_t *column,
+     void *table, size_t table_size)
+{
+    tinyjambu_128_eqindex_p_t *idx = (tinyjambu_128_eqindex_p_t *)index;
+    size_t align, num_slots, posn;
+
+    /* Align the table on a slot boundary */
+    align = (size_t)(((uintptr_t)table) % sizeof(uint64_t));
+    if (align) {
+        align = sizeof(uint64_t) - align;
+        table_size = (table_size > align) ? (table_size - align) : 0;
+    }
+
+    /* Find the largest power of two that fits */
+    num_slots = table_size / sizeof(tinyjambu_eqindex_slot_t);
+    if (num_slots < 2)
+        return -1;
+    while ((num_slots & (num_slots - 1)) != 0)
+        num_slots &= num_slots - 1;
+
+    /* Set up the index with all slots empty */
+    idx->column = column;
+    idx->slots = (tinyjambu_eqindex_slot_t *)
+        (((unsigned char *)table) + align);
+    idx->mask = num_slots - 1;
+    idx->count = 0;
+    for (posn = 0; posn < num_slots; ++posn) {
+        idx->slots[posn].tag = 0;
+        idx->slots[posn].row = TINYJAMBU_EQINDEX_NOT_FOUND;
+    }
+    return 0;
+}
+
+/* Finds the slot for a tag, or the empty slot where it would be inserted */
+static size_t tinyjambu_128_eqindex_probe
+    (const tinyjambu_128_eqindex_p_t *idx, uint64_t tag)
+{
+    size_t posn = (size_t)tag & idx->mask;
+    while (idx->slots[posn].row != TINYJAMBU_EQINDEX_NOT_FOUND &&
+           idx->slots[posn].tag != tag) {
+        posn = (posn + 1) & idx->mask;
+    }
+    return posn;
+}
+
+size_t tinyjambu_128_eqindex_insert
+    (tinyjambu_128_eqindex_t *index, const unsigned char * const *values,
+     const size_t *lens, const uint64_t *rows, size_t count)
+{
+    tinyjambu_128_eqindex_p_t *idx = (tinyjambu_128_eqindex_p_t *)index;
+    unsigned char tags[TINYJAMBU_EQINDEX_BATCH * TINYJAMBU_TAG_SIZE];
+    size_t inserted = 0;
+    size_t batch, posn, slot;
+    uint64_t tag;
+
+    while (count > 0) {
+        batch = count;
+        if (batch > TINYJAMBU_EQINDEX_BATCH)
+            batch = TINYJAMBU_EQINDEX_BATCH;
+        tinyjambu_128_column_tags(idx->column, tags, values, lens, batch);
+        for (posn = 0; posn < batch; ++posn) {
+            tag = le_load_word64(tags + posn * TINYJAMBU_TAG_SIZE);
+            slot = tinyjambu_128_eqindex_probe(idx, tag);
+            if (idx->slots[slot].row == TINYJAMBU_EQINDEX_NOT_FOUND) {
+                /* Always leave one slot empty to terminate the probes */
+                if (idx->count >= idx->mask)
+                    return inserted;
+                idx->slots[slot].tag = tag;
+                ++(idx->count);
+            }
+            idx->slots[slot].row = rows[posn];
+            ++inserted;
+        }
+        values += batch;
+        lens += batch;
+        rows += batch;
+        count -= batch;
+    }
+    return inserted;
+}
+
+size_t tinyjambu_128_eqindex_lookup
+    (const tinyjambu_128_eqindex_t *index, uint64_t *rows,
+     const unsigned char * const *values, const size_t *lens, size_t count)
+{
+    const tinyjambu_128_eqindex_p_t *idx =
+        (const tinyjambu_128_eqindex_p_t *)index;
+    unsigned char tags[TINYJAMBU_EQINDEX_BATCH * TINYJAMBU_TAG_SIZE];
+    size_t found = 0;
+    size_t batch, posn;
+    uint64_t tag;
+
+    while (count > 0) {
+        batch = count;
+        if (batch > TINYJAMBU_EQINDEX_BATCH)
+            batch = TINYJAMBU_EQINDEX_BATCH;
+        tinyjambu_128_column_tags(idx->column, tags, values, lens, batch);
+        for (posn = 0; posn < batch; ++posn) {
+            tag = le_load_word64(tags + posn * TINYJAMBU_TAG_SIZE);
+            rows[posn] =
+                idx->slots[tinyjambu_128_eqindex_probe(idx, tag)].row;
+            if (rows[posn] != TINYJAMBU_EQINDEX_NOT_FOUND)
+                ++found;
+        }
+        values += batch;
+        lens += batch;
+        rows += batch;
+        count -= batch;
+    }
+    return found;
+}
+
+uint64_t tinyjambu_128_eqindex_lookup_ciphertext
+    (const tinyjambu_128_eqindex_t *index,
+     const unsigned char *c, size_t clen)
+{
+    const tinyjambu_128_eqindex_p_t *idx =
+        (const tinyjambu_128_eqindex_p_t *)index;
+    uint64_t tag;
+    if (clen < TINYJAMBU_TAG_SIZE)
+        return TINYJAMBU_EQINDEX_NOT_FOUND;
+    tag = le_load_word64(c + clen - TINYJAMBU_TAG_SIZE);
+    return idx->slots[tinyjambu_128_eqindex_probe(idx, tag)].row;
+}
+
+int tinyjambu_128_eqindex_remove
+    (tinyjambu_128_eqindex_t *index, const unsigned char *value, size_t len)
+{
+    tinyjambu_128_eqindex_p_t *idx = (tinyjambu_128_eqindex_p_t *)index;
+    unsigned char tag[TINYJAMBU_TAG_SIZE];
+    size_t hole, posn, home;
+
+    tinyjambu_128_column_tags(idx->column, tag, &value, &len, 1);
+    hole = tinyjambu_128_eqindex_probe(idx, le_load_word64(tag));
+    if (idx->slots[hole].row == TINYJAMBU_EQINDEX_NOT_FOUND)
+        return -1;
+
+    /* Shift later entries in the probe sequence back into the hole
+     * so that lookups do not stop early at the removed slot */
+    posn = hole;
+    for (;;) {
+        posn = (posn + 1) & idx->mask;
+        if (idx->slots[posn].row == TINYJAMBU_EQINDEX_NOT_FOUND)
+            break;
+        home = (size_t)(idx->slots[posn].tag) & idx->mask;
+        if (((posn - home) & idx->mask) >= ((posn - hole) & idx->mask)) {
+            idx->slots[hole] = idx->slots[posn];
+            hole = posn;
+        }
+    }
+    idx->slots[hole].tag = 0;
+    idx->slots[hole].row = TINYJAMBU_EQINDEX_NOT_FOUND;
+    --(idx->count);
+    return 0;
+}
+
+size_t tinyjambu_128_eqindex_count(const tinyjambu_128_eqindex_t *index)
+{
+    return ((const tinyjambu_128_eqindex_p_t *)index)->count;
+}
@@ -0,0 +1,476 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#if defined(HAVE_CONFIG_H)
+#include <config.h>
+#endif
+#include "TinyJAMBU.h"
+#include "backend/tinyjambu-aead-common.h"
+#include <stdlib.h>
+#include <string.h>
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#define TINYJAMBU_KEYCACHE_PTHREAD 1
+#endif
+
+/*
+ * The cache is a set-associative table: a key identifier is hashed to
+ * pick a set of 8 slots, and the key can live in any slot of that set.
+ * Sets are assigned to shards in turn, and each shard has a lock for
+ * writers and its own hit, miss, and eviction counters.
+ *
+ * Readers never lock.  Each slot has a sequence counter that is odd while
+ * a writer is changing the slot.  A reader copies the slot and then checks
+ * that the counter did not change, retrying if it did.  Slots are never
+ * freed while the cache exists, so there is nothing for readers to wait
+ * on before memory can be reclaimed, and readers take their own copy of
+ * the key so that the slot can be evicted as soon as the read completes.
+ *
+ * Each slot also has a reference bit which readers set on a hit.  When a
+ * set is full, a CLOCK hand sweeps over the set clearing reference bits
+ * until it finds a slot that has not been used since the last sweep.
+ */
+
+/**
+ * \brief Number of slots in each set.
+ */
+#define TINYJAMBU_KEYCACHE_WAYS 8
+
+/**
+ * \brief Default number of shards.
+ */
+#define TINYJAMBU_KEYCACHE_DEFAULT_SHARDS 16
+
+/**
+ * \brief Maximum number of shards.
+ */
+#define TINYJAMBU_KEYCACHE_MAX_SHARDS 1024
+
+/**
+ * \brief Number of 32-bit words in a pre-computed key.
+ */
+#define TINYJAMBU_KEYCACHE_WORDS 8
+
+/**
+ * \brief Slot in the key cache.
+ */
+typedef struct
+{
+    /** Sequence counter, which is odd while the slot is being changed */
+    uint32_t seq;
+
+    /** Non-zero if the slot contains a key */
+    uint32_t used;
+
+    /** Low and high words of the key identifier */
+    uint32_t id[2];
+
+    /** Words of the pre-computed key */
+    uint32_t words[TINYJAMBU_KEYCACHE_WORDS];
+
+    /** Reference bit for the CLOCK algorithm */
+    uint32_t ref;
+
+    /** Padding to round the slot up to 64 bytes */
+    uint32_t reserved[3];
+
+} tinyjambu_keycache_slot_t;
+
+/**
+ * \brief Shard of the key cache.
+ */
+typedef struct
+{
+#if defined(TINYJAMBU_KEYCACHE_PTHREAD)
+    /** Lock that serializes writers to the sets in this shard */
+    pthread_mutex_t lock;
+#endif
+
+    /** Number of lookups that found the key in the cache */
+    size_t hits;
+
+    /** Number of lookups that did not find the key in the cache */
+    size_t misses;
+
+    /** Number of keys that were evicted to make room for others */
+    size_t evictions;
+
+} tinyjambu_keycache_shard_t;
+
+/**
+ * \brief Shard of the key cache, padded to keep the counters for
+ * different shards in different cache lines.
+ */
+typedef union
+{
+    tinyjambu_keycache_shard_t shard;   /**< Shard information */
+    unsigned char pad[128];             /**< Padding */
+
+} tinyjambu_keycache_shard_pad_t;
+
+struct tinyjambu_128_keycache_s
+{
+    /** Array of all slots, in sets of TINYJAMBU_KEYCACHE_WAYS */
+    tinyjambu_keycache_slot_t *slots;
+
+    /** Position of the CLOCK hand for each set */
+    unsigned char *hands;
+
+    /** Number of sets */
+    size_t num_sets;
+
+    /** Array of shards */
+    tinyjambu_keycache_shard_pad_t *shards;
+
+    /** Number of shards minus one */
+    unsigned shard_mask;
+
+    /** Callback for fetching keys on a miss */
+    tinyjambu_128_keycache_fetch_t fetch;
+
+    /** Context pointer for the callback */
+    void *ctx;
+};
+
+/** @cond */
+
+/* Compile-time check that a pre-computed key fits in the words of a slot */
+typedef int tinyjambu_128_keycache_words_check
+    [(sizeof(tinyjambu_128_key_p_t) ==
+            TINYJAMBU_KEYCACHE_WORDS * sizeof(uint32_t)) * 2 - 1];
+
+/** @endcond */
+
+/* Access to the slot fields, which are shared with lock-free readers */
+#if defined(__GNUC__) && defined(__ATOMIC_ACQUIRE)
+#define tinyjambu_keycache_load(ptr) \
+    (__atomic_load_n((ptr), __ATOMIC_RELAXED))
+#define tinyjambu_keycache_load_acquire(ptr) \
+    (__atomic_load_n((ptr), __ATOMIC_ACQUIRE))
+#define tinyjambu_keycache_store(ptr, value) \
+    (__atomic_store_n((ptr), (value), __ATOMIC_RELAXED))
+#define tinyjambu_keycache_store_release(ptr, value) \
+    (__atomic_store_n((ptr), (value), __ATOMIC_RELEASE))
+#define tinyjambu_keycache_fence_acquire() \
+    (__atomic_thread_fence(__ATOMIC_ACQUIRE))
+#define tinyjambu_keycache_fence_release() \
+    (__atomic_thread_fence(__ATOMIC_RELEASE))
+#define tinyjambu_keycache_count(ptr) \
+    ((void)__atomic_fetch_add((ptr), 1, __ATOMIC_RELAXED))
+#else
+#define tinyjambu_keycache_load(ptr) (*((volatile uint32_t *)(ptr)))
+#define tinyjambu_keycache_load_acquire(ptr) (*((volatile uint32_t *)(ptr)))
+#define tinyjambu_keycache_store(ptr, value) \
+    (*((volatile uint32_t *)(ptr)) = (value))
+#define tinyjambu_keycache_store_release(ptr, value) \
+    (*((volatile uint32_t *)(ptr)) = (value))
+#define tinyjambu_keycache_fence_acquire() do { ; } while (0)
+#define tinyjambu_keycache_fence_release() do { ; } while (0)
+#define tinyjambu_keycache_count(ptr) (++(*((volatile size_t *)(ptr))))
+#endif
+
+#if defined(TINYJAMBU_KEYCACHE_PTHREAD)
+#define tinyjambu_keycache_lock(shard) pthread_mutex_lock(&((shard)->lock))
+#define tinyjambu_keycache_unlock(shard) pthread_mutex_unlock(&((shard)->lock))
+#else
+#define tinyjambu_keycache_lock(shard) do { ; } while (0)
+#define tinyjambu_keycache_unlock(shard) do { ; } while (0)
+#endif
+
+/* Mixes the bits of a key identifier to select a set */
+static uint64_t tinyjambu_keycache_hash(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/* Reads a slot without locking; returns non-zero if it holds the key */
+static int tinyjambu_keycache_read
+    (tinyjambu_keycache_slot_t *slot, uint64_t key_id, uint32_t *words)
+{
+    uint32_t seq;
+    int found;
+    unsigned index;
+    for (;;) {
+        seq = tinyjambu_keycache_load_acquire(&(slot->seq));
+        if (seq & 1)
+            continue; /* A writer is changing the slot */
+        found = tinyjambu_keycache_load(&(slot->used)) &&
+                tinyjambu_keycache_load(&(slot->id[0])) == (uint32_t)key_id &&
+                tinyjambu_keycache_load(&(slot->id[1])) ==
+                    (uint32_t)(key_id >> 32);
+        if (found) {
+            for (index = 0; index < TINYJAMBU_KEYCACHE_WORDS; ++index)
+                words[index] = tinyjambu_keycache_load(&(slot->words[index]));
+        }
+        tinyjambu_keycache_fence_acquire();
+        if (tinyjambu_keycache_load(&(slot->seq)) == seq)
+            return found;
+    }
+}
+
+/* Replaces the contents of a slot, or empties it if words is NULL.
+ * Must be called with the lock held for the slot's shard */
+static void tinyjambu_keycache_write
+    (tinyjambu_keycache_slot_t *slot, uint64_t key_id, const uint32_t *words)
+{
+    uint32_t seq = slot->seq;
+    unsigned index;
+    tinyjambu_keycache_store(&(slot->seq), seq + 1);
+    tinyjambu_keycache_fence_release();
+    if (words) {
+        tinyjambu_keycache_store(&(slot->id[0]), (uint32_t)key_id);
+        tinyjambu_keycache_store(&(slot->id[1]), (uint32_t)(key_id >> 32));
+        for (index = 0; index < TINYJAMBU_KEYCACHE_WORDS; ++index)
+            tinyjambu_keycache_store(&(slot->words[index]), words[index]);
+        tinyjambu_keycache_store(&(slot->used), 1);
+    } else {
+        tinyjambu_keycache_store(&(slot->used), 0);
+        tinyjambu_keycache_store(&(slot->id[0]), 0);
+        tinyjambu_keycache_store(&(slot->id[1]), 0);
+        tinyjambu_clean(slot->words, sizeof(slot->words));
+    }
+    tinyjambu_keycache_store(&(slot->ref), 0);
+    tinyjambu_keycache_store_release(&(slot->seq), seq + 2);
+}
+
+/* Finds the set and shard for a key identifier */
+static tinyjambu_keycache_slot_t *tinyjambu_keycache_find_set
+    (tinyjambu_128_keycache_t *cache, uint64_t key_id,
+     tinyjambu_keycache_shard_t **shard, size_t *set)
+{
+    *set = (size_t)(tinyjambu_keycache_hash(key_id) % cache->num_sets);
+    *shard = &(cache->shards[*set & cache->shard_mask].shard);
+    return cache->slots + *set * TINYJAMBU_KEYCACHE_WAYS;
+}
+
+tinyjambu_128_keycache_t *tinyjambu_128_keycache_create
+    (size_t capacity, unsigned shards,
+     tinyjambu_128_keycache_fetch_t fetch, void *ctx)
+{
+    tinyjambu_128_keycache_t *cache;
+    unsigned num_shards;
+    unsigned index;
+
+    /* Round the capacity and the number of shards up */
+    if (capacity < TINYJAMBU_KEYCACHE_WAYS)
+        capacity = TINYJAMBU_KEYCACHE_WAYS;
+    if (!shards)
+        shards = TINYJAMBU_KEYCACHE_DEFAULT_SHARDS;
+    else if (shards > TINYJAMBU_KEYCACHE_MAX_SHARDS)
+        shards = TINYJAMBU_KEYCACHE_MAX_SHARDS;
+    num_shards = 1;
+    while (num_shards < shards)
+        num_shards <<= 1;
+
+    /* Allocate the cache */
+    cache = (tinyjambu_128_keycache_t *)calloc(1, sizeof(*cache));
+    if (!cache)
+        return 0;
+    cache->num_sets = (capacity + TINYJAMBU_KEYCACHE_WAYS - 1) /
+                      TINYJAMBU_KEYCACHE_WAYS;
+    cache->slots = (tinyjambu_keycache_slot_t *)calloc
+        (cache->num_sets * TINYJAMBU_KEYCACHE_WAYS,
+         sizeof(tinyjambu_keycache_slot_t));
+    cache->hands = (unsigned char *)calloc(cache->num_sets, 1);
+    cache->shards = (tinyjambu_keycache_shard_pad_t *)calloc
+        (num_shards, sizeof(tinyjambu_keycache_shard_pad_t));
+    if (!cache->slots || !cache->hands || !cache->shards) {
+        free(cache->slots);
+        free(cache->hands);
+        free(cache->shards);
+        free(cache);
+        return 0;
+    }
+    cache->shard_mask = num_shards - 1;
+    cache->fetch = fetch;
+    cache->ctx = ctx;
+#if defined(TINYJAMBU_KEYCACHE_PTHREAD)
+    for (index = 0; index < num_shards; ++index)
+        pthread_mutex_init(&(cache->shards[index].shard.lock), 0);
+#else
+    (void)index;
+#endif
+    return cache;
+}
+
+void tinyjambu_128_keycache_destroy(tinyjambu_128_keycache_t *cache)
+{
+    unsigned char *slots;
+    size_t size, len;
+    unsigned index;
+    if (!cache)
+        return;
+#if defined(TINYJAMBU_KEYCACHE_PTHREAD)
+    for (index = 0; index <= cache->shard_mask; ++index)
+        pthread_mutex_destroy(&(cache->shards[index].shard.lock));
+#else
+    (void)index;
+#endif
+    slots = (unsigned char *)(cache->slots);
+    size = cache->num_sets * TINYJAMBU_KEYCACHE_WAYS *
+           sizeof(tinyjambu_keycache_slot_t);
+    while (size > 0) {
+        len = size < 0x40000000U ? size : 0x40000000U;
+        tinyjambu_clean(slots, (unsigned)len);
+        slots += len;
+        size -= len;
+    }
+    free(cache->slots);
+    free(cache->hands);
+    free(cache->shards);
+    free(cache);
+}
+
+/* Inserts pre-computed key words into the cache */
+static void tinyjambu_keycache_insert_words
+    (tinyjambu_128_keycache_t *cache, uint64_t key_id, const uint32_t *words)
+{
+    tinyjambu_keycache_shard_t *shard;
+    tinyjambu_keycache_slot_t *ways;
+    tinyjambu_keycache_slot_t *slot = 0;
+    size_t set;
+    unsigned index, hand;
+
+    ways = tinyjambu_keycache_find_set(cache, key_id, &shard, &set);
+    tinyjambu_keycache_lock(shard);
+
+    /* Replace the key if it is already present, or else use a free slot */
+    for (index = 0; index < TINYJAMBU_KEYCACHE_WAYS; ++index) {
+        if (ways[index].used && ways[index].id[0] == (uint32_t)key_id &&
+                ways[index].id[1] == (uint32_t)(key_id >> 32)) {
+            slot = &(ways[index]);
+            break;
+        }
+        if (!slot && !(ways[index].used))
+            slot = &(ways[index]);
+    }
+
+    /* Sweep the CLOCK hand to find a victim if the set is full */
+    if (!slot) {
+        hand = cache->hands[set];
+        while (tinyjambu_keycache_load(&(ways[hand].ref))) {
+            tinyjambu_keycache_store(&(ways[hand].ref), 0);
+            hand = (hand + 1) % TINYJAMBU_KEYCACHE_WAYS;
+        }
+        slot = &(ways[hand]);
+        cache->hands[set] = (unsigned char)
+            ((hand + 1) % TINYJAMBU_KEYCACHE_WAYS);
+        tinyjambu_keycache_write(slot, 0, 0);
+        tinyjambu_keycache_count(&(shard->evictions));
+    }
+    tinyjambu_keycache_write(slot, key_id, words);
+    tinyjambu_keycache_unlock(shard);
+}
+
+int tinyjambu_128_keycache_get
+    (tinyjambu_128_keycache_t *cache, uint64_t key_id,
+     tinyjambu_128_key_t *key)
+{
+    tinyjambu_keycache_shard_t *shard;
+    tinyjambu_keycache_slot_t *ways;
+    uint32_t words[TINYJAMBU_KEYCACHE_WORDS];
+    unsigned char k[TINYJAMBU_128_KEY_SIZE];
+    size_t set;
+    unsigned index;
+
+    /* Look for the key in its set without locking */
+    ways = tinyjambu_keycache_find_set(cache, key_id, &shard, &set);
+    for (index = 0; index < TINYJAMBU_KEYCACHE_WAYS; ++index) {
+        if (tinyjambu_keycache_read(&(ways[index]), key_id, words)) {
+            if (!tinyjambu_keycache_load(&(ways[index].ref)))
+                tinyjambu_keycache_store(&(ways[index].ref), 1);
+            tinyjambu_keycache_count(&(shard->hits));
+            memcpy(key, words, sizeof(words));
+            tinyjambu_clean(words, sizeof(words));
+            return 0;
+        }
+    }
+    tinyjambu_keycache_count(&(shard->misses));
+
+    /* Fetch the key and add it to the cache */
+    if (!cache->fetch || (*(cache->fetch))(cache->ctx, key_id, k) != 0) {
+        tinyjambu_clean(k, sizeof(k));
+        return -1;
+    }
+    tinyjambu_128_key_init(key, k);
+    tinyjambu_keycache_insert_words(cache, key_id, (const uint32_t *)key);
+    tinyjambu_clean(k, sizeof(k));
+    return 0;
+}
+
+void tinyjambu_128_keycache_insert
+    (tinyjambu_128_keycache_t *cache, uint64_t key_id,
+     const unsigned char *k)
+{
+    tinyjambu_128_key_t key;
+    tinyjambu_128_key_init(&key, k);
+    tinyjambu_keycache_insert_words(cache, key_id, (const uint32_t *)&key);
+    tinyjambu_128_key_free(&key);
+}
+
+int tinyjambu_128_keycache_remove
+    (tinyjambu_128_keycache_t *cache, uint64_t key_id)
+{
+    tinyjambu_keycache_shard_t *shard;
+    tinyjambu_keycache_slot_t *ways;
+    size_t set;
+    unsigned index;
+    int result = -1;
+    ways = tinyjambu_keycache_find_set(cache, key_id, &shard, &set);
+    tinyjambu_keycache_lock(shard);
+    for (index = 0; index < TINYJAMBU_KEYCACHE_WAYS; ++index) {
+        if (ways[index].used && ways[index].id[0] == (uint32_t)key_id &&
+                ways[index].id[1] == (uint32_t)(key_id >> 32)) {
+            tinyjambu_keycache_write(&(ways[index]), 0, 0);
+            result = 0;
+            break;
+        }
+    }
+    tinyjambu_keycache_unlock(shard);
+    return result;
+}
+
+void tinyjambu_128_keycache_stats
+    (const tinyjambu_128_keycache_t *cache, uint64_t *hits,
+     uint64_t *misses, uint64_t *evictions)
+{
+    const tinyjambu_keycache_shard_t *shard;
+    uint64_t h = 0, m = 0, e = 0;
+    unsigned index;
+    for (index = 0; index <= cache->shard_mask; ++index) {
+        shard = &(cache->shards[index].shard);
+        h += shard->hits;
+        m += shard->misses;
+        e += shard->evictions;
+    }
+    if (hits)
+        *hits = h;
+    if (misses)
+        *misses = m;
+    if (evictions)
+        *evictions = e;
+}
@@ -0,0 +1,390 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TinyJAMBU.h"
+#include "backend/tinyjambu-aead-common.h"
+#include <string.h>
+
+/*
+ * The lane scheduler breaks each TinyJAMBU-128 AEAD job down into a
+ * sequence of operations of the form "add domain separator, permute for
+ * N rounds, absorb or squeeze a word".  Up to four jobs are in progress
+ * at once, each in its own lane with its own key.
+ *
+ * The operations in the different lanes may need different numbers of
+ * rounds; 640 steps for the nonce and associated data, and 1024 steps
+ * for the message and the first half of the tag.  Every round of the
+ * TinyJAMBU-128 permutation uses the same key schedule, so a permutation
+ * of N rounds can be split into smaller pieces.  On each iteration, all
+ * lanes are advanced by the smallest number of rounds that any lane still
+ * needs, and the lanes that reach the end of their permutation move onto
+ * their next operation.  When a job finishes, its lane is refilled from
+ * the queue straight away so that short jobs do not wait for long ones.
+ */
+
+/**
+ * \brief Number of lanes in the scheduler.
+ */
+#define TINYJAMBU_SCHED_LANES 4
+
+/* Phases of processing for a job in a lane */
+#define TINYJAMBU_SCHED_IDLE    0   /**< No job in the lane */
+#define TINYJAMBU_SCHED_NONCE   1   /**< Absorbing the nonce */
+#define TINYJAMBU_SCHED_AD      2   /**< Absorbing the associated data */
+#define TINYJAMBU_SCHED_MSG     3   /**< Encrypting or decrypting */
+#define TINYJAMBU_SCHED_TAG1    4   /**< Generating the first tag word */
+#define TINYJAMBU_SCHED_TAG2    5   /**< Generating the second tag word */
+
+/**
+ * \brief Information about a single lane in the scheduler.
+ */
+typedef struct
+{
+    /** Job that is being processed in this lane, or NULL if idle */
+    tinyjambu_128_aead_job_t *job;
+
+    /** Position within the data for the current phase */
+    size_t posn;
+
+    /** Current phase of processing for the job */
+    unsigned phase;
+
+    /** Number of rounds that remain for the current permutation */
+    unsigned rounds;
+
+    /** Authentication tag that was computed for the job */
+    unsigned char tag[TINYJAMBU_TAG_SIZE];
+
+} tinyjambu_sched_lane_t;
+
+/**
+ * \brief Private state information for the lane scheduler.
+ */
+typedef struct
+{
+    /** Permutation states for the lanes */
+    tinyjambu_128_state_t states[TINYJAMBU_SCHED_LANES];
+
+    /** Information about the job in each lane */
+    tinyjambu_sched_lane_t lanes[TINYJAMBU_SCHED_LANES];
+
+    /** Queue of jobs that are waiting for a lane */
+    tinyjambu_128_aead_job_t *head;
+    tinyjambu_128_aead_job_t *tail;
+
+    /** Queue of completed jobs that are waiting to be polled */
+    tinyjambu_128_aead_job_t *done_head;
+    tinyjambu_128_aead_job_t *done_tail;
+
+    /** Completion callback, or NULL to use polling */
+    tinyjambu_128_sched_callback_t callback;
+
+} tinyjambu_128_sched_p_t;
+
+/** @cond */
+
+/* Compile-time check that tinyjambu_128_sched_p_t can fit within the
+ * bounds of tinyjambu_128_sched_t.  This line of code will fail to
+ * compile if the private structure is too large for the public one. */
+typedef int tinyjambu_128_sched_size_check
+    [(sizeof(tinyjambu_128_sched_p_t) <=
+            sizeof(tinyjambu_128_sched_t)) * 2 - 1];
+
+/** @endcond */
+
+/* Loads a word of up to 4 bytes in little-endian byte order */
+static uint32_t tinyjambu_sched_load
+    (const unsigned char *data, size_t len)
+{
+    if (len >= 4)
+        return le_load_word32(data);
+    else if (len == 3)
+        return le_load_word16(data) | (((uint32_t)(data[2])) << 16);
+    else if (len == 2)
+        return le_load_word16(data);
+    else
+        return data[0];
+}
+
+/* Stores a word of up to 4 bytes in little-endian byte order */
+static void tinyjambu_sched_store
+    (unsigned char *data, size_t len, uint32_t value)
+{
+    if (len >= 4) {
+        le_store_word32(data, value);
+        return;
+    }
+    data[0] = (uint8_t)value;
+    if (len >= 2)
+        data[1] = (uint8_t)(value >> 8);
+    if (len >= 3)
+        data[2] = (uint8_t)(value >> 16);
+}
+
+/* Starts the next operation for a lane by adding the domain separator
+ * and setting the number of rounds for the permutation */
+static void tinyjambu_sched_start_op
+    (tinyjambu_128_state_t *state, tinyjambu_sched_lane_t *lane)
+{
+    const tinyjambu_128_aead_job_t *job = lane->job;
+    for (;;) {
+        switch (lane->phase) {
+        case TINYJAMBU_SCHED_NONCE:
+            if (lane->posn < TINYJAMBU_NONCE_SIZE) {
+                tinyjambu_add_domain(state, 0x10);
+                lane->rounds = TINYJAMBU_ROUNDS(640);
+                return;
+            }
+            lane->phase = TINYJAMBU_SCHED_AD;
+            lane->posn = 0;
+            break;
+
+        case TINYJAMBU_SCHED_AD:
+            if (lane->posn < job->adlen) {
+                tinyjambu_add_domain(state, 0x30);
+                lane->rounds = TINYJAMBU_ROUNDS(640);
+                return;
+            }
+            lane->phase = TINYJAMBU_SCHED_MSG;
+            lane->posn = 0;
+            break;
+
+        case TINYJAMBU_SCHED_MSG:
+            if (lane->posn < job->inlen) {
+                tinyjambu_add_domain(state, 0x50);
+                lane->rounds = TINYJAMBU_ROUNDS(1024);
+                return;
+            }
+            lane->phase = TINYJAMBU_SCHED_TAG1;
+            break;
+
+        case TINYJAMBU_SCHED_TAG1:
+            tinyjambu_add_domain(state, 0x70);
+            lane->rounds = TINYJAMBU_ROUNDS(1024);
+            return;
+
+        default:
+            tinyjambu_add_domain(state, 0x70);
+            lane->rounds = TINYJAMBU_ROUNDS(640);
+            return;
+        }
+    }
+}
+
+/* Finishes the current operation for a lane after the permutation.
+ * Returns non-zero if the job has now completed */
+static int tinyjambu_sched_finish_op
+    (tinyjambu_128_state_t *state, tinyjambu_sched_lane_t *lane)
+{
+    tinyjambu_128_aead_job_t *job = lane->job;
+    uint32_t data;
+    size_t len;
+
+    switch (lane->phase) {
+    case TINYJAMBU_SCHED_NONCE:
+        tinyjambu_absorb(state, le_load_word32(job->npub + lane->posn));
+        lane->posn += 4;
+        break;
+
+    case TINYJAMBU_SCHED_AD:
+        len = job->adlen - lane->posn;
+        if (len > 4)
+            len = 4;
+        tinyjambu_absorb(state, tinyjambu_sched_load(job->ad + lane->posn, len));
+        if (len < 4)
+            tinyjambu_add_domain(state, (uint32_t)len);
+        lane->posn += len;
+        break;
+
+    case TINYJAMBU_SCHED_MSG:
+        len = job->inlen - lane->posn;
+        if (len > 4)
+            len = 4;
+        data = tinyjambu_sched_load(job->in + lane->posn, len);
+        if (job->decrypt) {
+            data ^= tinyjambu_squeeze(state);
+            if (len < 4)
+                data &= (((uint32_t)1) << (len * 8)) - 1U;
+            tinyjambu_absorb(state, data);
+        } else {
+            tinyjambu_absorb(state, data);
+            data ^= tinyjambu_squeeze(state);
+        }
+        if (len < 4)
+            tinyjambu_add_domain(state, (uint32_t)len);
+        tinyjambu_sched_store(job->out + lane->posn, len, data);
+        lane->posn += len;
+        break;
+
+    case TINYJAMBU_SCHED_TAG1:
+        le_store_word32(lane->tag, tinyjambu_squeeze(state));
+        lane->phase = TINYJAMBU_SCHED_TAG2;
+        break;
+
+    default:
+        le_store_word32(lane->tag + 4, tinyjambu_squeeze(state));
+        return 1;
+    }
+    return 0;
+}
+
+/* Completes the job in a lane and makes the lane idle */
+static void tinyjambu_sched_complete
+    (tinyjambu_128_sched_p_t *psched, unsigned index)
+{
+    tinyjambu_sched_lane_t *lane = &(psched->lanes[index]);
+    tinyjambu_128_aead_job_t *job = lane->job;
+
+    /* Check or output the authentication tag */
+    if (job->decrypt) {
+        job->result = tinyjambu_aead_check_tag
+            (job->out, job->inlen, lane->tag, job->tag, TINYJAMBU_TAG_SIZE);
+    } else {
+        memcpy(job->tag, lane->tag, TINYJAMBU_TAG_SIZE);
+        job->result = 0;
+    }
+
+    /* Make the lane idle and destroy the state */
+    tinyjambu_clean(&(psched->states[index]), sizeof(tinyjambu_128_state_t));
+    tinyjambu_clean(lane->tag, sizeof(lane->tag));
+    lane->job = 0;
+    lane->phase = TINYJAMBU_SCHED_IDLE;
+
+    /* Notify the application that the job is done */
+    job->next = 0;
+    if (psched->callback) {
+        (*(psched->callback))(job);
+    } else {
+        if (psched->done_tail)
+            psched->done_tail->next = job;
+        else
+            psched->done_head = job;
+        psched->done_tail = job;
+    }
+}
+
+void tinyjambu_128_sched_init
+    (tinyjambu_128_sched_t *sched, tinyjambu_128_sched_callback_t callback)
+{
+    tinyjambu_128_sched_p_t *psched = (tinyjambu_128_sched_p_t *)sched;
+    memset(sched, 0, sizeof(tinyjambu_128_sched_t));
+    psched->callback = callback;
+}
+
+void tinyjambu_128_sched_free(tinyjambu_128_sched_t *sched)
+{
+    tinyjambu_clean(sched, sizeof(tinyjambu_128_sched_t));
+}
+
+void tinyjambu_128_sched_submit
+    (tinyjambu_128_sched_t *sched, tinyjambu_128_aead_job_t *job)
+{
+    tinyjambu_128_sched_p_t *psched = (tinyjambu_128_sched_p_t *)sched;
+    job->next = 0;
+    if (psched->tail)
+        psched->tail->next = job;
+    else
+        psched->head = job;
+    psched->tail = job;
+}
+
+size_t tinyjambu_128_sched_run(tinyjambu_128_sched_t *sched)
+{
+    tinyjambu_128_sched_p_t *psched = (tinyjambu_128_sched_p_t *)sched;
+    const tinyjambu_128_key_p_t *pkey;
+    tinyjambu_sched_lane_t *lane;
+    unsigned active[TINYJAMBU_SCHED_LANES];
+    unsigned num_active, index, rounds;
+    size_t completed = 0;
+
+    for (;;) {
+        /* Refill the idle lanes from the queue and find the smallest
+         * number of rounds that is needed by any active lane */
+        num_active = 0;
+        rounds = 0;
+        for (index = 0; index < TINYJAMBU_SCHED_LANES; ++index) {
+            lane = &(psched->lanes[index]);
+            if (!lane->job && psched->head) {
+                lane->job = psched->head;
+                psched->head = lane->job->next;
+                if (!psched->head)
+                    psched->tail = 0;
+                pkey = (const tinyjambu_128_key_p_t *)(lane->job->key);
+                psched->states[index] = pkey->init;
+                lane->phase = TINYJAMBU_SCHED_NONCE;
+                lane->posn = 0;
+                tinyjambu_sched_start_op(&(psched->states[index]), lane);
+            }
+            if (lane->job) {
+                if (!num_active || lane->rounds < rounds)
+                    rounds = lane->rounds;
+                active[num_active++] = index;
+            }
+        }
+        if (!num_active)
+            break;
+
+        /* Advance all lanes by the same number of rounds */
+        if (num_active == 1) {
+            tinyjambu_permutation_128
+                (&(psched->states[active[0]]), rounds);
+        } else if (num_active == 2) {
+            tinyjambu_permutation_128_x2
+                (&(psched->states[active[0]]),
+                 &(psched->states[active[1]]), rounds);
+        } else {
+            tinyjambu_permutation_128_x4(psched->states, rounds);
+        }
+
+        /* Move the lanes that have finished their permutation onto
+         * their next operation, or complete the job */
+        for (index = 0; index < num_active; ++index) {
+            lane = &(psched->lanes[active[index]]);
+            lane->rounds -= rounds;
+            if (lane->rounds != 0)
+                continue;
+            if (tinyjambu_sched_finish_op
+                    (&(psched->states[active[index]]), lane)) {
+                tinyjambu_sched_complete(psched, active[index]);
+                ++completed;
+            } else {
+                tinyjambu_sched_start_op
+                    (&(psched->states[active[index]]), lane);
+            }
+        }
+    }
+    return completed;
+}
+
+tinyjambu_128_aead_job_t *tinyjambu_128_sched_poll
+    (tinyjambu_128_sched_t *sched)
+{
+    tinyjambu_128_sched_p_t *psched = (tinyjambu_128_sched_p_t *)sched;
+    tinyjambu_128_aead_job_t *job = psched->done_head;
+    if (job) {
+        psched->done_head = job->next;
+        if (!psched->done_head)
+            psched->done_tail = 0;
+        job->next = 0;
+    }
+    return job;
+}
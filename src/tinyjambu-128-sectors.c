@@ -0,0 +1,384 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#if defined(HAVE_CONFIG_H)
+#include <config.h>
+#endif
+#include "TinyJAMBU.h"
+#include "backend/tinyjambu-aead-common.h"
+#include <string.h>
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#define TINYJAMBU_SECTORS_PTHREAD 1
+#endif
+
+/*
+ * Storage sectors are all the same size and use the same key, so a batch
+ * of sectors maps very well onto the multi-lane permutations.  Every lane
+ * performs exactly the same sequence of steps with different data, which
+ * means that no lane ever has to wait for the others to catch up.
+ *
+ * Encryption processes four sectors at a time, one per lane, first for
+ * the authentication pass and then for the encryption pass.  Decryption
+ * processes two sectors at a time, each of which uses two lanes: one to
+ * decrypt the sector and the other to authenticate the plaintext.
+ *
+ * Because all lanes share the key, the state after the initial key
+ * permutation is the same for every lane and is only computed once.
+ */
+
+/**
+ * \brief Maximum number of threads to use for a single batch.
+ */
+#define TINYJAMBU_SECTORS_MAX_THREADS 64
+
+/**
+ * \brief Minimum number of bytes that are worth giving to a separate thread.
+ */
+#define TINYJAMBU_SECTORS_THREAD_BYTES 16384
+
+/**
+ * \brief Information about a batch of sectors that is being processed.
+ */
+typedef struct
+{
+    /** Points to the output sectors */
+    unsigned char *out;
+
+    /** Points to the input sectors */
+    const unsigned char *in;
+
+    /** Points to the tags; written when encrypting and read otherwise */
+    unsigned char *tags;
+
+    /** Points to the 16 bytes of the key */
+    const unsigned char *k;
+
+    /** Key schedule for the lanes, with the key words inverted */
+    tinyjambu_128_state_t key;
+
+    /** Size of each sector in bytes */
+    size_t sector_size;
+
+    /** Number of the first sector in the batch */
+    uint64_t sector;
+
+    /** Non-zero when encrypting, zero when decrypting */
+    int encrypt;
+
+} tinyjambu_sectors_batch_t;
+
+void tinyjambu_128_siv_sector_nonce(unsigned char *npub, uint64_t sector)
+{
+    le_store_word32(npub, (uint32_t)sector);
+    le_store_word32(npub + 4, (uint32_t)(sector >> 32));
+    le_store_word32(npub + 8, 0);
+}
+
+/* Encrypts four sectors, one per lane */
+static void tinyjambu_sectors_encrypt_x4
+    (const tinyjambu_sectors_batch_t *batch, uint64_t first)
+{
+    tinyjambu_128_state_t states[4];
+    unsigned char nonces[4 * TINYJAMBU_NONCE_SIZE];
+    unsigned char tags[4 * TINYJAMBU_TAG_SIZE];
+    unsigned char domains[4];
+    const unsigned char *data[4];
+    size_t size = batch->sector_size;
+    const unsigned char *m = batch->in + first * size;
+    unsigned char *c = batch->out + first * size;
+    unsigned lane;
+
+    /* Authenticate the plaintext of each sector */
+    for (lane = 0; lane < 4; ++lane) {
+        tinyjambu_128_siv_sector_nonce
+            (nonces + lane * TINYJAMBU_NONCE_SIZE,
+             batch->sector + first + lane);
+        domains[lane] = 0x90;
+        data[lane] = m + lane * size;
+    }
+    tinyjambu_setup_128_x4(states, &(batch->key), nonces, domains);
+    tinyjambu_absorb_128_x4(states, data, size, 0x50, TINYJAMBU_ROUNDS(1024));
+    tinyjambu_generate_tag_128_x4(states, tags);
+
+    /* Encrypt each sector with a nonce that is derived from its tag */
+    for (lane = 0; lane < 4; ++lane) {
+        memcpy(batch->tags + (first + lane) * TINYJAMBU_TAG_SIZE,
+               tags + lane * TINYJAMBU_TAG_SIZE, TINYJAMBU_TAG_SIZE);
+        memcpy(nonces + lane * TINYJAMBU_NONCE_SIZE + 4,
+               tags + lane * TINYJAMBU_TAG_SIZE, TINYJAMBU_TAG_SIZE);
+        domains[lane] = 0xB0;
+    }
+    tinyjambu_setup_128_x4(states, &(batch->key), nonces, domains);
+    tinyjambu_siv_encrypt_128_x4(states, c, m, size);
+    tinyjambu_clean(states, sizeof(states));
+}
+
+/* Decrypts two sectors, using lanes 0 and 2 to decrypt and lanes 1
+ * and 3 to authenticate.  Returns -1 if either sector is invalid */
+static int tinyjambu_sectors_decrypt_x2
+    (const tinyjambu_sectors_batch_t *batch, uint64_t first)
+{
+    tinyjambu_128_state_t states[4];
+    unsigned char nonces[4 * TINYJAMBU_NONCE_SIZE];
+    unsigned char tags[4 * TINYJAMBU_TAG_SIZE];
+    unsigned char domains[4];
+    size_t size = batch->sector_size;
+    const unsigned char *c = batch->in + first * size;
+    unsigned char *m = batch->out + first * size;
+    const unsigned char *tag;
+    unsigned lane;
+    int result = 0;
+
+    /* Set up the decryption and authentication lanes for each sector */
+    for (lane = 0; lane < 4; lane += 2) {
+        tag = batch->tags + (first + lane / 2) * TINYJAMBU_TAG_SIZE;
+        tinyjambu_128_siv_sector_nonce
+            (nonces + (lane + 1) * TINYJAMBU_NONCE_SIZE,
+             batch->sector + first + lane / 2);
+        memcpy(nonces + lane * TINYJAMBU_NONCE_SIZE,
+               nonces + (lane + 1) * TINYJAMBU_NONCE_SIZE, 4);
+        memcpy(nonces + lane * TINYJAMBU_NONCE_SIZE + 4, tag,
+               TINYJAMBU_TAG_SIZE);
+        domains[lane] = 0xB0;
+        domains[lane + 1] = 0x90;
+    }
+    tinyjambu_setup_128_x4(states, &(batch->key), nonces, domains);
+
+    /* Decrypt the ciphertext and authenticate the plaintext in one pass */
+    tinyjambu_siv_decrypt_128_x2(states, m, c, size);
+
+    /* Check the authentication tags */
+    tinyjambu_generate_tag_128_x4(states, tags);
+    for (lane = 0; lane < 4; lane += 2) {
+        tag = batch->tags + (first + lane / 2) * TINYJAMBU_TAG_SIZE;
+        result |= tinyjambu_aead_check_tag
+            (m + (lane / 2) * size, size,
+             tags + (lane + 1) * TINYJAMBU_TAG_SIZE, tag,
+             TINYJAMBU_TAG_SIZE);
+    }
+    tinyjambu_clean(states, sizeof(states));
+    return result;
+}
+
+/* Processes a range of sectors.  Returns -1 if any sector failed
+ * to authenticate */
+static int tinyjambu_sectors_range
+    (const tinyjambu_sectors_batch_t *batch, uint64_t first, uint64_t count)
+{
+    unsigned char nonce[TINYJAMBU_NONCE_SIZE];
+    size_t size = batch->sector_size;
+    int result = 0;
+
+    /* Process as many sectors as possible in groups across the lanes */
+    if (batch->encrypt) {
+        while (count >= 4) {
+            tinyjambu_sectors_encrypt_x4(batch, first);
+            first += 4;
+            count -= 4;
+        }
+    } else {
+        while (count >= 2) {
+            result |= tinyjambu_sectors_decrypt_x2(batch, first);
+            first += 2;
+            count -= 2;
+        }
+    }
+
+    /* Process the left-over sectors one at a time */
+    while (count > 0) {
+        tinyjambu_128_siv_sector_nonce(nonce, batch->sector + first);
+        if (batch->encrypt) {
+            tinyjambu_128_siv_encrypt_detached
+                (batch->out + first * size,
+                 batch->tags + first * TINYJAMBU_TAG_SIZE,
+                 batch->in + first * size, size, 0, 0, nonce, batch->k);
+        } else {
+            result |= tinyjambu_128_siv_decrypt_detached
+                (batch->out + first * size, batch->in + first * size, size,
+                 batch->tags + first * TINYJAMBU_TAG_SIZE, 0, 0,
+                 nonce, batch->k);
+        }
+        ++first;
+        --count;
+    }
+    return result;
+}
+
+#if defined(TINYJAMBU_SECTORS_PTHREAD)
+
+/**
+ * \brief Range of sectors that is processed by a single thread.
+ */
+typedef struct
+{
+    /** Points to the batch information */
+    const tinyjambu_sectors_batch_t *batch;
+
+    /** Index of the first sector in the range */
+    uint64_t first;
+
+    /** Number of sectors in the range */
+    uint64_t count;
+
+    /** Result of processing the range */
+    int result;
+
+    /** Thread that is processing the range */
+    pthread_t thread;
+
+    /** Non-zero if the thread was started successfully */
+    int started;
+
+} tinyjambu_sectors_thread_t;
+
+/* Processes a range of sectors on a thread */
+static void *tinyjambu_sectors_thread(void *arg)
+{
+    tinyjambu_sectors_thread_t *range = (tinyjambu_sectors_thread_t *)arg;
+    range->result =
+        tinyjambu_sectors_range(range->batch, range->first, range->count);
+    return 0;
+}
+
+/* Processes all sectors of a batch, divided between threads */
+static int tinyjambu_sectors_process
+    (const tinyjambu_sectors_batch_t *batch, size_t count, unsigned threads)
+{
+    tinyjambu_sectors_thread_t ranges[TINYJAMBU_SECTORS_MAX_THREADS];
+    uint64_t groups, per_thread, extra, start, len;
+    unsigned num_threads, index;
+    int result = 0;
+
+    /* Determine how many threads are worth using for this batch.
+     * Sectors are handed out in groups of four to keep the lanes full */
+    if (threads > TINYJAMBU_SECTORS_MAX_THREADS)
+        threads = TINYJAMBU_SECTORS_MAX_THREADS;
+    groups = ((uint64_t)count + 3) / 4;
+    len = ((uint64_t)count) * batch->sector_size;
+    if ((len / TINYJAMBU_SECTORS_THREAD_BYTES) < threads)
+        num_threads = (unsigned)(len / TINYJAMBU_SECTORS_THREAD_BYTES);
+    else
+        num_threads = threads;
+    if (num_threads > groups)
+        num_threads = (unsigned)groups;
+    if (num_threads <= 1)
+        return tinyjambu_sectors_range(batch, 0, count);
+
+    /* Divide the groups between the threads as evenly as possible */
+    per_thread = groups / num_threads;
+    extra = groups % num_threads;
+    start = 0;
+    for (index = 0; index < num_threads; ++index) {
+        len = (per_thread + (index < extra ? 1 : 0)) * 4;
+        if (len > (count - start))
+            len = count - start;
+        ranges[index].batch = batch;
+        ranges[index].first = start;
+        ranges[index].count = len;
+        ranges[index].result = 0;
+        ranges[index].started = 0;
+        start += len;
+    }
+
+    /* Start the helper threads.  If a thread cannot be created, then its
+     * range is processed on the calling thread after the others */
+    for (index = 1; index < num_threads; ++index) {
+        ranges[index].started =
+            (pthread_create(&(ranges[index].thread), 0,
+                            tinyjambu_sectors_thread, &(ranges[index])) == 0);
+    }
+
+    /* Process the first range on the calling thread and then collect
+     * the results from the other threads */
+    for (index = 0; index < num_threads; ++index) {
+        if (ranges[index].started)
+            pthread_join(ranges[index].thread, 0);
+        else
+            tinyjambu_sectors_thread(&(ranges[index]));
+        result |= ranges[index].result;
+    }
+    return result;
+}
+
+#else /* !TINYJAMBU_SECTORS_PTHREAD */
+
+static int tinyjambu_sectors_process
+    (const tinyjambu_sectors_batch_t *batch, size_t count, unsigned threads)
+{
+    (void)threads;
+    return tinyjambu_sectors_range(batch, 0, count);
+}
+
+#endif /* !TINYJAMBU_SECTORS_PTHREAD */
+
+/* Initializes the batch information */
+static void tinyjambu_sectors_init
+    (tinyjambu_sectors_batch_t *batch, unsigned char *out,
+     const unsigned char *in, unsigned char *tags, size_t sector_size,
+     uint64_t sector, const unsigned char *k, int encrypt)
+{
+    batch->out = out;
+    batch->in = in;
+    batch->tags = tags;
+    batch->k = k;
+    batch->key.k[0] = tinyjambu_key_load_even(k);
+    batch->key.k[1] = tinyjambu_key_load_odd(k + 4);
+    batch->key.k[2] = tinyjambu_key_load_even(k + 8);
+    batch->key.k[3] = tinyjambu_key_load_odd(k + 12);
+    batch->sector_size = sector_size;
+    batch->sector = sector;
+    batch->encrypt = encrypt;
+}
+
+int tinyjambu_128_siv_encrypt_sectors
+    (unsigned char *c, unsigned char *tags,
+     const unsigned char *m, size_t sector_size,
+     uint64_t sector, size_t count,
+     const unsigned char *k, unsigned threads)
+{
+    tinyjambu_sectors_batch_t batch;
+    if (!sector_size || (sector_size % 4) != 0)
+        return -1;
+    tinyjambu_sectors_init
+        (&batch, c, m, tags, sector_size, sector, k, 1);
+    tinyjambu_sectors_process(&batch, count, threads);
+    tinyjambu_clean(&batch, sizeof(batch));
+    return 0;
+}
+
+int tinyjambu_128_siv_decrypt_sectors
+    (unsigned char *m, const unsigned char *c,
+     const unsigned char *tags, size_t sector_size,
+     uint64_t sector, size_t count,
+     const unsigned char *k, unsigned threads)
+{
+    tinyjambu_sectors_batch_t batch;
+    int result;
+    if (!sector_size || (sector_size % 4) != 0)
+        return -1;
+    tinyjambu_sectors_init
+        (&batch, m, c, (unsigned char *)tags, sector_size, sector, k, 0);
+    result = tinyjambu_sectors_process(&batch, count, threads);
+    tinyjambu_clean(&batch, sizeof(batch));
+    return result;
+}
@@ -0,0 +1,320 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TinyJAMBU.h"
+#include "backend/tinyjambu-aead-common.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The session table keeps each field of a session in its own array:
+ * the nonce counters, the four key words, and optionally the four state
+ * words after the key setup permutation.  A session is 24 bytes, or 40
+ * bytes with the cached setup state, and all sessions live in a single
+ * allocation.  When the session indexes in a batch are sorted, gathering
+ * the keys for the batch walks each array in order.
+ *
+ * Batches are broken into chunks.  The keys for each chunk are gathered
+ * into pre-computed key contexts, computing the setup permutation four
+ * sessions at a time if it is not cached, and then the messages are run
+ * through the lane scheduler, which keeps all four lanes busy even when
+ * the messages have different lengths.
+ */
+
+/**
+ * \brief Maximum number of messages to process in a single chunk.
+ */
+#define TINYJAMBU_SESSION_TABLE_CHUNK 64
+
+struct tinyjambu_128_session_table_s
+{
+    /** Nonce counter for each session */
+    uint64_t *counter;
+
+    /** Arrays of key words for the sessions */
+    uint32_t *k[4];
+
+    /** Arrays of state words after the key setup, or NULL if not cached */
+    uint32_t *s[4];
+
+    /** Number of sessions in the table */
+    uint32_t capacity;
+
+    /** Prefix for all nonces */
+    uint32_t nonce_prefix;
+
+    /** Number of bytes in the allocation for the arrays */
+    size_t size;
+};
+
+/** @cond */
+
+/* Compile-time check that an array of pre-computed keys can be processed
+ * as an array of TinyJAMBU-128 states by the multi-lane permutation */
+typedef int tinyjambu_128_session_table_key_check
+    [(sizeof(tinyjambu_128_key_p_t) == sizeof(tinyjambu_128_key_t) &&
+      sizeof(tinyjambu_128_state_t) == sizeof(tinyjambu_128_key_t)) * 2 - 1];
+
+/** @endcond */
+
+size_t tinyjambu_128_session_table_session_size(unsigned flags)
+{
+    size_t size = sizeof(uint64_t) + 4 * sizeof(uint32_t);
+    if (flags & TINYJAMBU_SESSION_TABLE_CACHE_SETUP)
+        size += 4 * sizeof(uint32_t);
+    return size;
+}
+
+tinyjambu_128_session_table_t *tinyjambu_128_session_table_create
+    (uint32_t capacity, uint32_t nonce_prefix, unsigned flags)
+{
+    tinyjambu_128_session_table_t *table;
+    unsigned char *arrays;
+    unsigned word;
+
+    /* Allocate the table and the arrays */
+    if (!capacity)
+        return 0;
+    table = (tinyjambu_128_session_table_t *)calloc(1, sizeof(*table));
+    if (!table)
+        return 0;
+    table->size = tinyjambu_128_session_table_session_size(flags) *
+                  (size_t)capacity;
+    if ((table->size / capacity) !=
+            tinyjambu_128_session_table_session_size(flags)) {
+        free(table);
+        return 0;
+    }
+    arrays = (unsigned char *)calloc(1, table->size);
+    if (!arrays) {
+        free(table);
+        return 0;
+    }
+
+    /* Carve the allocation up into the separate arrays, with the
+     * 64-bit counters first to keep them aligned */
+    table->counter = (uint64_t *)arrays;
+    arrays += sizeof(uint64_t) * (size_t)capacity;
+    for (word = 0; word < 4; ++word) {
+        table->k[word] = (uint32_t *)arrays;
+        arrays += sizeof(uint32_t) * (size_t)capacity;
+    }
+    if (flags & TINYJAMBU_SESSION_TABLE_CACHE_SETUP) {
+        for (word = 0; word < 4; ++word) {
+            table->s[word] = (uint32_t *)arrays;
+            arrays += sizeof(uint32_t) * (size_t)capacity;
+        }
+    }
+    table->capacity = capacity;
+    table->nonce_prefix = nonce_prefix;
+    return table;
+}
+
+void tinyjambu_128_session_table_destroy
+    (tinyjambu_128_session_table_t *table)
+{
+    unsigned char *arrays;
+    size_t size, len;
+    if (!table)
+        return;
+    arrays = (unsigned char *)(table->counter);
+    size = table->size;
+    while (size > 0) {
+        len = size < 0x40000000U ? size : 0x40000000U;
+        tinyjambu_clean(arrays, (unsigned)len);
+        arrays += len;
+        size -= len;
+    }
+    free(table->counter);
+    free(table);
+}
+
+void tinyjambu_128_session_table_set
+    (tinyjambu_128_session_table_t *table, uint32_t session,
+     const unsigned char *k, uint64_t counter)
+{
+    tinyjambu_128_key_t key;
+    tinyjambu_128_key_p_t *pkey = (tinyjambu_128_key_p_t *)&key;
+    unsigned word;
+    if (table->s[0]) {
+        tinyjambu_128_key_init(&key, k);
+        for (word = 0; word < 4; ++word) {
+            table->k[word][session] = pkey->init.k[word];
+            table->s[word][session] = pkey->init.s[word];
+        }
+        tinyjambu_128_key_free(&key);
+    } else {
+        table->k[0][session] = tinyjambu_key_load_even(k);
+        table->k[1][session] = tinyjambu_key_load_odd(k + 4);
+        table->k[2][session] = tinyjambu_key_load_even(k + 8);
+        table->k[3][session] = tinyjambu_key_load_odd(k + 12);
+    }
+    table->counter[session] = counter;
+}
+
+void tinyjambu_128_session_table_clear
+    (tinyjambu_128_session_table_t *table, uint32_t session)
+{
+    unsigned word;
+    for (word = 0; word < 4; ++word) {
+        tinyjambu_clean(&(table->k[word][session]), sizeof(uint32_t));
+        if (table->s[word])
+            tinyjambu_clean(&(table->s[word][session]), sizeof(uint32_t));
+    }
+    table->counter[session] = 0;
+}
+
+uint64_t tinyjambu_128_session_table_counter
+    (const tinyjambu_128_session_table_t *table, uint32_t session)
+{
+    return table->counter[session];
+}
+
+void tinyjambu_128_session_table_nonce
+    (const tinyjambu_128_session_table_t *table, unsigned char *npub,
+     uint64_t counter)
+{
+    le_store_word32(npub, table->nonce_prefix);
+    le_store_word32(npub + 4, (uint32_t)counter);
+    le_store_word32(npub + 8, (uint32_t)(counter >> 32));
+}
+
+/* Gathers the pre-computed keys for a chunk of sessions */
+static void tinyjambu_session_table_gather
+    (const tinyjambu_128_session_table_t *table, const uint32_t *sessions,
+     size_t count, tinyjambu_128_key_t *keys)
+{
+    tinyjambu_128_state_t *states = (tinyjambu_128_state_t *)keys;
+    uint32_t session;
+    size_t index;
+    unsigned word;
+
+    /* Copy the key words, and the cached setup state if we have it */
+    for (index = 0; index < count; ++index) {
+        session = sessions[index];
+        for (word = 0; word < 4; ++word)
+            states[index].k[word] = table->k[word][session];
+        if (table->s[0]) {
+            for (word = 0; word < 4; ++word)
+                states[index].s[word] = table->s[word][session];
+        } else {
+            tinyjambu_init_state(&(states[index]));
+        }
+    }
+
+    /* Run the key setup permutation four sessions at a time if the
+     * setup state is not cached */
+    if (!table->s[0]) {
+        for (index = 0; (index + 4) <= count; index += 4) {
+            tinyjambu_permutation_128_x4
+                (states + index, TINYJAMBU_ROUNDS(1024));
+        }
+        for (; index < count; ++index) {
+            tinyjambu_permutation_128
+                (&(states[index]), TINYJAMBU_ROUNDS(1024));
+        }
+    }
+}
+
+/* Processes a chunk of messages with the lane scheduler */
+static int tinyjambu_session_table_chunk
+    (tinyjambu_128_session_table_t *table, const uint32_t *sessions,
+     tinyjambu_128_session_msg_t *msgs, size_t count, int decrypt)
+{
+    tinyjambu_128_key_t keys[TINYJAMBU_SESSION_TABLE_CHUNK];
+    tinyjambu_128_aead_job_t jobs[TINYJAMBU_SESSION_TABLE_CHUNK];
+    unsigned char nonces[TINYJAMBU_SESSION_TABLE_CHUNK][TINYJAMBU_NONCE_SIZE];
+    tinyjambu_128_sched_t sched;
+    size_t index;
+    int result = 0;
+
+    /* Gather the keys and assign the nonces */
+    tinyjambu_session_table_gather(table, sessions, count, keys);
+    for (index = 0; index < count; ++index) {
+        if (!decrypt)
+            msgs[index].counter = (table->counter[sessions[index]])++;
+        tinyjambu_128_session_table_nonce
+            (table, nonces[index], msgs[index].counter);
+    }
+
+    /* Run the messages through the lanes of the scheduler */
+    tinyjambu_128_sched_init(&sched, 0);
+    for (index = 0; index < count; ++index) {
+        jobs[index].key = &(keys[index]);
+        jobs[index].npub = nonces[index];
+        jobs[index].ad = msgs[index].ad;
+        jobs[index].adlen = msgs[index].adlen;
+        jobs[index].in = msgs[index].in;
+        jobs[index].inlen = msgs[index].inlen;
+        jobs[index].out = msgs[index].out;
+        jobs[index].tag = msgs[index].tag;
+        jobs[index].decrypt = decrypt;
+        jobs[index].user_data = 0;
+        tinyjambu_128_sched_submit(&sched, &(jobs[index]));
+    }
+    tinyjambu_128_sched_run(&sched);
+    while (tinyjambu_128_sched_poll(&sched) != 0)
+        ; /* Discard the completed jobs; we already know where they are */
+    tinyjambu_128_sched_free(&sched);
+
+    /* Report the results */
+    for (index = 0; index < count; ++index) {
+        msgs[index].result = jobs[index].result;
+        result |= jobs[index].result;
+    }
+    tinyjambu_clean(keys, sizeof(tinyjambu_128_key_t) * count);
+    return result;
+}
+
+void tinyjambu_128_session_table_seal
+    (tinyjambu_128_session_table_t *table, const uint32_t *sessions,
+     tinyjambu_128_session_msg_t *msgs, size_t count)
+{
+    size_t len;
+    while (count > 0) {
+        len = count;
+        if (len > TINYJAMBU_SESSION_TABLE_CHUNK)
+            len = TINYJAMBU_SESSION_TABLE_CHUNK;
+        tinyjambu_session_table_chunk(table, sessions, msgs, len, 0);
+        sessions += len;
+        msgs += len;
+        count -= len;
+    }
+}
+
+int tinyjambu_128_session_table_open
+    (tinyjambu_128_session_table_t *table, const uint32_t *sessions,
+     tinyjambu_128_session_msg_t *msgs, size_t count)
+{
+    size_t len;
+    int result = 0;
+    while (count > 0) {
+        len = count;
+        if (len > TINYJAMBU_SESSION_TABLE_CHUNK)
+            len = TINYJAMBU_SESSION_TABLE_CHUNK;
+        result |= tinyjambu_session_table_chunk(table, sessions, msgs, len, 1);
+        sessions += len;
+        msgs += len;
+        count -= len;
+    }
+    return result;
+}
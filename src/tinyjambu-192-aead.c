@@ -23,8 +23,8 @@
 #include "TinyJAMBU.h"
 #include "backend/tinyjambu-aead-common.h"
 
-void tinyjambu_192_aead_encrypt
-    (unsigned char *c, size_t *clen,
+void tinyjambu_192_aead_encrypt_detached
+    (unsigned char *c, unsigned char *tag,
      const unsigned char *m, size_t mlen,
      const unsigned char *ad, size_t adlen,
      const unsigned char *npub,
@@ -33,9 +33,6 @@ void tinyjambu_192_aead_encrypt
     tinyjambu_192_state_t state;
     uint32_t data;
 
-    /* Set the length of the returned ciphertext */
-    *clen = mlen + TINYJAMBU_TAG_SIZE;
-
     /* Unpack the key and invert it for later */
     state.k[0] = tinyjambu_key_load_even(k);
     state.k[1] = tinyjambu_key_load_odd(k + 4);
@@ -89,26 +86,23 @@ void tinyjambu_192_aead_encrypt
     }
 
     /* Generate the authentication tag */
-    tinyjambu_generate_tag_192(&state, c + mlen);
+    tinyjambu_generate_tag_192(&state, tag);
 }
 
-int tinyjambu_192_aead_decrypt
-    (unsigned char *m, size_t *mlen,
+int tinyjambu_192_aead_decrypt_detached
+    (unsigned char *m,
      const unsigned char *c, size_t clen,
+     const unsigned char *tag,
      const unsigned char *ad, size_t adlen,
      const unsigned char *npub,
      const unsigned char *k)
 {
     unsigned char *mtemp = m;
     tinyjambu_192_state_t state;
-    unsigned char tag[TINYJAMBU_TAG_SIZE];
+    size_t mlen = clen;
+    unsigned char computed[TINYJAMBU_TAG_SIZE];
     uint32_t data;
 
-    /* Validate the ciphertext length and set the return "mlen" value */
-    if (clen < TINYJAMBU_TAG_SIZE)
-        return -1;
-    *mlen = clen - TINYJAMBU_TAG_SIZE;
-
     /* Unpack the key and invert it for later */
     state.k[0] = tinyjambu_key_load_even(k);
     state.k[1] = tinyjambu_key_load_odd(k + 4);
@@ -122,7 +116,6 @@ int tinyjambu_192_aead_decrypt
     tinyjambu_absorb_192(&state, ad, adlen, 0x30, TINYJAMBU_ROUNDS(640));
 
     /* Decrypt the ciphertext to produce the plaintext */
-    clen -= TINYJAMBU_TAG_SIZE;
     while (clen >= 4) {
         tinyjambu_add_domain(&state, 0x50); /* Domain sep for message data */
         tinyjambu_permutation_192(&state, TINYJAMBU_ROUNDS(1152));
@@ -140,7 +133,6 @@ int tinyjambu_192_aead_decrypt
         tinyjambu_absorb(&state, data);
         tinyjambu_add_domain(&state, 0x01);
         m[0] = (uint8_t)data;
-        ++c;
     } else if (clen == 2) {
         tinyjambu_add_domain(&state, 0x50);
         tinyjambu_permutation_192(&state, TINYJAMBU_ROUNDS(1152));
@@ -149,7 +141,6 @@ int tinyjambu_192_aead_decrypt
         tinyjambu_add_domain(&state, 0x02);
         m[0] = (uint8_t)data;
         m[1] = (uint8_t)(data >> 8);
-        c += 2;
     } else if (clen == 3) {
         tinyjambu_add_domain(&state, 0x50);
         tinyjambu_permutation_192(&state, TINYJAMBU_ROUNDS(1152));
@@ -160,10 +151,37 @@ int tinyjambu_192_aead_decrypt
         m[0] = (uint8_t)data;
         m[1] = (uint8_t)(data >> 8);
         m[2] = (uint8_t)(data >> 16);
-        c += 3;
     }
 
     /* Check the authentication tag */
-    tinyjambu_generate_tag_192(&state, tag);
-    return tinyjambu_aead_check_tag(mtemp, *mlen, tag, c, TINYJAMBU_TAG_SIZE);
+    tinyjambu_generate_tag_192(&state, computed);
+    return tinyjambu_aead_check_tag
+        (mtemp, mlen, computed, tag, TINYJAMBU_TAG_SIZE);
+}
+
+void tinyjambu_192_aead_encrypt
+    (unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k)
+{
+    *clen = mlen + TINYJAMBU_TAG_SIZE;
+    tinyjambu_192_aead_encrypt_detached
+        (c, c + mlen, m, mlen, ad, adlen, npub, k);
+}
+
+int tinyjambu_192_aead_decrypt
+    (unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k)
+{
+    /* Validate the ciphertext length and set the return "mlen" value */
+    if (clen < TINYJAMBU_TAG_SIZE)
+        return -1;
+    *mlen = clen - TINYJAMBU_TAG_SIZE;
+    return tinyjambu_192_aead_decrypt_detached
+        (m, c, *mlen, c + *mlen, ad, adlen, npub, k);
 }
@@ -24,19 +24,14 @@
 #include "backend/tinyjambu-aead-common.h"
 #include <string.h>
 
-void tinyjambu_192_siv_encrypt
-    (unsigned char *c, size_t *clen,
+void tinyjambu_192_siv_encrypt_detached
+    (unsigned char *c, unsigned char *tag,
      const unsigned char *m, size_t mlen,
      const unsigned char *ad, size_t adlen,
      const unsigned char *npub,
      const unsigned char *k)
 {
     tinyjambu_192_state_t state;
-    unsigned char nonce[TINYJAMBU_NONCE_SIZE];
-    uint32_t data;
-
-    /* Set the length of the returned ciphertext */
-    *clen = mlen + TINYJAMBU_TAG_SIZE;
 
     /* Unpack the key and invert it for later */
     state.k[0] = tinyjambu_key_load_even(k);
@@ -54,124 +49,78 @@ void tinyjambu_192_siv_encrypt
     tinyjambu_absorb_192(&state, m, mlen, 0x50, TINYJAMBU_ROUNDS(1152));
 
     /* Generate the authentication tag */
-    tinyjambu_generate_tag_192(&state, c + mlen);
+    tinyjambu_generate_tag_192(&state, tag);
 
     /* Re-initialize the state with a new nonce based on the tag */
-    memcpy(nonce, npub, 4);
-    memcpy(nonce + 4, c + mlen, 8);
-    tinyjambu_setup_192(&state, nonce, 0xB0);
+    tinyjambu_siv_setup_192(&state, npub, tag);
 
     /* Encrypt the plaintext to produce the ciphertext */
-    while (mlen >= 4) {
-        tinyjambu_add_domain(&state, 0xD0); /* Domain sep for message data */
-        tinyjambu_permutation_192(&state, TINYJAMBU_ROUNDS(1152));
-        data = le_load_word32(m);
-        data ^= tinyjambu_squeeze(&state);
-        le_store_word32(c, data);
-        c += 4;
-        m += 4;
-        mlen -= 4;
-    }
-    if (mlen == 1) {
-        tinyjambu_add_domain(&state, 0xD0);
-        tinyjambu_permutation_192(&state, TINYJAMBU_ROUNDS(1152));
-        data = m[0];
-        c[0] = (uint8_t)(tinyjambu_squeeze(&state) ^ data);
-    } else if (mlen == 2) {
-        tinyjambu_add_domain(&state, 0xD0);
-        tinyjambu_permutation_192(&state, TINYJAMBU_ROUNDS(1152));
-        data = le_load_word16(m);
-        data ^= tinyjambu_squeeze(&state);
-        c[0] = (uint8_t)data;
-        c[1] = (uint8_t)(data >> 8);
-    } else if (mlen == 3) {
-        tinyjambu_add_domain(&state, 0xD0);
-        tinyjambu_permutation_192(&state, TINYJAMBU_ROUNDS(1152));
-        data = le_load_word16(m) | (((uint32_t)(m[2])) << 16);
-        data ^= tinyjambu_squeeze(&state);
-        c[0] = (uint8_t)data;
-        c[1] = (uint8_t)(data >> 8);
-        c[2] = (uint8_t)(data >> 16);
-    }
+    tinyjambu_siv_encrypt_192(&state, c, m, mlen);
 }
 
-int tinyjambu_192_siv_decrypt
-    (unsigned char *m, size_t *mlen,
+int tinyjambu_192_siv_decrypt_detached
+    (unsigned char *m,
      const unsigned char *c, size_t clen,
+     const unsigned char *tag,
      const unsigned char *ad, size_t adlen,
      const unsigned char *npub,
      const unsigned char *k)
 {
-    unsigned char *mtemp = m;
     tinyjambu_192_state_t state;
-    unsigned char nonce[TINYJAMBU_NONCE_SIZE];
-    size_t m2len;
-    uint32_t data;
-
-    /* Validate the ciphertext length and set the return "mlen" value */
-    if (clen < TINYJAMBU_TAG_SIZE)
-        return -1;
-    *mlen = clen - TINYJAMBU_TAG_SIZE;
+    tinyjambu_192_state_t auth;
+    unsigned char computed[TINYJAMBU_TAG_SIZE];
 
     /* Unpack the key and invert it for later */
-    state.k[0] = tinyjambu_key_load_even(k);
-    state.k[1] = tinyjambu_key_load_odd(k + 4);
-    state.k[2] = tinyjambu_key_load_even(k + 8);
-    state.k[3] = tinyjambu_key_load_odd(k + 12);
-    state.k[4] = tinyjambu_key_load_even(k + 16);
-    state.k[5] = tinyjambu_key_load_odd(k + 20);
+    auth.k[0] = tinyjambu_key_load_even(k);
+    auth.k[1] = tinyjambu_key_load_odd(k + 4);
+    auth.k[2] = tinyjambu_key_load_even(k + 8);
+    auth.k[3] = tinyjambu_key_load_odd(k + 12);
+    auth.k[4] = tinyjambu_key_load_even(k + 16);
+    auth.k[5] = tinyjambu_key_load_odd(k + 20);
+    memcpy(state.k, auth.k, sizeof(state.k));
 
     /* Set up the TinyJAMBU state with the key, nonce, and authentication tag
      * to decrypt the ciphertext to produce the plaintext */
-    m2len = *mlen;
-    memcpy(nonce, npub, 4);
-    memcpy(nonce + 4, c + m2len, 8);
-    tinyjambu_setup_192(&state, nonce, 0xB0);
-
-    /* Decrypt the ciphertext to produce the plaintext */
-    clen = m2len;
-    while (clen >= 4) {
-        tinyjambu_add_domain(&state, 0xD0); /* Domain sep for message data */
-        tinyjambu_permutation_192(&state, TINYJAMBU_ROUNDS(1152));
-        data = le_load_word32(c) ^ tinyjambu_squeeze(&state);
-        le_store_word32(m, data);
-        c += 4;
-        m += 4;
-        clen -= 4;
-    }
-    if (clen == 1) {
-        tinyjambu_add_domain(&state, 0xD0);
-        tinyjambu_permutation_192(&state, TINYJAMBU_ROUNDS(1152));
-        data = (c[0] ^ tinyjambu_squeeze(&state)) & 0xFFU;
-        m[0] = (uint8_t)data;
-        ++c;
-    } else if (clen == 2) {
-        tinyjambu_add_domain(&state, 0xD0);
-        tinyjambu_permutation_192(&state, TINYJAMBU_ROUNDS(1152));
-        data = (le_load_word16(c) ^ tinyjambu_squeeze(&state)) & 0xFFFFU;
-        m[0] = (uint8_t)data;
-        m[1] = (uint8_t)(data >> 8);
-        c += 2;
-    } else if (clen == 3) {
-        tinyjambu_add_domain(&state, 0xD0);
-        tinyjambu_permutation_192(&state, TINYJAMBU_ROUNDS(1152));
-        data = le_load_word16(c) | (((uint32_t)(c[2])) << 16);
-        data = (data ^ tinyjambu_squeeze(&state)) & 0xFFFFFFU;
-        m[0] = (uint8_t)data;
-        m[1] = (uint8_t)(data >> 8);
-        m[2] = (uint8_t)(data >> 16);
-        c += 3;
-    }
-
-    /* Set up the TinyJAMBU state with the key, nonce, and associated data
-     * to perform the authentication pass over the plaintext */
-    tinyjambu_setup_192(&state, npub, 0x90);
-    tinyjambu_absorb_192(&state, ad, adlen, 0x30, TINYJAMBU_ROUNDS(640));
+    tinyjambu_siv_setup_192(&state, npub, tag);
+
+    /* Set up a second TinyJAMBU state with the key, nonce, and associated
+     * data to perform the authentication pass over the plaintext */
+    tinyjambu_setup_192(&auth, npub, 0x90);
+    tinyjambu_absorb_192(&auth, ad, adlen, 0x30, TINYJAMBU_ROUNDS(640));
 
-    /* Authenticate the plaintext */
-    tinyjambu_absorb_192(&state, mtemp, m2len, 0x50, TINYJAMBU_ROUNDS(1152));
+    /* Decrypt the ciphertext and authenticate the plaintext in a single
+     * pass, interleaving the permutations for the two states */
+    tinyjambu_siv_decrypt_192(&state, &auth, m, c, clen);
 
     /* Check the authentication tag */
-    tinyjambu_generate_tag_192(&state, nonce);
-    return tinyjambu_aead_check_tag(mtemp, m2len, nonce, c, TINYJAMBU_TAG_SIZE);
+    tinyjambu_generate_tag_192(&auth, computed);
+    return tinyjambu_aead_check_tag
+        (m, clen, computed, tag, TINYJAMBU_TAG_SIZE);
+}
+
+void tinyjambu_192_siv_encrypt
+    (unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k)
+{
+    *clen = mlen + TINYJAMBU_TAG_SIZE;
+    tinyjambu_192_siv_encrypt_detached
+        (c, c + mlen, m, mlen, ad, adlen, npub, k);
+}
+
+int tinyjambu_192_siv_decrypt
+    (unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k)
+{
+    /* Validate the ciphertext length and set the return "mlen" value */
+    if (clen < TINYJAMBU_TAG_SIZE)
+        return -1;
+    *mlen = clen - TINYJAMBU_TAG_SIZE;
+    return tinyjambu_192_siv_decrypt_detached
+        (m, c, *mlen, c + *mlen, ad, adlen, npub, k);
 }
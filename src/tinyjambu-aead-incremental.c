@@ -0,0 +1,361 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TinyJAMBU.h"
+#include "backend/tinyjambu-aead-common.h"
+#include <string.h>
+
+/*
+ * Incremental AEAD produces exactly the same output as the one-shot
+ * functions, but accepts the message in pieces of any size.  The keystream
+ * word for each message word is in S[2] straight after the permutation,
+ * and absorbing the plaintext only modifies S[3].  So the ciphertext can
+ * be released a byte at a time while the plaintext bytes of the current
+ * word are collected in a buffer, which is absorbed once it is full or
+ * when the operation is finished.
+ *
+ * The exported state has the following format, with multi-byte values
+ * in little-endian byte order:
+ *
+ *      0   "TJAI"
+ *      4   Version, TINYJAMBU_AEAD_EXPORT_VERSION
+ *      5   Size of the key in bytes
+ *      6   Number of bytes in the partial word buffer, 0 to 3
+ *      7   Zero
+ *      8   State words S[0] to S[3]
+ *      24  Partial word buffer, padded with zeroes
+ *      28  Number of message bytes that have been processed
+ *
+ * The key is not exported.  If there are bytes in the partial word
+ * buffer, then the permutation has already been run for the current word
+ * and S[2] still holds its keystream.
+ */
+
+/**
+ * \brief Magic number at the start of an exported state.
+ */
+static unsigned char const tinyjambu_aead_magic[4] = {'T', 'J', 'A', 'I'};
+
+/**
+ * \brief Permutation state for any of the TinyJAMBU variants.
+ */
+typedef union
+{
+    tinyjambu_128_state_t s128;     /**< TinyJAMBU-128 state */
+    tinyjambu_192_state_t s192;     /**< TinyJAMBU-192 state */
+    tinyjambu_256_state_t s256;     /**< TinyJAMBU-256 state */
+
+} tinyjambu_aead_perm_t;
+
+/**
+ * \brief Private state information for incremental TinyJAMBU AEAD.
+ */
+typedef struct
+{
+    /** Key and the permutation state */
+    tinyjambu_aead_perm_t state;
+
+    /** Number of message bytes that have been processed */
+    uint64_t position;
+
+    /** Size of the key in bytes */
+    unsigned key_size;
+
+    /** Number of bytes in the partial word buffer */
+    unsigned posn;
+
+    /** Plaintext bytes of the current partial word */
+    unsigned char buf[4];
+
+} tinyjambu_aead_state_p_t;
+
+/** @cond */
+
+/* Compile-time check that the private structure can fit within the
+ * bounds of the public one.  This line of code will fail to compile
+ * if the private structure is too large for the public one. */
+typedef int tinyjambu_aead_state_size_check
+    [(sizeof(tinyjambu_aead_state_p_t) <=
+            sizeof(tinyjambu_aead_state_t)) * 2 - 1];
+
+/** @endcond */
+
+/* Runs the longer permutation that is used for message words, which has
+ * more rounds for the larger key sizes */
+static void tinyjambu_aead_permute_long
+    (tinyjambu_aead_perm_t *state, unsigned key_size)
+{
+    if (key_size == TINYJAMBU_128_KEY_SIZE)
+        tinyjambu_permutation_128(&(state->s128), TINYJAMBU_ROUNDS(1024));
+    else if (key_size == TINYJAMBU_192_KEY_SIZE)
+        tinyjambu_permutation_192(&(state->s192), TINYJAMBU_ROUNDS(1152));
+    else
+        tinyjambu_permutation_256(&(state->s256), TINYJAMBU_ROUNDS(1280));
+}
+
+/* Loads the key words into the state; returns -1 for a bad key size */
+static int tinyjambu_aead_load_key
+    (tinyjambu_aead_state_p_t *pstate, const unsigned char *k,
+     size_t keylen)
+{
+    uint32_t *words = pstate->state.s128.k;
+    unsigned index;
+    if (keylen != TINYJAMBU_128_KEY_SIZE &&
+            keylen != TINYJAMBU_192_KEY_SIZE &&
+            keylen != TINYJAMBU_256_KEY_SIZE) {
+        return -1;
+    }
+    for (index = 0; index < keylen; index += 8) {
+        *words++ = tinyjambu_key_load_even(k + index);
+        *words++ = tinyjambu_key_load_odd(k + index + 4);
+    }
+    pstate->key_size = (unsigned)keylen;
+    return 0;
+}
+
+/* Sets up the state with the key, nonce, and associated data */
+static void tinyjambu_aead_start
+    (tinyjambu_aead_state_t *state,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k, size_t keylen)
+{
+    tinyjambu_aead_state_p_t *pstate = (tinyjambu_aead_state_p_t *)state;
+    memset(state, 0, sizeof(tinyjambu_aead_state_t));
+    tinyjambu_aead_load_key(pstate, k, keylen);
+    if (keylen == TINYJAMBU_128_KEY_SIZE) {
+        tinyjambu_setup_128(&(pstate->state.s128), npub, 0x10);
+        tinyjambu_absorb_128(&(pstate->state.s128), ad, adlen,
+                             0x30, TINYJAMBU_ROUNDS(640));
+    } else if (keylen == TINYJAMBU_192_KEY_SIZE) {
+        tinyjambu_setup_192(&(pstate->state.s192), npub, 0x10);
+        tinyjambu_absorb_192(&(pstate->state.s192), ad, adlen,
+                             0x30, TINYJAMBU_ROUNDS(640));
+    } else {
+        tinyjambu_setup_256(&(pstate->state.s256), npub, 0x10);
+        tinyjambu_absorb_256(&(pstate->state.s256), ad, adlen,
+                             0x30, TINYJAMBU_ROUNDS(640));
+    }
+}
+
+void tinyjambu_128_aead_start
+    (tinyjambu_aead_state_t *state,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k)
+{
+    tinyjambu_aead_start
+        (state, ad, adlen, npub, k, TINYJAMBU_128_KEY_SIZE);
+}
+
+void tinyjambu_192_aead_start
+    (tinyjambu_aead_state_t *state,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k)
+{
+    tinyjambu_aead_start
+        (state, ad, adlen, npub, k, TINYJAMBU_192_KEY_SIZE);
+}
+
+void tinyjambu_256_aead_start
+    (tinyjambu_aead_state_t *state,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k)
+{
+    tinyjambu_aead_start
+        (state, ad, adlen, npub, k, TINYJAMBU_256_KEY_SIZE);
+}
+
+/* Encrypts or decrypts more of the message */
+static void tinyjambu_aead_update
+    (tinyjambu_aead_state_p_t *pstate, unsigned char *out,
+     const unsigned char *in, size_t len, int decrypt)
+{
+    tinyjambu_128_state_t *state = &(pstate->state.s128);
+    unsigned key_size = pstate->key_size;
+    uint32_t data;
+    unsigned char m;
+    pstate->position += len;
+
+    /* Finish off the current partial word */
+    while (pstate->posn > 0 && len > 0) {
+        data = tinyjambu_squeeze(state) >> (pstate->posn * 8);
+        m = decrypt ? (unsigned char)(in[0] ^ data) : in[0];
+        out[0] = (unsigned char)(in[0] ^ data);
+        pstate->buf[pstate->posn++] = m;
+        if (pstate->posn == 4) {
+            tinyjambu_absorb(state, le_load_word32(pstate->buf));
+            pstate->posn = 0;
+        }
+        ++in;
+        ++out;
+        --len;
+    }
+
+    /* Process as many full words as possible */
+    while (len >= 4) {
+        tinyjambu_add_domain(state, 0x50); /* Domain sep for message data */
+        tinyjambu_aead_permute_long(&(pstate->state), key_size);
+        if (decrypt) {
+            data = le_load_word32(in) ^ tinyjambu_squeeze(state);
+            tinyjambu_absorb(state, data);
+            le_store_word32(out, data);
+        } else {
+            data = le_load_word32(in);
+            tinyjambu_absorb(state, data);
+            le_store_word32(out, data ^ tinyjambu_squeeze(state));
+        }
+        in += 4;
+        out += 4;
+        len -= 4;
+    }
+
+    /* Start a new partial word with the left-over bytes */
+    if (len > 0) {
+        tinyjambu_add_domain(state, 0x50);
+        tinyjambu_aead_permute_long(&(pstate->state), key_size);
+        data = tinyjambu_squeeze(state);
+        while (len > 0) {
+            m = decrypt ? (unsigned char)(in[0] ^ data) : in[0];
+            out[0] = (unsigned char)(in[0] ^ data);
+            pstate->buf[pstate->posn++] = m;
+            data >>= 8;
+            ++in;
+            ++out;
+            --len;
+        }
+    }
+}
+
+/* Absorbs the final partial word and generates the tag */
+static void tinyjambu_aead_finish
+    (tinyjambu_aead_state_p_t *pstate, unsigned char *tag)
+{
+    tinyjambu_128_state_t *state = &(pstate->state.s128);
+    uint32_t data = 0;
+    unsigned index;
+    if (pstate->posn > 0) {
+        for (index = 0; index < pstate->posn; ++index)
+            data |= ((uint32_t)(pstate->buf[index])) << (index * 8);
+        tinyjambu_absorb(state, data);
+        tinyjambu_add_domain(state, pstate->posn);
+    }
+    if (pstate->key_size == TINYJAMBU_128_KEY_SIZE)
+        tinyjambu_generate_tag_128(&(pstate->state.s128), tag);
+    else if (pstate->key_size == TINYJAMBU_192_KEY_SIZE)
+        tinyjambu_generate_tag_192(&(pstate->state.s192), tag);
+    else
+        tinyjambu_generate_tag_256(&(pstate->state.s256), tag);
+}
+
+void tinyjambu_aead_encrypt_update
+    (tinyjambu_aead_state_t *state, unsigned char *c,
+     const unsigned char *m, size_t len)
+{
+    tinyjambu_aead_update((tinyjambu_aead_state_p_t *)state, c, m, len, 0);
+}
+
+void tinyjambu_aead_encrypt_finish
+    (tinyjambu_aead_state_t *state, unsigned char *tag)
+{
+    tinyjambu_aead_finish((tinyjambu_aead_state_p_t *)state, tag);
+    tinyjambu_clean(state, sizeof(tinyjambu_aead_state_t));
+}
+
+void tinyjambu_aead_decrypt_update
+    (tinyjambu_aead_state_t *state, unsigned char *m,
+     const unsigned char *c, size_t len)
+{
+    tinyjambu_aead_update((tinyjambu_aead_state_p_t *)state, m, c, len, 1);
+}
+
+int tinyjambu_aead_decrypt_finish
+    (tinyjambu_aead_state_t *state, const unsigned char *tag)
+{
+    unsigned char computed[TINYJAMBU_TAG_SIZE];
+    int result;
+    tinyjambu_aead_finish((tinyjambu_aead_state_p_t *)state, computed);
+    result = tinyjambu_aead_check_tag(0, 0, computed, tag, TINYJAMBU_TAG_SIZE);
+    tinyjambu_clean(computed, sizeof(computed));
+    tinyjambu_clean(state, sizeof(tinyjambu_aead_state_t));
+    return result;
+}
+
+uint64_t tinyjambu_aead_position(const tinyjambu_aead_state_t *state)
+{
+    return ((const tinyjambu_aead_state_p_t *)state)->position;
+}
+
+void tinyjambu_aead_export
+    (const tinyjambu_aead_state_t *state, unsigned char *out)
+{
+    const tinyjambu_aead_state_p_t *pstate =
+        (const tinyjambu_aead_state_p_t *)state;
+    unsigned index;
+    memcpy(out, tinyjambu_aead_magic, sizeof(tinyjambu_aead_magic));
+    out[4] = TINYJAMBU_AEAD_EXPORT_VERSION;
+    out[5] = (unsigned char)(pstate->key_size);
+    out[6] = (unsigned char)(pstate->posn);
+    out[7] = 0;
+    for (index = 0; index < 4; ++index)
+        le_store_word32(out + 8 + index * 4, pstate->state.s128.s[index]);
+    memset(out + 24, 0, 4);
+    memcpy(out + 24, pstate->buf, pstate->posn);
+    le_store_word32(out + 28, (uint32_t)(pstate->position));
+    le_store_word32(out + 32, (uint32_t)(pstate->position >> 32));
+}
+
+int tinyjambu_aead_import
+    (tinyjambu_aead_state_t *state, const unsigned char *in,
+     const unsigned char *k, size_t keylen)
+{
+    tinyjambu_aead_state_p_t *pstate = (tinyjambu_aead_state_p_t *)state;
+    unsigned index;
+
+    /* Validate the header of the exported state */
+    memset(state, 0, sizeof(tinyjambu_aead_state_t));
+    if (memcmp(in, tinyjambu_aead_magic, sizeof(tinyjambu_aead_magic)) != 0 ||
+            in[4] != TINYJAMBU_AEAD_EXPORT_VERSION || in[5] != keylen ||
+            in[6] > 3 || in[7] != 0) {
+        return -1;
+    }
+    pstate->position = le_load_word32(in + 28) |
+                       (((uint64_t)le_load_word32(in + 32)) << 32);
+    if ((pstate->position % 4) != in[6])
+        return -1;
+    if (tinyjambu_aead_load_key(pstate, k, keylen) != 0)
+        return -1;
+
+    /* Restore the state words and the partial word buffer */
+    for (index = 0; index < 4; ++index)
+        pstate->state.s128.s[index] = le_load_word32(in + 8 + index * 4);
+    pstate->posn = in[6];
+    memcpy(pstate->buf, in + 24, pstate->posn);
+    return 0;
+}
+
+void tinyjambu_aead_free(tinyjambu_aead_state_t *state)
+{
+    tinyjambu_clean(state, sizeof(tinyjambu_aead_state_t));
+}
@@ -0,0 +1,544 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#if defined(HAVE_CONFIG_H)
+#include <config.h>
+#endif
+#include "TinyJAMBU.h"
+#include <stdlib.h>
+#include <string.h>
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#define TINYJAMBU_ASYNC_PTHREAD 1
+#endif
+
+/*
+ * Each worker has a bounded double-ended queue of jobs.  The submitting
+ * thread distributes jobs between the queues in turn.  A worker takes
+ * jobs from the front of its own queue, and when that is empty it steals
+ * jobs from the back of the other queues.  Idle workers sleep on a
+ * condition variable until more jobs are submitted.
+ *
+ * The pool lock protects the counters and the list of completed jobs.
+ * Each queue has its own lock so that workers only contend with each
+ * other when stealing.  The lock order is pool, then queue.
+ */
+
+/**
+ * \brief Default maximum number of outstanding jobs.
+ */
+#define TINYJAMBU_ASYNC_DEFAULT_PENDING 1024
+
+/**
+ * \brief Maximum number of worker threads.
+ */
+#define TINYJAMBU_ASYNC_MAX_WORKERS 256
+
+/**
+ * \brief Per-worker queue of jobs.
+ */
+typedef struct
+{
+#if defined(TINYJAMBU_ASYNC_PTHREAD)
+    /** Lock that protects the queue */
+    pthread_mutex_t lock;
+
+    /** Worker thread */
+    pthread_t thread;
+
+    /** Non-zero if the worker thread was started successfully */
+    int started;
+#endif
+
+    /** Ring buffer of jobs that are waiting in the queue */
+    tinyjambu_async_job_t **ring;
+
+    /** Index of the job at the front of the queue */
+    size_t head;
+
+    /** Number of jobs in the queue */
+    size_t count;
+
+    /** Points back to the pool that owns this worker */
+    tinyjambu_async_pool_t *pool;
+
+    /** Index of this worker in the pool */
+    unsigned index;
+
+} tinyjambu_async_worker_t;
+
+struct tinyjambu_async_pool_s
+{
+#if defined(TINYJAMBU_ASYNC_PTHREAD)
+    /** Lock that protects the pool counters and the completed jobs */
+    pthread_mutex_t lock;
+
+    /** Signalled when new jobs are submitted or the pool is shut down */
+    pthread_cond_t work;
+
+    /** Signalled when jobs complete */
+    pthread_cond_t done;
+#endif
+
+    /** Completion callback, or NULL to use polling */
+    tinyjambu_async_callback_t callback;
+
+    /** Maximum number of outstanding jobs */
+    size_t max_pending;
+
+    /** Number of outstanding jobs */
+    size_t outstanding;
+
+    /** Number of submitted jobs that have not completed yet */
+    size_t incomplete;
+
+    /** Number of jobs that are waiting in the worker queues */
+    size_t queued;
+
+    /** Number of workers that are sleeping while waiting for jobs */
+    unsigned idle;
+
+    /** Queue of completed jobs that are waiting to be polled */
+    tinyjambu_async_job_t *done_head;
+    tinyjambu_async_job_t *done_tail;
+
+    /** Number of workers; zero to run jobs synchronously */
+    unsigned num_workers;
+
+    /** Index of the worker queue that receives the next job */
+    unsigned next_worker;
+
+    /** Non-zero when the workers are being shut down */
+    int shutdown;
+
+    /** Array of workers */
+    tinyjambu_async_worker_t *workers;
+};
+
+#if defined(TINYJAMBU_ASYNC_PTHREAD)
+#define tinyjambu_async_lock(mutex) pthread_mutex_lock((mutex))
+#define tinyjambu_async_unlock(mutex) pthread_mutex_unlock((mutex))
+#else
+#define tinyjambu_async_lock(mutex) do { ; } while (0)
+#define tinyjambu_async_unlock(mutex) do { ; } while (0)
+#endif
+
+/* Runs an AEAD or SIV encryption job */
+static int tinyjambu_async_encrypt(tinyjambu_async_job_t *job, int siv)
+{
+    void (*encrypt)
+        (unsigned char *c, size_t *clen,
+         const unsigned char *m, size_t mlen,
+         const unsigned char *ad, size_t adlen,
+         const unsigned char *npub,
+         const unsigned char *k);
+    switch (job->keylen) {
+    case TINYJAMBU_128_KEY_SIZE:
+        encrypt = siv ? tinyjambu_128_siv_encrypt : tinyjambu_128_aead_encrypt;
+        break;
+    case TINYJAMBU_192_KEY_SIZE:
+        encrypt = siv ? tinyjambu_192_siv_encrypt : tinyjambu_192_aead_encrypt;
+        break;
+    case TINYJAMBU_256_KEY_SIZE:
+        encrypt = siv ? tinyjambu_256_siv_encrypt : tinyjambu_256_aead_encrypt;
+        break;
+    default:
+        return -1;
+    }
+    (*encrypt)(job->out, &(job->outlen), job->in, job->inlen,
+               job->ad, job->adlen, job->npub, job->key);
+    return 0;
+}
+
+/* Runs an AEAD or SIV decryption job */
+static int tinyjambu_async_decrypt(tinyjambu_async_job_t *job, int siv)
+{
+    int (*decrypt)
+        (unsigned char *m, size_t *mlen,
+         const unsigned char *c, size_t clen,
+         const unsigned char *ad, size_t adlen,
+         const unsigned char *npub,
+         const unsigned char *k);
+    switch (job->keylen) {
+    case TINYJAMBU_128_KEY_SIZE:
+        decrypt = siv ? tinyjambu_128_siv_decrypt : tinyjambu_128_aead_decrypt;
+        break;
+    case TINYJAMBU_192_KEY_SIZE:
+        decrypt = siv ? tinyjambu_192_siv_decrypt : tinyjambu_192_aead_decrypt;
+        break;
+    case TINYJAMBU_256_KEY_SIZE:
+        decrypt = siv ? tinyjambu_256_siv_decrypt : tinyjambu_256_aead_decrypt;
+        break;
+    default:
+        return -1;
+    }
+    return (*decrypt)(job->out, &(job->outlen), job->in, job->inlen,
+                      job->ad, job->adlen, job->npub, job->key);
+}
+
+/* Runs a job on the current thread */
+static void tinyjambu_async_run(tinyjambu_async_job_t *job)
+{
+    job->outlen = 0;
+    switch (job->op) {
+    case TINYJAMBU_ASYNC_AEAD_ENCRYPT:
+        job->result = tinyjambu_async_encrypt(job, 0);
+        break;
+
+    case TINYJAMBU_ASYNC_AEAD_DECRYPT:
+        job->result = tinyjambu_async_decrypt(job, 0);
+        break;
+
+    case TINYJAMBU_ASYNC_SIV_ENCRYPT:
+        job->result = tinyjambu_async_encrypt(job, 1);
+        break;
+
+    case TINYJAMBU_ASYNC_SIV_DECRYPT:
+        job->result = tinyjambu_async_decrypt(job, 1);
+        break;
+
+    case TINYJAMBU_ASYNC_HASH:
+        tinyjambu_hash(job->out, job->in, job->inlen);
+        job->outlen = TINYJAMBU_HASH_SIZE;
+        job->result = 0;
+        break;
+
+    case TINYJAMBU_ASYNC_HMAC:
+        tinyjambu_hmac(job->out, job->key, job->keylen, job->in, job->inlen);
+        job->outlen = TINYJAMBU_HMAC_SIZE;
+        job->result = 0;
+        break;
+
+    default:
+        job->result = -1;
+        break;
+    }
+}
+
+/* Reports that a job has completed */
+static void tinyjambu_async_complete
+    (tinyjambu_async_pool_t *pool, tinyjambu_async_job_t *job)
+{
+    job->next = 0;
+    if (pool->callback) {
+        (*(pool->callback))(job);
+        tinyjambu_async_lock(&(pool->lock));
+        --(pool->outstanding);
+    } else {
+        tinyjambu_async_lock(&(pool->lock));
+        if (pool->done_tail)
+            pool->done_tail->next = job;
+        else
+            pool->done_head = job;
+        pool->done_tail = job;
+    }
+    --(pool->incomplete);
+#if defined(TINYJAMBU_ASYNC_PTHREAD)
+    pthread_cond_broadcast(&(pool->done));
+#endif
+    tinyjambu_async_unlock(&(pool->lock));
+}
+
+/* Removes the first completed job from the pool; must be called with
+ * the pool lock held */
+static tinyjambu_async_job_t *tinyjambu_async_pop_done
+    (tinyjambu_async_pool_t *pool)
+{
+    tinyjambu_async_job_t *job = pool->done_head;
+    if (job) {
+        pool->done_head = job->next;
+        if (!pool->done_head)
+            pool->done_tail = 0;
+        job->next = 0;
+        --(pool->outstanding);
+    }
+    return job;
+}
+
+#if defined(TINYJAMBU_ASYNC_PTHREAD)
+
+/* Takes a job from the front of a worker's own queue */
+static tinyjambu_async_job_t *tinyjambu_async_take
+    (tinyjambu_async_worker_t *worker)
+{
+    tinyjambu_async_job_t *job = 0;
+    pthread_mutex_lock(&(worker->lock));
+    if (worker->count > 0) {
+        job = worker->ring[worker->head];
+        if (++(worker->head) >= worker->pool->max_pending)
+            worker->head = 0;
+        --(worker->count);
+    }
+    pthread_mutex_unlock(&(worker->lock));
+    return job;
+}
+
+/* Steals a job from the back of another worker's queue */
+static tinyjambu_async_job_t *tinyjambu_async_steal
+    (tinyjambu_async_worker_t *worker)
+{
+    tinyjambu_async_job_t *job = 0;
+    pthread_mutex_lock(&(worker->lock));
+    if (worker->count > 0) {
+        --(worker->count);
+        job = worker->ring
+            [(worker->head + worker->count) % worker->pool->max_pending];
+    }
+    pthread_mutex_unlock(&(worker->lock));
+    return job;
+}
+
+/* Main loop for a worker thread */
+static void *tinyjambu_async_worker(void *arg)
+{
+    tinyjambu_async_worker_t *worker = (tinyjambu_async_worker_t *)arg;
+    tinyjambu_async_pool_t *pool = worker->pool;
+    tinyjambu_async_job_t *job;
+    unsigned index;
+
+    /* Wait for tinyjambu_async_create() to finish starting the workers */
+    pthread_mutex_lock(&(pool->lock));
+    pthread_mutex_unlock(&(pool->lock));
+
+    for (;;) {
+        /* Look in our own queue first and then try to steal a job */
+        job = tinyjambu_async_take(worker);
+        for (index = 1; !job && index < pool->num_workers; ++index) {
+            job = tinyjambu_async_steal
+                (&(pool->workers[(worker->index + index) % pool->num_workers]));
+        }
+
+        /* Run the job if we found one */
+        if (job) {
+            pthread_mutex_lock(&(pool->lock));
+            --(pool->queued);
+            pthread_mutex_unlock(&(pool->lock));
+            tinyjambu_async_run(job);
+            tinyjambu_async_complete(pool, job);
+            continue;
+        }
+
+        /* Sleep until more jobs are submitted */
+        pthread_mutex_lock(&(pool->lock));
+        while (!pool->queued && !pool->shutdown) {
+            ++(pool->idle);
+            pthread_cond_wait(&(pool->work), &(pool->lock));
+            --(pool->idle);
+        }
+        if (!pool->queued && pool->shutdown) {
+            pthread_mutex_unlock(&(pool->lock));
+            break;
+        }
+        pthread_mutex_unlock(&(pool->lock));
+    }
+    return 0;
+}
+
+#endif /* TINYJAMBU_ASYNC_PTHREAD */
+
+tinyjambu_async_pool_t *tinyjambu_async_create
+    (unsigned workers, size_t max_pending, tinyjambu_async_callback_t callback)
+{
+    tinyjambu_async_pool_t *pool;
+#if defined(TINYJAMBU_ASYNC_PTHREAD)
+    unsigned index;
+#endif
+
+    /* Allocate the pool */
+    pool = (tinyjambu_async_pool_t *)calloc(1, sizeof(tinyjambu_async_pool_t));
+    if (!pool)
+        return 0;
+    pool->callback = callback;
+    pool->max_pending = max_pending ? max_pending
+                                    : TINYJAMBU_ASYNC_DEFAULT_PENDING;
+#if defined(TINYJAMBU_ASYNC_PTHREAD)
+    pthread_mutex_init(&(pool->lock), 0);
+    pthread_cond_init(&(pool->work), 0);
+    pthread_cond_init(&(pool->done), 0);
+    if (workers > TINYJAMBU_ASYNC_MAX_WORKERS)
+        workers = TINYJAMBU_ASYNC_MAX_WORKERS;
+    if (!workers)
+        return pool;
+
+    /* Allocate the workers and their queues */
+    pool->workers = (tinyjambu_async_worker_t *)calloc
+        (workers, sizeof(tinyjambu_async_worker_t));
+    if (!pool->workers) {
+        tinyjambu_async_destroy(pool);
+        return 0;
+    }
+    for (index = 0; index < workers; ++index) {
+        tinyjambu_async_worker_t *worker = &(pool->workers[index]);
+        worker->pool = pool;
+        worker->index = index;
+        worker->ring = (tinyjambu_async_job_t **)calloc
+            (pool->max_pending, sizeof(tinyjambu_async_job_t *));
+        pthread_mutex_init(&(worker->lock), 0);
+        if (!worker->ring) {
+            pool->num_workers = index + 1;
+            tinyjambu_async_destroy(pool);
+            return 0;
+        }
+    }
+
+    /* Start the worker threads.  If a thread cannot be created, then
+     * the pool runs with the workers that did start */
+    pthread_mutex_lock(&(pool->lock));
+    for (index = 0; index < workers; ++index) {
+        if (pthread_create(&(pool->workers[index].thread), 0,
+                           tinyjambu_async_worker, &(pool->workers[index]))) {
+            break;
+        }
+        pool->workers[index].started = 1;
+        pool->num_workers = index + 1;
+    }
+    for (; index < workers; ++index) {
+        pthread_mutex_destroy(&(pool->workers[index].lock));
+        free(pool->workers[index].ring);
+    }
+    pthread_mutex_unlock(&(pool->lock));
+#else
+    (void)workers;
+#endif
+    return pool;
+}
+
+void tinyjambu_async_destroy(tinyjambu_async_pool_t *pool)
+{
+#if defined(TINYJAMBU_ASYNC_PTHREAD)
+    unsigned index;
+#endif
+    if (!pool)
+        return;
+#if defined(TINYJAMBU_ASYNC_PTHREAD)
+    /* Wait for the jobs to finish and then stop the workers */
+    tinyjambu_async_drain(pool);
+    pthread_mutex_lock(&(pool->lock));
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&(pool->work));
+    pthread_mutex_unlock(&(pool->lock));
+    for (index = 0; index < pool->num_workers; ++index) {
+        if (pool->workers[index].started)
+            pthread_join(pool->workers[index].thread, 0);
+    }
+
+    /* Workers may steal from any queue, so only destroy the queues
+     * once all of the workers have stopped */
+    for (index = 0; index < pool->num_workers; ++index) {
+        pthread_mutex_destroy(&(pool->workers[index].lock));
+        free(pool->workers[index].ring);
+    }
+    free(pool->workers);
+    pthread_cond_destroy(&(pool->done));
+    pthread_cond_destroy(&(pool->work));
+    pthread_mutex_destroy(&(pool->lock));
+#endif
+    free(pool);
+}
+
+int tinyjambu_async_submit
+    (tinyjambu_async_pool_t *pool, tinyjambu_async_job_t *job)
+{
+#if defined(TINYJAMBU_ASYNC_PTHREAD)
+    tinyjambu_async_worker_t *worker;
+#endif
+
+    /* Apply backpressure if there are too many outstanding jobs */
+    tinyjambu_async_lock(&(pool->lock));
+    if (pool->outstanding >= pool->max_pending) {
+        tinyjambu_async_unlock(&(pool->lock));
+        return -1;
+    }
+    ++(pool->outstanding);
+    ++(pool->incomplete);
+    job->next = 0;
+
+    /* Run the job synchronously if there are no workers */
+    if (!pool->num_workers) {
+        tinyjambu_async_unlock(&(pool->lock));
+        tinyjambu_async_run(job);
+        tinyjambu_async_complete(pool, job);
+        return 0;
+    }
+
+#if defined(TINYJAMBU_ASYNC_PTHREAD)
+    /* Add the job to the back of the next worker's queue.  The queue
+     * cannot be full because it holds at most max_pending jobs */
+    worker = &(pool->workers[pool->next_worker]);
+    if (++(pool->next_worker) >= pool->num_workers)
+        pool->next_worker = 0;
+    pthread_mutex_lock(&(worker->lock));
+    worker->ring[(worker->head + worker->count) % pool->max_pending] = job;
+    ++(worker->count);
+    pthread_mutex_unlock(&(worker->lock));
+
+    /* Wake up a worker to process the job if they are all asleep */
+    ++(pool->queued);
+    if (pool->idle > 0)
+        pthread_cond_signal(&(pool->work));
+    pthread_mutex_unlock(&(pool->lock));
+#endif
+    return 0;
+}
+
+tinyjambu_async_job_t *tinyjambu_async_poll(tinyjambu_async_pool_t *pool)
+{
+    tinyjambu_async_job_t *job;
+    tinyjambu_async_lock(&(pool->lock));
+    job = tinyjambu_async_pop_done(pool);
+    tinyjambu_async_unlock(&(pool->lock));
+    return job;
+}
+
+tinyjambu_async_job_t *tinyjambu_async_wait(tinyjambu_async_pool_t *pool)
+{
+    tinyjambu_async_job_t *job;
+    tinyjambu_async_lock(&(pool->lock));
+#if defined(TINYJAMBU_ASYNC_PTHREAD)
+    while (!pool->done_head && pool->incomplete > 0)
+        pthread_cond_wait(&(pool->done), &(pool->lock));
+#endif
+    job = tinyjambu_async_pop_done(pool);
+    tinyjambu_async_unlock(&(pool->lock));
+    return job;
+}
+
+void tinyjambu_async_drain(tinyjambu_async_pool_t *pool)
+{
+#if defined(TINYJAMBU_ASYNC_PTHREAD)
+    pthread_mutex_lock(&(pool->lock));
+    while (pool->incomplete > 0)
+        pthread_cond_wait(&(pool->done), &(pool->lock));
+    pthread_mutex_unlock(&(pool->lock));
+#else
+    (void)pool;
+#endif
+}
+
+size_t tinyjambu_async_pending(tinyjambu_async_pool_t *pool)
+{
+    size_t pending;
+    tinyjambu_async_lock(&(pool->lock));
+    pending = pool->outstanding;
+    tinyjambu_async_unlock(&(pool->lock));
+    return pending;
+}
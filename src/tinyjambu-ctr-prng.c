@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "TinyJAMBU.h"
+#include "backend/tinyjambu-backend.h"
+#include "backend/tinyjambu-util.h"
+#include <string.h>
+
+/*
+ * Counter-based PRNG in the style of Random123 (Salmon et al, "Parallel
+ * Random Numbers: As Easy as 1, 2, 3", SC 2011).  Block i of stream S
+ * with seed K is computed as follows:
+ *
+ *      X = [i]_64 || [S]_64
+ *      Block(K, S, i) = P1024(K, X) ^ X
+ *
+ * where P1024 is the keyed TinyJAMBU-128 permutation with 1024 steps,
+ * and all values are in little-endian byte order.  The feed-forward makes
+ * the block function one-way even though the permutation is invertible.
+ *
+ * Every block is independent, so any position in the output can be
+ * reached in constant time and blocks can be computed in parallel.
+ */
+
+/**
+ * \brief Number of rounds to use for the counter-based PRNG.
+ */
+#define TINYJAMBU_CTR_PRNG_ROUNDS TINYJAMBU_ROUNDS(1024)
+
+/**
+ * \brief Size of a block of output from the counter-based PRNG.
+ */
+#define TINYJAMBU_CTR_PRNG_BLOCK_SIZE 16
+
+/**
+ * \brief Private state information for the counter-based PRNG.
+ */
+typedef struct
+{
+    /** Words of the seed, pre-inverted for the permutation */
+    uint32_t k[4];
+
+    /** Stream identifier */
+    uint32_t stream[2];
+
+    /** Position of the next byte to generate from the stream */
+    uint64_t posn;
+
+} tinyjambu_ctr_prng_p_t;
+
+/** @cond */
+
+/* Compile-time check that tinyjambu_ctr_prng_p_t can fit within the
+ * bounds of tinyjambu_ctr_prng_t.  This line of code will fail to
+ * compile if the private structure is too large for the public one. */
+typedef int tinyjambu_ctr_prng_size_check
+    [(sizeof(tinyjambu_ctr_prng_p_t) <=
+            sizeof(tinyjambu_ctr_prng_t)) * 2 - 1];
+
+/** @endcond */
+
+/* Sets up a permutation state to generate a specific block */
+static void tinyjambu_ctr_prng_setup
+    (const tinyjambu_ctr_prng_p_t *pctx, tinyjambu_128_state_t *state,
+     uint64_t block)
+{
+    state->s[0] = (uint32_t)block;
+    state->s[1] = (uint32_t)(block >> 32);
+    state->s[2] = pctx->stream[0];
+    state->s[3] = pctx->stream[1];
+    memcpy(state->k, pctx->k, sizeof(state->k));
+}
+
+/* Applies the feed-forward and writes out a block of output */
+static void tinyjambu_ctr_prng_output
+    (const tinyjambu_ctr_prng_p_t *pctx, const tinyjambu_128_state_t *state,
+     uint64_t block, unsigned char *out)
+{
+    le_store_word32(out,      state->s[0] ^ (uint32_t)block);
+    le_store_word32(out + 4,  state->s[1] ^ (uint32_t)(block >> 32));
+    le_store_word32(out + 8,  state->s[2] ^ pctx->stream[0]);
+    le_store_word32(out + 12, state->s[3] ^ pctx->stream[1]);
+}
+
+/* Generates a single block of output */
+static void tinyjambu_ctr_prng_block
+    (const tinyjambu_ctr_prng_p_t *pctx, uint64_t block, unsigned char *out)
+{
+    tinyjambu_128_state_t state;
+    tinyjambu_ctr_prng_setup(pctx, &state, block);
+    tinyjambu_permutation_128(&state, TINYJAMBU_CTR_PRNG_ROUNDS);
+    tinyjambu_ctr_prng_output(pctx, &state, block, out);
+    tinyjambu_clean(&state, sizeof(state));
+}
+
+void tinyjambu_ctr_prng_init
+    (tinyjambu_ctr_prng_t *ctx, const unsigned char *seed, uint64_t stream)
+{
+    tinyjambu_ctr_prng_p_t *pctx = (tinyjambu_ctr_prng_p_t *)ctx;
+    memset(ctx, 0, sizeof(tinyjambu_ctr_prng_t));
+    pctx->k[0] = tinyjambu_key_load_even(seed);
+    pctx->k[1] = tinyjambu_key_load_odd(seed + 4);
+    pctx->k[2] = tinyjambu_key_load_even(seed + 8);
+    pctx->k[3] = tinyjambu_key_load_odd(seed + 12);
+    pctx->stream[0] = (uint32_t)stream;
+    pctx->stream[1] = (uint32_t)(stream >> 32);
+    pctx->posn = 0;
+}
+
+void tinyjambu_ctr_prng_free(tinyjambu_ctr_prng_t *ctx)
+{
+    tinyjambu_clean(ctx, sizeof(tinyjambu_ctr_prng_t));
+}
+
+void tinyjambu_ctr_prng_generate
+    (tinyjambu_ctr_prng_t *ctx, unsigned char *data, size_t size)
+{
+    tinyjambu_ctr_prng_p_t *pctx = (tinyjambu_ctr_prng_p_t *)ctx;
+    tinyjambu_ctr_prng_generate_at(ctx, pctx->posn, data, size);
+    pctx->posn += size;
+}
+
+void tinyjambu_ctr_prng_generate_at
+    (const tinyjambu_ctr_prng_t *ctx, uint64_t posn,
+     unsigned char *data, size_t size)
+{
+    const tinyjambu_ctr_prng_p_t *pctx = (const tinyjambu_ctr_prng_p_t *)ctx;
+    tinyjambu_128_state_t states[4];
+    unsigned char temp[TINYJAMBU_CTR_PRNG_BLOCK_SIZE];
+    uint64_t block = posn / TINYJAMBU_CTR_PRNG_BLOCK_SIZE;
+    unsigned offset = (unsigned)(posn % TINYJAMBU_CTR_PRNG_BLOCK_SIZE);
+    size_t len;
+
+    /* Bail out if nothing to do */
+    if (!size)
+        return;
+
+    /* Deal with a partial block at the start of the request */
+    if (offset != 0) {
+        tinyjambu_ctr_prng_block(pctx, block, temp);
+        len = TINYJAMBU_CTR_PRNG_BLOCK_SIZE - offset;
+        if (len > size)
+            len = size;
+        memcpy(data, temp + offset, len);
+        data += len;
+        size -= len;
+        ++block;
+    }
+
+    /* Generate four blocks at a time in parallel lanes */
+    while (size >= (TINYJAMBU_CTR_PRNG_BLOCK_SIZE * 4)) {
+        tinyjambu_ctr_prng_setup(pctx, &(states[0]), block);
+        tinyjambu_ctr_prng_setup(pctx, &(states[1]), block + 1);
+        tinyjambu_ctr_prng_setup(pctx, &(states[2]), block + 2);
+        tinyjambu_ctr_prng_setup(pctx, &(states[3]), block + 3);
+        tinyjambu_permutation_128_x4(states, TINYJAMBU_CTR_PRNG_ROUNDS);
+        tinyjambu_ctr_prng_output(pctx, &(states[0]), block, data);
+        tinyjambu_ctr_prng_output(pctx, &(states[1]), block + 1, data + 16);
+        tinyjambu_ctr_prng_output(pctx, &(states[2]), block + 2, data + 32);
+        tinyjambu_ctr_prng_output(pctx, &(states[3]), block + 3, data + 48);
+        data += TINYJAMBU_CTR_PRNG_BLOCK_SIZE * 4;
+        size -= TINYJAMBU_CTR_PRNG_BLOCK_SIZE * 4;
+        block += 4;
+    }
+
+    /* Generate the remaining blocks one at a time */
+    while (size >= TINYJAMBU_CTR_PRNG_BLOCK_SIZE) {
+        tinyjambu_ctr_prng_block(pctx, block, data);
+        data += TINYJAMBU_CTR_PRNG_BLOCK_SIZE;
+        size -= TINYJAMBU_CTR_PRNG_BLOCK_SIZE;
+        ++block;
+    }
+    if (size > 0) {
+        tinyjambu_ctr_prng_block(pctx, block, temp);
+        memcpy(data, temp, size);
+    }
+
+    /* Clean up */
+    tinyjambu_clean(states, sizeof(states));
+    tinyjambu_clean(temp, sizeof(temp));
+}
+
+void tinyjambu_ctr_prng_skip(tinyjambu_ctr_prng_t *ctx, uint64_t n)
+{
+    tinyjambu_ctr_prng_p_t *pctx = (tinyjambu_ctr_prng_p_t *)ctx;
+    pctx->posn += n;
+}
+
+void tinyjambu_ctr_prng_seek(tinyjambu_ctr_prng_t *ctx, uint64_t posn)
+{
+    tinyjambu_ctr_prng_p_t *pctx = (tinyjambu_ctr_prng_p_t *)ctx;
+    pctx->posn = posn;
+}
@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TinyJAMBU.h"
+#include "backend/tinyjambu-jit.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct tinyjambu_jit_key_s
+{
+    /** Inverted key words and the generated code */
+    tinyjambu_jit_ctx_t ctx;
+
+    /** State after the key setup permutation */
+    uint32_t init[4];
+};
+
+tinyjambu_jit_key_t *tinyjambu_jit_key_create
+    (const unsigned char *k, size_t klen)
+{
+    tinyjambu_jit_key_t *key;
+    if (klen != TINYJAMBU_128_KEY_SIZE && klen != TINYJAMBU_192_KEY_SIZE &&
+            klen != TINYJAMBU_256_KEY_SIZE)
+        return 0;
+    key = (tinyjambu_jit_key_t *)calloc(1, sizeof(tinyjambu_jit_key_t));
+    if (!key)
+        return 0;
+    tinyjambu_jit_ctx_init(&(key->ctx), k, klen);
+
+    /* The key setup is the same for every packet, so do it once here */
+    tinyjambu_jit_permute(&(key->ctx), key->init, key->ctx.long_rounds);
+    return key;
+}
+
+void tinyjambu_jit_key_destroy(tinyjambu_jit_key_t *key)
+{
+    if (key) {
+        tinyjambu_jit_ctx_free(&(key->ctx));
+        tinyjambu_clean(key->init, sizeof(key->init));
+        free(key);
+    }
+}
+
+int tinyjambu_jit_key_is_native(const tinyjambu_jit_key_t *key)
+{
+    return tinyjambu_jit_ctx_is_native(&(key->ctx));
+}
+
+/* Loads a partial word of 1 to 3 bytes in little-endian order */
+static uint32_t tinyjambu_jit_load_partial
+    (const unsigned char *data, size_t len)
+{
+    uint32_t word = data[0];
+    if (len > 1)
+        word |= ((uint32_t)(data[1])) << 8;
+    if (len > 2)
+        word |= ((uint32_t)(data[2])) << 16;
+    return word;
+}
+
+/* Stores a partial word of 1 to 3 bytes in little-endian order */
+static void tinyjambu_jit_store_partial
+    (unsigned char *data, uint32_t word, size_t len)
+{
+    data[0] = (unsigned char)word;
+    if (len > 1)
+        data[1] = (unsigned char)(word >> 8);
+    if (len > 2)
+        data[2] = (unsigned char)(word >> 16);
+}
+
+/* Sets up the state with the nonce and associated data */
+static void tinyjambu_jit_setup
+    (const tinyjambu_jit_key_t *key, uint32_t *s,
+     const unsigned char *ad, size_t adlen, const unsigned char *npub)
+{
+    const tinyjambu_jit_ctx_t *ctx = &(key->ctx);
+    memcpy(s, key->init, sizeof(key->init));
+    tinyjambu_jit_absorb(ctx, s, npub, 3, 0x10);
+    tinyjambu_jit_absorb(ctx, s, ad, adlen / 4, 0x30);
+    ad += adlen & ~((size_t)3);
+    adlen &= 3;
+    if (adlen > 0) {
+        s[1] ^= 0x30;
+        tinyjambu_jit_permute(ctx, s, TINYJAMBU_ROUNDS(640));
+        s[3] ^= tinyjambu_jit_load_partial(ad, adlen);
+        s[1] ^= (uint32_t)adlen;
+    }
+}
+
+/* Generates the authentication tag */
+static void tinyjambu_jit_generate_tag
+    (const tinyjambu_jit_key_t *key, uint32_t *s, unsigned char *tag)
+{
+    s[1] ^= 0x70;
+    tinyjambu_jit_permute(&(key->ctx), s, key->ctx.long_rounds);
+    le_store_word32(tag, s[2]);
+    s[1] ^= 0x70;
+    tinyjambu_jit_permute(&(key->ctx), s, TINYJAMBU_ROUNDS(640));
+    le_store_word32(tag + 4, s[2]);
+}
+
+void tinyjambu_jit_aead_encrypt
+    (const tinyjambu_jit_key_t *key, unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub)
+{
+    uint32_t s[4];
+    uint32_t data;
+
+    /* Set up the state with the nonce and associated data */
+    *clen = mlen + TINYJAMBU_TAG_SIZE;
+    tinyjambu_jit_setup(key, s, ad, adlen, npub);
+
+    /* Encrypt the whole words and then the left-over bytes, if any */
+    tinyjambu_jit_encrypt(&(key->ctx), s, c, m, mlen / 4);
+    c += mlen & ~((size_t)3);
+    m += mlen & ~((size_t)3);
+    mlen &= 3;
+    if (mlen > 0) {
+        s[1] ^= 0x50;
+        tinyjambu_jit_permute(&(key->ctx), s, key->ctx.long_rounds);
+        data = tinyjambu_jit_load_partial(m, mlen);
+        s[3] ^= data;
+        s[1] ^= (uint32_t)mlen;
+        tinyjambu_jit_store_partial(c, data ^ s[2], mlen);
+        c += mlen;
+    }
+
+    /* Generate the authentication tag */
+    tinyjambu_jit_generate_tag(key, s, c);
+}
+
+int tinyjambu_jit_aead_decrypt
+    (const tinyjambu_jit_key_t *key, unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub)
+{
+    unsigned char computed[TINYJAMBU_TAG_SIZE];
+    unsigned char *mtemp = m;
+    uint32_t s[4];
+    uint32_t data;
+    size_t len;
+
+    /* Validate the ciphertext length and set the return "mlen" value */
+    if (clen < TINYJAMBU_TAG_SIZE)
+        return -1;
+    *mlen = len = clen - TINYJAMBU_TAG_SIZE;
+
+    /* Set up the state with the nonce and associated data */
+    tinyjambu_jit_setup(key, s, ad, adlen, npub);
+
+    /* Decrypt the whole words and then the left-over bytes, if any */
+    tinyjambu_jit_decrypt(&(key->ctx), s, m, c, len / 4);
+    c += len & ~((size_t)3);
+    m += len & ~((size_t)3);
+    len &= 3;
+    if (len > 0) {
+        s[1] ^= 0x50;
+        tinyjambu_jit_permute(&(key->ctx), s, key->ctx.long_rounds);
+        data = tinyjambu_jit_load_partial(c, len) ^ s[2];
+        data &= ~(((uint32_t)0xFFFFFFFFU) << (len * 8));
+        s[3] ^= data;
+        s[1] ^= (uint32_t)len;
+        tinyjambu_jit_store_partial(m, data, len);
+        c += len;
+    }
+
+    /* Check the authentication tag */
+    tinyjambu_jit_generate_tag(key, s, computed);
+    return tinyjambu_aead_check_tag
+        (mtemp, *mlen, computed, c, TINYJAMBU_TAG_SIZE);
+}
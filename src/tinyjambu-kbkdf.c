@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TinyJAMBU.h"
+#include "backend/tinyjambu-util.h"
+#include <string.h>
+
+/*
+ * This KDF is based on the counter mode KDF from section 4.1 of NIST
+ * Special Publication 800-108r1, with TinyJAMBU-HMAC as the PRF:
+ *
+ *      K(i) = HMAC(KI, Label || 0x00 || Context || [L]_64 || [i]_32)
+ *
+ * where L is the number of bits of key material to generate, i runs from
+ * 1 to ceil(L / 256), and all integers are encoded in big-endian byte order.
+ *
+ * SP 800-108r1 allows the counter to appear anywhere in the PRF input.
+ * We place it at the end so that the HMAC state after absorbing the key
+ * and the fixed input data can be computed once and then shared between
+ * all output blocks.  Each block only depends upon the key, the fixed
+ * input data, and i.  Blocks can be generated in any order.
+ */
+
+/**
+ * \brief Block size for TinyJAMBU-HMAC.
+ */
+#define TINYJAMBU_HMAC_BLOCK_SIZE 64
+
+/**
+ * \brief Private state for TinyJAMBU-KBKDF.
+ */
+typedef struct
+{
+    /** Inner HMAC hash state after absorbing the key and fixed input data */
+    tinyjambu_hash_state_t inner;
+
+    /** Outer HMAC hash state after absorbing the key */
+    tinyjambu_hash_state_t outer;
+
+    /** Number of output blocks that may be generated */
+    uint32_t blocks;
+
+} tinyjambu_kbkdf_state_p_t;
+
+/** @cond */
+
+/* Compile-time check that tinyjambu_kbkdf_state_p_t can fit within the
+ * bounds of tinyjambu_kbkdf_state_t.  This line of code will fail to
+ * compile if the private structure is too large for the public one. */
+typedef int tinyjambu_kbkdf_state_size_check
+    [(sizeof(tinyjambu_kbkdf_state_p_t) <=
+            sizeof(tinyjambu_kbkdf_state_t)) * 2 - 1];
+
+/** @endcond */
+
+/* Absorbs an HMAC key block into a hash state, in the same manner as
+ * tinyjambu_hmac_init() and tinyjambu_hmac_finalize() */
+static void tinyjambu_kbkdf_set_key
+    (tinyjambu_hash_state_t *hash, const unsigned char *key, size_t keylen,
+     unsigned char mask)
+{
+    unsigned char block[TINYJAMBU_HMAC_BLOCK_SIZE];
+    size_t posn;
+    for (posn = 0; posn < keylen; ++posn)
+        block[posn] = key[posn] ^ mask;
+    memset(block + keylen, mask, TINYJAMBU_HMAC_BLOCK_SIZE - keylen);
+    tinyjambu_hash_init(hash);
+    tinyjambu_hash_update(hash, block, sizeof(block));
+    tinyjambu_clean(block, sizeof(block));
+}
+
+int tinyjambu_kbkdf
+    (unsigned char *out, size_t outlen,
+     const unsigned char *key, size_t keylen,
+     const unsigned char *label, size_t labellen,
+     const unsigned char *context, size_t contextlen)
+{
+    tinyjambu_kbkdf_state_t state;
+    int result;
+    result = tinyjambu_kbkdf_init
+        (&state, key, keylen, label, labellen, context, contextlen, outlen);
+    if (result == 0)
+        result = tinyjambu_kbkdf_expand(&state, 0, out, outlen);
+    tinyjambu_kbkdf_free(&state);
+    return result;
+}
+
+int tinyjambu_kbkdf_init
+    (tinyjambu_kbkdf_state_t *state,
+     const unsigned char *key, size_t keylen,
+     const unsigned char *label, size_t labellen,
+     const unsigned char *context, size_t contextlen,
+     size_t outlen)
+{
+    tinyjambu_kbkdf_state_p_t *pstate = (tinyjambu_kbkdf_state_p_t *)state;
+    unsigned char hashed_key[TINYJAMBU_HASH_SIZE];
+    unsigned char L[8];
+    unsigned char zero = 0;
+    unsigned long long bits;
+    unsigned long long blocks;
+
+    /* Validate the output length; the counter is limited to 32 bits */
+    memset(state, 0, sizeof(tinyjambu_kbkdf_state_t));
+    blocks = ((unsigned long long)outlen + TINYJAMBU_KBKDF_SIZE - 1) /
+             TINYJAMBU_KBKDF_SIZE;
+    if (blocks > 0xFFFFFFFFULL)
+        return -1;
+    pstate->blocks = (uint32_t)blocks;
+
+    /* Long keys are hashed first, as for regular HMAC */
+    if (keylen > TINYJAMBU_HMAC_BLOCK_SIZE) {
+        tinyjambu_hash(hashed_key, key, keylen);
+        key = hashed_key;
+        keylen = TINYJAMBU_HASH_SIZE;
+    }
+
+    /* Set up the outer and inner HMAC states with the key */
+    tinyjambu_kbkdf_set_key(&(pstate->outer), key, keylen, 0x5C);
+    tinyjambu_kbkdf_set_key(&(pstate->inner), key, keylen, 0x36);
+    tinyjambu_clean(hashed_key, sizeof(hashed_key));
+
+    /* Absorb the fixed input data: Label || 0x00 || Context || [L]_64 */
+    bits = ((unsigned long long)outlen) * 8U;
+    be_store_word64(L, bits);
+    tinyjambu_hash_update(&(pstate->inner), label, labellen);
+    tinyjambu_hash_update(&(pstate->inner), &zero, 1);
+    tinyjambu_hash_update(&(pstate->inner), context, contextlen);
+    tinyjambu_hash_update(&(pstate->inner), L, sizeof(L));
+    return 0;
+}
+
+int tinyjambu_kbkdf_expand
+    (const tinyjambu_kbkdf_state_t *state, unsigned long block,
+     unsigned char *out, size_t outlen)
+{
+    const tinyjambu_kbkdf_state_p_t *pstate =
+        (const tinyjambu_kbkdf_state_p_t *)state;
+    tinyjambu_hash_state_t hash;
+    unsigned char T[TINYJAMBU_KBKDF_SIZE];
+    unsigned char counter[4];
+    size_t len;
+    int result = 0;
+
+    while (outlen > 0) {
+        /* Have we gone past the end of the key material? */
+        if (block >= pstate->blocks) {
+            memset(out, 0, outlen); /* Zero the rest of the output data */
+            result = -1;
+            break;
+        }
+
+        /* T = Hash(inner || [i]_32), where i = block + 1 */
+        be_store_word32(counter, (uint32_t)(block + 1));
+        memcpy(&hash, &(pstate->inner), sizeof(hash));
+        tinyjambu_hash_update(&hash, counter, sizeof(counter));
+        tinyjambu_hash_finalize(&hash, T);
+
+        /* K(i) = Hash(outer || T) */
+        memcpy(&hash, &(pstate->outer), sizeof(hash));
+        tinyjambu_hash_update(&hash, T, sizeof(T));
+        tinyjambu_hash_finalize(&hash, T);
+
+        /* Copy the block to the output buffer */
+        len = TINYJAMBU_KBKDF_SIZE;
+        if (len > outlen)
+            len = outlen;
+        memcpy(out, T, len);
+        out += len;
+        outlen -= len;
+        ++block;
+    }
+    tinyjambu_clean(&hash, sizeof(hash));
+    tinyjambu_clean(T, sizeof(T));
+    return result;
+}
+
+void tinyjambu_kbkdf_free(tinyjambu_kbkdf_state_t *state)
+{
+    tinyjambu_clean(state, sizeof(tinyjambu_kbkdf_state_t));
+}
@@ -0,0 +1,525 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#if defined(HAVE_CONFIG_H)
+#include <config.h>
+#endif
+#include "TinyJAMBU.h"
+#include <string.h>
+#include <stdlib.h>
+#if defined(__linux__) && defined(HAVE_LINUX_USERFAULTFD_H) && \
+        defined(HAVE_SYS_MMAN_H) && defined(HAVE_SYS_SYSCALL_H) && \
+        defined(HAVE_UNISTD_H) && defined(HAVE_FCNTL_H) && \
+        defined(HAVE_PTHREAD)
+#include <linux/userfaultfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
+#include <pthread.h>
+#if defined(SYS_userfaultfd)
+#define TINYJAMBU_LAZYMAP_UFFD 1
+#endif
+#endif
+
+#if defined(TINYJAMBU_LAZYMAP_UFFD)
+
+/*
+ * The mapping is an anonymous region that is registered with userfaultfd
+ * so that the first access to each page blocks the accessing thread and
+ * sends a fault message to the helper thread.  The helper reads the
+ * encrypted page from the file, decrypts and verifies it, and then uses
+ * UFFDIO_COPY to atomically install the plaintext and wake the thread.
+ *
+ * If the faults arrive in increasing page order, then the helper doubles
+ * the size of the read-ahead window on each fault.  The window is read
+ * and decrypted with a single batch across the permutation lanes and
+ * installed with a single UFFDIO_COPY.  A fault anywhere else resets
+ * the window back to a single page.
+ *
+ * The file is divided into sectors that are encrypted independently.
+ * The sector size is part of the file format and must not depend upon
+ * the page size of the machine that reads the file, so each page is
+ * made up of one or more whole sectors.  The sectors for a window of
+ * pages are decrypted together.  The last page may be only partially
+ * covered by sectors, in which case the rest of it is filled with zeroes.
+ *
+ * A page that fails to authenticate is made inaccessible with mprotect()
+ * and then unregistered from userfaultfd, which wakes the faulting thread
+ * so that it retries the access and receives SIGSEGV.  There is no other
+ * way to report an error to a thread that is blocked in a page fault.
+ */
+
+/**
+ * \brief Default maximum number of pages in the read-ahead window.
+ */
+#define TINYJAMBU_LAZYMAP_DEFAULT_READAHEAD 32
+
+struct tinyjambu_lazymap_s
+{
+    /** Copy of the key */
+    unsigned char key[TINYJAMBU_128_KEY_SIZE];
+
+    /** Lock that protects the counters that other threads can read */
+    pthread_mutex_t lock;
+
+    /** Helper thread that services the page faults */
+    pthread_t thread;
+
+    /** Start of the mapped region */
+    unsigned char *base;
+
+    /** Points to the tags for the pages */
+    const unsigned char *tags;
+
+    /** Buffer for decrypting the pages in the read-ahead window */
+    unsigned char *buffer;
+
+    /** Bitmap of the pages that have been installed */
+    unsigned char *present;
+
+    /** Size of a page */
+    size_t page_size;
+
+    /** Size of a sector in the encrypted file */
+    size_t sector_size;
+
+    /** Number of sectors in each page */
+    size_t sectors_per_page;
+
+    /** Number of pages in the mapping */
+    size_t num_pages;
+
+    /** Number of sectors in the encrypted file */
+    size_t num_sectors;
+
+    /** Maximum number of pages in the read-ahead window */
+    size_t max_window;
+
+    /** Current number of pages in the read-ahead window */
+    size_t window;
+
+    /** Page that will be faulted next if the accesses are sequential */
+    size_t next_page;
+
+    /** Number of pages that have been decrypted */
+    size_t decrypted;
+
+    /** File descriptor for the encrypted file */
+    int fd;
+
+    /** File descriptor for userfaultfd */
+    int uffd;
+
+    /** Pipe that is used to stop the helper thread */
+    int stop[2];
+
+    /** Non-zero if a page has failed to read or authenticate */
+    int failed;
+};
+
+size_t tinyjambu_lazymap_page_size(void)
+{
+    long size = sysconf(_SC_PAGESIZE);
+    return (size > 0) ? (size_t)size : 0;
+}
+
+/* Determine if a page has been installed in the mapping */
+#define tinyjambu_lazymap_is_present(map, page) \
+    ((map)->present[(page) / 8] & (1 << ((page) % 8)))
+
+/* Reads a number of sectors from the encrypted file into the buffer */
+static int tinyjambu_lazymap_read
+    (tinyjambu_lazymap_t *map, size_t sector, size_t count)
+{
+    size_t posn = 0;
+    size_t len = count * map->sector_size;
+    ssize_t n;
+    while (posn < len) {
+        n = pread(map->fd, map->buffer + posn, len - posn,
+                  (off_t)(sector * map->sector_size + posn));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        posn += (size_t)n;
+    }
+    return 0;
+}
+
+/* Reads and decrypts the sectors for a number of pages into the buffer,
+ * and fills the part of the last page that has no sectors with zeroes */
+static int tinyjambu_lazymap_load
+    (tinyjambu_lazymap_t *map, size_t page, size_t count)
+{
+    size_t sector = page * map->sectors_per_page;
+    size_t sectors = count * map->sectors_per_page;
+    if (sectors > (map->num_sectors - sector))
+        sectors = map->num_sectors - sector;
+    if (tinyjambu_lazymap_read(map, sector, sectors) != 0 ||
+            tinyjambu_128_siv_decrypt_sectors
+                (map->buffer, map->buffer,
+                 map->tags + sector * TINYJAMBU_TAG_SIZE, map->sector_size,
+                 sector, sectors, map->key, 1) != 0) {
+        return -1;
+    }
+    memset(map->buffer + sectors * map->sector_size, 0,
+           count * map->page_size - sectors * map->sector_size);
+    return 0;
+}
+
+/* Makes a page inaccessible after it fails to read or authenticate, and
+ * then wakes up the faulting thread so that it receives SIGSEGV */
+static void tinyjambu_lazymap_fail(tinyjambu_lazymap_t *map, size_t page)
+{
+    struct uffdio_range range;
+    pthread_mutex_lock(&(map->lock));
+    map->failed = 1;
+    pthread_mutex_unlock(&(map->lock));
+    map->present[page / 8] |= (unsigned char)(1 << (page % 8));
+    range.start = (unsigned long)(map->base + page * map->page_size);
+    range.len = map->page_size;
+    mprotect(map->base + page * map->page_size, map->page_size, PROT_NONE);
+    ioctl(map->uffd, UFFDIO_UNREGISTER, &range);
+}
+
+/* Services a page fault */
+static void tinyjambu_lazymap_fault(tinyjambu_lazymap_t *map, size_t page)
+{
+    struct uffdio_copy copy;
+    struct uffdio_range range;
+    size_t count, index, len;
+
+    /* If the page is already present, then another thread faulted on
+     * it at the same time and we only need to wake this thread */
+    if (tinyjambu_lazymap_is_present(map, page)) {
+        range.start = (unsigned long)(map->base + page * map->page_size);
+        range.len = map->page_size;
+        ioctl(map->uffd, UFFDIO_WAKE, &range);
+        return;
+    }
+
+    /* Grow the read-ahead window if the access is sequential */
+    if (page == map->next_page) {
+        map->window *= 2;
+        if (map->window > map->max_window)
+            map->window = map->max_window;
+    } else {
+        map->window = 1;
+    }
+    count = 1;
+    while (count < map->window && (page + count) < map->num_pages &&
+           !tinyjambu_lazymap_is_present(map, page + count)) {
+        ++count;
+    }
+
+    /* Read and decrypt the pages.  If the window fails, then fall back
+     * to the faulting page alone to find out if it is the bad one */
+    if (tinyjambu_lazymap_load(map, page, count) != 0) {
+        map->window = 1;
+        count = 1;
+        if (tinyjambu_lazymap_load(map, page, 1) != 0) {
+            tinyjambu_clean(map->buffer, map->page_size);
+            tinyjambu_lazymap_fail(map, page);
+            map->next_page = map->num_pages;
+            return;
+        }
+    }
+
+    /* Count the pages before installing them, because the faulting
+     * thread may resume and look at the count as soon as they appear */
+    pthread_mutex_lock(&(map->lock));
+    map->decrypted += count;
+    pthread_mutex_unlock(&(map->lock));
+
+    /* Install the plaintext pages and wake up the faulting thread */
+    copy.dst = (unsigned long)(map->base + page * map->page_size);
+    copy.src = (unsigned long)(map->buffer);
+    copy.len = len = count * map->page_size;
+    copy.mode = 0;
+    copy.copy = 0;
+    if (ioctl(map->uffd, UFFDIO_COPY, &copy) != 0) {
+        /* Some of the pages may have been installed before the error */
+        range.start = copy.dst;
+        range.len = copy.len;
+        ioctl(map->uffd, UFFDIO_WAKE, &range);
+        index = (copy.copy > 0) ? (size_t)(copy.copy) / map->page_size : 0;
+        pthread_mutex_lock(&(map->lock));
+        map->decrypted -= count - index;
+        pthread_mutex_unlock(&(map->lock));
+        count = index;
+    }
+    tinyjambu_clean(map->buffer, len);
+    for (index = 0; index < count; ++index) {
+        map->present[(page + index) / 8] |=
+            (unsigned char)(1 << ((page + index) % 8));
+    }
+    map->next_page = page + count;
+}
+
+/* Helper thread that waits for page faults and services them */
+static void *tinyjambu_lazymap_thread(void *arg)
+{
+    tinyjambu_lazymap_t *map = (tinyjambu_lazymap_t *)arg;
+    struct uffd_msg msg;
+    struct pollfd fds[2];
+    unsigned long addr;
+    ssize_t n;
+
+    for (;;) {
+        fds[0].fd = map->uffd;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd = map->stop[0];
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (fds[1].revents)
+            break;
+        if (!(fds[0].revents & POLLIN))
+            continue;
+        n = read(map->uffd, &msg, sizeof(msg));
+        if (n != (ssize_t)sizeof(msg) || msg.event != UFFD_EVENT_PAGEFAULT)
+            continue;
+        addr = (unsigned long)(msg.arg.pagefault.address);
+        tinyjambu_lazymap_fault
+            (map, (addr - (unsigned long)(map->base)) / map->page_size);
+    }
+    return 0;
+}
+
+/* Opens a userfaultfd handle, restricted to user-mode faults if the
+ * process is not allowed to handle kernel-mode faults */
+static int tinyjambu_lazymap_uffd(void)
+{
+    struct uffdio_api api;
+    int fd = (int)syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK);
+#if defined(UFFD_USER_MODE_ONLY)
+    if (fd < 0) {
+        fd = (int)syscall
+            (SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK | UFFD_USER_MODE_ONLY);
+    }
+#endif
+    if (fd < 0)
+        return -1;
+    memset(&api, 0, sizeof(api));
+    api.api = UFFD_API;
+    if (ioctl(fd, UFFDIO_API, &api) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+tinyjambu_lazymap_t *tinyjambu_lazymap_open
+    (int fd, size_t length, const unsigned char *tags, size_t sector_size,
+     const unsigned char *k, size_t readahead)
+{
+    tinyjambu_lazymap_t *map;
+    struct uffdio_register reg;
+    size_t page_size = tinyjambu_lazymap_page_size();
+
+    /* Validate the parameters.  Every page must contain a whole number
+     * of sectors, and the sectors must be a whole number of words */
+    if (!page_size || !length || !sector_size || (sector_size % 4) != 0 ||
+            (page_size % sector_size) != 0) {
+        return 0;
+    }
+
+    /* Allocate the mapping information */
+    map = (tinyjambu_lazymap_t *)calloc(1, sizeof(tinyjambu_lazymap_t));
+    if (!map)
+        return 0;
+    memcpy(map->key, k, TINYJAMBU_128_KEY_SIZE);
+    map->tags = tags;
+    map->page_size = page_size;
+    map->sector_size = sector_size;
+    map->sectors_per_page = page_size / sector_size;
+    map->num_pages = (length + page_size - 1) / page_size;
+    map->num_sectors = (length + sector_size - 1) / sector_size;
+    map->max_window =
+        readahead ? readahead : TINYJAMBU_LAZYMAP_DEFAULT_READAHEAD;
+    if (map->max_window > map->num_pages)
+        map->max_window = map->num_pages;
+    map->window = 1;
+    map->next_page = map->num_pages;
+    map->fd = fd;
+    map->uffd = -1;
+    map->stop[0] = -1;
+    map->stop[1] = -1;
+    map->base = MAP_FAILED;
+    map->buffer = (unsigned char *)malloc(map->max_window * page_size);
+    map->present = (unsigned char *)calloc(1, map->num_pages / 8 + 1);
+    if (!(map->buffer) || !(map->present) ||
+            pthread_mutex_init(&(map->lock), 0) != 0) {
+        free(map->buffer);
+        free(map->present);
+        tinyjambu_clean(map, sizeof(tinyjambu_lazymap_t));
+        free(map);
+        return 0;
+    }
+
+    /* Reserve the address space and register it with userfaultfd */
+    map->base = (unsigned char *)mmap
+        (0, map->num_pages * page_size, PROT_READ,
+         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    map->uffd = tinyjambu_lazymap_uffd();
+    if (map->base == MAP_FAILED || map->uffd < 0 || pipe(map->stop) != 0) {
+        tinyjambu_lazymap_close(map);
+        return 0;
+    }
+    memset(&reg, 0, sizeof(reg));
+    reg.range.start = (unsigned long)(map->base);
+    reg.range.len = map->num_pages * page_size;
+    reg.mode = UFFDIO_REGISTER_MODE_MISSING;
+    if (ioctl(map->uffd, UFFDIO_REGISTER, &reg) != 0) {
+        tinyjambu_lazymap_close(map);
+        return 0;
+    }
+
+    /* Start the helper thread */
+    if (pthread_create(&(map->thread), 0,
+                       tinyjambu_lazymap_thread, map) != 0) {
+        close(map->stop[1]);
+        map->stop[1] = -1;
+        tinyjambu_lazymap_close(map);
+        return 0;
+    }
+    return map;
+}
+
+const void *tinyjambu_lazymap_data(const tinyjambu_lazymap_t *map)
+{
+    return map->base;
+}
+
+int tinyjambu_lazymap_failed(tinyjambu_lazymap_t *map)
+{
+    int failed;
+    pthread_mutex_lock(&(map->lock));
+    failed = map->failed;
+    pthread_mutex_unlock(&(map->lock));
+    return failed;
+}
+
+size_t tinyjambu_lazymap_pages_decrypted(tinyjambu_lazymap_t *map)
+{
+    size_t decrypted;
+    pthread_mutex_lock(&(map->lock));
+    decrypted = map->decrypted;
+    pthread_mutex_unlock(&(map->lock));
+    return decrypted;
+}
+
+void tinyjambu_lazymap_close(tinyjambu_lazymap_t *map)
+{
+    size_t page;
+    if (!map)
+        return;
+
+    /* Stop the helper thread.  The write end of the pipe is only open
+     * while the helper thread is running */
+    if (map->stop[1] >= 0) {
+        while (write(map->stop[1], "", 1) < 0 && errno == EINTR)
+            ; /* Retry */
+        pthread_join(map->thread, 0);
+        close(map->stop[1]);
+    }
+    if (map->stop[0] >= 0)
+        close(map->stop[0]);
+    if (map->uffd >= 0)
+        close(map->uffd);
+
+    /* Destroy the plaintext and unmap the region.  Pages that were never
+     * installed are not touched because closing userfaultfd causes them
+     * to be filled with zeroes on access */
+    if (map->base != MAP_FAILED) {
+        for (page = 0; page < map->num_pages; ++page) {
+            if (tinyjambu_lazymap_is_present(map, page) &&
+                    mprotect(map->base + page * map->page_size,
+                             map->page_size, PROT_READ | PROT_WRITE) == 0) {
+                tinyjambu_clean(map->base + page * map->page_size,
+                                map->page_size);
+            }
+        }
+        munmap(map->base, map->num_pages * map->page_size);
+    }
+    pthread_mutex_destroy(&(map->lock));
+    free(map->buffer);
+    free(map->present);
+    tinyjambu_clean(map, sizeof(tinyjambu_lazymap_t));
+    free(map);
+}
+
+#else /* !TINYJAMBU_LAZYMAP_UFFD */
+
+/* Lazy decryption is not supported on this platform */
+
+size_t tinyjambu_lazymap_page_size(void)
+{
+    return 0;
+}
+
+tinyjambu_lazymap_t *tinyjambu_lazymap_open
+    (int fd, size_t length, const unsigned char *tags, size_t sector_size,
+     const unsigned char *k, size_t readahead)
+{
+    (void)fd;
+    (void)length;
+    (void)tags;
+    (void)sector_size;
+    (void)k;
+    (void)readahead;
+    return 0;
+}
+
+const void *tinyjambu_lazymap_data(const tinyjambu_lazymap_t *map)
+{
+    (void)map;
+    return 0;
+}
+
+int tinyjambu_lazymap_failed(tinyjambu_lazymap_t *map)
+{
+    (void)map;
+    return 1;
+}
+
+size_t tinyjambu_lazymap_pages_decrypted(tinyjambu_lazymap_t *map)
+{
+    (void)map;
+    return 0;
+}
+
+void tinyjambu_lazymap_close(tinyjambu_lazymap_t *map)
+{
+    (void)map;
+}
+
+#endif /* !TINYJAMBU_LAZYMAP_UFFD */
@@ -0,0 +1,334 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "TinyJAMBU.h"
+#include "backend/tinyjambu-aead-common.h"
+#include <string.h>
+
+/*
+ * TinyJAMBU-MAC uses the associated data path of TinyJAMBU AEAD to
+ * authenticate a message without encrypting anything:
+ *
+ *      S = P1024(K, 0)
+ *      for i = 0..2: S[1] ^= 0xF0; S = P640(K, S); S[3] ^= N[i]
+ *      for each word M[j]: S[1] ^= 0x30; S = P640(K, S); S[3] ^= M[j]
+ *      T = FinalizeTag(K, S)
+ *
+ * N is a 96-bit nonce, or all-zeroes for the fixed IV variant.  The nonce
+ * domain separator 0xF0 is not used by the AEAD or SIV modes, which keeps
+ * MAC tags separate from AEAD tags under the same key.  The last word of
+ * the message is handled the same way as the last word of associated data
+ * in the AEAD mode, and FinalizeTag is the AEAD tag generation step.
+ */
+
+/**
+ * \brief Domain separator for absorbing the nonce in MAC mode.
+ */
+#define TINYJAMBU_MAC_NONCE_DOMAIN 0xF0
+
+/**
+ * \brief Domain separator for absorbing message data in MAC mode.
+ */
+#define TINYJAMBU_MAC_DATA_DOMAIN 0x30
+
+/**
+ * \brief Permutation state for any of the TinyJAMBU variants.
+ */
+typedef union
+{
+    tinyjambu_128_state_t s128;     /**< TinyJAMBU-128 state */
+    tinyjambu_192_state_t s192;     /**< TinyJAMBU-192 state */
+    tinyjambu_256_state_t s256;     /**< TinyJAMBU-256 state */
+
+} tinyjambu_mac_perm_t;
+
+/**
+ * \brief Private state information for a TinyJAMBU-MAC key.
+ */
+typedef struct
+{
+    /** Key and the permutation state after the key setup step */
+    tinyjambu_mac_perm_t init;
+
+    /** Permutation state after absorbing the fixed IV */
+    uint32_t iv[4];
+
+    /** Size of the key in bytes */
+    unsigned key_size;
+
+} tinyjambu_mac_key_p_t;
+
+/**
+ * \brief Private state information for incremental TinyJAMBU-MAC.
+ */
+typedef struct
+{
+    /** Key and the permutation state */
+    tinyjambu_mac_perm_t state;
+
+    /** Size of the key in bytes */
+    unsigned key_size;
+
+    /** Number of bytes in the partial word buffer */
+    unsigned posn;
+
+    /** Partial word buffer */
+    unsigned char buf[4];
+
+} tinyjambu_mac_state_p_t;
+
+/** @cond */
+
+/* Compile-time check that the private structures can fit within the
+ * bounds of the public ones.  These lines of code will fail to
+ * compile if a private structure is too large for the public one. */
+typedef int tinyjambu_mac_key_size_check
+    [(sizeof(tinyjambu_mac_key_p_t) <= sizeof(tinyjambu_mac_key_t)) * 2 - 1];
+typedef int tinyjambu_mac_state_size_check
+    [(sizeof(tinyjambu_mac_state_p_t) <=
+            sizeof(tinyjambu_mac_state_t)) * 2 - 1];
+
+/** @endcond */
+
+/* Runs the permutation for the variant with a specific key size */
+static void tinyjambu_mac_permute
+    (tinyjambu_mac_perm_t *state, unsigned key_size, unsigned rounds)
+{
+    if (key_size == TINYJAMBU_128_KEY_SIZE)
+        tinyjambu_permutation_128(&(state->s128), rounds);
+    else if (key_size == TINYJAMBU_192_KEY_SIZE)
+        tinyjambu_permutation_192(&(state->s192), rounds);
+    else
+        tinyjambu_permutation_256(&(state->s256), rounds);
+}
+
+/* Absorbs the nonce into the permutation state */
+static void tinyjambu_mac_absorb_nonce
+    (tinyjambu_mac_perm_t *state, unsigned key_size,
+     const unsigned char *nonce)
+{
+    static unsigned char const fixed_iv[TINYJAMBU_NONCE_SIZE] = {0};
+    unsigned index;
+    if (!nonce)
+        nonce = fixed_iv;
+    for (index = 0; index < TINYJAMBU_NONCE_SIZE; index += 4) {
+        tinyjambu_add_domain(&(state->s128), TINYJAMBU_MAC_NONCE_DOMAIN);
+        tinyjambu_mac_permute(state, key_size, TINYJAMBU_ROUNDS(640));
+        tinyjambu_absorb(&(state->s128), le_load_word32(nonce + index));
+    }
+}
+
+/* Absorbs message data into the permutation state */
+static void tinyjambu_mac_absorb
+    (tinyjambu_mac_perm_t *state, unsigned key_size,
+     const unsigned char *data, size_t size)
+{
+    if (key_size == TINYJAMBU_128_KEY_SIZE) {
+        tinyjambu_absorb_128(&(state->s128), data, size,
+                             TINYJAMBU_MAC_DATA_DOMAIN, TINYJAMBU_ROUNDS(640));
+    } else if (key_size == TINYJAMBU_192_KEY_SIZE) {
+        tinyjambu_absorb_192(&(state->s192), data, size,
+                             TINYJAMBU_MAC_DATA_DOMAIN, TINYJAMBU_ROUNDS(640));
+    } else {
+        tinyjambu_absorb_256(&(state->s256), data, size,
+                             TINYJAMBU_MAC_DATA_DOMAIN, TINYJAMBU_ROUNDS(640));
+    }
+}
+
+/* Generates the final authentication tag */
+static void tinyjambu_mac_generate_tag
+    (tinyjambu_mac_perm_t *state, unsigned key_size, unsigned char *tag)
+{
+    if (key_size == TINYJAMBU_128_KEY_SIZE)
+        tinyjambu_generate_tag_128(&(state->s128), tag);
+    else if (key_size == TINYJAMBU_192_KEY_SIZE)
+        tinyjambu_generate_tag_192(&(state->s192), tag);
+    else
+        tinyjambu_generate_tag_256(&(state->s256), tag);
+}
+
+/* Finishes setting up a key after the key words have been loaded */
+static void tinyjambu_mac_init_key
+    (tinyjambu_mac_key_p_t *pkey, unsigned key_size)
+{
+    tinyjambu_mac_perm_t state;
+
+    /* Key setup: S = P1024(K, 0) */
+    pkey->key_size = key_size;
+    tinyjambu_init_state(&(pkey->init.s128));
+    tinyjambu_mac_permute(&(pkey->init), key_size, TINYJAMBU_ROUNDS(1024));
+
+    /* Pre-compute the state after absorbing the fixed IV */
+    memcpy(&state, &(pkey->init), sizeof(state));
+    tinyjambu_mac_absorb_nonce(&state, key_size, 0);
+    memcpy(pkey->iv, state.s128.s, sizeof(pkey->iv));
+    tinyjambu_clean(&state, sizeof(state));
+}
+
+void tinyjambu_128_mac_init_key
+    (tinyjambu_mac_key_t *key, const unsigned char *k)
+{
+    tinyjambu_mac_key_p_t *pkey = (tinyjambu_mac_key_p_t *)key;
+    memset(key, 0, sizeof(tinyjambu_mac_key_t));
+    pkey->init.s128.k[0] = tinyjambu_key_load_even(k);
+    pkey->init.s128.k[1] = tinyjambu_key_load_odd(k + 4);
+    pkey->init.s128.k[2] = tinyjambu_key_load_even(k + 8);
+    pkey->init.s128.k[3] = tinyjambu_key_load_odd(k + 12);
+    tinyjambu_mac_init_key(pkey, TINYJAMBU_128_KEY_SIZE);
+}
+
+void tinyjambu_192_mac_init_key
+    (tinyjambu_mac_key_t *key, const unsigned char *k)
+{
+    tinyjambu_mac_key_p_t *pkey = (tinyjambu_mac_key_p_t *)key;
+    memset(key, 0, sizeof(tinyjambu_mac_key_t));
+    pkey->init.s192.k[0] = tinyjambu_key_load_even(k);
+    pkey->init.s192.k[1] = tinyjambu_key_load_odd(k + 4);
+    pkey->init.s192.k[2] = tinyjambu_key_load_even(k + 8);
+    pkey->init.s192.k[3] = tinyjambu_key_load_odd(k + 12);
+    pkey->init.s192.k[4] = tinyjambu_key_load_even(k + 16);
+    pkey->init.s192.k[5] = tinyjambu_key_load_odd(k + 20);
+    tinyjambu_mac_init_key(pkey, TINYJAMBU_192_KEY_SIZE);
+}
+
+void tinyjambu_256_mac_init_key
+    (tinyjambu_mac_key_t *key, const unsigned char *k)
+{
+    tinyjambu_mac_key_p_t *pkey = (tinyjambu_mac_key_p_t *)key;
+    memset(key, 0, sizeof(tinyjambu_mac_key_t));
+    pkey->init.s256.k[0] = tinyjambu_key_load_even(k);
+    pkey->init.s256.k[1] = tinyjambu_key_load_odd(k + 4);
+    pkey->init.s256.k[2] = tinyjambu_key_load_even(k + 8);
+    pkey->init.s256.k[3] = tinyjambu_key_load_odd(k + 12);
+    pkey->init.s256.k[4] = tinyjambu_key_load_even(k + 16);
+    pkey->init.s256.k[5] = tinyjambu_key_load_odd(k + 20);
+    pkey->init.s256.k[6] = tinyjambu_key_load_even(k + 24);
+    pkey->init.s256.k[7] = tinyjambu_key_load_odd(k + 28);
+    tinyjambu_mac_init_key(pkey, TINYJAMBU_256_KEY_SIZE);
+}
+
+void tinyjambu_mac_free_key(tinyjambu_mac_key_t *key)
+{
+    tinyjambu_clean(key, sizeof(tinyjambu_mac_key_t));
+}
+
+void tinyjambu_mac
+    (unsigned char *tag, const tinyjambu_mac_key_t *key,
+     const unsigned char *nonce, const unsigned char *data, size_t size)
+{
+    const tinyjambu_mac_key_p_t *pkey = (const tinyjambu_mac_key_p_t *)key;
+    tinyjambu_mac_perm_t state;
+
+    /* Set up the state from the key, absorbing the nonce if necessary */
+    memcpy(&state, &(pkey->init), sizeof(state));
+    if (nonce)
+        tinyjambu_mac_absorb_nonce(&state, pkey->key_size, nonce);
+    else
+        memcpy(state.s128.s, pkey->iv, sizeof(pkey->iv));
+
+    /* Absorb the data and generate the tag */
+    tinyjambu_mac_absorb(&state, pkey->key_size, data, size);
+    tinyjambu_mac_generate_tag(&state, pkey->key_size, tag);
+    tinyjambu_clean(&state, sizeof(state));
+}
+
+int tinyjambu_mac_verify
+    (const unsigned char *tag, const tinyjambu_mac_key_t *key,
+     const unsigned char *nonce, const unsigned char *data, size_t size)
+{
+    unsigned char computed[TINYJAMBU_MAC_SIZE];
+    int result;
+    tinyjambu_mac(computed, key, nonce, data, size);
+    result = tinyjambu_aead_check_tag(0, 0, computed, tag, TINYJAMBU_MAC_SIZE);
+    tinyjambu_clean(computed, sizeof(computed));
+    return result;
+}
+
+void tinyjambu_mac_init
+    (tinyjambu_mac_state_t *state, const tinyjambu_mac_key_t *key,
+     const unsigned char *nonce)
+{
+    tinyjambu_mac_state_p_t *pstate = (tinyjambu_mac_state_p_t *)state;
+    const tinyjambu_mac_key_p_t *pkey = (const tinyjambu_mac_key_p_t *)key;
+    memset(state, 0, sizeof(tinyjambu_mac_state_t));
+    memcpy(&(pstate->state), &(pkey->init), sizeof(pstate->state));
+    pstate->key_size = pkey->key_size;
+    if (nonce)
+        tinyjambu_mac_absorb_nonce(&(pstate->state), pkey->key_size, nonce);
+    else
+        memcpy(pstate->state.s128.s, pkey->iv, sizeof(pkey->iv));
+}
+
+void tinyjambu_mac_update
+    (tinyjambu_mac_state_t *state, const unsigned char *data, size_t size)
+{
+    tinyjambu_mac_state_p_t *pstate = (tinyjambu_mac_state_p_t *)state;
+    size_t len;
+
+    /* Fill up the partial word buffer from last time */
+    if (pstate->posn > 0) {
+        len = 4 - pstate->posn;
+        if (len > size)
+            len = size;
+        memcpy(pstate->buf + pstate->posn, data, len);
+        pstate->posn += (unsigned)len;
+        data += len;
+        size -= len;
+        if (pstate->posn < 4)
+            return;
+        tinyjambu_mac_absorb
+            (&(pstate->state), pstate->key_size, pstate->buf, 4);
+        pstate->posn = 0;
+    }
+
+    /* Absorb whole words directly and save the rest for later */
+    len = size & ~((size_t)3);
+    tinyjambu_mac_absorb(&(pstate->state), pstate->key_size, data, len);
+    memcpy(pstate->buf, data + len, size - len);
+    pstate->posn = (unsigned)(size - len);
+}
+
+void tinyjambu_mac_finalize(tinyjambu_mac_state_t *state, unsigned char *tag)
+{
+    tinyjambu_mac_state_p_t *pstate = (tinyjambu_mac_state_p_t *)state;
+    tinyjambu_mac_absorb
+        (&(pstate->state), pstate->key_size, pstate->buf, pstate->posn);
+    tinyjambu_mac_generate_tag(&(pstate->state), pstate->key_size, tag);
+    tinyjambu_mac_free(state);
+}
+
+int tinyjambu_mac_check_finalize
+    (tinyjambu_mac_state_t *state, const unsigned char *tag)
+{
+    unsigned char computed[TINYJAMBU_MAC_SIZE];
+    int result;
+    tinyjambu_mac_finalize(state, computed);
+    result = tinyjambu_aead_check_tag(0, 0, computed, tag, TINYJAMBU_MAC_SIZE);
+    tinyjambu_clean(computed, sizeof(computed));
+    return result;
+}
+
+void tinyjambu_mac_free(tinyjambu_mac_state_t *state)
+{
+    tinyjambu_clean(state, sizeof(tinyjambu_mac_state_t));
+}
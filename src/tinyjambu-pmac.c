@@ -0,0 +1,528 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#if defined(HAVE_CONFIG_H)
+#include <config.h>
+#endif
+#include "TinyJAMBU.h"
+#include "backend/tinyjambu-aead-common.h"
+#include <string.h>
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#define TINYJAMBU_PMAC_PTHREAD 1
+#endif
+
+/*
+ * TinyJAMBU-PMAC follows the structure of PMAC from the OCB3 hash function
+ * (RFC 7253), with E(X) = P1024(K, X) the keyed TinyJAMBU-128 permutation
+ * used as a 128-bit block cipher:
+ *
+ *      L_* = E(0), L_$ = double(L_*), L_0 = double(L_$),
+ *      L_j = double(L_{j-1})
+ *      Offset_0 = 0, Sum = 0
+ *      for each full block M_i, i = 1..m:
+ *          Offset_i = Offset_{i-1} ^ L_{ntz(i)}
+ *          Sum ^= E(M_i ^ Offset_i)
+ *      if there is a partial final block M_*:
+ *          Sum ^= E((M_* || 1 || 0...) ^ Offset_m ^ L_*)
+ *      T = E(Sum ^ L_$)
+ *
+ * where double() is multiplication by x in GF(2^128) with the polynomial
+ * x^128 + x^7 + x^2 + x + 1.  Blocks are loaded as four little-endian
+ * 32-bit words with word 0 the least significant.
+ *
+ * Offset_i can be computed directly as the XOR of L_j for each bit j that
+ * is set in the Gray code of i, so the message can be split into ranges
+ * that are processed by separate threads.  Within a range, the blocks are
+ * independent and four are processed at a time in parallel lanes.
+ */
+
+/**
+ * \brief Number of rounds to use for the block cipher.
+ */
+#define TINYJAMBU_PMAC_ROUNDS TINYJAMBU_ROUNDS(1024)
+
+/**
+ * \brief Size of a block for TinyJAMBU-PMAC.
+ */
+#define TINYJAMBU_PMAC_BLOCK_SIZE 16
+
+/**
+ * \brief Number of L_j values that are pre-computed in the key.
+ *
+ * Higher values are only needed for messages of 64G or more, and are
+ * computed on the fly.
+ */
+#define TINYJAMBU_PMAC_NUM_L 32
+
+/**
+ * \brief Minimum number of blocks to give to each thread.
+ */
+#define TINYJAMBU_PMAC_THREAD_BLOCKS 4096
+
+/**
+ * \brief Maximum number of threads to use for a single message.
+ */
+#define TINYJAMBU_PMAC_MAX_THREADS 64
+
+/**
+ * \brief Private state information for a TinyJAMBU-PMAC key.
+ */
+typedef struct
+{
+    /** Words of the key, pre-inverted for the permutation */
+    uint32_t k[4];
+
+    /** L_* value */
+    uint32_t L_star[4];
+
+    /** L_$ value */
+    uint32_t L_dollar[4];
+
+    /** L_j values for j = 0..TINYJAMBU_PMAC_NUM_L-1 */
+    uint32_t L[TINYJAMBU_PMAC_NUM_L][4];
+
+} tinyjambu_pmac_key_p_t;
+
+/**
+ * \brief Private state information for incremental TinyJAMBU-PMAC.
+ */
+typedef struct
+{
+    /** Points to the pre-computed key */
+    const tinyjambu_pmac_key_p_t *key;
+
+    /** Running XOR of the enciphered blocks */
+    uint32_t sum[4];
+
+    /** Offset for the last block that was processed */
+    uint32_t offset[4];
+
+    /** Number of full blocks that have been processed so far */
+    uint64_t index;
+
+    /** Buffer for a partial block */
+    unsigned char buf[TINYJAMBU_PMAC_BLOCK_SIZE];
+
+    /** Number of bytes in the partial block buffer */
+    unsigned posn;
+
+} tinyjambu_pmac_state_p_t;
+
+/** @cond */
+
+/* Compile-time check that the private structures can fit within the
+ * bounds of the public ones.  These lines of code will fail to compile
+ * if the private structures are too large for the public ones. */
+typedef int tinyjambu_pmac_key_size_check
+    [(sizeof(tinyjambu_pmac_key_p_t) <=
+            sizeof(tinyjambu_pmac_key_t)) * 2 - 1];
+typedef int tinyjambu_pmac_state_size_check
+    [(sizeof(tinyjambu_pmac_state_p_t) <=
+            sizeof(tinyjambu_pmac_state_t)) * 2 - 1];
+
+/** @endcond */
+
+/* Enciphers a single block in place with the keyed permutation */
+static void tinyjambu_pmac_encipher
+    (const tinyjambu_pmac_key_p_t *pkey, uint32_t block[4])
+{
+    tinyjambu_128_state_t state;
+    memcpy(state.s, block, sizeof(state.s));
+    memcpy(state.k, pkey->k, sizeof(state.k));
+    tinyjambu_permutation_128(&state, TINYJAMBU_PMAC_ROUNDS);
+    memcpy(block, state.s, sizeof(state.s));
+    tinyjambu_clean(&state, sizeof(state));
+}
+
+/* XOR's L_j into an offset */
+static void tinyjambu_pmac_add_L
+    (const tinyjambu_pmac_key_p_t *pkey, unsigned j, uint32_t offset[4])
+{
+    uint32_t L[4];
+    if (j < TINYJAMBU_PMAC_NUM_L) {
+        offset[0] ^= pkey->L[j][0];
+        offset[1] ^= pkey->L[j][1];
+        offset[2] ^= pkey->L[j][2];
+        offset[3] ^= pkey->L[j][3];
+        return;
+    }
+    memcpy(L, pkey->L[TINYJAMBU_PMAC_NUM_L - 1], sizeof(L));
+    for (; j >= TINYJAMBU_PMAC_NUM_L; --j)
+        tinyjambu_gf128_double(L, L);
+    offset[0] ^= L[0];
+    offset[1] ^= L[1];
+    offset[2] ^= L[2];
+    offset[3] ^= L[3];
+    tinyjambu_clean(L, sizeof(L));
+}
+
+/* Returns the number of trailing zero bits in a non-zero block index */
+static unsigned tinyjambu_pmac_ntz(uint64_t index)
+{
+    unsigned count = 0;
+    while ((index & 1) == 0) {
+        index >>= 1;
+        ++count;
+    }
+    return count;
+}
+
+/* Computes Offset_i directly from the Gray code of i */
+static void tinyjambu_pmac_offset_at
+    (const tinyjambu_pmac_key_p_t *pkey, uint64_t index, uint32_t offset[4])
+{
+    uint64_t gray = index ^ (index >> 1);
+    unsigned j = 0;
+    memset(offset, 0, sizeof(uint32_t) * 4);
+    for (; gray != 0; gray >>= 1, ++j) {
+        if (gray & 1)
+            tinyjambu_pmac_add_L(pkey, j, offset);
+    }
+}
+
+/* Loads a block from a buffer and XOR's it with the offset for the block */
+#define tinyjambu_pmac_load(state, data, offset) \
+    do { \
+        (state)->s[0] = le_load_word32((data))      ^ (offset)[0]; \
+        (state)->s[1] = le_load_word32((data) + 4)  ^ (offset)[1]; \
+        (state)->s[2] = le_load_word32((data) + 8)  ^ (offset)[2]; \
+        (state)->s[3] = le_load_word32((data) + 12) ^ (offset)[3]; \
+    } while (0)
+
+/* Adds the enciphered version of a block to the sum */
+#define tinyjambu_pmac_accum(sum, state) \
+    do { \
+        (sum)[0] ^= (state)->s[0]; \
+        (sum)[1] ^= (state)->s[1]; \
+        (sum)[2] ^= (state)->s[2]; \
+        (sum)[3] ^= (state)->s[3]; \
+    } while (0)
+
+/* Processes a run of full blocks that follow block number "*index" */
+static void tinyjambu_pmac_blocks
+    (const tinyjambu_pmac_key_p_t *pkey, uint32_t sum[4], uint32_t offset[4],
+     uint64_t *index, const unsigned char *data, size_t nblocks)
+{
+    tinyjambu_128_state_t states[4];
+    uint64_t i = *index;
+    unsigned lane;
+
+    /* Copy the key into each of the lanes */
+    for (lane = 0; lane < 4; ++lane)
+        memcpy(states[lane].k, pkey->k, sizeof(pkey->k));
+
+    /* Process four blocks at a time in parallel lanes */
+    while (nblocks >= 4) {
+        for (lane = 0; lane < 4; ++lane) {
+            tinyjambu_pmac_add_L(pkey, tinyjambu_pmac_ntz(++i), offset);
+            tinyjambu_pmac_load(&(states[lane]), data, offset);
+            data += TINYJAMBU_PMAC_BLOCK_SIZE;
+        }
+        tinyjambu_permutation_128_x4(states, TINYJAMBU_PMAC_ROUNDS);
+        for (lane = 0; lane < 4; ++lane)
+            tinyjambu_pmac_accum(sum, &(states[lane]));
+        nblocks -= 4;
+    }
+
+    /* Process the remaining blocks one at a time */
+    while (nblocks > 0) {
+        tinyjambu_pmac_add_L(pkey, tinyjambu_pmac_ntz(++i), offset);
+        tinyjambu_pmac_load(&(states[0]), data, offset);
+        tinyjambu_permutation_128(&(states[0]), TINYJAMBU_PMAC_ROUNDS);
+        tinyjambu_pmac_accum(sum, &(states[0]));
+        data += TINYJAMBU_PMAC_BLOCK_SIZE;
+        --nblocks;
+    }
+
+    *index = i;
+    tinyjambu_clean(states, sizeof(states));
+}
+
+/* Processes the partial final block, if any, and generates the tag */
+static void tinyjambu_pmac_final
+    (const tinyjambu_pmac_key_p_t *pkey, uint32_t sum[4],
+     const uint32_t offset[4], const unsigned char *data, unsigned size,
+     unsigned char *tag)
+{
+    unsigned char padded[TINYJAMBU_PMAC_BLOCK_SIZE];
+    uint32_t block[4];
+    if (size > 0) {
+        memcpy(padded, data, size);
+        padded[size] = 0x80;
+        memset(padded + size + 1, 0, sizeof(padded) - size - 1);
+        block[0] = le_load_word32(padded)      ^ offset[0] ^ pkey->L_star[0];
+        block[1] = le_load_word32(padded + 4)  ^ offset[1] ^ pkey->L_star[1];
+        block[2] = le_load_word32(padded + 8)  ^ offset[2] ^ pkey->L_star[2];
+        block[3] = le_load_word32(padded + 12) ^ offset[3] ^ pkey->L_star[3];
+        tinyjambu_pmac_encipher(pkey, block);
+        sum[0] ^= block[0];
+        sum[1] ^= block[1];
+        sum[2] ^= block[2];
+        sum[3] ^= block[3];
+        tinyjambu_clean(padded, sizeof(padded));
+    }
+    block[0] = sum[0] ^ pkey->L_dollar[0];
+    block[1] = sum[1] ^ pkey->L_dollar[1];
+    block[2] = sum[2] ^ pkey->L_dollar[2];
+    block[3] = sum[3] ^ pkey->L_dollar[3];
+    tinyjambu_pmac_encipher(pkey, block);
+    le_store_word32(tag,      block[0]);
+    le_store_word32(tag + 4,  block[1]);
+    le_store_word32(tag + 8,  block[2]);
+    le_store_word32(tag + 12, block[3]);
+    tinyjambu_clean(block, sizeof(block));
+}
+
+void tinyjambu_pmac_init_key(tinyjambu_pmac_key_t *key, const unsigned char *k)
+{
+    tinyjambu_pmac_key_p_t *pkey = (tinyjambu_pmac_key_p_t *)key;
+    unsigned j;
+    memset(key, 0, sizeof(tinyjambu_pmac_key_t));
+    pkey->k[0] = tinyjambu_key_load_even(k);
+    pkey->k[1] = tinyjambu_key_load_odd(k + 4);
+    pkey->k[2] = tinyjambu_key_load_even(k + 8);
+    pkey->k[3] = tinyjambu_key_load_odd(k + 12);
+    tinyjambu_pmac_encipher(pkey, pkey->L_star);
+    tinyjambu_gf128_double(pkey->L_dollar, pkey->L_star);
+    tinyjambu_gf128_double(pkey->L[0], pkey->L_dollar);
+    for (j = 1; j < TINYJAMBU_PMAC_NUM_L; ++j)
+        tinyjambu_gf128_double(pkey->L[j], pkey->L[j - 1]);
+}
+
+void tinyjambu_pmac_free_key(tinyjambu_pmac_key_t *key)
+{
+    tinyjambu_clean(key, sizeof(tinyjambu_pmac_key_t));
+}
+
+void tinyjambu_pmac
+    (unsigned char *tag, const tinyjambu_pmac_key_t *key,
+     const unsigned char *data, size_t size)
+{
+    const tinyjambu_pmac_key_p_t *pkey = (const tinyjambu_pmac_key_p_t *)key;
+    uint32_t sum[4] = {0, 0, 0, 0};
+    uint32_t offset[4] = {0, 0, 0, 0};
+    uint64_t index = 0;
+    size_t nblocks = size / TINYJAMBU_PMAC_BLOCK_SIZE;
+    tinyjambu_pmac_blocks(pkey, sum, offset, &index, data, nblocks);
+    tinyjambu_pmac_final
+        (pkey, sum, offset, data + nblocks * TINYJAMBU_PMAC_BLOCK_SIZE,
+         (unsigned)(size % TINYJAMBU_PMAC_BLOCK_SIZE), tag);
+    tinyjambu_clean(sum, sizeof(sum));
+    tinyjambu_clean(offset, sizeof(offset));
+}
+
+#if defined(TINYJAMBU_PMAC_PTHREAD)
+
+/**
+ * \brief Range of blocks that is processed by a single thread.
+ */
+typedef struct
+{
+    /** Points to the pre-computed key */
+    const tinyjambu_pmac_key_p_t *key;
+
+    /** Points to the first block in the range */
+    const unsigned char *data;
+
+    /** Number of the block just before the range */
+    uint64_t first;
+
+    /** Number of blocks in the range */
+    size_t nblocks;
+
+    /** XOR of the enciphered blocks in the range */
+    uint32_t sum[4];
+
+    /** Thread that is processing the range */
+    pthread_t thread;
+
+    /** Non-zero if the thread was started successfully */
+    int started;
+
+} tinyjambu_pmac_range_t;
+
+/* Processes a range of blocks */
+static void *tinyjambu_pmac_range(void *arg)
+{
+    tinyjambu_pmac_range_t *range = (tinyjambu_pmac_range_t *)arg;
+    uint32_t offset[4];
+    uint64_t index = range->first;
+    tinyjambu_pmac_offset_at(range->key, index, offset);
+    memset(range->sum, 0, sizeof(range->sum));
+    tinyjambu_pmac_blocks
+        (range->key, range->sum, offset, &index, range->data, range->nblocks);
+    tinyjambu_clean(offset, sizeof(offset));
+    return 0;
+}
+
+void tinyjambu_pmac_parallel
+    (unsigned char *tag, const tinyjambu_pmac_key_t *key,
+     const unsigned char *data, size_t size, unsigned threads)
+{
+    const tinyjambu_pmac_key_p_t *pkey = (const tinyjambu_pmac_key_p_t *)key;
+    tinyjambu_pmac_range_t ranges[TINYJAMBU_PMAC_MAX_THREADS];
+    size_t nblocks = size / TINYJAMBU_PMAC_BLOCK_SIZE;
+    size_t per_thread, extra, start;
+    uint32_t sum[4] = {0, 0, 0, 0};
+    uint32_t offset[4];
+    unsigned count, index;
+
+    /* Determine how many threads are worth using for this message */
+    if (threads > TINYJAMBU_PMAC_MAX_THREADS)
+        threads = TINYJAMBU_PMAC_MAX_THREADS;
+    if ((nblocks / TINYJAMBU_PMAC_THREAD_BLOCKS) < threads)
+        count = (unsigned)(nblocks / TINYJAMBU_PMAC_THREAD_BLOCKS);
+    else
+        count = threads;
+    if (count <= 1) {
+        tinyjambu_pmac(tag, key, data, size);
+        return;
+    }
+
+    /* Divide the full blocks between the threads as evenly as possible */
+    per_thread = nblocks / count;
+    extra = nblocks % count;
+    start = 0;
+    for (index = 0; index < count; ++index) {
+        ranges[index].key = pkey;
+        ranges[index].data = data + start * TINYJAMBU_PMAC_BLOCK_SIZE;
+        ranges[index].first = start;
+        ranges[index].nblocks = per_thread + (index < extra ? 1 : 0);
+        ranges[index].started = 0;
+        start += ranges[index].nblocks;
+    }
+
+    /* Start the helper threads.  If a thread cannot be created, then its
+     * range is processed on the calling thread after the others */
+    for (index = 1; index < count; ++index) {
+        ranges[index].started =
+            (pthread_create(&(ranges[index].thread), 0,
+                            tinyjambu_pmac_range, &(ranges[index])) == 0);
+    }
+
+    /* Process the first range on the calling thread and then collect
+     * the results from the other threads */
+    for (index = 0; index < count; ++index) {
+        if (ranges[index].started)
+            pthread_join(ranges[index].thread, 0);
+        else
+            tinyjambu_pmac_range(&(ranges[index]));
+        sum[0] ^= ranges[index].sum[0];
+        sum[1] ^= ranges[index].sum[1];
+        sum[2] ^= ranges[index].sum[2];
+        sum[3] ^= ranges[index].sum[3];
+    }
+
+    /* Process the partial final block and generate the tag */
+    tinyjambu_pmac_offset_at(pkey, nblocks, offset);
+    tinyjambu_pmac_final
+        (pkey, sum, offset, data + nblocks * TINYJAMBU_PMAC_BLOCK_SIZE,
+         (unsigned)(size % TINYJAMBU_PMAC_BLOCK_SIZE), tag);
+    tinyjambu_clean(ranges, sizeof(ranges));
+    tinyjambu_clean(sum, sizeof(sum));
+    tinyjambu_clean(offset, sizeof(offset));
+}
+
+#else /* !TINYJAMBU_PMAC_PTHREAD */
+
+void tinyjambu_pmac_parallel
+    (unsigned char *tag, const tinyjambu_pmac_key_t *key,
+     const unsigned char *data, size_t size, unsigned threads)
+{
+    (void)threads;
+    tinyjambu_pmac(tag, key, data, size);
+}
+
+#endif /* !TINYJAMBU_PMAC_PTHREAD */
+
+int tinyjambu_pmac_verify
+    (const unsigned char *tag, const tinyjambu_pmac_key_t *key,
+     const unsigned char *data, size_t size)
+{
+    unsigned char computed[TINYJAMBU_PMAC_SIZE];
+    int result;
+    tinyjambu_pmac(computed, key, data, size);
+    result = tinyjambu_aead_check_tag
+        (0, 0, computed, tag, TINYJAMBU_PMAC_SIZE);
+    tinyjambu_clean(computed, sizeof(computed));
+    return result;
+}
+
+void tinyjambu_pmac_init
+    (tinyjambu_pmac_state_t *state, const tinyjambu_pmac_key_t *key)
+{
+    tinyjambu_pmac_state_p_t *pstate = (tinyjambu_pmac_state_p_t *)state;
+    memset(state, 0, sizeof(tinyjambu_pmac_state_t));
+    pstate->key = (const tinyjambu_pmac_key_p_t *)key;
+}
+
+void tinyjambu_pmac_update
+    (tinyjambu_pmac_state_t *state, const unsigned char *data, size_t size)
+{
+    tinyjambu_pmac_state_p_t *pstate = (tinyjambu_pmac_state_p_t *)state;
+    size_t len;
+
+    /* Fill up the partial block buffer if there is something in it */
+    if (pstate->posn > 0) {
+        len = TINYJAMBU_PMAC_BLOCK_SIZE - pstate->posn;
+        if (len > size)
+            len = size;
+        memcpy(pstate->buf + pstate->posn, data, len);
+        pstate->posn += (unsigned)len;
+        data += len;
+        size -= len;
+        if (pstate->posn < TINYJAMBU_PMAC_BLOCK_SIZE)
+            return;
+        tinyjambu_pmac_blocks
+            (pstate->key, pstate->sum, pstate->offset, &(pstate->index),
+             pstate->buf, 1);
+        pstate->posn = 0;
+    }
+
+    /* Process full blocks directly from the input */
+    len = size / TINYJAMBU_PMAC_BLOCK_SIZE;
+    tinyjambu_pmac_blocks
+        (pstate->key, pstate->sum, pstate->offset, &(pstate->index),
+         data, len);
+    data += len * TINYJAMBU_PMAC_BLOCK_SIZE;
+    size -= len * TINYJAMBU_PMAC_BLOCK_SIZE;
+
+    /* Save the left-over data for next time */
+    memcpy(pstate->buf, data, size);
+    pstate->posn = (unsigned)size;
+}
+
+void tinyjambu_pmac_finalize
+    (tinyjambu_pmac_state_t *state, unsigned char *tag)
+{
+    tinyjambu_pmac_state_p_t *pstate = (tinyjambu_pmac_state_p_t *)state;
+    tinyjambu_pmac_final
+        (pstate->key, pstate->sum, pstate->offset, pstate->buf,
+         pstate->posn, tag);
+    tinyjambu_pmac_free(state);
+}
+
+void tinyjambu_pmac_free(tinyjambu_pmac_state_t *state)
+{
+    tinyjambu_clean(state, sizeof(tinyjambu_pmac_state_t));
+}
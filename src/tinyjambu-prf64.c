@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TinyJAMBU.h"
+#include "backend/tinyjambu-backend.h"
+#include "backend/tinyjambu-util.h"
+#include <string.h>
+
+/*
+ * TinyJAMBU-PRF64 is CMAC (NIST SP 800-38B) with E(X) = P1024(K, X),
+ * the keyed TinyJAMBU-128 permutation used as a 128-bit block cipher,
+ * and the output truncated to 64 bits:
+ *
+ *      L = E(0), K1 = double(L), K2 = double(K1)
+ *      S = 0
+ *      for each block M_i except the last: S = E(S ^ M_i)
+ *      if the last block is full: S = E(S ^ M_n ^ K1)
+ *      otherwise:                 S = E(S ^ (M_n || 1 || 0...) ^ K2)
+ *      PRF(K, M) = first 64 bits of S
+ *
+ * Blocks are loaded as four little-endian 32-bit words, and double() is
+ * multiplication by x in GF(2^128) with the polynomial x^128 + x^7 +
+ * x^2 + x + 1.  The empty message is a single padded block.
+ *
+ * Inputs of up to 16 bytes need a single 1024-step permutation call,
+ * and inputs of up to 32 bytes need two.  The AEAD mode can get away
+ * with fewer steps per word because an attacker only controls 32 bits
+ * of the state at a time.  Here the attacker controls all 128 bits, so
+ * the full 1024 steps that TinyJAMBU uses to mix the entire state during
+ * key setup and tag generation are used for every block.
+ */
+
+/**
+ * \brief Number of rounds to use for the block cipher.
+ */
+#define TINYJAMBU_PRF64_ROUNDS TINYJAMBU_ROUNDS(1024)
+
+/**
+ * \brief Size of a block for TinyJAMBU-PRF64.
+ */
+#define TINYJAMBU_PRF64_BLOCK_SIZE 16
+
+/**
+ * \brief Private state information for a TinyJAMBU-PRF64 key.
+ */
+typedef struct
+{
+    /** Words of the key, pre-inverted for the permutation */
+    uint32_t k[4];
+
+    /** Subkey for messages that end on a full block */
+    uint32_t k1[4];
+
+    /** Subkey for messages that end on a partial block */
+    uint32_t k2[4];
+
+} tinyjambu_prf64_key_p_t;
+
+/** @cond */
+
+/* Compile-time check that tinyjambu_prf64_key_p_t can fit within the
+ * bounds of tinyjambu_prf64_key_t.  This line of code will fail to
+ * compile if the private structure is too large for the public one. */
+typedef int tinyjambu_prf64_key_size_check
+    [(sizeof(tinyjambu_prf64_key_p_t) <=
+            sizeof(tinyjambu_prf64_key_t)) * 2 - 1];
+
+/** @endcond */
+
+/* Absorbs the next block of a message into a state and returns the
+ * number of bytes that were consumed.  The last block is padded and
+ * masked with the appropriate subkey */
+static size_t tinyjambu_prf64_absorb
+    (const tinyjambu_prf64_key_p_t *pkey, tinyjambu_128_state_t *state,
+     const unsigned char *data, size_t size)
+{
+    unsigned char padded[TINYJAMBU_PRF64_BLOCK_SIZE];
+    if (size > TINYJAMBU_PRF64_BLOCK_SIZE) {
+        state->s[0] ^= le_load_word32(data);
+        state->s[1] ^= le_load_word32(data + 4);
+        state->s[2] ^= le_load_word32(data + 8);
+        state->s[3] ^= le_load_word32(data + 12);
+        return TINYJAMBU_PRF64_BLOCK_SIZE;
+    } else if (size == TINYJAMBU_PRF64_BLOCK_SIZE) {
+        state->s[0] ^= le_load_word32(data)      ^ pkey->k1[0];
+        state->s[1] ^= le_load_word32(data + 4)  ^ pkey->k1[1];
+        state->s[2] ^= le_load_word32(data + 8)  ^ pkey->k1[2];
+        state->s[3] ^= le_load_word32(data + 12) ^ pkey->k1[3];
+        return TINYJAMBU_PRF64_BLOCK_SIZE;
+    }
+    memcpy(padded, data, size);
+    padded[size] = 0x80;
+    memset(padded + size + 1, 0, sizeof(padded) - size - 1);
+    state->s[0] ^= le_load_word32(padded)      ^ pkey->k2[0];
+    state->s[1] ^= le_load_word32(padded + 4)  ^ pkey->k2[1];
+    state->s[2] ^= le_load_word32(padded + 8)  ^ pkey->k2[2];
+    state->s[3] ^= le_load_word32(padded + 12) ^ pkey->k2[3];
+    return size;
+}
+
+/* Sets up a state with the key and an all-zero chaining value */
+static void tinyjambu_prf64_setup
+    (const tinyjambu_prf64_key_p_t *pkey, tinyjambu_128_state_t *state)
+{
+    tinyjambu_init_state(state);
+    memcpy(state->k, pkey->k, sizeof(pkey->k));
+}
+
+/* Extracts the 64-bit output from a state */
+#define tinyjambu_prf64_output(state) \
+    (((uint64_t)((state)->s[0])) | (((uint64_t)((state)->s[1])) << 32))
+
+void tinyjambu_prf64_init_key
+    (tinyjambu_prf64_key_t *key, const unsigned char *k)
+{
+    tinyjambu_prf64_key_p_t *pkey = (tinyjambu_prf64_key_p_t *)key;
+    tinyjambu_128_state_t state;
+    memset(key, 0, sizeof(tinyjambu_prf64_key_t));
+    pkey->k[0] = tinyjambu_key_load_even(k);
+    pkey->k[1] = tinyjambu_key_load_odd(k + 4);
+    pkey->k[2] = tinyjambu_key_load_even(k + 8);
+    pkey->k[3] = tinyjambu_key_load_odd(k + 12);
+    tinyjambu_prf64_setup(pkey, &state);
+    tinyjambu_permutation_128(&state, TINYJAMBU_PRF64_ROUNDS);
+    tinyjambu_gf128_double(pkey->k1, state.s);
+    tinyjambu_gf128_double(pkey->k2, pkey->k1);
+    tinyjambu_clean(&state, sizeof(state));
+}
+
+void tinyjambu_prf64_free_key(tinyjambu_prf64_key_t *key)
+{
+    tinyjambu_clean(key, sizeof(tinyjambu_prf64_key_t));
+}
+
+uint64_t tinyjambu_prf64
+    (const tinyjambu_prf64_key_t *key, const unsigned char *data, size_t size)
+{
+    const tinyjambu_prf64_key_p_t *pkey =
+        (const tinyjambu_prf64_key_p_t *)key;
+    tinyjambu_128_state_t state;
+    size_t len;
+    uint64_t result;
+    tinyjambu_prf64_setup(pkey, &state);
+    do {
+        len = tinyjambu_prf64_absorb(pkey, &state, data, size);
+        tinyjambu_permutation_128(&state, TINYJAMBU_PRF64_ROUNDS);
+        data += len;
+        size -= len;
+    } while (size > 0);
+    result = tinyjambu_prf64_output(&state);
+    tinyjambu_clean(&state, sizeof(state));
+    return result;
+}
+
+void tinyjambu_prf64_batch
+    (const tinyjambu_prf64_key_t *key, uint64_t *out,
+     const unsigned char * const *data, const size_t *sizes, size_t count)
+{
+    const tinyjambu_prf64_key_p_t *pkey =
+        (const tinyjambu_prf64_key_p_t *)key;
+    tinyjambu_128_state_t states[4];
+    const unsigned char *ptr[4];
+    size_t left[4];
+    int last[4];
+    unsigned lanes, lane, active;
+    size_t len;
+
+    while (count > 0) {
+        /* Set up the next group of up to four messages */
+        lanes = count < 4 ? (unsigned)count : 4;
+        for (lane = 0; lane < 4; ++lane) {
+            tinyjambu_prf64_setup(pkey, &(states[lane]));
+            if (lane < lanes) {
+                ptr[lane] = data[lane];
+                left[lane] = sizes[lane];
+                last[lane] = 0;
+            } else {
+                ptr[lane] = 0;
+                left[lane] = 0;
+                last[lane] = 1;
+            }
+        }
+
+        /* Absorb one block from each message per permutation call.
+         * Lanes that have finished are permuted along with the others
+         * but their results have already been extracted */
+        do {
+            for (lane = 0; lane < lanes; ++lane) {
+                if (last[lane])
+                    continue;
+                len = tinyjambu_prf64_absorb
+                    (pkey, &(states[lane]), ptr[lane], left[lane]);
+                ptr[lane] += len;
+                left[lane] -= len;
+                last[lane] = (left[lane] == 0) ? 2 : 0;
+            }
+            if (lanes == 1)
+                tinyjambu_permutation_128(&(states[0]), TINYJAMBU_PRF64_ROUNDS);
+            else
+                tinyjambu_permutation_128_x4(states, TINYJAMBU_PRF64_ROUNDS);
+            active = 0;
+            for (lane = 0; lane < lanes; ++lane) {
+                if (last[lane] == 2) {
+                    out[lane] = tinyjambu_prf64_output(&(states[lane]));
+                    last[lane] = 1;
+                } else if (!last[lane]) {
+                    ++active;
+                }
+            }
+        } while (active > 0);
+
+        /* Move onto the next group */
+        out += lanes;
+        data += lanes;
+        sizes += lanes;
+        count -= lanes;
+    }
+    tinyjambu_clean(states, sizeof(states));
+}
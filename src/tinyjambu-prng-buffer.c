@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "TinyJAMBU.h"
+#include "backend/tinyjambu-util.h"
+#include <string.h>
+
+/**
+ * \brief Size of the buffer for random data.
+ */
+#define TINYJAMBU_PRNG_BUFFER_SIZE 256
+
+/**
+ * \brief Private state information for a buffered PRNG front-end.
+ */
+typedef struct
+{
+    /** PRNG to use to refill the buffer */
+    tinyjambu_prng_state_t *prng;
+
+    /** Position of the next unused byte in the buffer */
+    unsigned posn;
+
+    /** Buffer of random data */
+    unsigned char buf[TINYJAMBU_PRNG_BUFFER_SIZE];
+
+} tinyjambu_prng_buffer_p_t;
+
+/** @cond */
+
+/* Compile-time check that tinyjambu_prng_buffer_p_t can fit within the
+ * bounds of tinyjambu_prng_buffer_t.  This line of code will fail to
+ * compile if the private structure is too large for the public one. */
+typedef int tinyjambu_prng_buffer_size_check
+    [(sizeof(tinyjambu_prng_buffer_p_t) <=
+            sizeof(tinyjambu_prng_buffer_t)) * 2 - 1];
+
+/** @endcond */
+
+void tinyjambu_prng_buffer_init
+    (tinyjambu_prng_buffer_t *buffer, tinyjambu_prng_state_t *prng)
+{
+    tinyjambu_prng_buffer_p_t *pbuffer = (tinyjambu_prng_buffer_p_t *)buffer;
+    memset(buffer, 0, sizeof(tinyjambu_prng_buffer_t));
+    pbuffer->prng = prng;
+    pbuffer->posn = TINYJAMBU_PRNG_BUFFER_SIZE;
+}
+
+void tinyjambu_prng_buffer_free(tinyjambu_prng_buffer_t *buffer)
+{
+    tinyjambu_clean(buffer, sizeof(tinyjambu_prng_buffer_t));
+}
+
+void tinyjambu_prng_buffer_bytes
+    (tinyjambu_prng_buffer_t *buffer, unsigned char *data, size_t size)
+{
+    tinyjambu_prng_buffer_p_t *pbuffer = (tinyjambu_prng_buffer_p_t *)buffer;
+    size_t len;
+    while (size > 0) {
+        /* Large requests bypass the buffer once it has been used up */
+        if (pbuffer->posn >= TINYJAMBU_PRNG_BUFFER_SIZE) {
+            if (size >= TINYJAMBU_PRNG_BUFFER_SIZE) {
+                tinyjambu_prng_generate_bulk(pbuffer->prng, data, size);
+                break;
+            }
+            tinyjambu_prng_generate_bulk
+                (pbuffer->prng, pbuffer->buf, TINYJAMBU_PRNG_BUFFER_SIZE);
+            pbuffer->posn = 0;
+        }
+
+        /* Copy out as much as we can and erase the bytes we used */
+        len = TINYJAMBU_PRNG_BUFFER_SIZE - pbuffer->posn;
+        if (len > size)
+            len = size;
+        memcpy(data, pbuffer->buf + pbuffer->posn, len);
+        memset(pbuffer->buf + pbuffer->posn, 0, len);
+        pbuffer->posn += (unsigned)len;
+        data += len;
+        size -= len;
+    }
+}
+
+uint32_t tinyjambu_prng_buffer_u32(tinyjambu_prng_buffer_t *buffer)
+{
+    tinyjambu_prng_buffer_p_t *pbuffer = (tinyjambu_prng_buffer_p_t *)buffer;
+    unsigned char data[4];
+    uint32_t value;
+    if ((pbuffer->posn + 4) <= TINYJAMBU_PRNG_BUFFER_SIZE) {
+        /* Fast path: read directly out of the buffer */
+        value = le_load_word32(pbuffer->buf + pbuffer->posn);
+        memset(pbuffer->buf + pbuffer->posn, 0, 4);
+        pbuffer->posn += 4;
+        return value;
+    }
+    tinyjambu_prng_buffer_bytes(buffer, data, sizeof(data));
+    value = le_load_word32(data);
+    tinyjambu_clean(data, sizeof(data));
+    return value;
+}
+
+uint64_t tinyjambu_prng_buffer_u64(tinyjambu_prng_buffer_t *buffer)
+{
+    uint64_t value = tinyjambu_prng_buffer_u32(buffer);
+    return value | (((uint64_t)tinyjambu_prng_buffer_u32(buffer)) << 32);
+}
+
+/* Uses the method from "Fast Random Integer Generation in an Interval",
+ * Daniel Lemire, ACM Transactions on Modeling and Computer Simulation,
+ * 2019, which avoids a division in the common case. */
+uint32_t tinyjambu_prng_buffer_uniform
+    (tinyjambu_prng_buffer_t *buffer, uint32_t bound)
+{
+    uint64_t m;
+    uint32_t l, t;
+    if (bound <= 1)
+        return 0;
+    m = ((uint64_t)tinyjambu_prng_buffer_u32(buffer)) * bound;
+    l = (uint32_t)m;
+    if (l < bound) {
+        /* Reject values in the biased region at the bottom of the range */
+        t = ((uint32_t)(-bound)) % bound;
+        while (l < t) {
+            m = ((uint64_t)tinyjambu_prng_buffer_u32(buffer)) * bound;
+            l = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+/* Generates a uniform value between 0 and bound - 1 for large bounds */
+static size_t tinyjambu_prng_buffer_uniform_size
+    (tinyjambu_prng_buffer_t *buffer, size_t bound)
+{
+    uint64_t mask, value;
+    if (bound <= 0xFFFFFFFFUL)
+        return tinyjambu_prng_buffer_uniform(buffer, (uint32_t)bound);
+
+    /* Bitmask with rejection, which is fine for such rare bounds */
+    mask = ((uint64_t)bound) - 1;
+    mask |= mask >> 1;
+    mask |= mask >> 2;
+    mask |= mask >> 4;
+    mask |= mask >> 8;
+    mask |= mask >> 16;
+    mask |= mask >> 32;
+    do {
+        value = tinyjambu_prng_buffer_u64(buffer) & mask;
+    } while (value >= (uint64_t)bound);
+    return (size_t)value;
+}
+
+double tinyjambu_prng_buffer_double(tinyjambu_prng_buffer_t *buffer)
+{
+    /* Use the top 53 bits to fill the mantissa of the double */
+    return (double)(tinyjambu_prng_buffer_u64(buffer) >> 11) *
+           (1.0 / 9007199254740992.0);
+}
+
+void tinyjambu_prng_buffer_shuffle
+    (tinyjambu_prng_buffer_t *buffer, void *array, size_t count, size_t size)
+{
+    unsigned char *elems = (unsigned char *)array;
+    unsigned char *a, *b;
+    unsigned char temp;
+    size_t i, j, k;
+
+    /* Fisher-Yates shuffle, swapping elements byte by byte */
+    for (i = count; i > 1; --i) {
+        j = tinyjambu_prng_buffer_uniform_size(buffer, i);
+        if (j == (i - 1))
+            continue;
+        a = elems + j * size;
+        b = elems + (i - 1) * size;
+        for (k = 0; k < size; ++k) {
+            temp = a[k];
+            a[k] = b[k];
+            b[k] = temp;
+        }
+    }
+}
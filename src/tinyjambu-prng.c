@@ -21,7 +21,7 @@
  */
 
 #include "TinyJAMBU.h"
-#include "backend/tinyjambu-util.h"
+#include "backend/tinyjambu-aead-common.h"
 #include "random/tinyjambu-trng.h"
 #include <string.h>
 
@@ -40,6 +40,20 @@
  */
 #define TINYJAMBU_SEED_LENGTH 32
 
+/**
+ * \brief Maximum number of bytes to generate in bulk mode before the
+ * bulk key is ratcheted.
+ */
+#define TINYJAMBU_PRNG_BULK_CHUNK 4096
+
+/**
+ * \brief Maximum number of bytes to generate in a single Hashgen request.
+ *
+ * This is the max_number_of_bits_per_request value of 2^19 bits from
+ * table 2 of SP.800-90Ar1.
+ */
+#define TINYJAMBU_PRNG_MAX_REQUEST 65536UL
+
 /**
  * \brief Private state information for the TinyJAMBU-based PRNG.
  */
@@ -63,6 +77,24 @@ typedef struct
     /** User data pointer for the callback */
     void *user_data;
 
+    /** Key for generating output in bulk mode */
+    unsigned char bulk_key[TINYJAMBU_128_KEY_SIZE];
+
+    /** Non-zero if the bulk mode key has been derived from V */
+    int bulk_keyed;
+
+    /** Non-zero if automatic reseeding uses prefetched entropy only */
+    int async_reseed;
+
+    /** Non-zero if pending_V and pending_C are ready to be used */
+    int pending_ready;
+
+    /** Prefetched entropy to be mixed into V at the next reseed */
+    unsigned char pending_V[TINYJAMBU_SEED_LENGTH];
+
+    /** Prefetched entropy to be mixed into C at the next reseed */
+    unsigned char pending_C[TINYJAMBU_SEED_LENGTH];
+
 } tinyjambu_prng_state_p_t;
 
 /** @cond */
@@ -76,6 +108,19 @@ typedef int tinyjambu_prng_state_size_check
 
 /** @endcond */
 
+/* Access to the pending_ready flag, which may be shared between threads */
+#if defined(__GNUC__) && defined(__ATOMIC_ACQUIRE)
+#define tinyjambu_prng_load_ready(pstate) \
+    (__atomic_load_n(&((pstate)->pending_ready), __ATOMIC_ACQUIRE))
+#define tinyjambu_prng_store_ready(pstate, value) \
+    (__atomic_store_n(&((pstate)->pending_ready), (value), __ATOMIC_RELEASE))
+#else
+#define tinyjambu_prng_load_ready(pstate) \
+    (*((volatile int *)&((pstate)->pending_ready)))
+#define tinyjambu_prng_store_ready(pstate, value) \
+    (*((volatile int *)&((pstate)->pending_ready)) = (value))
+#endif
+
 /* Hash_df function from section 10.3.1 of SP.800-90Ar1 */
 static void tinyjambu_hash_df
     (unsigned char out[TINYJAMBU_SEED_LENGTH], unsigned char marker,
@@ -113,6 +158,38 @@ static void tinyjambu_hash_prefixed
     tinyjambu_hash_free(&hash);
 }
 
+/* Generates keystream from a TinyJAMBU-128 state.  The output is identical
+ * to the ciphertext from TinyJAMBU-128 AEAD when the plaintext is all-zero */
+static void tinyjambu_prng_keystream
+    (tinyjambu_128_state_t *state, unsigned char *data, size_t size)
+{
+    uint32_t word;
+    while (size >= 4) {
+        tinyjambu_add_domain(state, 0x50); /* Domain sep for message data */
+        tinyjambu_permutation_128(state, TINYJAMBU_ROUNDS(1024));
+        le_store_word32(data, tinyjambu_squeeze(state));
+        data += 4;
+        size -= 4;
+    }
+    if (size > 0) {
+        tinyjambu_add_domain(state, 0x50);
+        tinyjambu_permutation_128(state, TINYJAMBU_ROUNDS(1024));
+        word = tinyjambu_squeeze(state);
+        while (size > 0) {
+            *data++ = (unsigned char)word;
+            word >>= 8;
+            --size;
+        }
+    }
+}
+
+/* Discards the bulk mode key when the DRBG state has been reseeded */
+static void tinyjambu_prng_bulk_discard(tinyjambu_prng_state_p_t *pstate)
+{
+    tinyjambu_clean(pstate->bulk_key, sizeof(pstate->bulk_key));
+    pstate->bulk_keyed = 0;
+}
+
 /**
  * \brief Default random number source for the system.
  *
@@ -184,6 +261,57 @@ void tinyjambu_prng_free(tinyjambu_prng_state_t *state)
     tinyjambu_clean(state, sizeof(tinyjambu_prng_state_t));
 }
 
+/* Reseeds automatically when the reseed limit has been reached */
+static void tinyjambu_prng_auto_reseed(tinyjambu_prng_state_t *state)
+{
+    tinyjambu_prng_state_p_t *pstate = (tinyjambu_prng_state_p_t *)state;
+    int index;
+    if (!pstate->async_reseed) {
+        tinyjambu_prng_reseed(state);
+        return;
+    }
+
+    /* Asynchronous mode: never call the entropy callback here.  If there
+     * is no prefetched entropy yet, then keep going with the current
+     * state and try again on the next block */
+    if (!tinyjambu_prng_load_ready(pstate))
+        return;
+    for (index = 0; index < TINYJAMBU_SEED_LENGTH; ++index) {
+        pstate->V[index] ^= pstate->pending_V[index];
+        pstate->C[index] ^= pstate->pending_C[index];
+    }
+    tinyjambu_clean(pstate->pending_V, sizeof(pstate->pending_V));
+    tinyjambu_clean(pstate->pending_C, sizeof(pstate->pending_C));
+    tinyjambu_prng_store_ready(pstate, 0);
+    tinyjambu_prng_bulk_discard(pstate);
+    pstate->reseed_counter = 1;
+}
+
+/*
+ * Updates V at the end of a generate request:
+ *
+ *      H = Hash(0x03 || V)
+ *      V = V + H + C + reseed_counter
+ *      reseed_counter = reseed_counter + 1
+ */
+static void tinyjambu_prng_update(tinyjambu_prng_state_p_t *pstate)
+{
+    unsigned char H[TINYJAMBU_SEED_LENGTH];
+    uint32_t carry;
+    int index;
+    tinyjambu_hash_prefixed(H, 0x03, pstate->V);
+    carry = pstate->reseed_counter;
+    for (index = TINYJAMBU_SEED_LENGTH - 1; index >= 0; --index) {
+        carry += pstate->V[index];
+        carry += H[index];
+        carry += pstate->C[index];
+        pstate->V[index] = (unsigned char)carry;
+        carry >>= 8;
+    }
+    ++(pstate->reseed_counter);
+    tinyjambu_clean(H, sizeof(H));
+}
+
 /* Hash_DRBG_Generate from section 10.1.1.4 of SP.800-90Ar1 */
 void tinyjambu_prng_generate
     (tinyjambu_prng_state_t *state, unsigned char *data, size_t size)
@@ -191,8 +319,6 @@ void tinyjambu_prng_generate
     tinyjambu_prng_state_p_t *pstate = (tinyjambu_prng_state_p_t *)state;
     size_t len;
     unsigned char H[TINYJAMBU_SEED_LENGTH];
-    uint32_t carry;
-    int index;
 
     /* Bail out if nothing to do */
     if (!size)
@@ -205,7 +331,7 @@ void tinyjambu_prng_generate
     while (size > 0) {
         /* Reseed automatically if too much data has been generated already */
         if (pstate->reseed_counter > pstate->reseed_limit)
-            tinyjambu_prng_reseed(state);
+            tinyjambu_prng_auto_reseed(state);
 
         /* How many bytes do we need this time? */
         if (size < TINYJAMBU_SEED_LENGTH)
@@ -217,31 +343,167 @@ void tinyjambu_prng_generate
         tinyjambu_hash(H, pstate->V, sizeof(pstate->V));
         memcpy(data, H, len);
 
-        /*
-         * Update V for the next block:
-         *
-         *      H = Hash(0x03 || V)
-         *      V = V + H + C + reseed_counter
-         *      reseed_counter = reseed_counter + 1
-         */
-        tinyjambu_hash_prefixed(H, 0x03, pstate->V);
-        carry = pstate->reseed_counter;
+        /* Update V for the next block */
+        tinyjambu_prng_update(pstate);
+
+        /* Advance to the next block of output */
+        data += len;
+        size -= len;
+    }
+
+    /* Clean up */
+    tinyjambu_clean(H, sizeof(H));
+}
+
+/* Hashgen process from section 10.1.1.4 of SP.800-90Ar1 */
+static void tinyjambu_prng_hashgen
+    (const tinyjambu_prng_state_p_t *pstate, unsigned char *data, size_t size)
+{
+    unsigned char V[TINYJAMBU_SEED_LENGTH];
+    unsigned char H[TINYJAMBU_SEED_LENGTH];
+    tinyjambu_hash_state_t prefix;
+    tinyjambu_hash_state_t hash;
+    size_t len;
+    int index;
+
+    /* data = V */
+    memcpy(V, pstate->V, TINYJAMBU_SEED_LENGTH);
+
+    /* TinyJAMBU-Hash absorbs 16 bytes at a time and data is incremented
+     * in big-endian order.  The hash state after absorbing the first half
+     * of data only needs to be recomputed when the carry reaches it. */
+    tinyjambu_hash_init(&prefix);
+    tinyjambu_hash_update(&prefix, V, TINYJAMBU_SEED_LENGTH / 2);
+
+    for (;;) {
+        /* w = Hash(data) */
+        memcpy(&hash, &prefix, sizeof(hash));
+        tinyjambu_hash_update
+            (&hash, V + TINYJAMBU_SEED_LENGTH / 2, TINYJAMBU_SEED_LENGTH / 2);
+        tinyjambu_hash_finalize(&hash, H);
+
+        /* W = W || w */
+        if (size < TINYJAMBU_SEED_LENGTH)
+            len = size;
+        else
+            len = TINYJAMBU_SEED_LENGTH;
+        memcpy(data, H, len);
+        data += len;
+        size -= len;
+        if (!size)
+            break;
+
+        /* data = (data + 1) mod 2^seedlen */
         for (index = TINYJAMBU_SEED_LENGTH - 1; index >= 0; --index) {
-            carry += pstate->V[index];
-            carry += H[index];
-            carry += pstate->C[index];
-            pstate->V[index] = (unsigned char)carry;
-            carry >>= 8;
+            if (++(V[index]) != 0)
+                break;
+        }
+        if (index < TINYJAMBU_SEED_LENGTH / 2) {
+            tinyjambu_hash_init(&prefix);
+            tinyjambu_hash_update(&prefix, V, TINYJAMBU_SEED_LENGTH / 2);
+        }
+    }
+
+    /* Clean up */
+    tinyjambu_clean(V, sizeof(V));
+    tinyjambu_clean(H, sizeof(H));
+    tinyjambu_clean(&prefix, sizeof(prefix));
+    tinyjambu_clean(&hash, sizeof(hash));
+}
+
+/* Hash_DRBG_Generate from section 10.1.1.4 of SP.800-90Ar1, without the
+ * per-block deviation that is used by tinyjambu_prng_generate() */
+void tinyjambu_prng_generate_hashgen
+    (tinyjambu_prng_state_t *state, unsigned char *data, size_t size)
+{
+    tinyjambu_prng_state_p_t *pstate = (tinyjambu_prng_state_p_t *)state;
+    size_t len;
+
+    /* Bail out if nothing to do */
+    if (!size)
+        return;
+
+    /* Large requests are split into several requests of the maximum size */
+    while (size > 0) {
+        /* Reseed automatically if too many requests have been made.
+         * Each request counts as a single block for the reseed limit */
+        if (pstate->reseed_counter > pstate->reseed_limit)
+            tinyjambu_prng_auto_reseed(state);
+
+        /* How many bytes do we need this time? */
+        len = size;
+        if (len > TINYJAMBU_PRNG_MAX_REQUEST)
+            len = TINYJAMBU_PRNG_MAX_REQUEST;
+
+        /* Generate the output and then update V once for the request */
+        tinyjambu_prng_hashgen(pstate, data, len);
+        tinyjambu_prng_update(pstate);
+
+        /* Advance to the next request */
+        data += len;
+        size -= len;
+    }
+}
+
+/*
+ * Bulk mode uses "fast key erasure" on top of the DRBG.  A TinyJAMBU-128
+ * key is derived from the DRBG and then the keystream for an all-zero
+ * plaintext is generated in the same way as TinyJAMBU-128 AEAD with an
+ * all-zero nonce.  The first 16 bytes of keystream replace the key
+ * before any output is returned, and the rest of the keystream is the
+ * output.  Because the key is never used twice, a fixed nonce is fine.
+ */
+void tinyjambu_prng_generate_bulk
+    (tinyjambu_prng_state_t *state, unsigned char *data, size_t size)
+{
+    tinyjambu_prng_state_p_t *pstate = (tinyjambu_prng_state_p_t *)state;
+    static unsigned char const nonce[TINYJAMBU_NONCE_SIZE] = {0};
+    tinyjambu_128_state_t bulk;
+    size_t len;
+
+    /* Bail out if nothing to do */
+    if (!size)
+        return;
+
+    while (size > 0) {
+        /* Reseed automatically if too much data has been generated already.
+         * Each bulk chunk counts as a single block for the reseed limit */
+        if (pstate->reseed_counter > pstate->reseed_limit)
+            tinyjambu_prng_auto_reseed(state);
+
+        /* Derive a new bulk key from the DRBG if necessary */
+        if (!pstate->bulk_keyed) {
+            tinyjambu_prng_generate
+                (state, pstate->bulk_key, sizeof(pstate->bulk_key));
+            pstate->bulk_keyed = 1;
         }
+
+        /* How many bytes do we need this time? */
+        if (size < TINYJAMBU_PRNG_BULK_CHUNK)
+            len = size;
+        else
+            len = TINYJAMBU_PRNG_BULK_CHUNK;
+
+        /* Set up the TinyJAMBU state with the key and fixed nonce */
+        bulk.k[0] = tinyjambu_key_load_even(pstate->bulk_key);
+        bulk.k[1] = tinyjambu_key_load_odd(pstate->bulk_key + 4);
+        bulk.k[2] = tinyjambu_key_load_even(pstate->bulk_key + 8);
+        bulk.k[3] = tinyjambu_key_load_odd(pstate->bulk_key + 12);
+        tinyjambu_setup_128(&bulk, nonce, 0x10);
+
+        /* Ratchet the key and then generate the output */
+        tinyjambu_prng_keystream
+            (&bulk, pstate->bulk_key, sizeof(pstate->bulk_key));
+        tinyjambu_prng_keystream(&bulk, data, len);
         ++(pstate->reseed_counter);
 
-        /* Advance to the next block of output */
+        /* Advance to the next chunk of output */
         data += len;
         size -= len;
     }
 
     /* Clean up */
-    tinyjambu_clean(H, sizeof(H));
+    tinyjambu_clean(&bulk, sizeof(bulk));
 }
 
 /* Hash_DRBG_Reseed from section 10.1.1.3 of SP.800-90Ar1 for the special
@@ -257,6 +519,7 @@ void tinyjambu_prng_feed
 
     /* C = Hash_df((0x00 || V), seedlen) */
     tinyjambu_hash_df(pstate->C, 0x00, pstate->V, 0, 0);
+    tinyjambu_prng_bulk_discard(pstate);
 
     /* Note: SP.800-90Ar1 says that reseed_counter should be set back to 1
      * when reseeding, but we aren't really reseeding here.  So instead we
@@ -287,12 +550,50 @@ int tinyjambu_prng_reseed(tinyjambu_prng_state_t *state)
 
     /* C = Hash_df((0x00 || V), seedlen) */
     tinyjambu_hash_df(pstate->C, 0x00, pstate->V, 0, 0);
+    tinyjambu_prng_bulk_discard(pstate);
 
     /* reseed_counter = 1 */
     pstate->reseed_counter = 1;
     return reseeded;
 }
 
+void tinyjambu_prng_set_async_reseed
+    (tinyjambu_prng_state_t *state, int enable)
+{
+    tinyjambu_prng_state_p_t *pstate = (tinyjambu_prng_state_p_t *)state;
+    pstate->async_reseed = enable;
+}
+
+/*
+ * Prefetching collects entropy without touching V or C, so that it can
+ * run on a different thread to the one that is generating data.  The
+ * entropy is expanded into two values with Hash_df, which are XOR'ed
+ * into V and C at the next automatic reseed.  This is a departure from
+ * Hash_DRBG_Reseed, which hashes the old V along with the entropy.
+ */
+int tinyjambu_prng_prefetch(tinyjambu_prng_state_t *state)
+{
+    tinyjambu_prng_state_p_t *pstate = (tinyjambu_prng_state_p_t *)state;
+    unsigned char entropy[TINYJAMBU_SEED_LENGTH];
+    int fetched = 0;
+
+    /* Nothing to do if the previous prefetch has not been used yet */
+    if (tinyjambu_prng_load_ready(pstate))
+        return 1;
+
+    /* Get some new entropy from the system and expand it */
+    if ((*(pstate->callback))
+            (pstate->user_data, entropy, sizeof(entropy))
+                == sizeof(entropy)) {
+        tinyjambu_hash_df(pstate->pending_V, 0x02, entropy, 0, 0);
+        tinyjambu_hash_df(pstate->pending_C, 0x04, entropy, 0, 0);
+        tinyjambu_prng_store_ready(pstate, 1);
+        fetched = 1;
+    }
+    tinyjambu_clean(entropy, sizeof(entropy));
+    return fetched;
+}
+
 void tinyjambu_prng_set_reseed_limit
     (tinyjambu_prng_state_t *state, size_t limit)
 {
@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#if defined(HAVE_CONFIG_H)
+#include <config.h>
+#endif
+#include "TinyJAMBU.h"
+#include <string.h>
+
+/*
+ * The process-wide random number generator uses a separate PRNG state
+ * for every thread.  The state is created on first use and destroyed
+ * when the thread exits.  The hot path is lock-free because no state
+ * is shared between threads.
+ *
+ * After fork(), the child process would otherwise produce the same
+ * output as the parent.  A generation counter is incremented in the
+ * child by a pthread_atfork() handler, which forces the state of the
+ * calling thread to be re-created from the system random number source.
+ *
+ * If threads are not available, then a single global state is used
+ * and the functions are not thread-safe.
+ *
+ * If the system random number source fails when a state is created, then
+ * the state is still usable but is only as unpredictable as its address
+ * and the fork generation.  The state is reseeded on every call until the
+ * system random number source succeeds.
+ */
+
+#if defined(HAVE_PTHREAD) && defined(__GNUC__)
+#define TINYJAMBU_RANDOM_PTHREAD 1
+#include <pthread.h>
+#endif
+
+/**
+ * \brief Per-thread state for the process-wide random number generator.
+ */
+typedef struct
+{
+    /** PRNG state for this thread */
+    tinyjambu_prng_state_t prng;
+
+    /** Buffered front-end for small requests */
+    tinyjambu_prng_buffer_t buffer;
+
+    /** Fork generation that the PRNG state was created in */
+    unsigned long generation;
+
+    /** Non-zero if the PRNG state has been initialized */
+    int initialized;
+
+    /** Non-zero if the PRNG state has been seeded from the system */
+    int seeded;
+
+} tinyjambu_random_state_t;
+
+#if defined(TINYJAMBU_RANDOM_PTHREAD)
+
+/** Random number generator state for the current thread */
+static __thread tinyjambu_random_state_t tinyjambu_random_tls;
+
+/** Thread-specific key for destroying the state when the thread exits */
+static pthread_key_t tinyjambu_random_key;
+
+/** Guard for one-time global setup */
+static pthread_once_t tinyjambu_random_once = PTHREAD_ONCE_INIT;
+
+/** Fork generation, which is incremented in the child after a fork */
+static volatile unsigned long tinyjambu_random_generation = 1;
+
+static void tinyjambu_random_fork_child(void)
+{
+    /* Only the forking thread exists in the child, so no locking needed */
+    ++tinyjambu_random_generation;
+}
+
+static void tinyjambu_random_thread_exit(void *arg)
+{
+    tinyjambu_random_state_t *state = (tinyjambu_random_state_t *)arg;
+    tinyjambu_prng_buffer_free(&(state->buffer));
+    tinyjambu_prng_free(&(state->prng));
+    state->initialized = 0;
+}
+
+static void tinyjambu_random_setup(void)
+{
+    pthread_key_create(&tinyjambu_random_key, tinyjambu_random_thread_exit);
+    pthread_atfork(0, 0, tinyjambu_random_fork_child);
+}
+
+#define tinyjambu_random_current() (&tinyjambu_random_tls)
+#define tinyjambu_random_current_generation() (tinyjambu_random_generation)
+
+#else /* !TINYJAMBU_RANDOM_PTHREAD */
+
+/** Global random number generator state */
+static tinyjambu_random_state_t tinyjambu_random_global;
+
+#define tinyjambu_random_current() (&tinyjambu_random_global)
+#define tinyjambu_random_current_generation() 1UL
+
+#endif /* !TINYJAMBU_RANDOM_PTHREAD */
+
+/* Gets the random number generator state, creating it if necessary */
+static tinyjambu_random_state_t *tinyjambu_random_get(void)
+{
+    tinyjambu_random_state_t *state = tinyjambu_random_current();
+    unsigned long generation = tinyjambu_random_current_generation();
+    unsigned char custom[sizeof(void *) + sizeof(unsigned long)];
+    void *ptr;
+    if (!state->initialized || state->generation != generation) {
+#if defined(TINYJAMBU_RANDOM_PTHREAD)
+        pthread_once(&tinyjambu_random_once, tinyjambu_random_setup);
+        if (!state->initialized)
+            pthread_setspecific(tinyjambu_random_key, state);
+#endif
+
+        /* Make the state unique even if the system random number source
+         * is broken by customizing with the address and generation */
+        ptr = (void *)state;
+        memcpy(custom, &ptr, sizeof(void *));
+        memcpy(custom + sizeof(void *), &generation, sizeof(unsigned long));
+        state->seeded =
+            tinyjambu_prng_init(&(state->prng), custom, sizeof(custom));
+        tinyjambu_prng_buffer_init(&(state->buffer), &(state->prng));
+        state->generation = generation;
+        state->initialized = 1;
+    } else if (!state->seeded) {
+        /* The system random number source failed when the state was
+         * created.  Keep trying to reseed on every call, and throw away
+         * any buffered output from before once the reseed succeeds */
+        state->seeded = tinyjambu_prng_reseed(&(state->prng));
+        if (state->seeded) {
+            tinyjambu_prng_buffer_free(&(state->buffer));
+            tinyjambu_prng_buffer_init(&(state->buffer), &(state->prng));
+        }
+    }
+    return state;
+}
+
+void tinyjambu_random_bytes(unsigned char *data, size_t size)
+{
+    tinyjambu_random_state_t *state = tinyjambu_random_get();
+    tinyjambu_prng_buffer_bytes(&(state->buffer), data, size);
+}
+
+uint32_t tinyjambu_random_u32(void)
+{
+    tinyjambu_random_state_t *state = tinyjambu_random_get();
+    return tinyjambu_prng_buffer_u32(&(state->buffer));
+}
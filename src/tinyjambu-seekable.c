@@ -0,0 +1,502 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TinyJAMBU.h"
+#include "backend/tinyjambu-util.h"
+#include <string.h>
+
+/*
+ * The seekable container is an array of independently encrypted blocks
+ * that follow a fixed-size header.  Every record except the last has the
+ * same size, so the block index is implicit: the offset of a record is
+ * computed directly from its index rather than being stored in a table.
+ *
+ * The nonce for block i is [i]_32 || file_id.  This puts the block index
+ * in the position that TinyJAMBU-SIV reserves for a sequence number or
+ * memory address, which is what allows SIV containers to be updated in
+ * place one block at a time.  The header is the associated data for
+ * every block, which binds the block size and total length to each tag
+ * so that the container cannot be truncated or have its blocks resized.
+ *
+ * With AEAD mode, sealing new data for a block that has already been
+ * written would encrypt it under the same nonce, so in-place rewrites
+ * are only permitted for SIV containers.  tinyjambu_seekable_rewrite_block()
+ * refuses AEAD containers; updating one means writing a new container
+ * with a new file identifier.
+ */
+
+/**
+ * \brief Maximum number of blocks in a container.
+ */
+#define TINYJAMBU_SEEKABLE_MAX_BLOCKS 0x100000000ULL
+
+/**
+ * \brief Prototype for a combined encryption function.
+ */
+typedef void (*tinyjambu_seekable_encrypt_t)
+    (unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k);
+
+/**
+ * \brief Prototype for a combined decryption function.
+ */
+typedef int (*tinyjambu_seekable_decrypt_t)
+    (unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k);
+
+/**
+ * \brief Information about a block that is held in the cache.
+ *
+ * The decrypted block and its tag follow immediately after this
+ * structure in the cache memory.
+ */
+typedef struct
+{
+    /** Index of the cached block */
+    uint64_t block;
+
+    /** Value of the use counter when the block was last accessed */
+    uint64_t last_used;
+
+    /** Non-zero if the slot contains a verified block */
+    int valid;
+
+} tinyjambu_seekable_slot_t;
+
+/**
+ * \brief Private state for a seekable reader.
+ */
+typedef struct
+{
+    /** Copy of the key */
+    unsigned char key[TINYJAMBU_256_KEY_SIZE];
+
+    /** Copy of the header, which is the associated data for each block */
+    unsigned char header[TINYJAMBU_SEEKABLE_HEADER_SIZE];
+
+    /** Decryption function for the key size and mode */
+    tinyjambu_seekable_decrypt_t decrypt;
+
+    /** Callback for reading bytes from the container */
+    tinyjambu_seekable_read_t read;
+
+    /** Context pointer for the read callback */
+    void *ctx;
+
+    /** Points to the first slot in the cache */
+    unsigned char *cache;
+
+    /** Number of slots in the cache */
+    size_t num_slots;
+
+    /** Size of each slot in the cache, including the slot information */
+    size_t slot_size;
+
+    /** Size of the plaintext in each block */
+    size_t block_size;
+
+    /** Total length of the plaintext */
+    uint64_t length;
+
+    /** Number of blocks in the container */
+    uint64_t num_blocks;
+
+    /** Counter that is incremented each time a block is accessed */
+    uint64_t use_counter;
+
+    /** Number of block lookups that hit the cache */
+    uint64_t hits;
+
+    /** Number of block lookups that missed the cache */
+    uint64_t misses;
+
+} tinyjambu_seekable_reader_p_t;
+
+/** @cond */
+
+/* Compile-time check that tinyjambu_seekable_reader_p_t can fit within
+ * the bounds of tinyjambu_seekable_reader_t.  This line of code will fail
+ * to compile if the private structure is too large for the public one. */
+typedef int tinyjambu_seekable_reader_size_check
+    [(sizeof(tinyjambu_seekable_reader_p_t) <=
+            sizeof(tinyjambu_seekable_reader_t)) * 2 - 1];
+
+/** @endcond */
+
+/* Selects the encryption function for a key length and mode */
+static tinyjambu_seekable_encrypt_t tinyjambu_seekable_get_encrypt
+    (size_t keylen, int mode)
+{
+    if (mode == TINYJAMBU_SEEKABLE_SIV) {
+        switch (keylen) {
+        case TINYJAMBU_128_KEY_SIZE: return tinyjambu_128_siv_encrypt;
+        case TINYJAMBU_192_KEY_SIZE: return tinyjambu_192_siv_encrypt;
+        case TINYJAMBU_256_KEY_SIZE: return tinyjambu_256_siv_encrypt;
+        default:                     break;
+        }
+    } else if (mode == TINYJAMBU_SEEKABLE_AEAD) {
+        switch (keylen) {
+        case TINYJAMBU_128_KEY_SIZE: return tinyjambu_128_aead_encrypt;
+        case TINYJAMBU_192_KEY_SIZE: return tinyjambu_192_aead_encrypt;
+        case TINYJAMBU_256_KEY_SIZE: return tinyjambu_256_aead_encrypt;
+        default:                     break;
+        }
+    }
+    return 0;
+}
+
+/* Selects the decryption function for a key length and mode */
+static tinyjambu_seekable_decrypt_t tinyjambu_seekable_get_decrypt
+    (size_t keylen, int mode)
+{
+    if (mode == TINYJAMBU_SEEKABLE_SIV) {
+        switch (keylen) {
+        case TINYJAMBU_128_KEY_SIZE: return tinyjambu_128_siv_decrypt;
+        case TINYJAMBU_192_KEY_SIZE: return tinyjambu_192_siv_decrypt;
+        case TINYJAMBU_256_KEY_SIZE: return tinyjambu_256_siv_decrypt;
+        default:                     break;
+        }
+    } else if (mode == TINYJAMBU_SEEKABLE_AEAD) {
+        switch (keylen) {
+        case TINYJAMBU_128_KEY_SIZE: return tinyjambu_128_aead_decrypt;
+        case TINYJAMBU_192_KEY_SIZE: return tinyjambu_192_aead_decrypt;
+        case TINYJAMBU_256_KEY_SIZE: return tinyjambu_256_aead_decrypt;
+        default:                     break;
+        }
+    }
+    return 0;
+}
+
+/* Gets the number of blocks for a plaintext length.  The block size
+ * must be non-zero.  This cannot overflow, even if the length is close
+ * to 2^64 */
+static uint64_t tinyjambu_seekable_num_blocks
+    (uint64_t length, size_t block_size)
+{
+    return length / block_size + ((length % block_size) != 0);
+}
+
+/* Parses and validates a header, returning the block size or zero */
+static size_t tinyjambu_seekable_parse_header(const unsigned char *header)
+{
+    size_t block_size;
+    if (memcmp(header, "TJSK", 4) != 0 ||
+            header[4] != TINYJAMBU_SEEKABLE_VERSION ||
+            header[7] != 0 || header[28] != 0 || header[29] != 0 ||
+            header[30] != 0 || header[31] != 0) {
+        return 0;
+    }
+    if (!tinyjambu_seekable_get_decrypt(header[5], header[6]))
+        return 0;
+    block_size = le_load_word32(header + 8);
+    if (!block_size)
+        return 0;
+    if (tinyjambu_seekable_num_blocks(le_load_word64(header + 12), block_size)
+            > TINYJAMBU_SEEKABLE_MAX_BLOCKS) {
+        return 0;
+    }
+    return block_size;
+}
+
+/* Formats the nonce for a block */
+static void tinyjambu_seekable_nonce
+    (unsigned char nonce[TINYJAMBU_NONCE_SIZE], const unsigned char *header,
+     uint64_t index)
+{
+    le_store_word32(nonce, (uint32_t)index);
+    memcpy(nonce + 4, header + 20, TINYJAMBU_SEEKABLE_FILE_ID_SIZE);
+}
+
+uint64_t tinyjambu_seekable_size(uint64_t length, size_t block_size)
+{
+    uint64_t num_blocks;
+    if (!block_size)
+        return 0;
+    num_blocks = tinyjambu_seekable_num_blocks(length, block_size);
+    return TINYJAMBU_SEEKABLE_HEADER_SIZE + length +
+           num_blocks * TINYJAMBU_TAG_SIZE;
+}
+
+int tinyjambu_seekable_init_header
+    (unsigned char *header, int mode, size_t keylen, size_t block_size,
+     uint64_t length, const unsigned char *file_id)
+{
+    if (!tinyjambu_seekable_get_encrypt(keylen, mode) || !block_size ||
+            block_size > 0xFFFFFFFFU ||
+            tinyjambu_seekable_num_blocks(length, block_size) >
+                TINYJAMBU_SEEKABLE_MAX_BLOCKS) {
+        return -1;
+    }
+    memcpy(header, "TJSK", 4);
+    header[4] = TINYJAMBU_SEEKABLE_VERSION;
+    header[5] = (unsigned char)keylen;
+    header[6] = (unsigned char)mode;
+    header[7] = 0;
+    le_store_word32(header + 8, (uint32_t)block_size);
+    le_store_word64(header + 12, length);
+    memcpy(header + 20, file_id, TINYJAMBU_SEEKABLE_FILE_ID_SIZE);
+    memset(header + 28, 0, 4);
+    return 0;
+}
+
+/* Encrypts a block, optionally rejecting containers in AEAD mode */
+static int tinyjambu_seekable_encrypt_block
+    (unsigned char *record, size_t *reclen, const unsigned char *header,
+     uint64_t index, const unsigned char *data, const unsigned char *k,
+     int siv_only)
+{
+    unsigned char nonce[TINYJAMBU_NONCE_SIZE];
+    tinyjambu_seekable_encrypt_t encrypt;
+    size_t block_size, len;
+    uint64_t length;
+
+    /* Validate the header and the block index */
+    *reclen = 0;
+    block_size = tinyjambu_seekable_parse_header(header);
+    if (!block_size ||
+            (siv_only && header[6] != TINYJAMBU_SEEKABLE_SIV))
+        return -1;
+    length = le_load_word64(header + 12);
+    if (index >= tinyjambu_seekable_num_blocks(length, block_size))
+        return -1;
+    encrypt = tinyjambu_seekable_get_encrypt(header[5], header[6]);
+
+    /* Every block is full except possibly the last */
+    len = block_size;
+    if ((index * block_size + len) > length)
+        len = (size_t)(length - index * block_size);
+
+    /* Encrypt the block */
+    tinyjambu_seekable_nonce(nonce, header, index);
+    (*encrypt)(record, reclen, data, len,
+               header, TINYJAMBU_SEEKABLE_HEADER_SIZE, nonce, k);
+    return 0;
+}
+
+int tinyjambu_seekable_seal_block
+    (unsigned char *record, size_t *reclen, const unsigned char *header,
+     uint64_t index, const unsigned char *data, const unsigned char *k)
+{
+    return tinyjambu_seekable_encrypt_block
+        (record, reclen, header, index, data, k, 0);
+}
+
+int tinyjambu_seekable_rewrite_block
+    (unsigned char *record, size_t *reclen, const unsigned char *header,
+     uint64_t index, const unsigned char *data, const unsigned char *k)
+{
+    return tinyjambu_seekable_encrypt_block
+        (record, reclen, header, index, data, k, 1);
+}
+
+uint64_t tinyjambu_seekable_block_offset
+    (const unsigned char *header, uint64_t index)
+{
+    uint64_t block_size = le_load_word32(header + 8);
+    return TINYJAMBU_SEEKABLE_HEADER_SIZE +
+           index * (block_size + TINYJAMBU_TAG_SIZE);
+}
+
+int tinyjambu_seekable_open
+    (tinyjambu_seekable_reader_t *reader,
+     tinyjambu_seekable_read_t read, void *ctx,
+     const unsigned char *k, size_t keylen,
+     void *cache, size_t cache_size)
+{
+    tinyjambu_seekable_reader_p_t *r =
+        (tinyjambu_seekable_reader_p_t *)reader;
+    size_t align, index;
+
+    /* Read and validate the header */
+    memset(r, 0, sizeof(tinyjambu_seekable_reader_p_t));
+    if (keylen > sizeof(r->key) ||
+            (*read)(ctx, r->header, TINYJAMBU_SEEKABLE_HEADER_SIZE, 0) != 0) {
+        tinyjambu_clean(r, sizeof(tinyjambu_seekable_reader_p_t));
+        return -1;
+    }
+    r->block_size = tinyjambu_seekable_parse_header(r->header);
+    if (!(r->block_size) || r->header[5] != keylen) {
+        tinyjambu_clean(r, sizeof(tinyjambu_seekable_reader_p_t));
+        return -1;
+    }
+    r->decrypt = tinyjambu_seekable_get_decrypt(keylen, r->header[6]);
+    r->length = le_load_word64(r->header + 12);
+    r->num_blocks =
+        tinyjambu_seekable_num_blocks(r->length, r->block_size);
+
+    /* Carve the cache memory up into slots, each of which is aligned
+     * so that the slot information can be accessed directly */
+    align = (size_t)(((uintptr_t)cache) % sizeof(uint64_t));
+    if (align) {
+        align = sizeof(uint64_t) - align;
+        cache_size = (cache_size > align) ? (cache_size - align) : 0;
+    }
+    r->cache = ((unsigned char *)cache) + align;
+    r->slot_size = sizeof(tinyjambu_seekable_slot_t) +
+                   r->block_size + TINYJAMBU_TAG_SIZE;
+    r->slot_size = (r->slot_size + sizeof(uint64_t) - 1) &
+                   ~(sizeof(uint64_t) - 1);
+    r->num_slots = cache_size / r->slot_size;
+    if (!(r->num_slots)) {
+        tinyjambu_clean(r, sizeof(tinyjambu_seekable_reader_p_t));
+        return -1;
+    }
+    for (index = 0; index < r->num_slots; ++index) {
+        ((tinyjambu_seekable_slot_t *)(r->cache + index * r->slot_size))
+            ->valid = 0;
+    }
+
+    /* Finish setting up the reader */
+    memcpy(r->key, k, keylen);
+    r->read = read;
+    r->ctx = ctx;
+    return 0;
+}
+
+/* Finds a block in the cache, reading and decrypting it on a miss.
+ * Returns NULL if the block could not be read or failed to authenticate */
+static tinyjambu_seekable_slot_t *tinyjambu_seekable_fetch
+    (tinyjambu_seekable_reader_p_t *r, uint64_t block, size_t *len)
+{
+    unsigned char nonce[TINYJAMBU_NONCE_SIZE];
+    tinyjambu_seekable_slot_t *slot;
+    tinyjambu_seekable_slot_t *victim = 0;
+    unsigned char *data;
+    size_t index, mlen;
+
+    /* Determine the size of the block's plaintext */
+    *len = r->block_size;
+    if ((block * r->block_size + *len) > r->length)
+        *len = (size_t)(r->length - block * r->block_size);
+
+    /* Look for the block in the cache, and remember the least
+     * recently used slot in case we need to replace it */
+    for (index = 0; index < r->num_slots; ++index) {
+        slot = (tinyjambu_seekable_slot_t *)
+            (r->cache + index * r->slot_size);
+        if (!(slot->valid)) {
+            if (!victim || victim->valid)
+                victim = slot;
+        } else if (slot->block == block) {
+            slot->last_used = ++(r->use_counter);
+            ++(r->hits);
+            return slot;
+        } else if (!victim ||
+                   (victim->valid && slot->last_used < victim->last_used)) {
+            victim = slot;
+        }
+    }
+
+    /* Read the record into the victim slot and decrypt it in-place */
+    ++(r->misses);
+    victim->valid = 0;
+    data = ((unsigned char *)victim) + sizeof(tinyjambu_seekable_slot_t);
+    if ((*(r->read))(r->ctx, data, *len + TINYJAMBU_TAG_SIZE,
+                     tinyjambu_seekable_block_offset(r->header, block))
+            != 0) {
+        tinyjambu_clean(data, *len + TINYJAMBU_TAG_SIZE);
+        return 0;
+    }
+    tinyjambu_seekable_nonce(nonce, r->header, block);
+    if ((*(r->decrypt))(data, &mlen, data, *len + TINYJAMBU_TAG_SIZE,
+                        r->header, TINYJAMBU_SEEKABLE_HEADER_SIZE,
+                        nonce, r->key) != 0) {
+        tinyjambu_clean(data, *len + TINYJAMBU_TAG_SIZE);
+        return 0;
+    }
+    victim->block = block;
+    victim->last_used = ++(r->use_counter);
+    victim->valid = 1;
+    return victim;
+}
+
+int tinyjambu_seekable_pread
+    (tinyjambu_seekable_reader_t *reader, unsigned char *buf, size_t len,
+     uint64_t offset, size_t *nread)
+{
+    tinyjambu_seekable_reader_p_t *r =
+        (tinyjambu_seekable_reader_p_t *)reader;
+    tinyjambu_seekable_slot_t *slot;
+    size_t posn, blen, temp;
+    size_t request = len;
+    size_t done = 0;
+    uint64_t block;
+
+    /* Clamp the range to the end of the plaintext */
+    *nread = 0;
+    if (offset >= r->length)
+        return 0;
+    if (len > (r->length - offset))
+        len = (size_t)(r->length - offset);
+
+    /* Copy the plaintext out of each block that overlaps the range */
+    block = offset / r->block_size;
+    posn = (size_t)(offset % r->block_size);
+    while (done < len) {
+        slot = tinyjambu_seekable_fetch(r, block, &blen);
+        if (!slot) {
+            memset(buf, 0, request);
+            return -1;
+        }
+        temp = blen - posn;
+        if (temp > (len - done))
+            temp = len - done;
+        memcpy(buf + done,
+               ((unsigned char *)slot) + sizeof(tinyjambu_seekable_slot_t) +
+                   posn, temp);
+        done += temp;
+        posn = 0;
+        ++block;
+    }
+    *nread = len;
+    return 0;
+}
+
+uint64_t tinyjambu_seekable_length(const tinyjambu_seekable_reader_t *reader)
+{
+    return ((const tinyjambu_seekable_reader_p_t *)reader)->length;
+}
+
+void tinyjambu_seekable_cache_stats
+    (const tinyjambu_seekable_reader_t *reader,
+     uint64_t *hits, uint64_t *misses)
+{
+    const tinyjambu_seekable_reader_p_t *r =
+        (const tinyjambu_seekable_reader_p_t *)reader;
+    *hits = r->hits;
+    *misses = r->misses;
+}
+
+void tinyjambu_seekable_close(tinyjambu_seekable_reader_t *reader)
+{
+    tinyjambu_seekable_reader_p_t *r =
+        (tinyjambu_seekable_reader_p_t *)reader;
+    if (r->cache)
+        tinyjambu_clean(r->cache, r->num_slots * r->slot_size);
+    tinyjambu_clean(r, sizeof(tinyjambu_seekable_reader_p_t));
+}
@@ -0,0 +1,363 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TinyJAMBU.h"
+#include "backend/tinyjambu-aead-common.h"
+#include <string.h>
+
+/*
+ * A TinyJAMBU session keeps one permutation state for each direction
+ * of a conversation and carries it over from one message to the next:
+ *
+ *      S = Pn(K, 0)
+ *      for i = 0..2: S[1] ^= D; S = P640(K, S); S[3] ^= N[i]
+ *
+ *      for each message (A, M):
+ *          for each word A[j]: S[1] ^= 0x30; S = P640(K, S); S[3] ^= A[j]
+ *          for each word M[j]: S[1] ^= 0x50; S = Pn(K, S);
+ *                              C[j] = M[j] ^ S[2]; S[3] ^= M[j]
+ *          T = FinalizeTag(K, S)
+ *
+ * Pn is the longer permutation from the AEAD mode, with 1024 steps for
+ * TinyJAMBU-128, 1152 steps for TinyJAMBU-192, and 1280 steps for
+ * TinyJAMBU-256.  D is 0xA0 for messages from the initiator to the
+ * responder and 0xE0 for messages in the other direction.  Neither value
+ * is used by the AEAD, SIV, or MAC modes, so the first message of a
+ * session can never be confused with a one-shot AEAD packet, and the two
+ * directions never share a keystream.  Partial words of A and M are
+ * handled in the same way as the AEAD mode, and FinalizeTag is the AEAD
+ * tag generation step, which leaves S in a state that depends upon every
+ * byte so far.
+ *
+ * Because the tag step always runs between two messages, it forms the
+ * boundary between them: moving bytes across a message boundary, or
+ * dropping, replaying, or reordering messages, changes every later tag.
+ */
+
+/**
+ * \brief Nonce domain separator for messages sent by the initiator.
+ */
+#define TINYJAMBU_SESSION_INITIATOR_DOMAIN 0xA0
+
+/**
+ * \brief Nonce domain separator for messages sent by the responder.
+ */
+#define TINYJAMBU_SESSION_RESPONDER_DOMAIN 0xE0
+
+/**
+ * \brief Permutation state for any of the TinyJAMBU variants.
+ */
+typedef union
+{
+    tinyjambu_128_state_t s128;     /**< TinyJAMBU-128 state */
+    tinyjambu_192_state_t s192;     /**< TinyJAMBU-192 state */
+    tinyjambu_256_state_t s256;     /**< TinyJAMBU-256 state */
+
+} tinyjambu_session_perm_t;
+
+/**
+ * \brief Private state information for a TinyJAMBU session.
+ */
+typedef struct
+{
+    /** Permutation state for messages that we send */
+    tinyjambu_session_perm_t send;
+
+    /** Permutation state for messages that we receive */
+    tinyjambu_session_perm_t recv;
+
+    /** Size of the key in bytes */
+    unsigned key_size;
+
+} tinyjambu_session_p_t;
+
+/** @cond */
+
+/* Compile-time check that the private structure can fit within the
+ * bounds of the public one.  This line of code will fail to compile
+ * if the private structure is too large for the public one. */
+typedef int tinyjambu_session_size_check
+    [(sizeof(tinyjambu_session_p_t) <= sizeof(tinyjambu_session_t)) * 2 - 1];
+
+/** @endcond */
+
+/* Runs the permutation for the variant with a specific key size */
+static void tinyjambu_session_permute
+    (tinyjambu_session_perm_t *state, unsigned key_size, unsigned rounds)
+{
+    if (key_size == TINYJAMBU_128_KEY_SIZE)
+        tinyjambu_permutation_128(&(state->s128), rounds);
+    else if (key_size == TINYJAMBU_192_KEY_SIZE)
+        tinyjambu_permutation_192(&(state->s192), rounds);
+    else
+        tinyjambu_permutation_256(&(state->s256), rounds);
+}
+
+/* Runs the longer permutation for the key setup and message words */
+static void tinyjambu_session_permute_long
+    (tinyjambu_session_perm_t *state, unsigned key_size)
+{
+    if (key_size == TINYJAMBU_128_KEY_SIZE)
+        tinyjambu_permutation_128(&(state->s128), TINYJAMBU_ROUNDS(1024));
+    else if (key_size == TINYJAMBU_192_KEY_SIZE)
+        tinyjambu_permutation_192(&(state->s192), TINYJAMBU_ROUNDS(1152));
+    else
+        tinyjambu_permutation_256(&(state->s256), TINYJAMBU_ROUNDS(1280));
+}
+
+/* Absorbs the nonce into the permutation state for one direction */
+static void tinyjambu_session_absorb_nonce
+    (tinyjambu_session_perm_t *state, unsigned key_size,
+     const unsigned char *nonce, unsigned char domain)
+{
+    unsigned index;
+    for (index = 0; index < TINYJAMBU_NONCE_SIZE; index += 4) {
+        tinyjambu_add_domain(&(state->s128), domain);
+        tinyjambu_session_permute(state, key_size, TINYJAMBU_ROUNDS(640));
+        tinyjambu_absorb(&(state->s128), le_load_word32(nonce + index));
+    }
+}
+
+/* Absorbs associated data into the permutation state */
+static void tinyjambu_session_absorb
+    (tinyjambu_session_perm_t *state, unsigned key_size,
+     const unsigned char *data, size_t size)
+{
+    if (key_size == TINYJAMBU_128_KEY_SIZE) {
+        tinyjambu_absorb_128(&(state->s128), data, size,
+                             0x30, TINYJAMBU_ROUNDS(640));
+    } else if (key_size == TINYJAMBU_192_KEY_SIZE) {
+        tinyjambu_absorb_192(&(state->s192), data, size,
+                             0x30, TINYJAMBU_ROUNDS(640));
+    } else {
+        tinyjambu_absorb_256(&(state->s256), data, size,
+                             0x30, TINYJAMBU_ROUNDS(640));
+    }
+}
+
+/* Generates the authentication tag for the current message */
+static void tinyjambu_session_generate_tag
+    (tinyjambu_session_perm_t *state, unsigned key_size, unsigned char *tag)
+{
+    if (key_size == TINYJAMBU_128_KEY_SIZE)
+        tinyjambu_generate_tag_128(&(state->s128), tag);
+    else if (key_size == TINYJAMBU_192_KEY_SIZE)
+        tinyjambu_generate_tag_192(&(state->s192), tag);
+    else
+        tinyjambu_generate_tag_256(&(state->s256), tag);
+}
+
+/* Finishes setting up a session after the key words have been loaded */
+static void tinyjambu_session_init
+    (tinyjambu_session_p_t *psession, unsigned key_size,
+     const unsigned char *npub, int role)
+{
+    /* Key setup: S = Pn(K, 0), shared by both directions */
+    psession->key_size = key_size;
+    tinyjambu_init_state(&(psession->send.s128));
+    tinyjambu_session_permute_long(&(psession->send), key_size);
+    memcpy(&(psession->recv), &(psession->send), sizeof(psession->recv));
+
+    /* Absorb the nonce separately for each direction */
+    if (role == TINYJAMBU_SESSION_INITIATOR) {
+        tinyjambu_session_absorb_nonce
+            (&(psession->send), key_size, npub,
+             TINYJAMBU_SESSION_INITIATOR_DOMAIN);
+        tinyjambu_session_absorb_nonce
+            (&(psession->recv), key_size, npub,
+             TINYJAMBU_SESSION_RESPONDER_DOMAIN);
+    } else {
+        tinyjambu_session_absorb_nonce
+            (&(psession->send), key_size, npub,
+             TINYJAMBU_SESSION_RESPONDER_DOMAIN);
+        tinyjambu_session_absorb_nonce
+            (&(psession->recv), key_size, npub,
+             TINYJAMBU_SESSION_INITIATOR_DOMAIN);
+    }
+}
+
+void tinyjambu_128_session_init
+    (tinyjambu_session_t *session, const unsigned char *k,
+     const unsigned char *npub, int role)
+{
+    tinyjambu_session_p_t *psession = (tinyjambu_session_p_t *)session;
+    memset(session, 0, sizeof(tinyjambu_session_t));
+    psession->send.s128.k[0] = tinyjambu_key_load_even(k);
+    psession->send.s128.k[1] = tinyjambu_key_load_odd(k + 4);
+    psession->send.s128.k[2] = tinyjambu_key_load_even(k + 8);
+    psession->send.s128.k[3] = tinyjambu_key_load_odd(k + 12);
+    tinyjambu_session_init(psession, TINYJAMBU_128_KEY_SIZE, npub, role);
+}
+
+void tinyjambu_192_session_init
+    (tinyjambu_session_t *session, const unsigned char *k,
+     const unsigned char *npub, int role)
+{
+    tinyjambu_session_p_t *psession = (tinyjambu_session_p_t *)session;
+    memset(session, 0, sizeof(tinyjambu_session_t));
+    psession->send.s192.k[0] = tinyjambu_key_load_even(k);
+    psession->send.s192.k[1] = tinyjambu_key_load_odd(k + 4);
+    psession->send.s192.k[2] = tinyjambu_key_load_even(k + 8);
+    psession->send.s192.k[3] = tinyjambu_key_load_odd(k + 12);
+    psession->send.s192.k[4] = tinyjambu_key_load_even(k + 16);
+    psession->send.s192.k[5] = tinyjambu_key_load_odd(k + 20);
+    tinyjambu_session_init(psession, TINYJAMBU_192_KEY_SIZE, npub, role);
+}
+
+void tinyjambu_256_session_init
+    (tinyjambu_session_t *session, const unsigned char *k,
+     const unsigned char *npub, int role)
+{
+    tinyjambu_session_p_t *psession = (tinyjambu_session_p_t *)session;
+    memset(session, 0, sizeof(tinyjambu_session_t));
+    psession->send.s256.k[0] = tinyjambu_key_load_even(k);
+    psession->send.s256.k[1] = tinyjambu_key_load_odd(k + 4);
+    psession->send.s256.k[2] = tinyjambu_key_load_even(k + 8);
+    psession->send.s256.k[3] = tinyjambu_key_load_odd(k + 12);
+    psession->send.s256.k[4] = tinyjambu_key_load_even(k + 16);
+    psession->send.s256.k[5] = tinyjambu_key_load_odd(k + 20);
+    psession->send.s256.k[6] = tinyjambu_key_load_even(k + 24);
+    psession->send.s256.k[7] = tinyjambu_key_load_odd(k + 28);
+    tinyjambu_session_init(psession, TINYJAMBU_256_KEY_SIZE, npub, role);
+}
+
+void tinyjambu_session_encrypt
+    (tinyjambu_session_t *session, unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen)
+{
+    tinyjambu_session_p_t *psession = (tinyjambu_session_p_t *)session;
+    tinyjambu_session_perm_t *state = &(psession->send);
+    unsigned key_size = psession->key_size;
+    uint32_t data;
+
+    /* Absorb the associated data for this message */
+    *clen = mlen + TINYJAMBU_TAG_SIZE;
+    tinyjambu_session_absorb(state, key_size, ad, adlen);
+
+    /* Encrypt the plaintext to produce the ciphertext */
+    while (mlen >= 4) {
+        tinyjambu_add_domain(&(state->s128), 0x50);
+        tinyjambu_session_permute_long(state, key_size);
+        data = le_load_word32(m);
+        tinyjambu_absorb(&(state->s128), data);
+        data ^= tinyjambu_squeeze(&(state->s128));
+        le_store_word32(c, data);
+        c += 4;
+        m += 4;
+        mlen -= 4;
+    }
+    if (mlen > 0) {
+        tinyjambu_add_domain(&(state->s128), 0x50);
+        tinyjambu_session_permute_long(state, key_size);
+        if (mlen == 1)
+            data = m[0];
+        else if (mlen == 2)
+            data = le_load_word16(m);
+        else
+            data = le_load_word16(m) | (((uint32_t)(m[2])) << 16);
+        tinyjambu_absorb(&(state->s128), data);
+        tinyjambu_add_domain(&(state->s128), (unsigned char)mlen);
+        data ^= tinyjambu_squeeze(&(state->s128));
+        c[0] = (uint8_t)data;
+        if (mlen > 1)
+            c[1] = (uint8_t)(data >> 8);
+        if (mlen > 2)
+            c[2] = (uint8_t)(data >> 16);
+        c += mlen;
+    }
+
+    /* Generate the tag, which also separates this message from the next */
+    tinyjambu_session_generate_tag(state, key_size, c);
+}
+
+int tinyjambu_session_decrypt
+    (tinyjambu_session_t *session, unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen,
+     const unsigned char *ad, size_t adlen)
+{
+    tinyjambu_session_p_t *psession = (tinyjambu_session_p_t *)session;
+    unsigned key_size = psession->key_size;
+    tinyjambu_session_perm_t state;
+    unsigned char computed[TINYJAMBU_TAG_SIZE];
+    unsigned char *mtemp = m;
+    size_t len;
+    uint32_t data;
+    int result;
+
+    /* Validate the ciphertext length and set the return "mlen" value */
+    if (clen < TINYJAMBU_TAG_SIZE)
+        return -1;
+    *mlen = len = clen - TINYJAMBU_TAG_SIZE;
+
+    /* Work on a copy of the receive state so that the session is not
+     * disturbed if the message turns out to be a forgery */
+    memcpy(&state, &(psession->recv), sizeof(state));
+    tinyjambu_session_absorb(&state, key_size, ad, adlen);
+
+    /* Decrypt the ciphertext to produce the plaintext */
+    while (len >= 4) {
+        tinyjambu_add_domain(&(state.s128), 0x50);
+        tinyjambu_session_permute_long(&state, key_size);
+        data = le_load_word32(c) ^ tinyjambu_squeeze(&(state.s128));
+        tinyjambu_absorb(&(state.s128), data);
+        le_store_word32(m, data);
+        c += 4;
+        m += 4;
+        len -= 4;
+    }
+    if (len > 0) {
+        tinyjambu_add_domain(&(state.s128), 0x50);
+        tinyjambu_session_permute_long(&state, key_size);
+        if (len == 1) {
+            data = (c[0] ^ tinyjambu_squeeze(&(state.s128))) & 0xFFU;
+        } else if (len == 2) {
+            data = le_load_word16(c) ^ tinyjambu_squeeze(&(state.s128));
+            data &= 0xFFFFU;
+        } else {
+            data = le_load_word16(c) | (((uint32_t)(c[2])) << 16);
+            data = (data ^ tinyjambu_squeeze(&(state.s128))) & 0xFFFFFFU;
+        }
+        tinyjambu_absorb(&(state.s128), data);
+        tinyjambu_add_domain(&(state.s128), (unsigned char)len);
+        m[0] = (uint8_t)data;
+        if (len > 1)
+            m[1] = (uint8_t)(data >> 8);
+        if (len > 2)
+            m[2] = (uint8_t)(data >> 16);
+        c += len;
+    }
+
+    /* Check the tag and only advance the session if it is correct */
+    tinyjambu_session_generate_tag(&state, key_size, computed);
+    result = tinyjambu_aead_check_tag
+        (mtemp, *mlen, computed, c, TINYJAMBU_TAG_SIZE);
+    if (result == 0)
+        memcpy(&(psession->recv), &state, sizeof(state));
+    tinyjambu_clean(&state, sizeof(state));
+    return result;
+}
+
+void tinyjambu_session_free(tinyjambu_session_t *session)
+{
+    tinyjambu_clean(session, sizeof(tinyjambu_session_t));
+}
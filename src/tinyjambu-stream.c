@@ -0,0 +1,536 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#if defined(HAVE_CONFIG_H)
+#include <config.h>
+#endif
+#include "TinyJAMBU.h"
+#include "backend/tinyjambu-util.h"
+#include <string.h>
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#define TINYJAMBU_STREAM_PTHREAD 1
+#endif
+
+/*
+ * TinyJAMBU-STREAM follows the STREAM construction from "Online
+ * Authenticated-Encryption and its Nonce-Reuse Misuse-Resistance"
+ * by Hoang, Reyhanitabar, Rogaway, and Vizar.  Each chunk is encrypted
+ * independently, so the chunks can be processed in parallel, and each
+ * chunk's plaintext can be released as soon as its tag has been checked.
+ *
+ * The nonce for chunk i is prefix || [i]_32 || last, where last is 1 for
+ * the final chunk and 0 otherwise.  The index stops chunks from being
+ * reordered and the last flag stops the message from being truncated at
+ * a chunk boundary.  The header is the associated data for every chunk,
+ * which binds the chunk size and format version to each tag.
+ */
+
+/**
+ * \brief Maximum number of threads to use for a single message.
+ */
+#define TINYJAMBU_STREAM_MAX_THREADS 64
+
+/**
+ * \brief Minimum number of plaintext bytes that are worth giving to
+ * a separate thread.
+ */
+#define TINYJAMBU_STREAM_THREAD_BYTES 16384
+
+/**
+ * \brief Maximum number of chunks in a message.
+ */
+#define TINYJAMBU_STREAM_MAX_CHUNKS 0x100000000ULL
+
+/**
+ * \brief Prototype for a combined AEAD encryption function.
+ */
+typedef void (*tinyjambu_stream_encrypt_t)
+    (unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k);
+
+/**
+ * \brief Prototype for a combined AEAD decryption function.
+ */
+typedef int (*tinyjambu_stream_decrypt_t)
+    (unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k);
+
+/**
+ * \brief Private state for incremental TinyJAMBU-STREAM decryption.
+ */
+typedef struct
+{
+    /** Copy of the key */
+    unsigned char key[TINYJAMBU_256_KEY_SIZE];
+
+    /** Copy of the header, which is the associated data for each chunk */
+    unsigned char header[TINYJAMBU_STREAM_HEADER_SIZE];
+
+    /** Decryption function for the key size */
+    tinyjambu_stream_decrypt_t decrypt;
+
+    /** Size of the plaintext in each chunk */
+    size_t chunk_size;
+
+    /** Index of the next chunk */
+    uint64_t index;
+
+    /** Zero while decrypting, 1 after the last chunk, -1 on failure */
+    int status;
+
+} tinyjambu_stream_decryptor_p_t;
+
+/** @cond */
+
+/* Compile-time check that tinyjambu_stream_decryptor_p_t can fit within
+ * the bounds of tinyjambu_stream_decryptor_t.  This line of code will fail
+ * to compile if the private structure is too large for the public one. */
+typedef int tinyjambu_stream_decryptor_size_check
+    [(sizeof(tinyjambu_stream_decryptor_p_t) <=
+            sizeof(tinyjambu_stream_decryptor_t)) * 2 - 1];
+
+/** @endcond */
+
+/**
+ * \brief Information about a message that is being processed.
+ */
+typedef struct
+{
+    /** Encryption function for the key size, or NULL when decrypting */
+    tinyjambu_stream_encrypt_t encrypt;
+
+    /** Decryption function for the key size, or NULL when encrypting */
+    tinyjambu_stream_decrypt_t decrypt;
+
+    /** Points to the key */
+    const unsigned char *key;
+
+    /** Points to the header */
+    const unsigned char *header;
+
+    /** Points to the plaintext */
+    unsigned char *m;
+
+    /** Distance between the plaintext chunks */
+    size_t mstride;
+
+    /** Points to the first encrypted chunk after the header */
+    unsigned char *c;
+
+    /** Total length of the plaintext */
+    size_t mlen;
+
+    /** Size of the plaintext in each chunk */
+    size_t chunk_size;
+
+    /** Number of chunks in the message */
+    uint64_t nchunks;
+
+} tinyjambu_stream_message_t;
+
+/* Formats the nonce for a chunk */
+static void tinyjambu_stream_nonce
+    (unsigned char nonce[TINYJAMBU_NONCE_SIZE], const unsigned char *header,
+     uint64_t index, int last)
+{
+    memcpy(nonce, header + 10, TINYJAMBU_STREAM_PREFIX_SIZE);
+    le_store_word32(nonce + TINYJAMBU_STREAM_PREFIX_SIZE, (uint32_t)index);
+    nonce[TINYJAMBU_NONCE_SIZE - 1] = (unsigned char)(last ? 1 : 0);
+}
+
+/* Selects the encryption function for a key length */
+static tinyjambu_stream_encrypt_t tinyjambu_stream_get_encrypt(size_t keylen)
+{
+    switch (keylen) {
+    case TINYJAMBU_128_KEY_SIZE: return tinyjambu_128_aead_encrypt;
+    case TINYJAMBU_192_KEY_SIZE: return tinyjambu_192_aead_encrypt;
+    case TINYJAMBU_256_KEY_SIZE: return tinyjambu_256_aead_encrypt;
+    default:                     return 0;
+    }
+}
+
+/* Selects the decryption function for a key length */
+static tinyjambu_stream_decrypt_t tinyjambu_stream_get_decrypt(size_t keylen)
+{
+    switch (keylen) {
+    case TINYJAMBU_128_KEY_SIZE: return tinyjambu_128_aead_decrypt;
+    case TINYJAMBU_192_KEY_SIZE: return tinyjambu_192_aead_decrypt;
+    case TINYJAMBU_256_KEY_SIZE: return tinyjambu_256_aead_decrypt;
+    default:                     return 0;
+    }
+}
+
+/* Parses and validates a header, returning the chunk size or zero */
+static size_t tinyjambu_stream_parse_header
+    (const unsigned char *header, size_t keylen)
+{
+    if (memcmp(header, "TJST", 4) != 0 ||
+            header[4] != TINYJAMBU_STREAM_VERSION ||
+            header[5] != keylen ||
+            header[17] != 0 || header[18] != 0 || header[19] != 0) {
+        return 0;
+    }
+    return le_load_word32(header + 6);
+}
+
+/* Processes a range of chunks.  Returns -1 if any chunk failed to
+ * authenticate */
+static int tinyjambu_stream_chunks
+    (const tinyjambu_stream_message_t *msg, uint64_t first, uint64_t count)
+{
+    unsigned char nonce[TINYJAMBU_NONCE_SIZE];
+    size_t full = msg->chunk_size + TINYJAMBU_TAG_SIZE;
+    size_t len, outlen;
+    int result = 0;
+    int last;
+
+    while (count > 0) {
+        last = (first == msg->nchunks - 1);
+        len = last ? (size_t)(msg->mlen - first * msg->chunk_size)
+                   : msg->chunk_size;
+        tinyjambu_stream_nonce(nonce, msg->header, first, last);
+        if (msg->encrypt) {
+            (*(msg->encrypt))
+                (msg->c + first * full, &outlen,
+                 msg->m + first * msg->mstride, len,
+                 msg->header, TINYJAMBU_STREAM_HEADER_SIZE,
+                 nonce, msg->key);
+        } else {
+            result |= (*(msg->decrypt))
+                (msg->m + first * msg->mstride, &outlen,
+                 msg->c + first * full, len + TINYJAMBU_TAG_SIZE,
+                 msg->header, TINYJAMBU_STREAM_HEADER_SIZE,
+                 nonce, msg->key);
+            if (result != 0)
+                break;
+        }
+        ++first;
+        --count;
+    }
+    return result;
+}
+
+#if defined(TINYJAMBU_STREAM_PTHREAD)
+
+/**
+ * \brief Range of chunks that is processed by a single thread.
+ */
+typedef struct
+{
+    /** Points to the message information */
+    const tinyjambu_stream_message_t *msg;
+
+    /** Index of the first chunk in the range */
+    uint64_t first;
+
+    /** Number of chunks in the range */
+    uint64_t count;
+
+    /** Result of processing the range */
+    int result;
+
+    /** Thread that is processing the range */
+    pthread_t thread;
+
+    /** Non-zero if the thread was started successfully */
+    int started;
+
+} tinyjambu_stream_range_t;
+
+/* Processes a range of chunks on a thread */
+static void *tinyjambu_stream_range(void *arg)
+{
+    tinyjambu_stream_range_t *range = (tinyjambu_stream_range_t *)arg;
+    range->result =
+        tinyjambu_stream_chunks(range->msg, range->first, range->count);
+    return 0;
+}
+
+/* Processes all chunks of a message, divided between threads */
+static int tinyjambu_stream_process
+    (const tinyjambu_stream_message_t *msg, unsigned threads)
+{
+    tinyjambu_stream_range_t ranges[TINYJAMBU_STREAM_MAX_THREADS];
+    uint64_t per_thread, extra, start;
+    unsigned count, index;
+    int result = 0;
+
+    /* Determine how many threads are worth using for this message */
+    if (threads > TINYJAMBU_STREAM_MAX_THREADS)
+        threads = TINYJAMBU_STREAM_MAX_THREADS;
+    if ((msg->mlen / TINYJAMBU_STREAM_THREAD_BYTES) < threads)
+        count = (unsigned)(msg->mlen / TINYJAMBU_STREAM_THREAD_BYTES);
+    else
+        count = threads;
+    if (count > msg->nchunks)
+        count = (unsigned)(msg->nchunks);
+    if (count <= 1)
+        return tinyjambu_stream_chunks(msg, 0, msg->nchunks);
+
+    /* Divide the chunks between the threads as evenly as possible */
+    per_thread = msg->nchunks / count;
+    extra = msg->nchunks % count;
+    start = 0;
+    for (index = 0; index < count; ++index) {
+        ranges[index].msg = msg;
+        ranges[index].first = start;
+        ranges[index].count = per_thread + (index < extra ? 1 : 0);
+        ranges[index].result = 0;
+        ranges[index].started = 0;
+        start += ranges[index].count;
+    }
+
+    /* Start the helper threads.  If a thread cannot be created, then its
+     * range is processed on the calling thread after the others */
+    for (index = 1; index < count; ++index) {
+        ranges[index].started =
+            (pthread_create(&(ranges[index].thread), 0,
+                            tinyjambu_stream_range, &(ranges[index])) == 0);
+    }
+
+    /* Process the first range on the calling thread and then collect
+     * the results from the other threads */
+    for (index = 0; index < count; ++index) {
+        if (ranges[index].started)
+            pthread_join(ranges[index].thread, 0);
+        else
+            tinyjambu_stream_range(&(ranges[index]));
+        result |= ranges[index].result;
+    }
+    return result;
+}
+
+#else /* !TINYJAMBU_STREAM_PTHREAD */
+
+static int tinyjambu_stream_process
+    (const tinyjambu_stream_message_t *msg, unsigned threads)
+{
+    (void)threads;
+    return tinyjambu_stream_chunks(msg, 0, msg->nchunks);
+}
+
+#endif /* !TINYJAMBU_STREAM_PTHREAD */
+
+size_t tinyjambu_stream_encrypted_size(size_t mlen, size_t chunk_size)
+{
+    size_t nchunks = chunk_size ? (mlen / chunk_size + 1) : 1;
+    if (chunk_size && mlen && (mlen % chunk_size) == 0)
+        --nchunks; /* The final chunk is full */
+    return TINYJAMBU_STREAM_HEADER_SIZE + mlen +
+           nchunks * TINYJAMBU_TAG_SIZE;
+}
+
+int tinyjambu_stream_encrypt
+    (unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *prefix,
+     const unsigned char *k, size_t keylen,
+     size_t chunk_size, unsigned threads)
+{
+    tinyjambu_stream_message_t msg;
+    unsigned char header[TINYJAMBU_STREAM_HEADER_SIZE];
+    size_t full, total;
+    uint64_t index;
+
+    /* Validate the parameters */
+    *clen = 0;
+    msg.encrypt = tinyjambu_stream_get_encrypt(keylen);
+    msg.decrypt = 0;
+    if (!msg.encrypt || !chunk_size || chunk_size > 0xFFFFFFFFUL)
+        return -1;
+    msg.nchunks = mlen ? ((uint64_t)mlen + chunk_size - 1) / chunk_size : 1;
+    if (msg.nchunks > TINYJAMBU_STREAM_MAX_CHUNKS)
+        return -1;
+
+    /* Format the header */
+    memcpy(header, "TJST", 4);
+    header[4] = TINYJAMBU_STREAM_VERSION;
+    header[5] = (unsigned char)keylen;
+    le_store_word32(header + 6, (uint32_t)chunk_size);
+    memcpy(header + 10, prefix, TINYJAMBU_STREAM_PREFIX_SIZE);
+    header[17] = 0;
+    header[18] = 0;
+    header[19] = 0;
+
+    /* If the buffers overlap, then move the plaintext chunks to their
+     * final positions, starting at the end, and encrypt them in-place */
+    msg.key = k;
+    msg.header = header;
+    msg.m = (unsigned char *)m;
+    msg.mstride = chunk_size;
+    msg.c = c + TINYJAMBU_STREAM_HEADER_SIZE;
+    msg.mlen = mlen;
+    msg.chunk_size = chunk_size;
+    full = chunk_size + TINYJAMBU_TAG_SIZE;
+    total = tinyjambu_stream_encrypted_size(mlen, chunk_size);
+    if (c < m + mlen && m < c + total) {
+        for (index = msg.nchunks; index > 0; --index) {
+            memmove(msg.c + (index - 1) * full,
+                    m + (index - 1) * chunk_size,
+                    (index == msg.nchunks)
+                        ? (size_t)(mlen - (index - 1) * chunk_size)
+                        : chunk_size);
+        }
+        msg.m = msg.c;
+        msg.mstride = full;
+    }
+
+    /* Encrypt the chunks */
+    tinyjambu_stream_process(&msg, threads);
+    memcpy(c, header, TINYJAMBU_STREAM_HEADER_SIZE);
+    *clen = total;
+    return 0;
+}
+
+int tinyjambu_stream_decrypt
+    (unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen,
+     const unsigned char *k, size_t keylen,
+     unsigned threads)
+{
+    tinyjambu_stream_message_t msg;
+    unsigned char header[TINYJAMBU_STREAM_HEADER_SIZE];
+    size_t body, full, last;
+
+    /* Validate the header */
+    *mlen = 0;
+    msg.encrypt = 0;
+    msg.decrypt = tinyjambu_stream_get_decrypt(keylen);
+    if (!msg.decrypt ||
+            clen < (TINYJAMBU_STREAM_HEADER_SIZE + TINYJAMBU_TAG_SIZE))
+        return -1;
+    body = clen - TINYJAMBU_STREAM_HEADER_SIZE - TINYJAMBU_TAG_SIZE;
+    msg.chunk_size = tinyjambu_stream_parse_header(c, keylen);
+    if (!msg.chunk_size) {
+        memset(m, 0, body);
+        return -1;
+    }
+
+    /* Every chunk except the last is full, and the last chunk has
+     * between 0 and chunk_size bytes of plaintext */
+    full = msg.chunk_size + TINYJAMBU_TAG_SIZE;
+    msg.nchunks = body / full + 1;
+    last = body % full;
+    if (msg.nchunks > TINYJAMBU_STREAM_MAX_CHUNKS) {
+        memset(m, 0, body);
+        return -1;
+    }
+    msg.mlen = (size_t)((msg.nchunks - 1) * msg.chunk_size) + last;
+
+    /* Decrypt the chunks and zero everything if any of them failed.
+     * The header is copied first because in-place decryption will
+     * overwrite it.  Each plaintext chunk is written before the start
+     * of its ciphertext, so overlapping buffers can be decrypted from
+     * the first chunk to the last on a single thread */
+    memcpy(header, c, TINYJAMBU_STREAM_HEADER_SIZE);
+    msg.key = k;
+    msg.header = header;
+    msg.m = m;
+    msg.mstride = msg.chunk_size;
+    msg.c = (unsigned char *)(c + TINYJAMBU_STREAM_HEADER_SIZE);
+    if (m < c + clen && c < m + msg.mlen)
+        threads = 1;
+    if (tinyjambu_stream_process(&msg, threads) != 0) {
+        memset(m, 0, msg.mlen);
+        return -1;
+    }
+    *mlen = msg.mlen;
+    return 0;
+}
+
+int tinyjambu_stream_decrypt_init
+    (tinyjambu_stream_decryptor_t *dec, const unsigned char *header,
+     const unsigned char *k, size_t keylen)
+{
+    tinyjambu_stream_decryptor_p_t *pdec =
+        (tinyjambu_stream_decryptor_p_t *)dec;
+    memset(dec, 0, sizeof(tinyjambu_stream_decryptor_t));
+    pdec->decrypt = tinyjambu_stream_get_decrypt(keylen);
+    pdec->chunk_size = tinyjambu_stream_parse_header(header, keylen);
+    if (!pdec->decrypt || !pdec->chunk_size) {
+        pdec->status = -1;
+        return -1;
+    }
+    memcpy(pdec->key, k, keylen);
+    memcpy(pdec->header, header, TINYJAMBU_STREAM_HEADER_SIZE);
+    return 0;
+}
+
+size_t tinyjambu_stream_decrypt_chunk_size
+    (const tinyjambu_stream_decryptor_t *dec)
+{
+    const tinyjambu_stream_decryptor_p_t *pdec =
+        (const tinyjambu_stream_decryptor_p_t *)dec;
+    return pdec->chunk_size + TINYJAMBU_TAG_SIZE;
+}
+
+int tinyjambu_stream_decrypt_chunk
+    (tinyjambu_stream_decryptor_t *dec, unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen, int last)
+{
+    tinyjambu_stream_decryptor_p_t *pdec =
+        (tinyjambu_stream_decryptor_p_t *)dec;
+    unsigned char nonce[TINYJAMBU_NONCE_SIZE];
+    size_t full = pdec->chunk_size + TINYJAMBU_TAG_SIZE;
+
+    /* Check that the chunk is expected and has the right length */
+    *mlen = 0;
+    if (pdec->status != 0 || clen < TINYJAMBU_TAG_SIZE || clen > full ||
+            (!last && clen != full) ||
+            pdec->index >= TINYJAMBU_STREAM_MAX_CHUNKS) {
+        pdec->status = -1;
+        return -1;
+    }
+
+    /* Decrypt the chunk and verify its tag */
+    tinyjambu_stream_nonce(nonce, pdec->header, pdec->index, last);
+    if ((*(pdec->decrypt))
+            (m, mlen, c, clen, pdec->header, TINYJAMBU_STREAM_HEADER_SIZE,
+             nonce, pdec->key) != 0) {
+        *mlen = 0;
+        pdec->status = -1;
+        return -1;
+    }
+    ++(pdec->index);
+    if (last)
+        pdec->status = 1;
+    return 0;
+}
+
+int tinyjambu_stream_decrypt_finish(const tinyjambu_stream_decryptor_t *dec)
+{
+    const tinyjambu_stream_decryptor_p_t *pdec =
+        (const tinyjambu_stream_decryptor_p_t *)dec;
+    return pdec->status == 1 ? 0 : -1;
+}
+
+void tinyjambu_stream_decrypt_free(tinyjambu_stream_decryptor_t *dec)
+{
+    tinyjambu_clean(dec, sizeof(tinyjambu_stream_decryptor_t));
+}
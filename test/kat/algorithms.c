@@ -58,6 +58,96 @@ aead_cipher_t const tinyjambu256_cipher = {
     0, 0, 0, 0, 0, 0, 0, 0, 0
 };
 
+/* The pre-computed key for the JIT ciphers is a pointer to a key context */
+static void tinyjambu_jit_encrypt
+    (unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k)
+{
+    tinyjambu_jit_aead_encrypt
+        (*((tinyjambu_jit_key_t * const *)k), c, clen, m, mlen,
+         ad, adlen, npub);
+}
+
+static int tinyjambu_jit_decrypt
+    (unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k)
+{
+    return tinyjambu_jit_aead_decrypt
+        (*((tinyjambu_jit_key_t * const *)k), m, mlen, c, clen,
+         ad, adlen, npub);
+}
+
+static void tinyjambu128_jit_init(unsigned char *pk, const unsigned char *k)
+{
+    *((tinyjambu_jit_key_t **)pk) =
+        tinyjambu_jit_key_create(k, TINYJAMBU_128_KEY_SIZE);
+}
+
+static void tinyjambu192_jit_init(unsigned char *pk, const unsigned char *k)
+{
+    *((tinyjambu_jit_key_t **)pk) =
+        tinyjambu_jit_key_create(k, TINYJAMBU_192_KEY_SIZE);
+}
+
+static void tinyjambu256_jit_init(unsigned char *pk, const unsigned char *k)
+{
+    *((tinyjambu_jit_key_t **)pk) =
+        tinyjambu_jit_key_create(k, TINYJAMBU_256_KEY_SIZE);
+}
+
+static void tinyjambu_jit_free(unsigned char *pk)
+{
+    tinyjambu_jit_key_destroy(*((tinyjambu_jit_key_t **)pk));
+}
+
+aead_cipher_t const tinyjambu128_jit_cipher = {
+    "TinyJAMBU-128-JIT",
+    TINYJAMBU_128_KEY_SIZE,
+    TINYJAMBU_NONCE_SIZE,
+    TINYJAMBU_TAG_SIZE,
+    AEAD_FLAG_LITTLE_ENDIAN,
+    tinyjambu_jit_encrypt,
+    tinyjambu_jit_decrypt,
+    sizeof(tinyjambu_jit_key_t *),
+    tinyjambu128_jit_init,
+    tinyjambu_jit_free,
+    0, 0, 0, 0, 0, 0
+};
+
+aead_cipher_t const tinyjambu192_jit_cipher = {
+    "TinyJAMBU-192-JIT",
+    TINYJAMBU_192_KEY_SIZE,
+    TINYJAMBU_NONCE_SIZE,
+    TINYJAMBU_TAG_SIZE,
+    AEAD_FLAG_LITTLE_ENDIAN,
+    tinyjambu_jit_encrypt,
+    tinyjambu_jit_decrypt,
+    sizeof(tinyjambu_jit_key_t *),
+    tinyjambu192_jit_init,
+    tinyjambu_jit_free,
+    0, 0, 0, 0, 0, 0
+};
+
+aead_cipher_t const tinyjambu256_jit_cipher = {
+    "TinyJAMBU-256-JIT",
+    TINYJAMBU_256_KEY_SIZE,
+    TINYJAMBU_NONCE_SIZE,
+    TINYJAMBU_TAG_SIZE,
+    AEAD_FLAG_LITTLE_ENDIAN,
+    tinyjambu_jit_encrypt,
+    tinyjambu_jit_decrypt,
+    sizeof(tinyjambu_jit_key_t *),
+    tinyjambu256_jit_init,
+    tinyjambu_jit_free,
+    0, 0, 0, 0, 0, 0
+};
+
 aead_cipher_t const tinyjambu128_siv_cipher = {
     "TinyJAMBU-128-SIV",
     TINYJAMBU_128_KEY_SIZE,
@@ -91,6 +181,372 @@ aead_cipher_t const tinyjambu256_siv_cipher = {
     0, 0, 0, 0, 0, 0, 0, 0, 0
 };
 
+/* The incremental AEAD functions take their arguments in a different
+ * order to the test framework */
+static void tinyjambu_aead_encrypt_inc
+    (void *state, const unsigned char *in, unsigned char *out, size_t len)
+{
+    tinyjambu_aead_encrypt_update
+        ((tinyjambu_aead_state_t *)state, out, in, len);
+}
+
+static void tinyjambu_aead_decrypt_inc
+    (void *state, const unsigned char *in, unsigned char *out, size_t len)
+{
+    tinyjambu_aead_decrypt_update
+        ((tinyjambu_aead_state_t *)state, out, in, len);
+}
+
+aead_cipher_t const tinyjambu128_incremental_cipher = {
+    "TinyJAMBU-128-Incremental",
+    TINYJAMBU_128_KEY_SIZE,
+    TINYJAMBU_NONCE_SIZE,
+    TINYJAMBU_TAG_SIZE,
+    AEAD_FLAG_LITTLE_ENDIAN,
+    tinyjambu_128_aead_encrypt,
+    tinyjambu_128_aead_decrypt,
+    0, 0, 0,
+    sizeof(tinyjambu_aead_state_t),
+    (aead_cipher_inc_start_t)tinyjambu_128_aead_start,
+    tinyjambu_aead_encrypt_inc,
+    (aead_cipher_enc_fin_t)tinyjambu_aead_encrypt_finish,
+    tinyjambu_aead_decrypt_inc,
+    (aead_cipher_dec_fin_t)tinyjambu_aead_decrypt_finish
+};
+
+aead_cipher_t const tinyjambu192_incremental_cipher = {
+    "TinyJAMBU-192-Incremental",
+    TINYJAMBU_192_KEY_SIZE,
+    TINYJAMBU_NONCE_SIZE,
+    TINYJAMBU_TAG_SIZE,
+    AEAD_FLAG_LITTLE_ENDIAN,
+    tinyjambu_192_aead_encrypt,
+    tinyjambu_192_aead_decrypt,
+    0, 0, 0,
+    sizeof(tinyjambu_aead_state_t),
+    (aead_cipher_inc_start_t)tinyjambu_192_aead_start,
+    tinyjambu_aead_encrypt_inc,
+    (aead_cipher_enc_fin_t)tinyjambu_aead_encrypt_finish,
+    tinyjambu_aead_decrypt_inc,
+    (aead_cipher_dec_fin_t)tinyjambu_aead_decrypt_finish
+};
+
+aead_cipher_t const tinyjambu256_incremental_cipher = {
+    "TinyJAMBU-256-Incremental",
+    TINYJAMBU_256_KEY_SIZE,
+    TINYJAMBU_NONCE_SIZE,
+    TINYJAMBU_TAG_SIZE,
+    AEAD_FLAG_LITTLE_ENDIAN,
+    tinyjambu_256_aead_encrypt,
+    tinyjambu_256_aead_decrypt,
+    0, 0, 0,
+    sizeof(tinyjambu_aead_state_t),
+    (aead_cipher_inc_start_t)tinyjambu_256_aead_start,
+    tinyjambu_aead_encrypt_inc,
+    (aead_cipher_enc_fin_t)tinyjambu_aead_encrypt_finish,
+    tinyjambu_aead_decrypt_inc,
+    (aead_cipher_dec_fin_t)tinyjambu_aead_decrypt_finish
+};
+
+/* The TinyJAMBU-STREAM KAT vectors use a small chunk size so that the
+ * messages are split into several chunks.  The nonce is the prefix and
+ * the vectors are generated without associated data */
+#define TINYJAMBU_STREAM_KAT_CHUNK_SIZE 16
+
+/* Maximum ciphertext expansion for the 32-byte messages in the KAT */
+#define TINYJAMBU_STREAM_KAT_EXPANSION \
+    (TINYJAMBU_STREAM_HEADER_SIZE + 3 * TINYJAMBU_TAG_SIZE)
+
+static void tinyjambu_stream_encrypt_wrapper
+    (unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k, size_t keylen)
+{
+    (void)ad;
+    (void)adlen;
+    tinyjambu_stream_encrypt
+        (c, clen, m, mlen, npub, k, keylen,
+         TINYJAMBU_STREAM_KAT_CHUNK_SIZE, 1);
+}
+
+static int tinyjambu_stream_decrypt_wrapper
+    (unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k, size_t keylen)
+{
+    (void)ad;
+    (void)adlen;
+    (void)npub;
+    return tinyjambu_stream_decrypt(m, mlen, c, clen, k, keylen, 1);
+}
+
+static void tinyjambu_128_stream_encrypt
+    (unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k)
+{
+    tinyjambu_stream_encrypt_wrapper
+        (c, clen, m, mlen, ad, adlen, npub, k, TINYJAMBU_128_KEY_SIZE);
+}
+
+static int tinyjambu_128_stream_decrypt
+    (unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k)
+{
+    return tinyjambu_stream_decrypt_wrapper
+        (m, mlen, c, clen, ad, adlen, npub, k, TINYJAMBU_128_KEY_SIZE);
+}
+
+aead_cipher_t const tinyjambu128_stream_cipher = {
+    "TinyJAMBU-128-STREAM",
+    TINYJAMBU_128_KEY_SIZE,
+    TINYJAMBU_STREAM_PREFIX_SIZE,
+    TINYJAMBU_STREAM_KAT_EXPANSION,
+    AEAD_FLAG_LITTLE_ENDIAN,
+    tinyjambu_128_stream_encrypt,
+    tinyjambu_128_stream_decrypt,
+    0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+static void tinyjambu_192_stream_encrypt
+    (unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k)
+{
+    tinyjambu_stream_encrypt_wrapper
+        (c, clen, m, mlen, ad, adlen, npub, k, TINYJAMBU_192_KEY_SIZE);
+}
+
+static int tinyjambu_192_stream_decrypt
+    (unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k)
+{
+    return tinyjambu_stream_decrypt_wrapper
+        (m, mlen, c, clen, ad, adlen, npub, k, TINYJAMBU_192_KEY_SIZE);
+}
+
+aead_cipher_t const tinyjambu192_stream_cipher = {
+    "TinyJAMBU-192-STREAM",
+    TINYJAMBU_192_KEY_SIZE,
+    TINYJAMBU_STREAM_PREFIX_SIZE,
+    TINYJAMBU_STREAM_KAT_EXPANSION,
+    AEAD_FLAG_LITTLE_ENDIAN,
+    tinyjambu_192_stream_encrypt,
+    tinyjambu_192_stream_decrypt,
+    0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+static void tinyjambu_256_stream_encrypt
+    (unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k)
+{
+    tinyjambu_stream_encrypt_wrapper
+        (c, clen, m, mlen, ad, adlen, npub, k, TINYJAMBU_256_KEY_SIZE);
+}
+
+static int tinyjambu_256_stream_decrypt
+    (unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k)
+{
+    return tinyjambu_stream_decrypt_wrapper
+        (m, mlen, c, clen, ad, adlen, npub, k, TINYJAMBU_256_KEY_SIZE);
+}
+
+aead_cipher_t const tinyjambu256_stream_cipher = {
+    "TinyJAMBU-256-STREAM",
+    TINYJAMBU_256_KEY_SIZE,
+    TINYJAMBU_STREAM_PREFIX_SIZE,
+    TINYJAMBU_STREAM_KAT_EXPANSION,
+    AEAD_FLAG_LITTLE_ENDIAN,
+    tinyjambu_256_stream_encrypt,
+    tinyjambu_256_stream_decrypt,
+    0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+/* The session KAT vectors send two messages from the initiator to the
+ * responder: the first carries the associated data and plaintext and the
+ * second is empty.  The output is the first ciphertext and tag followed
+ * by the tag for the second message, which depends upon the first */
+#define TINYJAMBU_SESSION_KAT_EXPANSION (2 * TINYJAMBU_TAG_SIZE)
+
+static void tinyjambu_session_encrypt_wrapper
+    (unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k, size_t keylen)
+{
+    tinyjambu_session_t session;
+    size_t len;
+    if (keylen == TINYJAMBU_128_KEY_SIZE)
+        tinyjambu_128_session_init
+            (&session, k, npub, TINYJAMBU_SESSION_INITIATOR);
+    else if (keylen == TINYJAMBU_192_KEY_SIZE)
+        tinyjambu_192_session_init
+            (&session, k, npub, TINYJAMBU_SESSION_INITIATOR);
+    else
+        tinyjambu_256_session_init
+            (&session, k, npub, TINYJAMBU_SESSION_INITIATOR);
+    tinyjambu_session_encrypt(&session, c, clen, m, mlen, ad, adlen);
+    tinyjambu_session_encrypt(&session, c + *clen, &len, 0, 0, 0, 0);
+    *clen += len;
+    tinyjambu_session_free(&session);
+}
+
+static int tinyjambu_session_decrypt_wrapper
+    (unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k, size_t keylen)
+{
+    tinyjambu_session_t session;
+    unsigned char empty[1];
+    size_t len;
+    int result;
+    if (clen < TINYJAMBU_SESSION_KAT_EXPANSION)
+        return -1;
+    if (keylen == TINYJAMBU_128_KEY_SIZE)
+        tinyjambu_128_session_init
+            (&session, k, npub, TINYJAMBU_SESSION_RESPONDER);
+    else if (keylen == TINYJAMBU_192_KEY_SIZE)
+        tinyjambu_192_session_init
+            (&session, k, npub, TINYJAMBU_SESSION_RESPONDER);
+    else
+        tinyjambu_256_session_init
+            (&session, k, npub, TINYJAMBU_SESSION_RESPONDER);
+    result = tinyjambu_session_decrypt
+        (&session, m, mlen, c, clen - TINYJAMBU_TAG_SIZE, ad, adlen);
+    if (result == 0) {
+        result = tinyjambu_session_decrypt
+            (&session, empty, &len, c + clen - TINYJAMBU_TAG_SIZE,
+             TINYJAMBU_TAG_SIZE, 0, 0);
+        if (result != 0)
+            memset(m, 0, *mlen);
+    }
+    tinyjambu_session_free(&session);
+    return result;
+}
+
+static void tinyjambu_128_session_encrypt
+    (unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k)
+{
+    tinyjambu_session_encrypt_wrapper
+        (c, clen, m, mlen, ad, adlen, npub, k, TINYJAMBU_128_KEY_SIZE);
+}
+
+static int tinyjambu_128_session_decrypt
+    (unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k)
+{
+    return tinyjambu_session_decrypt_wrapper
+        (m, mlen, c, clen, ad, adlen, npub, k, TINYJAMBU_128_KEY_SIZE);
+}
+
+aead_cipher_t const tinyjambu128_session_cipher = {
+    "TinyJAMBU-128-Session",
+    TINYJAMBU_128_KEY_SIZE,
+    TINYJAMBU_NONCE_SIZE,
+    TINYJAMBU_SESSION_KAT_EXPANSION,
+    AEAD_FLAG_LITTLE_ENDIAN,
+    tinyjambu_128_session_encrypt,
+    tinyjambu_128_session_decrypt,
+    0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+static void tinyjambu_192_session_encrypt
+    (unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k)
+{
+    tinyjambu_session_encrypt_wrapper
+        (c, clen, m, mlen, ad, adlen, npub, k, TINYJAMBU_192_KEY_SIZE);
+}
+
+static int tinyjambu_192_session_decrypt
+    (unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k)
+{
+    return tinyjambu_session_decrypt_wrapper
+        (m, mlen, c, clen, ad, adlen, npub, k, TINYJAMBU_192_KEY_SIZE);
+}
+
+aead_cipher_t const tinyjambu192_session_cipher = {
+    "TinyJAMBU-192-Session",
+    TINYJAMBU_192_KEY_SIZE,
+    TINYJAMBU_NONCE_SIZE,
+    TINYJAMBU_SESSION_KAT_EXPANSION,
+    AEAD_FLAG_LITTLE_ENDIAN,
+    tinyjambu_192_session_encrypt,
+    tinyjambu_192_session_decrypt,
+    0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+static void tinyjambu_256_session_encrypt
+    (unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k)
+{
+    tinyjambu_session_encrypt_wrapper
+        (c, clen, m, mlen, ad, adlen, npub, k, TINYJAMBU_256_KEY_SIZE);
+}
+
+static int tinyjambu_256_session_decrypt
+    (unsigned char *m, size_t *mlen,
+     const unsigned char *c, size_t clen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k)
+{
+    return tinyjambu_session_decrypt_wrapper
+        (m, mlen, c, clen, ad, adlen, npub, k, TINYJAMBU_256_KEY_SIZE);
+}
+
+aead_cipher_t const tinyjambu256_session_cipher = {
+    "TinyJAMBU-256-Session",
+    TINYJAMBU_256_KEY_SIZE,
+    TINYJAMBU_NONCE_SIZE,
+    TINYJAMBU_SESSION_KAT_EXPANSION,
+    AEAD_FLAG_LITTLE_ENDIAN,
+    tinyjambu_256_session_encrypt,
+    tinyjambu_256_session_decrypt,
+    0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
 aead_hash_algorithm_t const tinyjambu_hash_algorithm = {
     "TinyJAMBU-Hash",
     sizeof(tinyjambu_hash_state_t),
@@ -129,14 +585,346 @@ aead_auth_algorithm_t const tinyjambu_hmac_auth = {
     (auth_hmac_finalize_t)tinyjambu_hmac_finalize
 };
 
+static void tinyjambu_kbkdf_compute_wrapper
+    (unsigned char *tag, size_t taglen,
+     const unsigned char *key, size_t keylen,
+     const unsigned char *in, size_t inlen)
+{
+    tinyjambu_kbkdf(tag, taglen, key, keylen, in, inlen, 0, 0);
+}
+
+aead_auth_algorithm_t const tinyjambu_kbkdf_auth = {
+    "TinyJAMBU-KBKDF",
+    sizeof(tinyjambu_kbkdf_state_t),
+    TINYJAMBU_HMAC_SIZE,
+    TINYJAMBU_KBKDF_SIZE * 2,
+    AEAD_FLAG_NONE,
+    tinyjambu_kbkdf_compute_wrapper,
+    0, /* verify */
+    0, /* init */
+    0, /* init_fixed */
+    0, /* absorb */
+    0, /* squeeze */
+    0  /* hmac_finalize */
+};
+
+/* TinyJAMBU-MAC is tested with the fixed IV, as the KAT format has no nonce */
+typedef void (*tinyjambu_mac_init_key_t)
+    (tinyjambu_mac_key_t *key, const unsigned char *k);
+
+typedef struct
+{
+    tinyjambu_mac_key_t key;
+    tinyjambu_mac_state_t state;
+
+} tinyjambu_mac_kat_state_t;
+
+static void tinyjambu_mac_compute_common
+    (tinyjambu_mac_init_key_t init_key, unsigned char *tag,
+     const unsigned char *key, const unsigned char *in, size_t inlen)
+{
+    tinyjambu_mac_key_t mac_key;
+    (*init_key)(&mac_key, key);
+    tinyjambu_mac(tag, &mac_key, 0, in, inlen);
+    tinyjambu_mac_free_key(&mac_key);
+}
+
+static int tinyjambu_mac_verify_common
+    (tinyjambu_mac_init_key_t init_key, const unsigned char *tag,
+     const unsigned char *key, const unsigned char *in, size_t inlen)
+{
+    tinyjambu_mac_key_t mac_key;
+    int result;
+    (*init_key)(&mac_key, key);
+    result = tinyjambu_mac_verify(tag, &mac_key, 0, in, inlen);
+    tinyjambu_mac_free_key(&mac_key);
+    return result;
+}
+
+static void tinyjambu_mac_init_common
+    (tinyjambu_mac_init_key_t init_key, void *state, const unsigned char *key)
+{
+    tinyjambu_mac_kat_state_t *st = (tinyjambu_mac_kat_state_t *)state;
+    (*init_key)(&(st->key), key);
+    tinyjambu_mac_init(&(st->state), &(st->key), 0);
+}
+
+static void tinyjambu_mac_update_wrapper
+    (void *state, const unsigned char *in, size_t inlen)
+{
+    tinyjambu_mac_kat_state_t *st = (tinyjambu_mac_kat_state_t *)state;
+    tinyjambu_mac_update(&(st->state), in, inlen);
+}
+
+static void tinyjambu_mac_finalize_wrapper
+    (void *state, const unsigned char *key, size_t keylen, unsigned char *out)
+{
+    tinyjambu_mac_kat_state_t *st = (tinyjambu_mac_kat_state_t *)state;
+    (void)key;
+    (void)keylen;
+    tinyjambu_mac_finalize(&(st->state), out);
+    tinyjambu_mac_free_key(&(st->key));
+}
+
+static void tinyjambu_128_mac_compute_wrapper
+    (unsigned char *tag, size_t taglen,
+     const unsigned char *key, size_t keylen,
+     const unsigned char *in, size_t inlen)
+{
+    (void)taglen;
+    (void)keylen;
+    tinyjambu_mac_compute_common
+        (tinyjambu_128_mac_init_key, tag, key, in, inlen);
+}
+
+static int tinyjambu_128_mac_verify_wrapper
+    (const unsigned char *tag, size_t taglen,
+     const unsigned char *key, size_t keylen,
+     const unsigned char *in, size_t inlen)
+{
+    (void)taglen;
+    (void)keylen;
+    return tinyjambu_mac_verify_common
+        (tinyjambu_128_mac_init_key, tag, key, in, inlen);
+}
+
+static void tinyjambu_128_mac_init_wrapper
+    (void *state, const unsigned char *key, size_t keylen)
+{
+    (void)keylen;
+    tinyjambu_mac_init_common(tinyjambu_128_mac_init_key, state, key);
+}
+
+aead_auth_algorithm_t const tinyjambu_128_mac_auth = {
+    "TinyJAMBU-128-MAC",
+    sizeof(tinyjambu_mac_kat_state_t),
+    TINYJAMBU_128_KEY_SIZE,
+    TINYJAMBU_MAC_SIZE,
+    AEAD_FLAG_NONE,
+    tinyjambu_128_mac_compute_wrapper,
+    tinyjambu_128_mac_verify_wrapper,
+    tinyjambu_128_mac_init_wrapper,
+    0, /* init_fixed */
+    tinyjambu_mac_update_wrapper,
+    0, /* squeeze */
+    tinyjambu_mac_finalize_wrapper
+};
+
+static void tinyjambu_192_mac_compute_wrapper
+    (unsigned char *tag, size_t taglen,
+     const unsigned char *key, size_t keylen,
+     const unsigned char *in, size_t inlen)
+{
+    (void)taglen;
+    (void)keylen;
+    tinyjambu_mac_compute_common
+        (tinyjambu_192_mac_init_key, tag, key, in, inlen);
+}
+
+static int tinyjambu_192_mac_verify_wrapper
+    (const unsigned char *tag, size_t taglen,
+     const unsigned char *key, size_t keylen,
+     const unsigned char *in, size_t inlen)
+{
+    (void)taglen;
+    (void)keylen;
+    return tinyjambu_mac_verify_common
+        (tinyjambu_192_mac_init_key, tag, key, in, inlen);
+}
+
+static void tinyjambu_192_mac_init_wrapper
+    (void *state, const unsigned char *key, size_t keylen)
+{
+    (void)keylen;
+    tinyjambu_mac_init_common(tinyjambu_192_mac_init_key, state, key);
+}
+
+aead_auth_algorithm_t const tinyjambu_192_mac_auth = {
+    "TinyJAMBU-192-MAC",
+    sizeof(tinyjambu_mac_kat_state_t),
+    TINYJAMBU_192_KEY_SIZE,
+    TINYJAMBU_MAC_SIZE,
+    AEAD_FLAG_NONE,
+    tinyjambu_192_mac_compute_wrapper,
+    tinyjambu_192_mac_verify_wrapper,
+    tinyjambu_192_mac_init_wrapper,
+    0, /* init_fixed */
+    tinyjambu_mac_update_wrapper,
+    0, /* squeeze */
+    tinyjambu_mac_finalize_wrapper
+};
+
+static void tinyjambu_256_mac_compute_wrapper
+    (unsigned char *tag, size_t taglen,
+     const unsigned char *key, size_t keylen,
+     const unsigned char *in, size_t inlen)
+{
+    (void)taglen;
+    (void)keylen;
+    tinyjambu_mac_compute_common
+        (tinyjambu_256_mac_init_key, tag, key, in, inlen);
+}
+
+static int tinyjambu_256_mac_verify_wrapper
+    (const unsigned char *tag, size_t taglen,
+     const unsigned char *key, size_t keylen,
+     const unsigned char *in, size_t inlen)
+{
+    (void)taglen;
+    (void)keylen;
+    return tinyjambu_mac_verify_common
+        (tinyjambu_256_mac_init_key, tag, key, in, inlen);
+}
+
+static void tinyjambu_256_mac_init_wrapper
+    (void *state, const unsigned char *key, size_t keylen)
+{
+    (void)keylen;
+    tinyjambu_mac_init_common(tinyjambu_256_mac_init_key, state, key);
+}
+
+aead_auth_algorithm_t const tinyjambu_256_mac_auth = {
+    "TinyJAMBU-256-MAC",
+    sizeof(tinyjambu_mac_kat_state_t),
+    TINYJAMBU_256_KEY_SIZE,
+    TINYJAMBU_MAC_SIZE,
+    AEAD_FLAG_NONE,
+    tinyjambu_256_mac_compute_wrapper,
+    tinyjambu_256_mac_verify_wrapper,
+    tinyjambu_256_mac_init_wrapper,
+    0, /* init_fixed */
+    tinyjambu_mac_update_wrapper,
+    0, /* squeeze */
+    tinyjambu_mac_finalize_wrapper
+};
+
+typedef struct
+{
+    tinyjambu_pmac_key_t key;
+    tinyjambu_pmac_state_t state;
+
+} tinyjambu_pmac_kat_state_t;
+
+static void tinyjambu_pmac_compute_wrapper
+    (unsigned char *tag, size_t taglen,
+     const unsigned char *key, size_t keylen,
+     const unsigned char *in, size_t inlen)
+{
+    tinyjambu_pmac_key_t pmac_key;
+    (void)taglen;
+    (void)keylen;
+    tinyjambu_pmac_init_key(&pmac_key, key);
+    tinyjambu_pmac(tag, &pmac_key, in, inlen);
+    tinyjambu_pmac_free_key(&pmac_key);
+}
+
+static int tinyjambu_pmac_verify_wrapper
+    (const unsigned char *tag, size_t taglen,
+     const unsigned char *key, size_t keylen,
+     const unsigned char *in, size_t inlen)
+{
+    tinyjambu_pmac_key_t pmac_key;
+    int result;
+    (void)taglen;
+    (void)keylen;
+    tinyjambu_pmac_init_key(&pmac_key, key);
+    result = tinyjambu_pmac_verify(tag, &pmac_key, in, inlen);
+    tinyjambu_pmac_free_key(&pmac_key);
+    return result;
+}
+
+static void tinyjambu_pmac_init_wrapper
+    (void *state, const unsigned char *key, size_t keylen)
+{
+    tinyjambu_pmac_kat_state_t *st = (tinyjambu_pmac_kat_state_t *)state;
+    (void)keylen;
+    tinyjambu_pmac_init_key(&(st->key), key);
+    tinyjambu_pmac_init(&(st->state), &(st->key));
+}
+
+static void tinyjambu_pmac_update_wrapper
+    (void *state, const unsigned char *in, size_t inlen)
+{
+    tinyjambu_pmac_kat_state_t *st = (tinyjambu_pmac_kat_state_t *)state;
+    tinyjambu_pmac_update(&(st->state), in, inlen);
+}
+
+static void tinyjambu_pmac_finalize_wrapper
+    (void *state, const unsigned char *key, size_t keylen, unsigned char *out)
+{
+    tinyjambu_pmac_kat_state_t *st = (tinyjambu_pmac_kat_state_t *)state;
+    (void)key;
+    (void)keylen;
+    tinyjambu_pmac_finalize(&(st->state), out);
+    tinyjambu_pmac_free_key(&(st->key));
+}
+
+aead_auth_algorithm_t const tinyjambu_pmac_auth = {
+    "TinyJAMBU-PMAC",
+    sizeof(tinyjambu_pmac_kat_state_t),
+    TINYJAMBU_PMAC_KEY_SIZE,
+    TINYJAMBU_PMAC_SIZE,
+    AEAD_FLAG_NONE,
+    tinyjambu_pmac_compute_wrapper,
+    tinyjambu_pmac_verify_wrapper,
+    tinyjambu_pmac_init_wrapper,
+    0, /* init_fixed */
+    tinyjambu_pmac_update_wrapper,
+    0, /* squeeze */
+    tinyjambu_pmac_finalize_wrapper
+};
+
+static void tinyjambu_prf64_compute_wrapper
+    (unsigned char *tag, size_t taglen,
+     const unsigned char *key, size_t keylen,
+     const unsigned char *in, size_t inlen)
+{
+    tinyjambu_prf64_key_t prf_key;
+    uint64_t result;
+    size_t index;
+    (void)keylen;
+    tinyjambu_prf64_init_key(&prf_key, key);
+    result = tinyjambu_prf64(&prf_key, in, inlen);
+    for (index = 0; index < taglen; ++index)
+        tag[index] = (unsigned char)(result >> (index * 8));
+    tinyjambu_prf64_free_key(&prf_key);
+}
+
+aead_auth_algorithm_t const tinyjambu_prf64_auth = {
+    "TinyJAMBU-PRF64",
+    0,
+    TINYJAMBU_PRF64_KEY_SIZE,
+    TINYJAMBU_PRF64_SIZE,
+    AEAD_FLAG_NONE,
+    tinyjambu_prf64_compute_wrapper,
+    0, /* verify */
+    0, /* init */
+    0, /* init_fixed */
+    0, /* absorb */
+    0, /* squeeze */
+    0  /* hmac_finalize */
+};
+
 /* List of all AEAD ciphers that we can run KAT tests for */
 static const aead_cipher_t *const ciphers[] = {
     &tinyjambu128_cipher,
     &tinyjambu192_cipher,
     &tinyjambu256_cipher,
+    &tinyjambu128_incremental_cipher,
+    &tinyjambu192_incremental_cipher,
+    &tinyjambu256_incremental_cipher,
+    &tinyjambu128_jit_cipher,
+    &tinyjambu192_jit_cipher,
+    &tinyjambu256_jit_cipher,
     &tinyjambu128_siv_cipher,
     &tinyjambu192_siv_cipher,
     &tinyjambu256_siv_cipher,
+    &tinyjambu128_stream_cipher,
+    &tinyjambu192_stream_cipher,
+    &tinyjambu256_stream_cipher,
+    &tinyjambu128_session_cipher,
+    &tinyjambu192_session_cipher,
+    &tinyjambu256_session_cipher,
     0
 };
 
@@ -149,6 +937,12 @@ static const aead_hash_algorithm_t *const hashes[] = {
 /* List of all authentication algorithms that we can run KAT tests for */
 static const aead_auth_algorithm_t *const auths[] = {
     &tinyjambu_hmac_auth,
+    &tinyjambu_kbkdf_auth,
+    &tinyjambu_128_mac_auth,
+    &tinyjambu_192_mac_auth,
+    &tinyjambu_256_mac_auth,
+    &tinyjambu_pmac_auth,
+    &tinyjambu_prf64_auth,
     0
 };
 
@@ -29,6 +29,7 @@
 #include "timing.h"
 #include "internal-chachapoly.h"
 #include "internal-blake2s.h"
+#include "TinyJAMBU.h"
 
 /* Dynamically-allocated test string that was converted from hexadecimal */
 typedef struct {
@@ -560,6 +561,8 @@ static perf_timer_t perf_cipher_encrypt_decrypt
     int count;
     int loops;
     int bytes;
+    unsigned char *pk = 0;
+    const unsigned char *actual_key = key;
 
     /* Print what we are doing now */
     if (report) {
@@ -577,7 +580,14 @@ static perf_timer_t perf_cipher_encrypt_decrypt
         plen = 1024;
     else
         plen = 16;
-    alg->encrypt(ciphertext, &clen, plaintext, plen, 0, 0, nonce, key);
+    if (alg->pk_state_len) {
+        pk = malloc(alg->pk_state_len);
+        if (!pk)
+            exit(2);
+        (*(alg->pk_init))(pk, key);
+        actual_key = pk;
+    }
+    alg->encrypt(ciphertext, &clen, plaintext, plen, 0, 0, nonce, actual_key);
 
     /* Run several loops without timing to force the CPU
      * to load the code and data into internal cache to get
@@ -586,7 +596,7 @@ static perf_timer_t perf_cipher_encrypt_decrypt
     case MODE_ENC128:
         for (count = 0; count < PERF_LOOPS_WARMUP; ++count) {
             alg->encrypt
-                (ciphertext, &len, plaintext, plen, 0, 0, nonce, key);
+                (ciphertext, &len, plaintext, plen, 0, 0, nonce, actual_key);
         }
         ref_time = cipher_ref_metrics.encrypt_128;
         break;
@@ -594,7 +604,7 @@ static perf_timer_t perf_cipher_encrypt_decrypt
     case MODE_DEC128:
         for (count = 0; count < PERF_LOOPS_WARMUP; ++count) {
             alg->decrypt
-                (plaintext, &len, ciphertext, clen, 0, 0, nonce, key);
+                (plaintext, &len, ciphertext, clen, 0, 0, nonce, actual_key);
         }
         ref_time = cipher_ref_metrics.decrypt_128;
         break;
@@ -602,7 +612,7 @@ static perf_timer_t perf_cipher_encrypt_decrypt
     case MODE_ENC16:
         for (count = 0; count < PERF_LOOPS_WARMUP; ++count) {
             alg->encrypt
-                (ciphertext, &len, plaintext, plen, 0, 0, nonce, key);
+                (ciphertext, &len, plaintext, plen, 0, 0, nonce, actual_key);
         }
         ref_time = cipher_ref_metrics.encrypt_16;
         break;
@@ -610,7 +620,7 @@ static perf_timer_t perf_cipher_encrypt_decrypt
     case MODE_DEC16:
         for (count = 0; count < PERF_LOOPS_WARMUP; ++count) {
             alg->decrypt
-                (plaintext, &len, ciphertext, clen, 0, 0, nonce, key);
+                (plaintext, &len, ciphertext, clen, 0, 0, nonce, actual_key);
         }
         ref_time = cipher_ref_metrics.decrypt_16;
         break;
@@ -618,7 +628,7 @@ static perf_timer_t perf_cipher_encrypt_decrypt
     case MODE_ENC1024:
         for (count = 0; count < PERF_LOOPS_WARMUP; ++count) {
             alg->encrypt
-                (ciphertext, &len, plaintext, plen, 0, 0, nonce, key);
+                (ciphertext, &len, plaintext, plen, 0, 0, nonce, actual_key);
         }
         ref_time = cipher_ref_metrics.encrypt_1024;
         break;
@@ -626,7 +636,7 @@ static perf_timer_t perf_cipher_encrypt_decrypt
     case MODE_DEC1024:
         for (count = 0; count < PERF_LOOPS_WARMUP; ++count) {
             alg->decrypt
-                (plaintext, &len, ciphertext, clen, 0, 0, nonce, key);
+                (plaintext, &len, ciphertext, clen, 0, 0, nonce, actual_key);
         }
         ref_time = cipher_ref_metrics.decrypt_1024;
         break;
@@ -644,17 +654,21 @@ static perf_timer_t perf_cipher_encrypt_decrypt
         start = perf_timer_get_time();
         for (count = 0; count < loops; ++count) {
             alg->encrypt
-                (ciphertext, &len, plaintext, plen, 0, 0, nonce, key);
+                (ciphertext, &len, plaintext, plen, 0, 0, nonce, actual_key);
         }
         elapsed = perf_timer_get_time() - start;
     } else {
         start = perf_timer_get_time();
         for (count = 0; count < loops; ++count) {
             alg->decrypt
-                (plaintext, &len, ciphertext, clen, 0, 0, nonce, key);
+                (plaintext, &len, ciphertext, clen, 0, 0, nonce, actual_key);
         }
         elapsed = perf_timer_get_time() - start;
     }
+    if (pk) {
+        (*(alg->pk_free))(pk);
+        free(pk);
+    }
 
     /* Report the results */
     if (report) {
@@ -1093,14 +1107,344 @@ static int test_auth(const aead_auth_algorithm_t *alg, FILE *file)
     return fail != 0;
 }
 
+#define MAX_AUTH_KEY_SIZE 64
+#define MAX_AUTH_TAG_SIZE 64
+#define MAX_AUTH_DATA_SIZE 1024
+#define PERF_AUTH_LOOPS 100000
+
+/* Generate performance metrics for an authentication algorithm on
+ * inputs of a specific size.  Short inputs are typical for keyed hash
+ * table lookups, so the time per operation is reported as well */
+static void perf_auth_N(const aead_auth_algorithm_t *alg, int size)
+{
+    unsigned char key[MAX_AUTH_KEY_SIZE];
+    unsigned char data[MAX_AUTH_DATA_SIZE];
+    unsigned char tag[MAX_AUTH_TAG_SIZE];
+    perf_timer_t start, elapsed;
+    perf_timer_t ticks_per_second = perf_timer_ticks_per_second();
+    size_t tag_len = alg->tag_len;
+    int count;
+    int loops;
+
+    /* Print what we are doing now */
+    printf("   auth %4d bytes ... ", size);
+    fflush(stdout);
+
+    /* Initialize the key and the input buffer */
+    for (count = 0; count < MAX_AUTH_KEY_SIZE; ++count)
+        key[count] = (unsigned char)(count + 0x40);
+    for (count = 0; count < MAX_AUTH_DATA_SIZE; ++count)
+        data[count] = (unsigned char)count;
+    if (tag_len > MAX_AUTH_TAG_SIZE)
+        tag_len = MAX_AUTH_TAG_SIZE;
+
+    /* Run several loops without timing to force the CPU
+     * to load the code and data into internal cache to get
+     * the best speed when we measure properly later. */
+    for (count = 0; count < PERF_LOOPS_WARMUP; ++count)
+        alg->compute(tag, tag_len, key, alg->key_len, data, size);
+
+    /* Determine how many loops to do; more on the smaller sizes */
+    if (size < 1024)
+        loops = PERF_AUTH_LOOPS * 4;
+    else
+        loops = PERF_AUTH_LOOPS;
+
+    /* Now measure the timing for real */
+    start = perf_timer_get_time();
+    for (count = 0; count < loops; ++count)
+        alg->compute(tag, tag_len, key, alg->key_len, data, size);
+    elapsed = perf_timer_get_time() - start;
+
+    /* Report the results */
+    printf("%.1f ns/op", (elapsed * 1000000000.0) / (loops * (double)ticks_per_second));
+    if (size > 0) {
+        printf(", %.3f ns/byte, %.3f MiB/sec",
+               (elapsed * 1000000000.0) / (size * (double)loops * ticks_per_second),
+               (size * (double)loops * ticks_per_second) / (elapsed * 1024.0 * 1024.0));
+    }
+    printf("\n");
+}
+
 /* Generate performance metrics for an authentication algorithm */
 static int perf_auth(const aead_auth_algorithm_t *alg)
 {
-    /* TODO */
-    (void)alg;
+    if (alg->key_len > MAX_AUTH_KEY_SIZE) {
+        fprintf(stderr, "%s: key is too large for performance testing\n",
+                alg->name);
+        return 1;
+    }
+    printf("%s:\n", alg->name);
+    perf_auth_N(alg, 1024);
+    perf_auth_N(alg, 128);
+    perf_auth_N(alg, 32);
+    perf_auth_N(alg, 16);
+    perf_auth_N(alg, 8);
+    printf("\n");
     return 0;
 }
 
+/* Number of passes over the KAT vectors for the asynchronous benchmark */
+#define ASYNC_PASSES 50
+
+/* Maximum number of outstanding jobs for the asynchronous benchmark */
+#define ASYNC_MAX_PENDING 256
+
+/* Asynchronous job for a KAT vector, along with the expected output */
+typedef struct
+{
+    tinyjambu_async_job_t job;
+    const test_string_t *expected;
+    unsigned char *out;
+
+} async_kat_job_t;
+
+/* Checks the output of an asynchronous job against the KAT vector */
+static void async_check_job(tinyjambu_async_job_t *job, int *fail)
+{
+    const async_kat_job_t *kjob = (const async_kat_job_t *)(job->user_data);
+    if (job->result != 0 || job->outlen != kjob->expected->size ||
+            memcmp(job->out, kjob->expected->data, job->outlen) != 0) {
+        ++(*fail);
+    }
+}
+
+/* Runs all of the KAT jobs through a worker pool and returns the time */
+static perf_timer_t async_run_jobs
+    (async_kat_job_t *jobs, size_t count, unsigned workers, int *fail)
+{
+    tinyjambu_async_pool_t *pool;
+    tinyjambu_async_job_t *job;
+    perf_timer_t start;
+    size_t index;
+    int pass;
+
+    pool = tinyjambu_async_create(workers, ASYNC_MAX_PENDING, 0);
+    if (!pool)
+        exit(2);
+    start = perf_timer_get_wall_time();
+    for (pass = 0; pass < ASYNC_PASSES; ++pass) {
+        for (index = 0; index < count; ++index) {
+            /* Collect completed jobs when the pool applies backpressure */
+            while (tinyjambu_async_submit(pool, &(jobs[index].job)) != 0) {
+                job = tinyjambu_async_wait(pool);
+                if (job)
+                    async_check_job(job, fail);
+            }
+            while ((job = tinyjambu_async_poll(pool)) != 0)
+                async_check_job(job, fail);
+        }
+    }
+    while ((job = tinyjambu_async_wait(pool)) != 0)
+        async_check_job(job, fail);
+    start = perf_timer_get_wall_time() - start;
+    tinyjambu_async_destroy(pool);
+    return start;
+}
+
+/* Benchmarks the asynchronous worker pool on the KAT vectors for an
+ * algorithm with increasing numbers of workers.  Each KAT vector is
+ * submitted as a separate job and the outputs are checked */
+static int perf_async
+    (const char *name, const aead_cipher_t *cipher,
+     const aead_hash_algorithm_t *hash, FILE *file)
+{
+    static unsigned const workers[] = {0, 1, 2, 4, 8};
+    perf_timer_t ticks_per_second = perf_timer_ticks_per_second();
+    perf_timer_t elapsed, ref_time = 0;
+    test_vector_t *vecs = 0;
+    async_kat_job_t *jobs = 0;
+    size_t count = 0;
+    size_t max_count = 0;
+    size_t index;
+    unsigned windex;
+    int fail = 0;
+
+    /* Read all of the KAT vectors and convert them into jobs */
+    for (;;) {
+        if (count >= max_count) {
+            max_count += 256;
+            vecs = (test_vector_t *)realloc
+                (vecs, max_count * sizeof(test_vector_t));
+            if (!vecs)
+                exit(2);
+        }
+        if (!test_vector_read(&vecs[count], file))
+            break;
+        ++count;
+    }
+    jobs = (async_kat_job_t *)calloc(count ? count : 1, sizeof(async_kat_job_t));
+    if (!jobs)
+        exit(2);
+    for (index = 0; index < count; ++index) {
+        const test_vector_t *vec = &vecs[index];
+        tinyjambu_async_job_t *job = &(jobs[index].job);
+        const test_string_t *in;
+        if (cipher) {
+            job->op = strstr(name, "-SIV") ? TINYJAMBU_ASYNC_SIV_ENCRYPT
+                                           : TINYJAMBU_ASYNC_AEAD_ENCRYPT;
+            job->key = get_test_string(vec, "Key")->data;
+            job->keylen = cipher->key_len;
+            job->npub = get_test_string(vec, "Nonce")->data;
+            job->ad = get_test_string(vec, "AD")->data;
+            job->adlen = get_test_string(vec, "AD")->size;
+            in = get_test_string(vec, "PT");
+            jobs[index].expected = get_test_string(vec, "CT");
+        } else if (hash) {
+            job->op = TINYJAMBU_ASYNC_HASH;
+            in = get_test_string(vec, "Msg");
+            jobs[index].expected = get_test_string(vec, "MD");
+        } else {
+            job->op = TINYJAMBU_ASYNC_HMAC;
+            job->key = get_test_string(vec, "Key")->data;
+            job->keylen = get_test_string(vec, "Key")->size;
+            in = get_test_string(vec, "Msg");
+            jobs[index].expected = get_test_string(vec, "Tag");
+        }
+        job->in = in->data;
+        job->inlen = in->size;
+        jobs[index].out = (unsigned char *)malloc
+            (jobs[index].expected->size + 1);
+        if (!jobs[index].out)
+            exit(2);
+        job->out = jobs[index].out;
+        job->user_data = &(jobs[index]);
+    }
+
+    /* Run the jobs with increasing numbers of workers.  Zero workers
+     * runs the jobs synchronously on the submitting thread */
+    printf("%s, %d jobs:\n", name, (int)(count * ASYNC_PASSES));
+    for (windex = 0; windex < sizeof(workers) / sizeof(workers[0]); ++windex) {
+        printf("   %u workers ... ", workers[windex]);
+        fflush(stdout);
+        elapsed = async_run_jobs(jobs, count, workers[windex], &fail);
+        if (elapsed <= 0)
+            elapsed = 1;
+        if (!windex)
+            ref_time = elapsed;
+        printf("%.0f jobs/sec, %.2fx\n",
+               (count * (double)ASYNC_PASSES * ticks_per_second) / elapsed,
+               ((double)ref_time) / elapsed);
+    }
+    if (fail)
+        printf("%s: %d async jobs failed\n", name, fail);
+    printf("\n");
+
+    /* Clean up */
+    for (index = 0; index < count; ++index) {
+        free(jobs[index].out);
+        test_vector_free(&vecs[index]);
+    }
+    free(jobs);
+    free(vecs);
+    return fail != 0;
+}
+
+/* Number of sectors in each batch for the sector benchmark */
+#define SECTOR_BATCH 256
+
+/* Number of passes over the batch for the sector benchmark */
+#define SECTOR_PASSES 8
+
+/* Benchmarks TinyJAMBU-128-SIV sector encryption for a sector size,
+ * comparing one call per sector against batches across lanes and threads */
+static int perf_sectors_N(size_t sector_size)
+{
+    static unsigned const threads[] = {1, 2, 4, 8};
+    perf_timer_t ticks_per_second = perf_timer_ticks_per_second();
+    perf_timer_t start, elapsed, ref_time;
+    unsigned char key[TINYJAMBU_128_KEY_SIZE];
+    unsigned char nonce[TINYJAMBU_NONCE_SIZE];
+    unsigned char *m = (unsigned char *)malloc(SECTOR_BATCH * sector_size);
+    unsigned char *c = (unsigned char *)malloc(SECTOR_BATCH * sector_size);
+    unsigned char *tags = (unsigned char *)malloc
+        (SECTOR_BATCH * TINYJAMBU_TAG_SIZE);
+    double total = (double)SECTOR_BATCH * SECTOR_PASSES;
+    size_t index;
+    unsigned tindex;
+    int pass;
+    int fail = 0;
+
+    if (!m || !c || !tags)
+        exit(2);
+    for (index = 0; index < sizeof(key); ++index)
+        key[index] = (unsigned char)index;
+    for (index = 0; index < SECTOR_BATCH * sector_size; ++index)
+        m[index] = (unsigned char)(index * 7);
+
+    /* Reference: encrypt each sector with a separate call */
+    printf("   %4d byte sectors, one call per sector ... ", (int)sector_size);
+    fflush(stdout);
+    start = perf_timer_get_wall_time();
+    for (pass = 0; pass < SECTOR_PASSES; ++pass) {
+        for (index = 0; index < SECTOR_BATCH; ++index) {
+            tinyjambu_128_siv_sector_nonce(nonce, index);
+            tinyjambu_128_siv_encrypt_detached
+                (c + index * sector_size, tags + index * TINYJAMBU_TAG_SIZE,
+                 m + index * sector_size, sector_size, 0, 0, nonce, key);
+        }
+    }
+    ref_time = perf_timer_get_wall_time() - start;
+    if (ref_time <= 0)
+        ref_time = 1;
+    printf("%.0f sectors/sec\n", (total * ticks_per_second) / ref_time);
+
+    /* Batched encryption and decryption with increasing thread counts */
+    for (tindex = 0; tindex < sizeof(threads) / sizeof(threads[0]);
+            ++tindex) {
+        printf("   %4d byte sectors, batch, %u threads ... ",
+               (int)sector_size, threads[tindex]);
+        fflush(stdout);
+        start = perf_timer_get_wall_time();
+        for (pass = 0; pass < SECTOR_PASSES; ++pass) {
+            tinyjambu_128_siv_encrypt_sectors
+                (c, tags, m, sector_size, 0, SECTOR_BATCH,
+                 key, threads[tindex]);
+        }
+        elapsed = perf_timer_get_wall_time() - start;
+        if (elapsed <= 0)
+            elapsed = 1;
+        printf("encrypt %.0f sectors/sec, %.2fx",
+               (total * ticks_per_second) / elapsed,
+               ((double)ref_time) / elapsed);
+        start = perf_timer_get_wall_time();
+        for (pass = 0; pass < SECTOR_PASSES; ++pass) {
+            if (tinyjambu_128_siv_decrypt_sectors
+                    (c, c, tags, sector_size, 0, SECTOR_BATCH,
+                     key, threads[tindex]) != 0) {
+                ++fail;
+            }
+            tinyjambu_128_siv_encrypt_sectors
+                (c, tags, c, sector_size, 0, SECTOR_BATCH,
+                 key, threads[tindex]);
+        }
+        elapsed = perf_timer_get_wall_time() - start;
+        if (elapsed <= 0)
+            elapsed = 1;
+        printf(", decrypt+encrypt %.0f sectors/sec\n",
+               (total * ticks_per_second) / elapsed);
+    }
+
+    free(m);
+    free(c);
+    free(tags);
+    return fail;
+}
+
+/* Benchmarks TinyJAMBU-128-SIV sector encryption in sectors per second */
+static int perf_sectors(void)
+{
+    int fail = 0;
+    printf("TinyJAMBU-128-SIV sectors:\n");
+    fail += perf_sectors_N(512);
+    fail += perf_sectors_N(1024);
+    fail += perf_sectors_N(4096);
+    if (fail)
+        printf("TinyJAMBU-128-SIV: %d sector batches failed\n", fail);
+    printf("\n");
+    return fail != 0;
+}
+
 int main(int argc, char *argv[])
 {
     const char *progname = argv[0];
@@ -1117,9 +1461,19 @@ int main(int argc, char *argv[])
         return 0;
     }
 
+    /* If "--sectors" is supplied, then benchmark the sector engine */
+    if (argc > 1 && !strcmp(argv[1], "--sectors")) {
+        if (!perf_timer_init()) {
+            fprintf(stderr, "%s: do not know how to time events on this system\n", progname);
+            return 1;
+        }
+        return perf_sectors();
+    }
+
     /* Check that we have all command-line arguments that we need */
-    if (argc > 3 && !strcmp(argv[1], "--performance")) {
-        performance = 1;
+    if (argc > 3 && (!strcmp(argv[1], "--performance") ||
+                     !strcmp(argv[1], "--async"))) {
+        performance = !strcmp(argv[1], "--async") ? 2 : 1;
         if (!perf_timer_init()) {
             fprintf(stderr, "%s: do not know how to time events on this system\n", progname);
             return 1;
@@ -1140,6 +1494,23 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    /* Benchmark the asynchronous worker pool if requested */
+    if (performance == 2) {
+        cipher = find_cipher(argv[1]);
+        hash = find_hash_algorithm(argv[1]);
+        if ((cipher && !strstr(argv[1], "-STREAM") &&
+                !strstr(argv[1], "-Session")) || hash ||
+                !strcmp(argv[1], "TinyJAMBU-HMAC")) {
+            exit_val = perf_async(argv[1], cipher, hash, file);
+        } else {
+            fprintf(stderr, "%s: not supported by the async API\n", argv[1]);
+            exit_val = 1;
+        }
+        if (file != stdin)
+            fclose(file);
+        return exit_val;
+    }
+
     /* Look for a cipher with the specified name */
     cipher = find_cipher(argv[1]);
     if (cipher) {
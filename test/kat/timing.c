@@ -71,6 +71,17 @@ perf_timer_t perf_timer_get_time(void)
 #endif
 }
 
+perf_timer_t perf_timer_get_wall_time(void)
+{
+#if PERF_TIMER == PERF_TIMER_CLOCK_GETTIME && defined(CLOCK_MONOTONIC)
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return tv.tv_sec * 1000000000LL + tv.tv_nsec;
+#else
+    return perf_timer_get_time();
+#endif
+}
+
 perf_timer_t perf_timer_ticks_per_second(void)
 {
 #if PERF_TIMER == PERF_TIMER_CLOCK_GETTIME
@@ -60,4 +60,14 @@ perf_timer_t perf_timer_get_time(void);
  */
 perf_timer_t perf_timer_ticks_per_second(void);
 
+/**
+ * \brief Gets the elapsed wall-clock time.
+ *
+ * \return The timer value, in the same units as perf_timer_get_time().
+ *
+ * This is used when measuring work that is spread across multiple
+ * threads, where the CPU time of the calling thread is not meaningful.
+ */
+perf_timer_t perf_timer_get_wall_time(void);
+
 #endif
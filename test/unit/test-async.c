@@ -0,0 +1,295 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TinyJAMBU.h"
+#include "test-cipher.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define NUM_JOBS 64
+#define MAX_DATA_LEN 200
+#define AD_LEN 9
+
+typedef struct
+{
+    tinyjambu_async_job_t job;
+    unsigned char key[32];
+    unsigned char npub[TINYJAMBU_NONCE_SIZE];
+    unsigned char ad[AD_LEN];
+    unsigned char in[MAX_DATA_LEN + TINYJAMBU_TAG_SIZE];
+    unsigned char out[MAX_DATA_LEN + TINYJAMBU_HASH_SIZE];
+    unsigned char expected[MAX_DATA_LEN + TINYJAMBU_HASH_SIZE];
+    size_t expected_len;
+    int expected_result;
+    int done;
+
+} TestAsyncJob;
+
+static TestAsyncJob jobs[NUM_JOBS];
+
+/* Sets up a job with a mixture of operations and lengths */
+static void setup_job(TestAsyncJob *job, int index)
+{
+    static size_t const key_sizes[3] = {16, 24, 32};
+    int op = index % 6;
+    size_t keylen = key_sizes[(index / 6) % 3];
+    size_t inlen = (index * 29) % MAX_DATA_LEN;
+    size_t posn;
+
+    memset(job, 0, sizeof(TestAsyncJob));
+    for (posn = 0; posn < sizeof(job->key); ++posn)
+        job->key[posn] = (unsigned char)(index + posn * 7);
+    for (posn = 0; posn < sizeof(job->npub); ++posn)
+        job->npub[posn] = (unsigned char)(index * 3 + posn);
+    for (posn = 0; posn < sizeof(job->ad); ++posn)
+        job->ad[posn] = (unsigned char)(index ^ posn);
+    for (posn = 0; posn < inlen; ++posn)
+        job->in[posn] = (unsigned char)(index * 5 + posn * 11);
+
+    /* Compute the expected output directly */
+    job->expected_result = 0;
+    switch (op) {
+    case TINYJAMBU_ASYNC_AEAD_ENCRYPT:
+    case TINYJAMBU_ASYNC_AEAD_DECRYPT:
+        if (keylen == 16) {
+            tinyjambu_128_aead_encrypt
+                (job->expected, &(job->expected_len), job->in, inlen,
+                 job->ad, AD_LEN, job->npub, job->key);
+        } else if (keylen == 24) {
+            tinyjambu_192_aead_encrypt
+                (job->expected, &(job->expected_len), job->in, inlen,
+                 job->ad, AD_LEN, job->npub, job->key);
+        } else {
+            tinyjambu_256_aead_encrypt
+                (job->expected, &(job->expected_len), job->in, inlen,
+                 job->ad, AD_LEN, job->npub, job->key);
+        }
+        break;
+
+    case TINYJAMBU_ASYNC_SIV_ENCRYPT:
+    case TINYJAMBU_ASYNC_SIV_DECRYPT:
+        if (keylen == 16) {
+            tinyjambu_128_siv_encrypt
+                (job->expected, &(job->expected_len), job->in, inlen,
+                 job->ad, AD_LEN, job->npub, job->key);
+        } else if (keylen == 24) {
+            tinyjambu_192_siv_encrypt
+                (job->expected, &(job->expected_len), job->in, inlen,
+                 job->ad, AD_LEN, job->npub, job->key);
+        } else {
+            tinyjambu_256_siv_encrypt
+                (job->expected, &(job->expected_len), job->in, inlen,
+                 job->ad, AD_LEN, job->npub, job->key);
+        }
+        break;
+
+    case TINYJAMBU_ASYNC_HASH:
+        tinyjambu_hash(job->expected, job->in, inlen);
+        job->expected_len = TINYJAMBU_HASH_SIZE;
+        break;
+
+    case TINYJAMBU_ASYNC_HMAC:
+        tinyjambu_hmac(job->expected, job->key, keylen, job->in, inlen);
+        job->expected_len = TINYJAMBU_HMAC_SIZE;
+        break;
+    }
+
+    /* Decryption jobs swap the plaintext and ciphertext around */
+    if (op == TINYJAMBU_ASYNC_AEAD_DECRYPT ||
+            op == TINYJAMBU_ASYNC_SIV_DECRYPT) {
+        unsigned char temp[MAX_DATA_LEN + TINYJAMBU_TAG_SIZE];
+        memcpy(temp, job->in, inlen);
+        memcpy(job->in, job->expected, job->expected_len);
+        memcpy(job->expected, temp, inlen);
+        job->expected_len = inlen;
+        inlen += TINYJAMBU_TAG_SIZE;
+        if ((index % 7) == 3) {
+            /* Corrupt the tag; the plaintext should come back as zeroes */
+            job->in[inlen - 1] ^= 0x01;
+            memset(job->expected, 0, job->expected_len);
+            job->expected_result = -1;
+        }
+    }
+
+    /* Every so often, make the job invalid with a bad key size */
+    if (op != TINYJAMBU_ASYNC_HASH && op != TINYJAMBU_ASYNC_HMAC &&
+            (index % 11) == 10) {
+        keylen = 20;
+        job->expected_len = 0;
+        job->expected_result = -1;
+    }
+
+    job->job.op = op;
+    job->job.key = job->key;
+    job->job.keylen = keylen;
+    job->job.npub = job->npub;
+    job->job.ad = job->ad;
+    job->job.adlen = AD_LEN;
+    job->job.in = job->in;
+    job->job.inlen = inlen;
+    job->job.out = job->out;
+    job->job.user_data = job;
+    job->job.result = 99;
+}
+
+/* Checks the results of a completed job */
+static int check_job(const TestAsyncJob *job)
+{
+    if (job->done != 1)
+        return 0;
+    if (job->job.result != job->expected_result)
+        return 0;
+    if (job->job.outlen != job->expected_len)
+        return 0;
+    return memcmp(job->out, job->expected, job->expected_len) == 0;
+}
+
+static void job_done(tinyjambu_async_job_t *job)
+{
+    ++(((TestAsyncJob *)(job->user_data))->done);
+}
+
+static void test_pool(unsigned workers, int use_callback)
+{
+    tinyjambu_async_pool_t *pool;
+    tinyjambu_async_job_t *job;
+    int index;
+    int ok = 1;
+
+    printf("Async pool, %u workers, %s ... ", workers,
+           use_callback ? "callback" : "poll");
+    fflush(stdout);
+
+    for (index = 0; index < NUM_JOBS; ++index)
+        setup_job(&jobs[index], index);
+
+    pool = tinyjambu_async_create
+        (workers, NUM_JOBS, use_callback ? job_done : 0);
+    if (!pool) {
+        printf("failed to create\n");
+        test_exit_result = 1;
+        return;
+    }
+    for (index = 0; index < NUM_JOBS; ++index) {
+        if (tinyjambu_async_submit(pool, &(jobs[index].job)) != 0)
+            ok = 0;
+    }
+    if (use_callback) {
+        tinyjambu_async_drain(pool);
+        if (tinyjambu_async_wait(pool) != 0)
+            ok = 0;
+    } else {
+        while ((job = tinyjambu_async_wait(pool)) != 0)
+            job_done(job);
+    }
+    if (tinyjambu_async_pending(pool) != 0)
+        ok = 0;
+    for (index = 0; index < NUM_JOBS; ++index) {
+        if (!check_job(&jobs[index]))
+            ok = 0;
+    }
+    tinyjambu_async_destroy(pool);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+static void test_backpressure(unsigned workers)
+{
+    tinyjambu_async_pool_t *pool;
+    tinyjambu_async_job_t *job;
+    int index;
+    int ok = 1;
+
+    printf("Async pool, %u workers, backpressure ... ", workers);
+    fflush(stdout);
+
+    for (index = 0; index < 5; ++index)
+        setup_job(&jobs[index], index);
+
+    pool = tinyjambu_async_create(workers, 4, 0);
+    if (!pool) {
+        printf("failed to create\n");
+        test_exit_result = 1;
+        return;
+    }
+
+    /* The fifth job is rejected until an earlier job has been polled */
+    for (index = 0; index < 4; ++index) {
+        if (tinyjambu_async_submit(pool, &(jobs[index].job)) != 0)
+            ok = 0;
+    }
+    if (tinyjambu_async_pending(pool) != 4)
+        ok = 0;
+    if (tinyjambu_async_submit(pool, &(jobs[4].job)) != -1)
+        ok = 0;
+    tinyjambu_async_drain(pool);
+    if (tinyjambu_async_submit(pool, &(jobs[4].job)) != -1)
+        ok = 0;
+    job = tinyjambu_async_poll(pool);
+    if (!job)
+        ok = 0;
+    else
+        job_done(job);
+    if (tinyjambu_async_submit(pool, &(jobs[4].job)) != 0)
+        ok = 0;
+    while ((job = tinyjambu_async_wait(pool)) != 0)
+        job_done(job);
+    if (tinyjambu_async_poll(pool) != 0)
+        ok = 0;
+    for (index = 0; index < 5; ++index) {
+        if (!check_job(&jobs[index]))
+            ok = 0;
+    }
+    tinyjambu_async_destroy(pool);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    test_pool(0, 0);
+    test_pool(0, 1);
+    test_pool(1, 0);
+    test_pool(1, 1);
+    test_pool(4, 0);
+    test_pool(4, 1);
+    test_backpressure(0);
+    test_backpressure(2);
+
+    /* Destroying a NULL pool does nothing */
+    tinyjambu_async_destroy(0);
+    return test_exit_result;
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TinyJAMBU.h"
+#include "test-cipher.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define MAX_DATA_LEN 67
+#define AD_LEN 5
+
+typedef void (*encrypt_t)
+    (unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k);
+typedef void (*encrypt_detached_t)
+    (unsigned char *c, unsigned char *tag,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k);
+typedef int (*decrypt_detached_t)
+    (unsigned char *m,
+     const unsigned char *c, size_t clen,
+     const unsigned char *tag,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k);
+
+typedef struct
+{
+    const char *name;
+    encrypt_t encrypt;
+    encrypt_detached_t encrypt_detached;
+    decrypt_detached_t decrypt_detached;
+
+} TestDetachedCipher;
+
+static TestDetachedCipher const ciphers[] = {
+    {"TinyJAMBU-128", tinyjambu_128_aead_encrypt,
+     tinyjambu_128_aead_encrypt_detached, tinyjambu_128_aead_decrypt_detached},
+    {"TinyJAMBU-192", tinyjambu_192_aead_encrypt,
+     tinyjambu_192_aead_encrypt_detached, tinyjambu_192_aead_decrypt_detached},
+    {"TinyJAMBU-256", tinyjambu_256_aead_encrypt,
+     tinyjambu_256_aead_encrypt_detached, tinyjambu_256_aead_decrypt_detached},
+    {"TinyJAMBU-128-SIV", tinyjambu_128_siv_encrypt,
+     tinyjambu_128_siv_encrypt_detached, tinyjambu_128_siv_decrypt_detached},
+    {"TinyJAMBU-192-SIV", tinyjambu_192_siv_encrypt,
+     tinyjambu_192_siv_encrypt_detached, tinyjambu_192_siv_decrypt_detached},
+    {"TinyJAMBU-256-SIV", tinyjambu_256_siv_encrypt,
+     tinyjambu_256_siv_encrypt_detached, tinyjambu_256_siv_decrypt_detached},
+    {0, 0, 0, 0}
+};
+
+static void test_detached(const TestDetachedCipher *cipher)
+{
+    unsigned char k[32];
+    unsigned char npub[TINYJAMBU_NONCE_SIZE];
+    unsigned char ad[AD_LEN];
+    unsigned char m[MAX_DATA_LEN];
+    unsigned char expected[MAX_DATA_LEN + TINYJAMBU_TAG_SIZE];
+    unsigned char buf[MAX_DATA_LEN];
+    unsigned char tag[TINYJAMBU_TAG_SIZE];
+    size_t mlen, clen, posn;
+    int ok = 1;
+
+    printf("%s detached ... ", cipher->name);
+    fflush(stdout);
+
+    for (posn = 0; posn < sizeof(k); ++posn)
+        k[posn] = (unsigned char)(posn * 3 + 1);
+    for (posn = 0; posn < sizeof(npub); ++posn)
+        npub[posn] = (unsigned char)(0xA0 + posn);
+    for (posn = 0; posn < sizeof(ad); ++posn)
+        ad[posn] = (unsigned char)(0x50 + posn);
+    for (posn = 0; posn < sizeof(m); ++posn)
+        m[posn] = (unsigned char)(posn * 11);
+
+    for (mlen = 0; mlen <= MAX_DATA_LEN && ok; ++mlen) {
+        /* The combined API produces the reference output */
+        (*(cipher->encrypt))(expected, &clen, m, mlen, ad, AD_LEN, npub, k);
+
+        /* Encrypt in-place with a separate tag */
+        memcpy(buf, m, mlen);
+        memset(tag, 0xAA, sizeof(tag));
+        (*(cipher->encrypt_detached))(buf, tag, buf, mlen, ad, AD_LEN, npub, k);
+        if (test_memcmp(buf, expected, mlen) != 0 ||
+                test_memcmp(tag, expected + mlen, sizeof(tag)) != 0) {
+            ok = 0;
+            break;
+        }
+
+        /* Decrypt in-place with a separate tag */
+        if ((*(cipher->decrypt_detached))
+                (buf, buf, mlen, tag, ad, AD_LEN, npub, k) != 0 ||
+                test_memcmp(buf, m, mlen) != 0) {
+            ok = 0;
+            break;
+        }
+
+        /* Decryption with a bad tag must fail and zero the plaintext */
+        memcpy(buf, expected, mlen);
+        tag[mlen % TINYJAMBU_TAG_SIZE] ^= 0x10;
+        if ((*(cipher->decrypt_detached))
+                (buf, buf, mlen, tag, ad, AD_LEN, npub, k) != -1) {
+            ok = 0;
+            break;
+        }
+        for (posn = 0; posn < mlen; ++posn) {
+            if (buf[posn] != 0)
+                ok = 0;
+        }
+    }
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int index;
+
+    (void)argc;
+    (void)argv;
+
+    for (index = 0; ciphers[index].name; ++index)
+        test_detached(&ciphers[index]);
+
+    return test_exit_result;
+}
@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TinyJAMBU.h"
+#include "test-cipher.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define NUM_VALUES 1000
+#define MAX_VALUE_LEN 24
+#define TABLE_SLOTS 4096
+
+static unsigned char const key[TINYJAMBU_128_KEY_SIZE] = {
+    0x0F, 0x1E, 0x2D, 0x3C, 0x4B, 0x5A, 0x69, 0x78,
+    0x87, 0x96, 0xA5, 0xB4, 0xC3, 0xD2, 0xE1, 0xF0
+};
+
+static unsigned char const column_name[] = "customers.email";
+
+static unsigned char value_data[NUM_VALUES][MAX_VALUE_LEN];
+static const unsigned char *values[NUM_VALUES];
+static size_t lens[NUM_VALUES];
+
+/* Formats values of varying lengths so that the lanes get out of step */
+static void make_values(void)
+{
+    size_t index;
+    for (index = 0; index < NUM_VALUES; ++index) {
+        lens[index] = (size_t)sprintf
+            ((char *)(value_data[index]), "user%d@%.*s", (int)index,
+             (int)(index % 9), "example.com");
+        values[index] = value_data[index];
+    }
+}
+
+static void test_column(void)
+{
+    static unsigned char const nonce[TINYJAMBU_NONCE_SIZE] = {0};
+    tinyjambu_128_column_t column;
+    unsigned char m[48];
+    unsigned char c1[48 + TINYJAMBU_TAG_SIZE];
+    unsigned char c2[48 + TINYJAMBU_TAG_SIZE];
+    unsigned char tags[12 * TINYJAMBU_TAG_SIZE];
+    const unsigned char *ptrs[12];
+    size_t sizes[12];
+    size_t len, clen1, clen2, mlen, posn;
+    int ok = 1;
+
+    printf("TinyJAMBU-128 deterministic column encryption ... ");
+    fflush(stdout);
+
+    for (posn = 0; posn < sizeof(m); ++posn)
+        m[posn] = (unsigned char)(posn * 29 + 3);
+    tinyjambu_128_column_init
+        (&column, key, column_name, sizeof(column_name) - 1);
+
+    for (len = 0; len <= sizeof(m); ++len) {
+        /* Must match regular SIV with the column name as associated data */
+        tinyjambu_128_siv_encrypt
+            (c1, &clen1, m, len, column_name, sizeof(column_name) - 1,
+             nonce, key);
+        tinyjambu_128_column_encrypt(&column, c2, &clen2, m, len);
+        if (clen1 != clen2 || memcmp(c1, c2, clen1) != 0)
+            ok = 0;
+
+        /* In-place encryption */
+        memcpy(c2, m, len);
+        tinyjambu_128_column_encrypt(&column, c2, &clen2, c2, len);
+        if (clen1 != clen2 || memcmp(c1, c2, clen1) != 0)
+            ok = 0;
+
+        /* Decryption, including in-place */
+        if (tinyjambu_128_column_decrypt(&column, c2, &mlen, c1, clen1) != 0)
+            ok = 0;
+        if (mlen != len || memcmp(c2, m, len) != 0)
+            ok = 0;
+        memcpy(c2, c1, clen1);
+        if (tinyjambu_128_column_decrypt(&column, c2, &mlen, c2, clen1) != 0)
+            ok = 0;
+        if (mlen != len || memcmp(c2, m, len) != 0)
+            ok = 0;
+
+        /* Tampering is detected */
+        memcpy(c2, c1, clen1);
+        c2[len / 2] ^= 0x01;
+        if (tinyjambu_128_column_decrypt(&column, c2, &mlen, c2, clen1) != -1)
+            ok = 0;
+    }
+
+    /* Batches of tags for values of different lengths */
+    for (len = 0; len < 12; ++len) {
+        ptrs[len] = m + len;
+        sizes[len] = (len * 7) % 23;
+    }
+    for (len = 0; len <= 12; ++len) {
+        memset(tags, 0xAA, sizeof(tags));
+        tinyjambu_128_column_tags(&column, tags, ptrs, sizes, len);
+        for (posn = 0; posn < len; ++posn) {
+            tinyjambu_128_column_encrypt
+                (&column, c1, &clen1, ptrs[posn], sizes[posn]);
+            if (memcmp(tags + posn * TINYJAMBU_TAG_SIZE,
+                       c1 + sizes[posn], TINYJAMBU_TAG_SIZE) != 0)
+                ok = 0;
+        }
+    }
+    if (tinyjambu_128_column_decrypt(&column, m, &mlen, c1, 7) != -1)
+        ok = 0;
+    tinyjambu_128_column_free(&column);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+static void test_index(void)
+{
+    tinyjambu_128_column_t column;
+    tinyjambu_128_column_t other;
+    tinyjambu_128_eqindex_t index;
+    unsigned char *table;
+    uint64_t rows[NUM_VALUES];
+    uint64_t found[NUM_VALUES];
+    unsigned char c[MAX_VALUE_LEN + TINYJAMBU_TAG_SIZE];
+    unsigned char small[5 * 16];
+    size_t posn, clen;
+    int ok = 1;
+
+    printf("TinyJAMBU-128 equality index ... ");
+    fflush(stdout);
+
+    table = (unsigned char *)malloc(TABLE_SLOTS * 16 + 7);
+    if (!table)
+        exit(2);
+    tinyjambu_128_column_init
+        (&column, key, column_name, sizeof(column_name) - 1);
+    tinyjambu_128_column_init
+        (&other, key, (const unsigned char *)"customers.name", 14);
+
+    /* Insert all of the values with a misaligned table */
+    if (tinyjambu_128_eqindex_init
+            (&index, &column, table + 1, TABLE_SLOTS * 16 + 6) != 0)
+        ok = 0;
+    for (posn = 0; posn < NUM_VALUES; ++posn)
+        rows[posn] = posn * 3 + 1;
+    if (tinyjambu_128_eqindex_insert
+            (&index, values, lens, rows, NUM_VALUES) != NUM_VALUES)
+        ok = 0;
+    if (tinyjambu_128_eqindex_count(&index) != NUM_VALUES)
+        ok = 0;
+
+    /* Every value can be found, either by plaintext or by ciphertext */
+    if (tinyjambu_128_eqindex_lookup
+            (&index, found, values, lens, NUM_VALUES) != NUM_VALUES)
+        ok = 0;
+    if (memcmp(found, rows, sizeof(rows)) != 0)
+        ok = 0;
+    for (posn = 0; posn < NUM_VALUES; posn += 37) {
+        tinyjambu_128_column_encrypt
+            (&column, c, &clen, values[posn], lens[posn]);
+        if (tinyjambu_128_eqindex_lookup_ciphertext(&index, c, clen)
+                != rows[posn])
+            ok = 0;
+
+        /* The same value encrypted for a different column is not found */
+        tinyjambu_128_column_encrypt
+            (&other, c, &clen, values[posn], lens[posn]);
+        if (tinyjambu_128_eqindex_lookup_ciphertext(&index, c, clen)
+                != TINYJAMBU_EQINDEX_NOT_FOUND)
+            ok = 0;
+    }
+
+    /* Re-inserting a value replaces its row */
+    rows[10] = 12345;
+    if (tinyjambu_128_eqindex_insert
+            (&index, values + 10, lens + 10, rows + 10, 1) != 1)
+        ok = 0;
+    if (tinyjambu_128_eqindex_count(&index) != NUM_VALUES)
+        ok = 0;
+
+    /* Remove every third value and check that the rest can be found */
+    for (posn = 0; posn < NUM_VALUES; posn += 3) {
+        if (tinyjambu_128_eqindex_remove(&index, values[posn], lens[posn])
+                != 0)
+            ok = 0;
+    }
+    if (tinyjambu_128_eqindex_remove(&index, values[0], lens[0]) != -1)
+        ok = 0;
+    if (tinyjambu_128_eqindex_count(&index) != NUM_VALUES - 334)
+        ok = 0;
+    if (tinyjambu_128_eqindex_lookup
+            (&index, found, values, lens, NUM_VALUES) != NUM_VALUES - 334)
+        ok = 0;
+    for (posn = 0; posn < NUM_VALUES; ++posn) {
+        if ((posn % 3) == 0) {
+            if (found[posn] != TINYJAMBU_EQINDEX_NOT_FOUND)
+                ok = 0;
+        } else if (found[posn] != rows[posn]) {
+            ok = 0;
+        }
+    }
+
+    /* A full table stops inserting and leaves one slot empty */
+    if (tinyjambu_128_eqindex_init(&index, &column, small, 15) != -1)
+        ok = 0;
+    if (tinyjambu_128_eqindex_init(&index, &column, small, sizeof(small))
+            != 0)
+        ok = 0;
+    if (tinyjambu_128_eqindex_insert(&index, values, lens, rows, 10) != 3)
+        ok = 0;
+    if (tinyjambu_128_eqindex_lookup(&index, found, values, lens, 10) != 3)
+        ok = 0;
+
+    tinyjambu_128_column_free(&column);
+    tinyjambu_128_column_free(&other);
+    free(table);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    make_values();
+    test_column();
+    test_index();
+    return test_exit_result;
+}
@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TinyJAMBU.h"
+#include "test-cipher.h"
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_MESSAGE_LEN 37
+
+typedef void (*aead_start_t)
+    (tinyjambu_aead_state_t *state,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k);
+
+typedef void (*aead_encrypt_detached_t)
+    (unsigned char *c, unsigned char *tag,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k);
+
+static unsigned char const key[TINYJAMBU_256_KEY_SIZE] = {
+    0x10, 0x21, 0x32, 0x43, 0x54, 0x65, 0x76, 0x87,
+    0x98, 0xA9, 0xBA, 0xCB, 0xDC, 0xED, 0xFE, 0x0F,
+    0x01, 0x12, 0x23, 0x34, 0x45, 0x56, 0x67, 0x78,
+    0x89, 0x9A, 0xAB, 0xBC, 0xCD, 0xDE, 0xEF, 0xF0
+};
+
+static unsigned char const nonce[TINYJAMBU_NONCE_SIZE] = {
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+    0x88, 0x99, 0xAA, 0xBB
+};
+
+static unsigned char const ad[5] = {0xA0, 0xA1, 0xA2, 0xA3, 0xA4};
+
+/* Checkpoints an incremental state and resumes it in a new object */
+static int checkpoint
+    (tinyjambu_aead_state_t *state, size_t keylen, uint64_t position)
+{
+    unsigned char saved[TINYJAMBU_AEAD_EXPORT_SIZE];
+    if (tinyjambu_aead_position(state) != position)
+        return 0;
+    tinyjambu_aead_export(state, saved);
+    tinyjambu_aead_free(state);
+    memset(state, 0xAA, sizeof(tinyjambu_aead_state_t));
+    if (tinyjambu_aead_import(state, saved, key, keylen) != 0)
+        return 0;
+    return tinyjambu_aead_position(state) == position;
+}
+
+static void test_resume
+    (const char *name, size_t keylen, aead_start_t start,
+     aead_encrypt_detached_t encrypt)
+{
+    tinyjambu_aead_state_t state;
+    unsigned char m[MAX_MESSAGE_LEN];
+    unsigned char c[MAX_MESSAGE_LEN];
+    unsigned char c2[MAX_MESSAGE_LEN];
+    unsigned char m2[MAX_MESSAGE_LEN];
+    unsigned char tag[TINYJAMBU_TAG_SIZE];
+    unsigned char tag2[TINYJAMBU_TAG_SIZE];
+    size_t len, split, posn;
+    int ok = 1;
+
+    printf("%s incremental checkpoint and resume ... ", name);
+    fflush(stdout);
+
+    for (posn = 0; posn < sizeof(m); ++posn)
+        m[posn] = (unsigned char)(posn * 11 + 1);
+
+    for (len = 0; len <= sizeof(m); ++len) {
+        (*encrypt)(c, tag, m, len, ad, sizeof(ad), nonce, key);
+        for (split = 0; split <= len; ++split) {
+            /* Encrypt, stopping at the split point to export and import */
+            memset(c2, 0xAA, sizeof(c2));
+            (*start)(&state, ad, sizeof(ad), nonce, key);
+            tinyjambu_aead_encrypt_update(&state, c2, m, split / 2);
+            tinyjambu_aead_encrypt_update
+                (&state, c2 + split / 2, m + split / 2, split - split / 2);
+            if (!checkpoint(&state, keylen, split))
+                ok = 0;
+            tinyjambu_aead_encrypt_update
+                (&state, c2 + split, m + split, len - split);
+            tinyjambu_aead_encrypt_finish(&state, tag2);
+            if (memcmp(c, c2, len) != 0 || memcmp(tag, tag2, sizeof(tag)) != 0)
+                ok = 0;
+
+            /* Decrypt in-place with a checkpoint at the same point */
+            memcpy(m2, c, len);
+            (*start)(&state, ad, sizeof(ad), nonce, key);
+            tinyjambu_aead_decrypt_update(&state, m2, m2, split);
+            if (!checkpoint(&state, keylen, split))
+                ok = 0;
+            tinyjambu_aead_decrypt_update
+                (&state, m2 + split, m2 + split, len - split);
+            if (tinyjambu_aead_decrypt_finish(&state, tag) != 0)
+                ok = 0;
+            if (memcmp(m, m2, len) != 0)
+                ok = 0;
+        }
+
+        /* A bad tag must be detected */
+        (*start)(&state, ad, sizeof(ad), nonce, key);
+        tinyjambu_aead_decrypt_update(&state, m2, c, len);
+        tag[0] ^= 0x01;
+        if (tinyjambu_aead_decrypt_finish(&state, tag) != -1)
+            ok = 0;
+    }
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+static void test_import_errors(void)
+{
+    tinyjambu_aead_state_t state;
+    unsigned char saved[TINYJAMBU_AEAD_EXPORT_SIZE];
+    unsigned char bad[TINYJAMBU_AEAD_EXPORT_SIZE];
+    unsigned char m[6] = {1, 2, 3, 4, 5, 6};
+    int ok = 1;
+
+    printf("TinyJAMBU incremental import validation ... ");
+    fflush(stdout);
+
+    tinyjambu_128_aead_start(&state, 0, 0, nonce, key);
+    tinyjambu_aead_encrypt_update(&state, m, m, sizeof(m));
+    tinyjambu_aead_export(&state, saved);
+    tinyjambu_aead_free(&state);
+
+    if (tinyjambu_aead_import(&state, saved, key, TINYJAMBU_128_KEY_SIZE) != 0)
+        ok = 0;
+    if (tinyjambu_aead_import(&state, saved, key, TINYJAMBU_192_KEY_SIZE) != -1)
+        ok = 0;
+    memcpy(bad, saved, sizeof(bad));
+    bad[0] ^= 0x01; /* Magic number */
+    if (tinyjambu_aead_import(&state, bad, key, TINYJAMBU_128_KEY_SIZE) != -1)
+        ok = 0;
+    memcpy(bad, saved, sizeof(bad));
+    bad[4] = TINYJAMBU_AEAD_EXPORT_VERSION + 1;
+    if (tinyjambu_aead_import(&state, bad, key, TINYJAMBU_128_KEY_SIZE) != -1)
+        ok = 0;
+    memcpy(bad, saved, sizeof(bad));
+    bad[6] = 3; /* Partial word length does not match the position */
+    if (tinyjambu_aead_import(&state, bad, key, TINYJAMBU_128_KEY_SIZE) != -1)
+        ok = 0;
+    tinyjambu_aead_free(&state);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    test_resume("TinyJAMBU-128", TINYJAMBU_128_KEY_SIZE,
+                tinyjambu_128_aead_start, tinyjambu_128_aead_encrypt_detached);
+    test_resume("TinyJAMBU-192", TINYJAMBU_192_KEY_SIZE,
+                tinyjambu_192_aead_start, tinyjambu_192_aead_encrypt_detached);
+    test_resume("TinyJAMBU-256", TINYJAMBU_256_KEY_SIZE,
+                tinyjambu_256_aead_start, tinyjambu_256_aead_encrypt_detached);
+    test_import_errors();
+    return test_exit_result;
+}
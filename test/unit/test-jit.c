@@ -0,0 +1,265 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TinyJAMBU.h"
+#include "backend/tinyjambu-backend.h"
+#include "backend/tinyjambu-jit.h"
+#include "test-cipher.h"
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_MESSAGE_LEN 37
+#define MAX_AD_LEN 9
+#define MAX_WORDS 5
+
+typedef void (*aead_encrypt_t)
+    (unsigned char *c, size_t *clen,
+     const unsigned char *m, size_t mlen,
+     const unsigned char *ad, size_t adlen,
+     const unsigned char *npub,
+     const unsigned char *k);
+
+static unsigned char const key[TINYJAMBU_256_KEY_SIZE] = {
+    0x10, 0x21, 0x32, 0x43, 0x54, 0x65, 0x76, 0x87,
+    0x98, 0xA9, 0xBA, 0xCB, 0xDC, 0xED, 0xFE, 0x0F,
+    0x01, 0x12, 0x23, 0x34, 0x45, 0x56, 0x67, 0x78,
+    0x89, 0x9A, 0xAB, 0xBC, 0xCD, 0xDE, 0xEF, 0xF0
+};
+
+static unsigned char const nonce[TINYJAMBU_NONCE_SIZE] = {
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+    0x88, 0x99, 0xAA, 0xBB
+};
+
+/* Runs the permutation with the c32 backend */
+static void reference_permute(size_t keylen, uint32_t *s, unsigned rounds)
+{
+    if (keylen == TINYJAMBU_128_KEY_SIZE) {
+        tinyjambu_128_state_t state;
+        state.k[0] = tinyjambu_key_load_even(key);
+        state.k[1] = tinyjambu_key_load_odd(key + 4);
+        state.k[2] = tinyjambu_key_load_even(key + 8);
+        state.k[3] = tinyjambu_key_load_odd(key + 12);
+        memcpy(state.s, s, sizeof(state.s));
+        tinyjambu_permutation_128(&state, rounds);
+        memcpy(s, state.s, sizeof(state.s));
+    } else if (keylen == TINYJAMBU_192_KEY_SIZE) {
+        tinyjambu_192_state_t state;
+        state.k[0] = tinyjambu_key_load_even(key);
+        state.k[1] = tinyjambu_key_load_odd(key + 4);
+        state.k[2] = tinyjambu_key_load_even(key + 8);
+        state.k[3] = tinyjambu_key_load_odd(key + 12);
+        state.k[4] = tinyjambu_key_load_even(key + 16);
+        state.k[5] = tinyjambu_key_load_odd(key + 20);
+        memcpy(state.s, s, sizeof(state.s));
+        tinyjambu_permutation_192(&state, rounds);
+        memcpy(s, state.s, sizeof(state.s));
+    } else {
+        tinyjambu_256_state_t state;
+        state.k[0] = tinyjambu_key_load_even(key);
+        state.k[1] = tinyjambu_key_load_odd(key + 4);
+        state.k[2] = tinyjambu_key_load_even(key + 8);
+        state.k[3] = tinyjambu_key_load_odd(key + 12);
+        state.k[4] = tinyjambu_key_load_even(key + 16);
+        state.k[5] = tinyjambu_key_load_odd(key + 20);
+        state.k[6] = tinyjambu_key_load_even(key + 24);
+        state.k[7] = tinyjambu_key_load_odd(key + 28);
+        memcpy(state.s, s, sizeof(state.s));
+        tinyjambu_permutation_256(&state, rounds);
+        memcpy(s, state.s, sizeof(state.s));
+    }
+}
+
+/* Cross-checks the generated kernels against the c32 backend */
+static void test_kernels(const char *name, size_t keylen)
+{
+    tinyjambu_jit_ctx_t ctx;
+    unsigned char in[MAX_WORDS * 4];
+    unsigned char out1[MAX_WORDS * 4];
+    unsigned char out2[MAX_WORDS * 4];
+    uint32_t s1[4], s2[4];
+    unsigned rounds, index;
+    size_t nwords;
+    uint32_t data;
+    int ok = 1;
+
+    tinyjambu_jit_ctx_init(&ctx, key, keylen);
+    printf("%s JIT kernels (%s) ... ", name,
+           tinyjambu_jit_ctx_is_native(&ctx) ? "native" : "portable");
+    fflush(stdout);
+
+    for (index = 0; index < sizeof(in); ++index)
+        in[index] = (unsigned char)(index * 7 + 3);
+
+    /* The permutation for every round count, including the ones that
+     * are handed off to the portable backend */
+    for (rounds = 1; rounds <= 12; ++rounds) {
+        for (index = 0; index < 4; ++index)
+            s1[index] = s2[index] = 0x01234567U * (index + rounds);
+        tinyjambu_jit_permute(&ctx, s1, rounds);
+        reference_permute(keylen, s2, rounds);
+        if (memcmp(s1, s2, sizeof(s1)) != 0)
+            ok = 0;
+    }
+
+    /* Absorbing, encrypting, and decrypting whole words */
+    for (nwords = 0; nwords <= MAX_WORDS; ++nwords) {
+        for (index = 0; index < 4; ++index)
+            s1[index] = s2[index] = 0x89ABCDEFU ^ (index * 0x11111111U);
+        tinyjambu_jit_absorb(&ctx, s1, in, nwords, 0x30);
+        for (index = 0; index < nwords; ++index) {
+            s2[1] ^= 0x30;
+            reference_permute(keylen, s2, TINYJAMBU_ROUNDS(640));
+            s2[3] ^= le_load_word32(in + index * 4);
+        }
+        if (memcmp(s1, s2, sizeof(s1)) != 0)
+            ok = 0;
+
+        memset(out1, 0xAA, sizeof(out1));
+        memset(out2, 0xAA, sizeof(out2));
+        tinyjambu_jit_encrypt(&ctx, s1, out1, in, nwords);
+        for (index = 0; index < nwords; ++index) {
+            s2[1] ^= 0x50;
+            reference_permute(keylen, s2, ctx.long_rounds);
+            data = le_load_word32(in + index * 4);
+            s2[3] ^= data;
+            le_store_word32(out2 + index * 4, data ^ s2[2]);
+        }
+        if (memcmp(s1, s2, sizeof(s1)) != 0 ||
+                memcmp(out1, out2, sizeof(out1)) != 0)
+            ok = 0;
+
+        tinyjambu_jit_decrypt(&ctx, s1, out1, in, nwords);
+        for (index = 0; index < nwords; ++index) {
+            s2[1] ^= 0x50;
+            reference_permute(keylen, s2, ctx.long_rounds);
+            data = le_load_word32(in + index * 4) ^ s2[2];
+            s2[3] ^= data;
+            le_store_word32(out2 + index * 4, data);
+        }
+        if (memcmp(s1, s2, sizeof(s1)) != 0 ||
+                memcmp(out1, out2, sizeof(out1)) != 0)
+            ok = 0;
+    }
+
+    tinyjambu_jit_ctx_free(&ctx);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+/* Cross-checks the AEAD mode against the regular implementation */
+static void test_aead(const char *name, size_t keylen, aead_encrypt_t encrypt)
+{
+    tinyjambu_jit_key_t *jkey;
+    unsigned char m[MAX_MESSAGE_LEN];
+    unsigned char ad[MAX_AD_LEN];
+    unsigned char c1[MAX_MESSAGE_LEN + TINYJAMBU_TAG_SIZE];
+    unsigned char c2[MAX_MESSAGE_LEN + TINYJAMBU_TAG_SIZE];
+    unsigned char m2[MAX_MESSAGE_LEN];
+    size_t mlen, adlen, clen1, clen2, len, posn;
+    int ok = 1;
+
+    printf("%s JIT AEAD ... ", name);
+    fflush(stdout);
+
+    for (posn = 0; posn < sizeof(m); ++posn)
+        m[posn] = (unsigned char)(posn * 11 + 1);
+    for (posn = 0; posn < sizeof(ad); ++posn)
+        ad[posn] = (unsigned char)(0xA0 + posn);
+
+    jkey = tinyjambu_jit_key_create(key, keylen);
+    if (!jkey) {
+        printf("failed\n");
+        test_exit_result = 1;
+        return;
+    }
+
+    for (mlen = 0; mlen <= sizeof(m); ++mlen) {
+        for (adlen = 0; adlen <= sizeof(ad); ++adlen) {
+            /* Encryption must match the regular implementation */
+            (*encrypt)(c1, &clen1, m, mlen, ad, adlen, nonce, key);
+            memset(c2, 0xAA, sizeof(c2));
+            tinyjambu_jit_aead_encrypt
+                (jkey, c2, &clen2, m, mlen, ad, adlen, nonce);
+            if (clen1 != clen2 || memcmp(c1, c2, clen1) != 0)
+                ok = 0;
+
+            /* Decryption must recover the plaintext */
+            memset(m2, 0xAA, sizeof(m2));
+            if (tinyjambu_jit_aead_decrypt
+                    (jkey, m2, &len, c2, clen2, ad, adlen, nonce) != 0)
+                ok = 0;
+            if (len != mlen || memcmp(m, m2, mlen) != 0)
+                ok = 0;
+
+            /* A bad tag must be detected and the plaintext destroyed */
+            c2[clen2 - 1] ^= 0x01;
+            if (tinyjambu_jit_aead_decrypt
+                    (jkey, m2, &len, c2, clen2, ad, adlen, nonce) != -1)
+                ok = 0;
+            for (posn = 0; posn < mlen; ++posn) {
+                if (m2[posn] != 0)
+                    ok = 0;
+            }
+        }
+    }
+
+    /* Ciphertext that is too short to contain a tag */
+    if (tinyjambu_jit_aead_decrypt
+            (jkey, m2, &len, c2, TINYJAMBU_TAG_SIZE - 1, 0, 0, nonce) != -1)
+        ok = 0;
+
+    tinyjambu_jit_key_destroy(jkey);
+
+    /* Keys of the wrong size are rejected */
+    if (tinyjambu_jit_key_create(key, 20) != 0)
+        ok = 0;
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    test_kernels("TinyJAMBU-128", TINYJAMBU_128_KEY_SIZE);
+    test_kernels("TinyJAMBU-192", TINYJAMBU_192_KEY_SIZE);
+    test_kernels("TinyJAMBU-256", TINYJAMBU_256_KEY_SIZE);
+    test_aead("TinyJAMBU-128", TINYJAMBU_128_KEY_SIZE,
+              tinyjambu_128_aead_encrypt);
+    test_aead("TinyJAMBU-192", TINYJAMBU_192_KEY_SIZE,
+              tinyjambu_192_aead_encrypt);
+    test_aead("TinyJAMBU-256", TINYJAMBU_256_KEY_SIZE,
+              tinyjambu_256_aead_encrypt);
+    return test_exit_result;
+}
@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "TinyJAMBU.h"
+#include "test-cipher.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define MAX_KEY_LEN 80
+#define MAX_LABEL_LEN 32
+#define MAX_CONTEXT_LEN 32
+#define MAX_OUT_LEN 200
+
+typedef struct
+{
+    const char *name;
+    size_t key_len;
+    size_t label_len;
+    size_t context_len;
+    size_t out_len;
+
+} TestKBKDFVector;
+
+/* Input lengths to test; the input data is filled with a simple pattern */
+static TestKBKDFVector const testVectorKBKDF_1 = {
+    "Test Vector 1", 16, 5, 7, 32
+};
+static TestKBKDFVector const testVectorKBKDF_2 = {
+    "Test Vector 2", 32, 0, 0, 42
+};
+static TestKBKDFVector const testVectorKBKDF_3 = {
+    "Test Vector 3", 80, 32, 32, 200
+};
+
+/* Simple implementation of the SP 800-108r1 counter mode KDF that is used
+ * to cross-check the more efficient version in the library */
+static void KBKDF
+    (unsigned char *out, size_t outlen,
+     const unsigned char *key, size_t keylen,
+     const unsigned char *label, size_t labellen,
+     const unsigned char *context, size_t contextlen)
+{
+    unsigned char T[TINYJAMBU_HMAC_SIZE];
+    unsigned char block[MAX_LABEL_LEN + MAX_CONTEXT_LEN + 13];
+    unsigned long long bits = ((unsigned long long)outlen) * 8U;
+    size_t blocklen, posn;
+    uint32_t counter = 1;
+    int index;
+
+    for (posn = 0; posn < outlen; posn += sizeof(T), ++counter) {
+        memcpy(block, label, labellen);
+        block[labellen] = 0x00;
+        memcpy(block + labellen + 1, context, contextlen);
+        blocklen = labellen + 1 + contextlen;
+        for (index = 7; index >= 0; --index)
+            block[blocklen++] = (unsigned char)(bits >> (index * 8));
+        for (index = 3; index >= 0; --index)
+            block[blocklen++] = (unsigned char)(counter >> (index * 8));
+        tinyjambu_hmac(T, key, keylen, block, blocklen);
+        if ((outlen - posn) >= sizeof(T))
+            memcpy(out + posn, T, sizeof(T));
+        else
+            memcpy(out + posn, T, outlen - posn);
+    }
+}
+
+/* Perform tests on the KBKDF implementation in the library */
+static void test_kbkdf_vector(const TestKBKDFVector *test_vector)
+{
+    tinyjambu_kbkdf_state_t state;
+    unsigned char key[MAX_KEY_LEN];
+    unsigned char label[MAX_LABEL_LEN];
+    unsigned char context[MAX_CONTEXT_LEN];
+    unsigned char actual[MAX_OUT_LEN];
+    unsigned char expected[MAX_OUT_LEN];
+    size_t out_len = test_vector->out_len;
+    size_t num_blocks, offset, len;
+    unsigned long block;
+    int result;
+    int ok = 1;
+
+    printf("TinyJAMBU-KBKDF %s ... ", test_vector->name);
+    fflush(stdout);
+
+    /* Construct the input data */
+    for (offset = 0; offset < sizeof(key); ++offset)
+        key[offset] = (unsigned char)offset;
+    for (offset = 0; offset < sizeof(label); ++offset)
+        label[offset] = (unsigned char)(0x60 + offset);
+    for (offset = 0; offset < sizeof(context); ++offset)
+        context[offset] = (unsigned char)(0xB0 + offset);
+    KBKDF(expected, out_len, key, test_vector->key_len,
+          label, test_vector->label_len, context, test_vector->context_len);
+
+    /* Test the all-in-one KBKDF function */
+    memset(actual, 0xAA, sizeof(actual));
+    result = tinyjambu_kbkdf
+        (actual, out_len, key, test_vector->key_len,
+         label, test_vector->label_len, context, test_vector->context_len);
+    if (result != 0 || test_memcmp(actual, expected, out_len) != 0) {
+        ok = 0;
+    }
+
+    /* Test random-access expansion, generating the blocks in reverse order */
+    memset(actual, 0xAA, sizeof(actual));
+    result = tinyjambu_kbkdf_init
+        (&state, key, test_vector->key_len, label, test_vector->label_len,
+         context, test_vector->context_len, out_len);
+    num_blocks = (out_len + TINYJAMBU_KBKDF_SIZE - 1) / TINYJAMBU_KBKDF_SIZE;
+    for (block = num_blocks; result == 0 && block > 0; --block) {
+        offset = (block - 1) * TINYJAMBU_KBKDF_SIZE;
+        len = out_len - offset;
+        if (len > TINYJAMBU_KBKDF_SIZE)
+            len = TINYJAMBU_KBKDF_SIZE;
+        result = tinyjambu_kbkdf_expand(&state, block - 1, actual + offset, len);
+    }
+    if (result != 0 || test_memcmp(actual, expected, out_len) != 0) {
+        ok = 0;
+    }
+
+    /* Requesting data past the end of the key material should fail and
+     * zero the part of the output that is out of range */
+    memset(actual, 0xAA, sizeof(actual));
+    result = tinyjambu_kbkdf_expand
+        (&state, num_blocks - 1, actual, TINYJAMBU_KBKDF_SIZE * 2);
+    if (result != -1 ||
+            test_memcmp(actual, expected + (num_blocks - 1) * TINYJAMBU_KBKDF_SIZE,
+                        out_len - (num_blocks - 1) * TINYJAMBU_KBKDF_SIZE) != 0 ||
+            actual[TINYJAMBU_KBKDF_SIZE] != 0 ||
+            actual[TINYJAMBU_KBKDF_SIZE * 2 - 1] != 0) {
+        ok = 0;
+    }
+    tinyjambu_kbkdf_free(&state);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    if (!hash_sanity_check())
+        return 1;
+
+    test_kbkdf_vector(&testVectorKBKDF_1);
+    test_kbkdf_vector(&testVectorKBKDF_2);
+    test_kbkdf_vector(&testVectorKBKDF_3);
+
+    return test_exit_result;
+}
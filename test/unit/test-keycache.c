@@ -0,0 +1,340 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#if defined(HAVE_CONFIG_H)
+#include <config.h>
+#endif
+#include "TinyJAMBU.h"
+#include "test-cipher.h"
+#include <stdio.h>
+#include <string.h>
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#endif
+
+#define NUM_THREADS 4
+#define THREAD_LOOKUPS 20000
+#define THREAD_KEY_IDS 256
+
+/* Derives the test key for a key identifier */
+static void make_key(unsigned char *k, uint64_t key_id)
+{
+    unsigned index;
+    for (index = 0; index < TINYJAMBU_128_KEY_SIZE; ++index)
+        k[index] = (unsigned char)(key_id * 7 + index * 13 + (key_id >> 8));
+}
+
+/* Checks that a key from the cache is correct for a key identifier */
+static int check_key(const tinyjambu_128_key_t *key, uint64_t key_id)
+{
+    unsigned char k[TINYJAMBU_128_KEY_SIZE];
+    tinyjambu_128_key_t expected;
+    make_key(k, key_id);
+    tinyjambu_128_key_init(&expected, k);
+    return memcmp(key, &expected, sizeof(expected)) == 0;
+}
+
+static int fetch_calls;
+
+/* Fetch callback that knows about all even key identifiers */
+static int fetch_key(void *ctx, uint64_t key_id, unsigned char *k)
+{
+    (void)ctx;
+    ++fetch_calls;
+    if (key_id & 1)
+        return -1;
+    make_key(k, key_id);
+    return 0;
+}
+
+static void test_basic(void)
+{
+    tinyjambu_128_keycache_t *cache;
+    tinyjambu_128_key_t key;
+    unsigned char k[TINYJAMBU_128_KEY_SIZE];
+    uint64_t hits, misses, evictions;
+    uint64_t key_id;
+    int ok = 1;
+
+    printf("TinyJAMBU-128 key cache ... ");
+    fflush(stdout);
+
+    cache = tinyjambu_128_keycache_create(64, 4, 0, 0);
+    if (!cache) {
+        printf("failed to create\n");
+        test_exit_result = 1;
+        return;
+    }
+
+    /* Insert some keys and read them back, including 64-bit identifiers */
+    for (key_id = 0; key_id < 32; ++key_id) {
+        make_key(k, key_id | (key_id << 40));
+        tinyjambu_128_keycache_insert(cache, key_id | (key_id << 40), k);
+    }
+    for (key_id = 0; key_id < 32; ++key_id) {
+        if (tinyjambu_128_keycache_get
+                (cache, key_id | (key_id << 40), &key) == 0 &&
+                !check_key(&key, key_id | (key_id << 40))) {
+            ok = 0;
+        }
+    }
+    if (tinyjambu_128_keycache_get(cache, 12345, &key) != -1)
+        ok = 0;
+
+    /* Keys hash to sets of 8, so a few may have been evicted already */
+    tinyjambu_128_keycache_stats(cache, &hits, &misses, &evictions);
+    if (hits + evictions != 32 || misses != evictions + 1)
+        ok = 0;
+
+    /* Replacing a key must not create a second entry */
+    make_key(k, 99);
+    tinyjambu_128_keycache_insert(cache, 5000, k);
+    make_key(k, 5000);
+    tinyjambu_128_keycache_insert(cache, 5000, k);
+    if (tinyjambu_128_keycache_get(cache, 5000, &key) != 0 ||
+            !check_key(&key, 5000)) {
+        ok = 0;
+    }
+
+    /* Removing keys */
+    if (tinyjambu_128_keycache_remove(cache, 5000) != 0)
+        ok = 0;
+    if (tinyjambu_128_keycache_remove(cache, 5000) != -1)
+        ok = 0;
+    if (tinyjambu_128_keycache_get(cache, 5000, &key) != -1)
+        ok = 0;
+
+    /* Overfill the cache; every key must either be resident or evicted */
+    for (key_id = 1000; key_id < 2000; ++key_id) {
+        make_key(k, key_id);
+        tinyjambu_128_keycache_insert(cache, key_id, k);
+    }
+    tinyjambu_128_keycache_stats(cache, 0, 0, &evictions);
+    hits = 0;
+    for (key_id = 1000; key_id < 2000; ++key_id) {
+        if (tinyjambu_128_keycache_get(cache, key_id, &key) == 0) {
+            if (!check_key(&key, key_id))
+                ok = 0;
+            ++hits;
+        }
+    }
+    for (key_id = 0; key_id < 32; ++key_id) {
+        if (tinyjambu_128_keycache_get
+                (cache, key_id | (key_id << 40), &key) == 0) {
+            ++hits;
+        }
+    }
+    if (hits != 64 || evictions != 32 + 1000 - 64)
+        ok = 0;
+
+    tinyjambu_128_key_free(&key);
+    tinyjambu_128_keycache_destroy(cache);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+static void test_clock(void)
+{
+    tinyjambu_128_keycache_t *cache;
+    tinyjambu_128_key_t key;
+    unsigned char k[TINYJAMBU_128_KEY_SIZE];
+    uint64_t key_id;
+    int ok = 1;
+
+    printf("TinyJAMBU-128 key cache CLOCK eviction ... ");
+    fflush(stdout);
+
+    /* A single set of 8 slots, which is filled and then streamed over.
+     * The key that is used between every insertion must stay resident */
+    cache = tinyjambu_128_keycache_create(8, 1, 0, 0);
+    if (!cache) {
+        printf("failed to create\n");
+        test_exit_result = 1;
+        return;
+    }
+    for (key_id = 0; key_id < 100; ++key_id) {
+        make_key(k, key_id);
+        tinyjambu_128_keycache_insert(cache, key_id, k);
+        if (tinyjambu_128_keycache_get(cache, 0, &key) != 0 ||
+                !check_key(&key, 0)) {
+            ok = 0;
+        }
+    }
+    tinyjambu_128_key_free(&key);
+    tinyjambu_128_keycache_destroy(cache);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+static void test_fetch(void)
+{
+    tinyjambu_128_keycache_t *cache;
+    tinyjambu_128_key_t key;
+    uint64_t hits, misses;
+    int ok = 1;
+
+    printf("TinyJAMBU-128 key cache fetch ... ");
+    fflush(stdout);
+
+    cache = tinyjambu_128_keycache_create(256, 0, fetch_key, 0);
+    if (!cache) {
+        printf("failed to create\n");
+        test_exit_result = 1;
+        return;
+    }
+    fetch_calls = 0;
+    if (tinyjambu_128_keycache_get(cache, 42, &key) != 0 ||
+            !check_key(&key, 42)) {
+        ok = 0;
+    }
+    if (tinyjambu_128_keycache_get(cache, 42, &key) != 0 ||
+            !check_key(&key, 42)) {
+        ok = 0;
+    }
+    if (tinyjambu_128_keycache_get(cache, 43, &key) != -1)
+        ok = 0;
+    if (tinyjambu_128_keycache_get(cache, 43, &key) != -1)
+        ok = 0;
+    tinyjambu_128_keycache_stats(cache, &hits, &misses, 0);
+    if (fetch_calls != 3 || hits != 1 || misses != 3)
+        ok = 0;
+    tinyjambu_128_key_free(&key);
+    tinyjambu_128_keycache_destroy(cache);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+#if defined(HAVE_PTHREAD)
+
+typedef struct
+{
+    tinyjambu_128_keycache_t *cache;
+    unsigned seed;
+    int ok;
+
+} keycache_thread_t;
+
+/* Fetch callback for the threaded test, which knows about every key */
+static int fetch_any_key(void *ctx, uint64_t key_id, unsigned char *k)
+{
+    (void)ctx;
+    make_key(k, key_id);
+    return 0;
+}
+
+static void *keycache_thread(void *arg)
+{
+    keycache_thread_t *info = (keycache_thread_t *)arg;
+    tinyjambu_128_key_t key;
+    uint64_t key_id;
+    unsigned count;
+    for (count = 0; count < THREAD_LOOKUPS; ++count) {
+        info->seed = info->seed * 1103515245U + 12345U;
+        key_id = (info->seed >> 8) % THREAD_KEY_IDS;
+        if (tinyjambu_128_keycache_get(info->cache, key_id, &key) != 0 ||
+                !check_key(&key, key_id)) {
+            info->ok = 0;
+        }
+        if ((count % 1000) == 999)
+            tinyjambu_128_keycache_remove(info->cache, key_id);
+    }
+    tinyjambu_128_key_free(&key);
+    return 0;
+}
+
+static void test_threads(void)
+{
+    tinyjambu_128_keycache_t *cache;
+    keycache_thread_t info[NUM_THREADS];
+    pthread_t threads[NUM_THREADS];
+    uint64_t hits, misses;
+    unsigned index;
+    int ok = 1;
+
+    printf("TinyJAMBU-128 key cache threads ... ");
+    fflush(stdout);
+
+    cache = tinyjambu_128_keycache_create(64, 2, fetch_any_key, 0);
+    if (!cache) {
+        printf("failed to create\n");
+        test_exit_result = 1;
+        return;
+    }
+    for (index = 0; index < NUM_THREADS; ++index) {
+        info[index].cache = cache;
+        info[index].seed = index * 977 + 1;
+        info[index].ok = 1;
+        if (pthread_create(&threads[index], 0, keycache_thread,
+                           &info[index]) != 0) {
+            keycache_thread(&info[index]);
+            threads[index] = pthread_self();
+        }
+    }
+    for (index = 0; index < NUM_THREADS; ++index) {
+        if (!pthread_equal(threads[index], pthread_self()))
+            pthread_join(threads[index], 0);
+        if (!info[index].ok)
+            ok = 0;
+    }
+    tinyjambu_128_keycache_stats(cache, &hits, &misses, 0);
+    if (hits + misses != NUM_THREADS * THREAD_LOOKUPS)
+        ok = 0;
+    tinyjambu_128_keycache_destroy(cache);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+#endif
+
+int main(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    test_basic();
+    test_clock();
+    test_fetch();
+#if defined(HAVE_PTHREAD)
+    test_threads();
+#endif
+    return test_exit_result;
+}
@@ -0,0 +1,316 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#if defined(HAVE_CONFIG_H)
+#include <config.h>
+#endif
+#include "TinyJAMBU.h"
+#include "test-cipher.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#if defined(__linux__)
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+#define TEST_LAZYMAP_FORK 1
+#endif
+
+#define NUM_PAGES 40
+
+static unsigned char const key[TINYJAMBU_128_KEY_SIZE] = {
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+    0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF
+};
+
+static size_t page_size;
+static size_t sector_size;
+static size_t length;
+static unsigned char *plaintext;
+static unsigned char *tags;
+static FILE *file;
+
+/* Encrypts the test data and writes it to a temporary file */
+static int create_file(void)
+{
+    size_t total = NUM_PAGES * page_size;
+    unsigned char *c = (unsigned char *)calloc(1, total);
+    size_t num_sectors, posn;
+    plaintext = (unsigned char *)calloc(1, total);
+    tags = (unsigned char *)malloc
+        ((total / sector_size) * TINYJAMBU_TAG_SIZE);
+    if (!c || !plaintext || !tags)
+        exit(2);
+
+    /* The last page is only half-full, so if there are several sectors
+     * per page then the file does not cover the whole of the last page */
+    length = total - page_size / 2;
+    for (posn = 0; posn < length; ++posn)
+        plaintext[posn] = (unsigned char)(posn * 3 + (posn >> 12));
+    num_sectors = (length + sector_size - 1) / sector_size;
+    tinyjambu_128_siv_encrypt_sectors
+        (c, tags, plaintext, sector_size, 0, num_sectors, key, 1);
+    total = num_sectors * sector_size;
+    file = tmpfile();
+    if (!file || fwrite(c, 1, total, file) != total || fflush(file) != 0)
+        return 0;
+    free(c);
+    return 1;
+}
+
+static void test_sequential(void)
+{
+    tinyjambu_lazymap_t *map;
+    const unsigned char *data;
+    int ok = 1;
+
+    printf("Lazy decryption, sequential access, %u-byte sectors ... ",
+           (unsigned)sector_size);
+    fflush(stdout);
+
+    map = tinyjambu_lazymap_open
+        (fileno(file), length, tags, sector_size, key, 8);
+    if (!map) {
+        printf("failed\n");
+        test_exit_result = 1;
+        return;
+    }
+    data = (const unsigned char *)tinyjambu_lazymap_data(map);
+    if (tinyjambu_lazymap_pages_decrypted(map) != 0)
+        ok = 0;
+    if (memcmp(data, plaintext, length) != 0)
+        ok = 0;
+    if (tinyjambu_lazymap_pages_decrypted(map) != NUM_PAGES)
+        ok = 0;
+    if (tinyjambu_lazymap_failed(map))
+        ok = 0;
+    tinyjambu_lazymap_close(map);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+static void test_random(void)
+{
+    tinyjambu_lazymap_t *map;
+    const unsigned char *data;
+    size_t page, before;
+    int ok = 1;
+
+    printf("Lazy decryption, random access, %u-byte sectors ... ",
+           (unsigned)sector_size);
+    fflush(stdout);
+
+    map = tinyjambu_lazymap_open
+        (fileno(file), length, tags, sector_size, key, 0);
+    if (!map) {
+        printf("failed\n");
+        test_exit_result = 1;
+        return;
+    }
+    data = (const unsigned char *)tinyjambu_lazymap_data(map);
+
+    /* Touching a single page only decrypts that page */
+    if (data[page_size * 20 + 7] != plaintext[page_size * 20 + 7])
+        ok = 0;
+    if (tinyjambu_lazymap_pages_decrypted(map) != 1)
+        ok = 0;
+
+    /* Non-sequential faults do not read ahead */
+    if (data[page_size * 3] != plaintext[page_size * 3])
+        ok = 0;
+    if (data[page_size * 30] != plaintext[page_size * 30])
+        ok = 0;
+    if (tinyjambu_lazymap_pages_decrypted(map) != 3)
+        ok = 0;
+
+    /* Sequential faults after page 3 grow the read-ahead window,
+     * which stops at page 20 because it is already present */
+    before = tinyjambu_lazymap_pages_decrypted(map);
+    for (page = 4; page < 20; ++page) {
+        if (data[page_size * page] != plaintext[page_size * page])
+            ok = 0;
+    }
+    if (tinyjambu_lazymap_pages_decrypted(map) != before + 16)
+        ok = 0;
+    if (memcmp(data + page_size * 3, plaintext + page_size * 3,
+               page_size * 18) != 0)
+        ok = 0;
+    tinyjambu_lazymap_close(map);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+#if defined(TEST_LAZYMAP_FORK)
+
+static void segv_handler(int sig)
+{
+    (void)sig;
+    _exit(3);
+}
+
+static void test_tampered(void)
+{
+    tinyjambu_lazymap_t *map;
+    const unsigned char *data;
+    unsigned char byte;
+    pid_t pid;
+    int status = 0;
+    int ok = 1;
+
+    printf("Lazy decryption, tampered page, %u-byte sectors ... ",
+           (unsigned)sector_size);
+    fflush(stdout);
+
+    /* Flip a bit in page 5 of the file */
+    if (pread(fileno(file), &byte, 1, page_size * 5 + 9) != 1)
+        exit(2);
+    byte ^= 0x20;
+    if (pwrite(fileno(file), &byte, 1, page_size * 5 + 9) != 1)
+        exit(2);
+
+    /* Other pages are readable, but touching page 5 kills the child */
+    pid = fork();
+    if (pid == 0) {
+        signal(SIGSEGV, segv_handler);
+        map = tinyjambu_lazymap_open
+            (fileno(file), length, tags, sector_size, key, 0);
+        if (!map)
+            _exit(1);
+        data = (const unsigned char *)tinyjambu_lazymap_data(map);
+        if (data[page_size * 4] != plaintext[page_size * 4])
+            _exit(1);
+        if (data[page_size * 5] != 0xFF)
+            _exit(1);
+        _exit(2);
+    } else if (pid < 0 || waitpid(pid, &status, 0) != pid ||
+               !WIFEXITED(status) || WEXITSTATUS(status) != 3) {
+        ok = 0;
+    }
+
+    byte ^= 0x20;
+    if (pwrite(fileno(file), &byte, 1, page_size * 5 + 9) != 1)
+        exit(2);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+#endif
+
+static void test_invalid_sector_size(void)
+{
+    tinyjambu_lazymap_t *map;
+    int ok = 1;
+
+    printf("Lazy decryption, invalid sector sizes ... ");
+    fflush(stdout);
+
+    /* Sector sizes that do not divide the page size are rejected */
+    map = tinyjambu_lazymap_open
+        (fileno(file), length, tags, page_size * 2, key, 0);
+    if (map) {
+        tinyjambu_lazymap_close(map);
+        ok = 0;
+    }
+    map = tinyjambu_lazymap_open
+        (fileno(file), length, tags, page_size - 4, key, 0);
+    if (map) {
+        tinyjambu_lazymap_close(map);
+        ok = 0;
+    }
+    map = tinyjambu_lazymap_open(fileno(file), length, tags, 0, key, 0);
+    if (map) {
+        tinyjambu_lazymap_close(map);
+        ok = 0;
+    }
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    static size_t const sector_sizes[] = {
+        TINYJAMBU_LAZYMAP_SECTOR_SIZE, 1024
+    };
+    tinyjambu_lazymap_t *map;
+    unsigned index;
+
+    (void)argc;
+    (void)argv;
+
+    page_size = tinyjambu_lazymap_page_size();
+    if (!page_size) {
+        printf("Lazy decryption is not supported on this platform\n");
+        return 0;
+    }
+
+    for (index = 0; index < sizeof(sector_sizes) / sizeof(size_t); ++index) {
+        sector_size = sector_sizes[index];
+        if ((page_size % sector_size) != 0)
+            continue;
+        if (!create_file()) {
+            perror("tmpfile");
+            return 1;
+        }
+
+        /* The kernel may not allow this process to use userfaultfd */
+        map = tinyjambu_lazymap_open
+            (fileno(file), length, tags, sector_size, key, 0);
+        if (!map) {
+            printf("Lazy decryption is not available to this process\n");
+            return 0;
+        }
+        tinyjambu_lazymap_close(map);
+
+        test_sequential();
+        test_random();
+#if defined(TEST_LAZYMAP_FORK)
+        test_tampered();
+#endif
+        if (index == 0)
+            test_invalid_sector_size();
+
+        fclose(file);
+        free(plaintext);
+        free(tags);
+    }
+    return test_exit_result;
+}
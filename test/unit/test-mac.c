@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TinyJAMBU.h"
+#include "test-cipher.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define MAX_DATA_LEN 77
+
+typedef void (*mac_init_key_t)
+    (tinyjambu_mac_key_t *key, const unsigned char *k);
+
+typedef struct
+{
+    const char *name;
+    mac_init_key_t init_key;
+
+} TestMACVariant;
+
+static TestMACVariant const variants[] = {
+    {"TinyJAMBU-128-MAC", tinyjambu_128_mac_init_key},
+    {"TinyJAMBU-192-MAC", tinyjambu_192_mac_init_key},
+    {"TinyJAMBU-256-MAC", tinyjambu_256_mac_init_key},
+    {0, 0}
+};
+
+/* Computes the MAC incrementally, splitting the data at "split" */
+static int mac_incremental
+    (unsigned char *tag, const tinyjambu_mac_key_t *key,
+     const unsigned char *nonce, const unsigned char *data,
+     size_t size, size_t split, int check)
+{
+    tinyjambu_mac_state_t state;
+    tinyjambu_mac_init(&state, key, nonce);
+    tinyjambu_mac_update(&state, data, split);
+    tinyjambu_mac_update(&state, data + split, size - split);
+    if (check)
+        return tinyjambu_mac_check_finalize(&state, tag);
+    tinyjambu_mac_finalize(&state, tag);
+    return 0;
+}
+
+static void test_mac_variant(const TestMACVariant *variant)
+{
+    tinyjambu_mac_key_t key;
+    unsigned char k[TINYJAMBU_256_KEY_SIZE];
+    unsigned char nonce[TINYJAMBU_NONCE_SIZE];
+    unsigned char zero_nonce[TINYJAMBU_NONCE_SIZE];
+    unsigned char data[MAX_DATA_LEN];
+    unsigned char expected[TINYJAMBU_MAC_SIZE];
+    unsigned char actual[TINYJAMBU_MAC_SIZE];
+    unsigned char fixed[TINYJAMBU_MAC_SIZE];
+    size_t size, split, posn;
+    int ok = 1;
+
+    printf("%s ... ", variant->name);
+    fflush(stdout);
+
+    for (posn = 0; posn < sizeof(k); ++posn)
+        k[posn] = (unsigned char)(0x20 + posn);
+    for (posn = 0; posn < sizeof(nonce); ++posn)
+        nonce[posn] = (unsigned char)(0xC0 + posn);
+    for (posn = 0; posn < sizeof(data); ++posn)
+        data[posn] = (unsigned char)(posn * 7);
+    memset(zero_nonce, 0, sizeof(zero_nonce));
+    (*(variant->init_key))(&key, k);
+
+    for (size = 0; size <= MAX_DATA_LEN && ok; ++size) {
+        /* Incremental and one-shot tags must agree for all split points */
+        tinyjambu_mac(expected, &key, nonce, data, size);
+        for (split = 0; split <= size; ++split) {
+            mac_incremental(actual, &key, nonce, data, size, split, 0);
+            if (test_memcmp(actual, expected, sizeof(actual)) != 0)
+                ok = 0;
+            if (mac_incremental(expected, &key, nonce, data,
+                                size, split, 1) != 0)
+                ok = 0;
+        }
+        if (tinyjambu_mac_verify(expected, &key, nonce, data, size) != 0)
+            ok = 0;
+
+        /* Modifying the tag or the nonce must cause verification to fail */
+        expected[size % TINYJAMBU_MAC_SIZE] ^= 0x01;
+        if (tinyjambu_mac_verify(expected, &key, nonce, data, size) != -1)
+            ok = 0;
+        expected[size % TINYJAMBU_MAC_SIZE] ^= 0x01;
+        nonce[size % TINYJAMBU_NONCE_SIZE] ^= 0x80;
+        if (tinyjambu_mac_verify(expected, &key, nonce, data, size) != -1)
+            ok = 0;
+        nonce[size % TINYJAMBU_NONCE_SIZE] ^= 0x80;
+
+        /* The fixed IV is the same as an all-zero nonce, so this
+         * cross-checks the IV state that is cached in the key */
+        tinyjambu_mac(fixed, &key, 0, data, size);
+        tinyjambu_mac(actual, &key, zero_nonce, data, size);
+        if (test_memcmp(actual, fixed, sizeof(actual)) != 0)
+            ok = 0;
+        if (memcmp(actual, expected, sizeof(actual)) == 0)
+            ok = 0;
+    }
+
+    tinyjambu_mac_free_key(&key);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int index;
+
+    (void)argc;
+    (void)argv;
+
+    for (index = 0; variants[index].name; ++index)
+        test_mac_variant(&variants[index]);
+
+    return test_exit_result;
+}
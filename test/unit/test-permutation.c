@@ -146,12 +146,141 @@ void test_tinyjambu_permutation(void)
     printf("\n");
 }
 
+void test_tinyjambu_lanes(void)
+{
+    tinyjambu_128_state_t expected[4];
+    tinyjambu_128_state_t actual[4];
+    tinyjambu_192_state_t expected192[2];
+    tinyjambu_192_state_t actual192[2];
+    tinyjambu_256_state_t expected256[2];
+    tinyjambu_256_state_t actual256[2];
+    unsigned lane, index, rounds;
+    int ok;
+
+    printf("TinyJAMBU Lanes:\n");
+
+    /* Set up four states with different inputs and keys */
+    for (lane = 0; lane < 4; ++lane) {
+        for (index = 0; index < 4; ++index) {
+            expected[lane].s[index] = tinyjambu_input[index] + lane * 0x11111111U;
+            expected[lane].k[index] = ~(tinyjambu_key_1[index] ^ (lane << 8));
+        }
+        tinyjambu_permutation_128(&(expected[lane]), TINYJAMBU_ROUNDS(1024));
+    }
+
+    printf("    TinyJAMBU-128 x2 ... ");
+    fflush(stdout);
+    for (lane = 0; lane < 4; ++lane) {
+        for (index = 0; index < 4; ++index) {
+            actual[lane].s[index] = tinyjambu_input[index] + lane * 0x11111111U;
+            actual[lane].k[index] = ~(tinyjambu_key_1[index] ^ (lane << 8));
+        }
+    }
+    tinyjambu_permutation_128_x2
+        (&(actual[0]), &(actual[1]), TINYJAMBU_ROUNDS(1024));
+    tinyjambu_permutation_128_x2
+        (&(actual[2]), &(actual[3]), TINYJAMBU_ROUNDS(1024));
+    ok = 1;
+    for (lane = 0; lane < 4; ++lane) {
+        if (test_memcmp((const unsigned char *)&(actual[lane]),
+                        (const unsigned char *)&(expected[lane]),
+                        sizeof(tinyjambu_128_state_t)) != 0)
+            ok = 0;
+    }
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+
+    printf("    TinyJAMBU-128 x4 ... ");
+    fflush(stdout);
+    for (lane = 0; lane < 4; ++lane) {
+        for (index = 0; index < 4; ++index) {
+            actual[lane].s[index] = tinyjambu_input[index] + lane * 0x11111111U;
+            actual[lane].k[index] = ~(tinyjambu_key_1[index] ^ (lane << 8));
+        }
+    }
+    tinyjambu_permutation_128_x4(actual, TINYJAMBU_ROUNDS(1024));
+    ok = 1;
+    for (lane = 0; lane < 4; ++lane) {
+        if (test_memcmp((const unsigned char *)&(actual[lane]),
+                        (const unsigned char *)&(expected[lane]),
+                        sizeof(tinyjambu_128_state_t)) != 0)
+            ok = 0;
+    }
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+
+    /* The 192-bit and 256-bit versions have a different key schedule
+     * for each round, so check every round count up to a full cycle */
+    printf("    TinyJAMBU-192 x2 ... ");
+    fflush(stdout);
+    ok = 1;
+    for (rounds = 1; rounds <= 12; ++rounds) {
+        for (lane = 0; lane < 2; ++lane) {
+            for (index = 0; index < 4; ++index)
+                expected192[lane].s[index] = tinyjambu_input[index] + lane;
+            for (index = 0; index < 6; ++index)
+                expected192[lane].k[index] = ~(tinyjambu_key_3[index] ^ lane);
+            actual192[lane] = expected192[lane];
+            tinyjambu_permutation_192(&(expected192[lane]), rounds);
+        }
+        tinyjambu_permutation_192_x2
+            (&(actual192[0]), &(actual192[1]), rounds);
+        if (test_memcmp((const unsigned char *)actual192,
+                        (const unsigned char *)expected192,
+                        sizeof(actual192)) != 0)
+            ok = 0;
+    }
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+
+    printf("    TinyJAMBU-256 x2 ... ");
+    fflush(stdout);
+    ok = 1;
+    for (rounds = 1; rounds <= 12; ++rounds) {
+        for (lane = 0; lane < 2; ++lane) {
+            for (index = 0; index < 4; ++index)
+                expected256[lane].s[index] = tinyjambu_input[index] + lane;
+            for (index = 0; index < 8; ++index)
+                expected256[lane].k[index] = ~(tinyjambu_key_2[index] ^ lane);
+            actual256[lane] = expected256[lane];
+            tinyjambu_permutation_256(&(expected256[lane]), rounds);
+        }
+        tinyjambu_permutation_256_x2
+            (&(actual256[0]), &(actual256[1]), rounds);
+        if (test_memcmp((const unsigned char *)actual256,
+                        (const unsigned char *)expected256,
+                        sizeof(actual256)) != 0)
+            ok = 0;
+    }
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+
+    printf("\n");
+}
+
 int main(int argc, char *argv[])
 {
     (void)argc;
     (void)argv;
 
     test_tinyjambu_permutation();
+    test_tinyjambu_lanes();
 
     return test_exit_result;
 }
@@ -0,0 +1,237 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TinyJAMBU.h"
+#include "backend/tinyjambu-backend.h"
+#include "test-cipher.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define SMALL_DATA_LEN 80
+#define LARGE_DATA_LEN (16 * 4096 * 5 + 11)
+
+/* Multiplies a 16-byte little-endian value by x in GF(2^128) */
+static void ref_double(unsigned char *out, const unsigned char *in)
+{
+    unsigned char carry = in[15] >> 7;
+    int index;
+    for (index = 15; index > 0; --index)
+        out[index] = (unsigned char)((in[index] << 1) | (in[index - 1] >> 7));
+    out[0] = (unsigned char)(in[0] << 1);
+    if (carry)
+        out[0] ^= 0x87;
+}
+
+/* Enciphers a block in place with the keyed TinyJAMBU-128 permutation */
+static void ref_encipher(const unsigned char *k, unsigned char *block)
+{
+    tinyjambu_128_state_t state;
+    int index;
+    for (index = 0; index < 4; ++index) {
+        state.s[index] =
+            ((uint32_t)(block[index * 4])) |
+            (((uint32_t)(block[index * 4 + 1])) << 8) |
+            (((uint32_t)(block[index * 4 + 2])) << 16) |
+            (((uint32_t)(block[index * 4 + 3])) << 24);
+        state.k[index] = ~(
+            ((uint32_t)(k[index * 4])) |
+            (((uint32_t)(k[index * 4 + 1])) << 8) |
+            (((uint32_t)(k[index * 4 + 2])) << 16) |
+            (((uint32_t)(k[index * 4 + 3])) << 24));
+    }
+    tinyjambu_permutation_128(&state, 8);
+    for (index = 0; index < 4; ++index) {
+        block[index * 4]     = (unsigned char)(state.s[index]);
+        block[index * 4 + 1] = (unsigned char)(state.s[index] >> 8);
+        block[index * 4 + 2] = (unsigned char)(state.s[index] >> 16);
+        block[index * 4 + 3] = (unsigned char)(state.s[index] >> 24);
+    }
+}
+
+/* Simple implementation of TinyJAMBU-PMAC that processes one block at a
+ * time and updates the offset by doubling, to cross-check the library */
+static void ref_pmac
+    (unsigned char *tag, const unsigned char *k,
+     const unsigned char *data, size_t size)
+{
+    unsigned char L_star[16], L_dollar[16], L[64][16];
+    unsigned char offset[16], sum[16], block[16];
+    size_t i, posn;
+    unsigned j, ntz;
+
+    memset(L_star, 0, sizeof(L_star));
+    ref_encipher(k, L_star);
+    ref_double(L_dollar, L_star);
+    ref_double(L[0], L_dollar);
+    for (j = 1; j < 64; ++j)
+        ref_double(L[j], L[j - 1]);
+
+    memset(offset, 0, sizeof(offset));
+    memset(sum, 0, sizeof(sum));
+    for (i = 1; size >= 16; ++i, data += 16, size -= 16) {
+        for (ntz = 0; ((i >> ntz) & 1) == 0; ++ntz)
+            ; /* Do nothing */
+        for (posn = 0; posn < 16; ++posn) {
+            offset[posn] ^= L[ntz][posn];
+            block[posn] = data[posn] ^ offset[posn];
+        }
+        ref_encipher(k, block);
+        for (posn = 0; posn < 16; ++posn)
+            sum[posn] ^= block[posn];
+    }
+    if (size > 0) {
+        memset(block, 0, sizeof(block));
+        memcpy(block, data, size);
+        block[size] = 0x80;
+        for (posn = 0; posn < 16; ++posn)
+            block[posn] ^= offset[posn] ^ L_star[posn];
+        ref_encipher(k, block);
+        for (posn = 0; posn < 16; ++posn)
+            sum[posn] ^= block[posn];
+    }
+    for (posn = 0; posn < 16; ++posn)
+        tag[posn] = sum[posn] ^ L_dollar[posn];
+    ref_encipher(k, tag);
+}
+
+/* Computes the PMAC incrementally, in chunks of "chunk" bytes */
+static void pmac_incremental
+    (unsigned char *tag, const tinyjambu_pmac_key_t *key,
+     const unsigned char *data, size_t size, size_t chunk)
+{
+    tinyjambu_pmac_state_t state;
+    size_t len;
+    tinyjambu_pmac_init(&state, key);
+    while (size > 0) {
+        len = chunk;
+        if (len > size)
+            len = size;
+        tinyjambu_pmac_update(&state, data, len);
+        data += len;
+        size -= len;
+    }
+    tinyjambu_pmac_finalize(&state, tag);
+}
+
+static void test_pmac_small(const unsigned char *k, const unsigned char *data)
+{
+    tinyjambu_pmac_key_t key;
+    unsigned char expected[TINYJAMBU_PMAC_SIZE];
+    unsigned char actual[TINYJAMBU_PMAC_SIZE];
+    size_t size, chunk;
+    int ok = 1;
+
+    printf("TinyJAMBU-PMAC short messages ... ");
+    fflush(stdout);
+
+    tinyjambu_pmac_init_key(&key, k);
+    for (size = 0; size <= SMALL_DATA_LEN && ok; ++size) {
+        ref_pmac(expected, k, data, size);
+        tinyjambu_pmac(actual, &key, data, size);
+        if (test_memcmp(actual, expected, sizeof(actual)) != 0)
+            ok = 0;
+        for (chunk = 1; chunk <= 33; ++chunk) {
+            pmac_incremental(actual, &key, data, size, chunk);
+            if (test_memcmp(actual, expected, sizeof(actual)) != 0)
+                ok = 0;
+        }
+        if (tinyjambu_pmac_verify(expected, &key, data, size) != 0)
+            ok = 0;
+        expected[size % TINYJAMBU_PMAC_SIZE] ^= 0x40;
+        if (tinyjambu_pmac_verify(expected, &key, data, size) != -1)
+            ok = 0;
+    }
+    tinyjambu_pmac_free_key(&key);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+static void test_pmac_large(const unsigned char *k, const unsigned char *data)
+{
+    static size_t const sizes[] = {
+        LARGE_DATA_LEN, LARGE_DATA_LEN - 11, 16 * 4096 * 2 + 3, 16 * 4096 * 2
+    };
+    static unsigned const threads[] = {0, 1, 2, 3, 4, 8, 1000};
+    tinyjambu_pmac_key_t key;
+    unsigned char expected[TINYJAMBU_PMAC_SIZE];
+    unsigned char actual[TINYJAMBU_PMAC_SIZE];
+    unsigned index, thread_index;
+    int ok = 1;
+
+    printf("TinyJAMBU-PMAC long messages ... ");
+    fflush(stdout);
+
+    tinyjambu_pmac_init_key(&key, k);
+    for (index = 0; index < sizeof(sizes) / sizeof(sizes[0]); ++index) {
+        ref_pmac(expected, k, data, sizes[index]);
+        pmac_incremental(actual, &key, data, sizes[index], 1000);
+        if (test_memcmp(actual, expected, sizeof(actual)) != 0)
+            ok = 0;
+        for (thread_index = 0;
+                thread_index < sizeof(threads) / sizeof(threads[0]);
+                ++thread_index) {
+            memset(actual, 0xAA, sizeof(actual));
+            tinyjambu_pmac_parallel
+                (actual, &key, data, sizes[index], threads[thread_index]);
+            if (test_memcmp(actual, expected, sizeof(actual)) != 0)
+                ok = 0;
+        }
+    }
+    tinyjambu_pmac_free_key(&key);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned char k[TINYJAMBU_PMAC_KEY_SIZE];
+    unsigned char *data;
+    size_t posn;
+
+    (void)argc;
+    (void)argv;
+
+    data = (unsigned char *)malloc(LARGE_DATA_LEN);
+    if (!data)
+        return 1;
+    for (posn = 0; posn < sizeof(k); ++posn)
+        k[posn] = (unsigned char)(0x90 + posn);
+    for (posn = 0; posn < LARGE_DATA_LEN; ++posn)
+        data[posn] = (unsigned char)((posn * 13) ^ (posn >> 8));
+
+    test_pmac_small(k, data);
+    test_pmac_large(k, data);
+
+    free(data);
+    return test_exit_result;
+}
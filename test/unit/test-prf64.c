@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TinyJAMBU.h"
+#include "backend/tinyjambu-backend.h"
+#include "test-cipher.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define MAX_DATA_LEN 48
+#define MAX_BATCH 11
+
+/* Multiplies a 16-byte little-endian value by x in GF(2^128) */
+static void ref_double(unsigned char *out, const unsigned char *in)
+{
+    unsigned char carry = in[15] >> 7;
+    int index;
+    for (index = 15; index > 0; --index)
+        out[index] = (unsigned char)((in[index] << 1) | (in[index - 1] >> 7));
+    out[0] = (unsigned char)(in[0] << 1);
+    if (carry)
+        out[0] ^= 0x87;
+}
+
+/* Enciphers a block in place with the keyed TinyJAMBU-128 permutation */
+static void ref_encipher(const unsigned char *k, unsigned char *block)
+{
+    tinyjambu_128_state_t state;
+    int index;
+    for (index = 0; index < 4; ++index) {
+        state.s[index] =
+            ((uint32_t)(block[index * 4])) |
+            (((uint32_t)(block[index * 4 + 1])) << 8) |
+            (((uint32_t)(block[index * 4 + 2])) << 16) |
+            (((uint32_t)(block[index * 4 + 3])) << 24);
+        state.k[index] = ~(
+            ((uint32_t)(k[index * 4])) |
+            (((uint32_t)(k[index * 4 + 1])) << 8) |
+            (((uint32_t)(k[index * 4 + 2])) << 16) |
+            (((uint32_t)(k[index * 4 + 3])) << 24));
+    }
+    tinyjambu_permutation_128(&state, 8);
+    for (index = 0; index < 4; ++index) {
+        block[index * 4]     = (unsigned char)(state.s[index]);
+        block[index * 4 + 1] = (unsigned char)(state.s[index] >> 8);
+        block[index * 4 + 2] = (unsigned char)(state.s[index] >> 16);
+        block[index * 4 + 3] = (unsigned char)(state.s[index] >> 24);
+    }
+}
+
+/* Simple implementation of CMAC over the keyed permutation that is used
+ * to cross-check the more efficient version in the library */
+static uint64_t ref_prf64
+    (const unsigned char *k, const unsigned char *data, size_t size)
+{
+    unsigned char L[16], K1[16], K2[16], S[16];
+    uint64_t result = 0;
+    size_t posn;
+    int index;
+
+    memset(L, 0, sizeof(L));
+    ref_encipher(k, L);
+    ref_double(K1, L);
+    ref_double(K2, K1);
+
+    memset(S, 0, sizeof(S));
+    while (size > 16) {
+        for (posn = 0; posn < 16; ++posn)
+            S[posn] ^= data[posn];
+        ref_encipher(k, S);
+        data += 16;
+        size -= 16;
+    }
+    if (size == 16) {
+        for (posn = 0; posn < 16; ++posn)
+            S[posn] ^= data[posn] ^ K1[posn];
+    } else {
+        for (posn = 0; posn < size; ++posn)
+            S[posn] ^= data[posn];
+        S[size] ^= 0x80;
+        for (posn = 0; posn < 16; ++posn)
+            S[posn] ^= K2[posn];
+    }
+    ref_encipher(k, S);
+    for (index = 7; index >= 0; --index)
+        result = (result << 8) | S[index];
+    return result;
+}
+
+static void test_prf64(void)
+{
+    tinyjambu_prf64_key_t key;
+    unsigned char k[TINYJAMBU_PRF64_KEY_SIZE];
+    unsigned char data[MAX_DATA_LEN];
+    const unsigned char *ptrs[MAX_BATCH];
+    size_t sizes[MAX_BATCH];
+    uint64_t expected[MAX_BATCH];
+    uint64_t actual[MAX_BATCH + 1];
+    size_t size, count, index;
+    int ok = 1;
+
+    printf("TinyJAMBU-PRF64 ... ");
+    fflush(stdout);
+
+    for (index = 0; index < sizeof(k); ++index)
+        k[index] = (unsigned char)(0x31 * index + 7);
+    for (index = 0; index < sizeof(data); ++index)
+        data[index] = (unsigned char)(0xE0 - index);
+    tinyjambu_prf64_init_key(&key, k);
+
+    /* Check single inputs against the reference implementation */
+    for (size = 0; size <= MAX_DATA_LEN; ++size) {
+        if (tinyjambu_prf64(&key, data, size) != ref_prf64(k, data, size))
+            ok = 0;
+    }
+
+    /* Check batches of every size with a mix of input lengths, including
+     * a final group that does not fill all of the lanes */
+    for (index = 0; index < MAX_BATCH; ++index) {
+        sizes[index] = (index * 13 + 5) % (MAX_DATA_LEN + 1);
+        ptrs[index] = data + (MAX_DATA_LEN - sizes[index]);
+        expected[index] = ref_prf64(k, ptrs[index], sizes[index]);
+    }
+    for (count = 0; count <= MAX_BATCH; ++count) {
+        memset(actual, 0xAA, sizeof(actual));
+        tinyjambu_prf64_batch(&key, actual, ptrs, sizes, count);
+        for (index = 0; index < count; ++index) {
+            if (actual[index] != expected[index])
+                ok = 0;
+        }
+        if (actual[count] != 0xAAAAAAAAAAAAAAAAULL)
+            ok = 0;
+    }
+
+    tinyjambu_prf64_free_key(&key);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    test_prf64();
+
+    return test_exit_result;
+}
@@ -0,0 +1,528 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "TinyJAMBU.h"
+#include "backend/tinyjambu-backend.h"
+#include "test-cipher.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define MAX_BULK_LEN 10000
+
+/* Deterministic seed source so that the PRNG output is repeatable */
+static size_t test_prng_callback
+    (void *user_data, unsigned char *buf, size_t size)
+{
+    unsigned char *counter = (unsigned char *)user_data;
+    size_t posn;
+    for (posn = 0; posn < size; ++posn)
+        buf[posn] = (*counter)++;
+    return size;
+}
+
+/* Computes the expected bulk output for a given key, and the ratcheted key */
+static void test_prng_bulk_expected
+    (unsigned char key[TINYJAMBU_128_KEY_SIZE],
+     unsigned char *out, size_t outlen)
+{
+    static unsigned char const nonce[TINYJAMBU_NONCE_SIZE] = {0};
+    static unsigned char zeroes[TINYJAMBU_128_KEY_SIZE + 4096];
+    static unsigned char ciphertext
+        [TINYJAMBU_128_KEY_SIZE + 4096 + TINYJAMBU_TAG_SIZE];
+    size_t clen, len;
+    while (outlen > 0) {
+        len = outlen < 4096 ? outlen : 4096;
+        tinyjambu_128_aead_encrypt
+            (ciphertext, &clen, zeroes, TINYJAMBU_128_KEY_SIZE + len,
+             0, 0, nonce, key);
+        memcpy(key, ciphertext, TINYJAMBU_128_KEY_SIZE);
+        memcpy(out, ciphertext + TINYJAMBU_128_KEY_SIZE, len);
+        out += len;
+        outlen -= len;
+    }
+}
+
+static void test_prng_bulk(size_t len)
+{
+    tinyjambu_prng_state_t state;
+    tinyjambu_prng_state_t ref;
+    unsigned char key[TINYJAMBU_128_KEY_SIZE];
+    static unsigned char actual[MAX_BULK_LEN];
+    static unsigned char expected[MAX_BULK_LEN];
+    unsigned char counter1 = 0;
+    unsigned char counter2 = 0;
+    int ok = 1;
+
+    printf("TinyJAMBU-PRNG bulk %u ... ", (unsigned)len);
+    fflush(stdout);
+
+    /* Both PRNG's are seeded identically */
+    tinyjambu_prng_init_user(&state, test_prng_callback, &counter1, 0, 0);
+    tinyjambu_prng_init_user(&ref, test_prng_callback, &counter2, 0, 0);
+    tinyjambu_prng_set_reseed_limit(&state, 1024 * 1024);
+    tinyjambu_prng_set_reseed_limit(&ref, 1024 * 1024);
+
+    /* The first request derives the key from the DRBG */
+    tinyjambu_prng_generate(&ref, key, sizeof(key));
+    test_prng_bulk_expected(key, expected, len);
+    memset(actual, 0xAA, sizeof(actual));
+    tinyjambu_prng_generate_bulk(&state, actual, len);
+    if (test_memcmp(actual, expected, len) != 0)
+        ok = 0;
+
+    /* The second request continues with the ratcheted key */
+    test_prng_bulk_expected(key, expected, len);
+    memset(actual, 0xAA, sizeof(actual));
+    tinyjambu_prng_generate_bulk(&state, actual, len);
+    if (test_memcmp(actual, expected, len) != 0)
+        ok = 0;
+
+    /* Reseeding discards the key and derives a new one from the DRBG */
+    tinyjambu_prng_reseed(&state);
+    tinyjambu_prng_reseed(&ref);
+    tinyjambu_prng_generate(&ref, key, sizeof(key));
+    test_prng_bulk_expected(key, expected, len);
+    memset(actual, 0xAA, sizeof(actual));
+    tinyjambu_prng_generate_bulk(&state, actual, len);
+    if (test_memcmp(actual, expected, len) != 0)
+        ok = 0;
+
+    tinyjambu_prng_free(&state);
+    tinyjambu_prng_free(&ref);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+/* Reference implementation of Hash_DRBG instantiate and generate from
+ * SP.800-90Ar1 for cross-checking tinyjambu_prng_generate_hashgen() */
+typedef struct
+{
+    unsigned char V[32];
+    unsigned char C[32];
+    uint32_t reseed_counter;
+
+} test_hash_drbg_t;
+
+static void test_hash_df
+    (unsigned char out[32], const unsigned char *prefix, size_t prefix_len,
+     const unsigned char *in, size_t inlen)
+{
+    static unsigned char const header[5] = {1, 0, 0, 1, 0};
+    tinyjambu_hash_state_t hash;
+    tinyjambu_hash_init(&hash);
+    tinyjambu_hash_update(&hash, header, sizeof(header));
+    tinyjambu_hash_update(&hash, prefix, prefix_len);
+    tinyjambu_hash_update(&hash, in, inlen);
+    tinyjambu_hash_finalize(&hash, out);
+}
+
+static void test_hash_drbg_init
+    (test_hash_drbg_t *drbg, const unsigned char entropy[32])
+{
+    unsigned char temp[33];
+    test_hash_df(drbg->V, entropy, 32, 0, 0);
+    temp[0] = 0x00;
+    memcpy(temp + 1, drbg->V, 32);
+    test_hash_df(drbg->C, temp, sizeof(temp), 0, 0);
+    drbg->reseed_counter = 1;
+}
+
+static void test_hash_drbg_generate
+    (test_hash_drbg_t *drbg, unsigned char *out, size_t outlen)
+{
+    unsigned char data[33];
+    unsigned char H[32];
+    uint32_t carry;
+    size_t len;
+    int index;
+
+    /* Hashgen */
+    memcpy(data, drbg->V, 32);
+    while (outlen > 0) {
+        tinyjambu_hash(H, data, 32);
+        len = outlen < 32 ? outlen : 32;
+        memcpy(out, H, len);
+        out += len;
+        outlen -= len;
+        for (index = 31; index >= 0; --index) {
+            if (++(data[index]) != 0)
+                break;
+        }
+    }
+
+    /* V = V + Hash(0x03 || V) + C + reseed_counter */
+    data[0] = 0x03;
+    memcpy(data + 1, drbg->V, 32);
+    tinyjambu_hash(H, data, sizeof(data));
+    carry = drbg->reseed_counter;
+    for (index = 31; index >= 0; --index) {
+        carry += drbg->V[index];
+        carry += H[index];
+        carry += drbg->C[index];
+        drbg->V[index] = (unsigned char)carry;
+        carry >>= 8;
+    }
+    ++(drbg->reseed_counter);
+}
+
+static void test_prng_hashgen(unsigned char first_byte, size_t len)
+{
+    tinyjambu_prng_state_t state;
+    test_hash_drbg_t drbg;
+    unsigned char entropy[32];
+    static unsigned char actual[MAX_BULK_LEN];
+    static unsigned char expected[MAX_BULK_LEN];
+    unsigned char counter = first_byte;
+    int ok = 1;
+    int request;
+
+    printf("TinyJAMBU-PRNG hashgen %u ... ", (unsigned)len);
+    fflush(stdout);
+
+    tinyjambu_prng_init_user(&state, test_prng_callback, &counter, 0, 0);
+    tinyjambu_prng_set_reseed_limit(&state, 1024 * 1024);
+    counter = first_byte;
+    test_prng_callback(&counter, entropy, sizeof(entropy));
+    test_hash_drbg_init(&drbg, entropy);
+
+    for (request = 0; request < 3; ++request) {
+        test_hash_drbg_generate(&drbg, expected, len);
+        memset(actual, 0xAA, sizeof(actual));
+        tinyjambu_prng_generate_hashgen(&state, actual, len);
+        if (test_memcmp(actual, expected, len) != 0)
+            ok = 0;
+    }
+
+    tinyjambu_prng_free(&state);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+static void test_prng_buffer(void)
+{
+    tinyjambu_prng_state_t state;
+    tinyjambu_prng_state_t ref;
+    tinyjambu_prng_buffer_t buffer;
+    static unsigned char expected[1024];
+    unsigned char actual[1024];
+    unsigned counts[10];
+    unsigned shuffle[100];
+    unsigned char counter1 = 0;
+    unsigned char counter2 = 0;
+    uint32_t value;
+    double d;
+    size_t posn;
+    int index;
+    int ok = 1;
+
+    printf("TinyJAMBU-PRNG buffer ... ");
+    fflush(stdout);
+
+    tinyjambu_prng_init_user(&state, test_prng_callback, &counter1, 0, 0);
+    tinyjambu_prng_init_user(&ref, test_prng_callback, &counter2, 0, 0);
+    tinyjambu_prng_buffer_init(&buffer, &state);
+
+    /* Buffer refills come from the bulk generator 256 bytes at a time */
+    tinyjambu_prng_generate_bulk(&ref, expected, 256);
+    tinyjambu_prng_generate_bulk(&ref, expected + 256, 256);
+    for (posn = 0; posn < 256; posn += 4) {
+        value = tinyjambu_prng_buffer_u32(&buffer);
+        actual[posn] = (unsigned char)value;
+        actual[posn + 1] = (unsigned char)(value >> 8);
+        actual[posn + 2] = (unsigned char)(value >> 16);
+        actual[posn + 3] = (unsigned char)(value >> 24);
+    }
+    tinyjambu_prng_buffer_bytes(&buffer, actual + 256, 3);
+    tinyjambu_prng_buffer_bytes(&buffer, actual + 259, 253);
+    if (test_memcmp(actual, expected, 512) != 0)
+        ok = 0;
+
+    /* Large requests bypass the buffer when it is empty */
+    tinyjambu_prng_generate_bulk(&ref, expected, 1000);
+    tinyjambu_prng_buffer_bytes(&buffer, actual, 1000);
+    if (test_memcmp(actual, expected, 1000) != 0)
+        ok = 0;
+
+    /* Bounded integers must be in range and cover the whole range */
+    memset(counts, 0, sizeof(counts));
+    for (index = 0; index < 1000; ++index) {
+        value = tinyjambu_prng_buffer_uniform(&buffer, 10);
+        if (value >= 10)
+            ok = 0;
+        else
+            ++(counts[value]);
+    }
+    for (index = 0; index < 10; ++index) {
+        if (counts[index] == 0)
+            ok = 0;
+    }
+    if (tinyjambu_prng_buffer_uniform(&buffer, 0) != 0 ||
+            tinyjambu_prng_buffer_uniform(&buffer, 1) != 0)
+        ok = 0;
+    if (tinyjambu_prng_buffer_uniform(&buffer, 0xFFFFFFFFU) == 0xFFFFFFFFU)
+        ok = 0;
+
+    /* Doubles must be between 0 and 1 */
+    for (index = 0; index < 1000; ++index) {
+        d = tinyjambu_prng_buffer_double(&buffer);
+        if (d < 0.0 || d >= 1.0)
+            ok = 0;
+    }
+
+    /* Shuffling must produce a permutation of the original array */
+    for (index = 0; index < 100; ++index)
+        shuffle[index] = index;
+    tinyjambu_prng_buffer_shuffle(&buffer, shuffle, 100, sizeof(unsigned));
+    memset(counts, 0, sizeof(counts));
+    value = 0;
+    for (index = 0; index < 100; ++index) {
+        if (shuffle[index] >= 100)
+            ok = 0;
+        else
+            value += shuffle[index];
+        if (shuffle[index] != (unsigned)index)
+            ++(counts[0]);
+    }
+    if (value != 4950 || counts[0] == 0)
+        ok = 0;
+
+    tinyjambu_prng_buffer_free(&buffer);
+    tinyjambu_prng_free(&state);
+    tinyjambu_prng_free(&ref);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+/* Seed source that counts how many times it has been called */
+static unsigned test_prng_calls = 0;
+static size_t test_prng_counting_callback
+    (void *user_data, unsigned char *buf, size_t size)
+{
+    ++test_prng_calls;
+    return test_prng_callback(user_data, buf, size);
+}
+
+static void test_prng_async_reseed(void)
+{
+    tinyjambu_prng_state_t state;
+    tinyjambu_prng_state_t ref;
+    unsigned char counter1 = 0;
+    unsigned char counter2 = 0;
+    unsigned char actual[64];
+    unsigned char expected[64];
+    int index;
+    int ok = 1;
+
+    printf("TinyJAMBU-PRNG async reseed ... ");
+    fflush(stdout);
+
+    tinyjambu_prng_init_user
+        (&state, test_prng_counting_callback, &counter1, 0, 0);
+    tinyjambu_prng_init_user(&ref, test_prng_callback, &counter2, 0, 0);
+    tinyjambu_prng_set_async_reseed(&state, 1);
+    tinyjambu_prng_set_reseed_limit(&state, 32);
+    tinyjambu_prng_set_reseed_limit(&ref, 1024 * 1024);
+
+    /* Generating past the limit must not call the callback */
+    test_prng_calls = 0;
+    for (index = 0; index < 10; ++index) {
+        tinyjambu_prng_generate(&state, actual, sizeof(actual));
+        tinyjambu_prng_generate(&ref, expected, sizeof(expected));
+        if (test_memcmp(actual, expected, sizeof(actual)) != 0)
+            ok = 0;
+    }
+    if (test_prng_calls != 0)
+        ok = 0;
+
+    /* Prefetch calls the callback once, even if called twice */
+    if (!tinyjambu_prng_prefetch(&state) || !tinyjambu_prng_prefetch(&state))
+        ok = 0;
+    if (test_prng_calls != 1)
+        ok = 0;
+
+    /* The next generate request should reseed with the prefetched entropy */
+    tinyjambu_prng_generate(&state, actual, sizeof(actual));
+    tinyjambu_prng_generate(&ref, expected, sizeof(expected));
+    if (!memcmp(actual, expected, sizeof(actual)))
+        ok = 0;
+    if (test_prng_calls != 1)
+        ok = 0;
+
+    /* The pending entropy has been used up so prefetch must fetch again */
+    if (!tinyjambu_prng_prefetch(&state) || test_prng_calls != 2)
+        ok = 0;
+
+    tinyjambu_prng_free(&state);
+    tinyjambu_prng_free(&ref);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+/* Reference implementation of the counter-based PRNG block function */
+static void test_ctr_prng_block
+    (const unsigned char seed[16], uint64_t stream, uint64_t block,
+     unsigned char out[16])
+{
+    tinyjambu_128_state_t state;
+    uint32_t X[4];
+    int index;
+    X[0] = (uint32_t)block;
+    X[1] = (uint32_t)(block >> 32);
+    X[2] = (uint32_t)stream;
+    X[3] = (uint32_t)(stream >> 32);
+    for (index = 0; index < 4; ++index) {
+        state.s[index] = X[index];
+        state.k[index] = ~(seed[index * 4] |
+                           (((uint32_t)(seed[index * 4 + 1])) << 8) |
+                           (((uint32_t)(seed[index * 4 + 2])) << 16) |
+                           (((uint32_t)(seed[index * 4 + 3])) << 24));
+    }
+    tinyjambu_permutation_128(&state, TINYJAMBU_ROUNDS(1024));
+    for (index = 0; index < 4; ++index) {
+        uint32_t word = state.s[index] ^ X[index];
+        out[index * 4] = (unsigned char)word;
+        out[index * 4 + 1] = (unsigned char)(word >> 8);
+        out[index * 4 + 2] = (unsigned char)(word >> 16);
+        out[index * 4 + 3] = (unsigned char)(word >> 24);
+    }
+}
+
+static void test_ctr_prng(void)
+{
+    static unsigned char const seed[TINYJAMBU_CTR_PRNG_SEED_SIZE] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+        0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+    };
+    static uint64_t const stream = 0x0123456789ABCDEFULL;
+    tinyjambu_ctr_prng_t ctx;
+    tinyjambu_ctr_prng_t other;
+    static unsigned char expected[1000];
+    static unsigned char actual[1000];
+    size_t posn, len;
+    int ok = 1;
+
+    printf("TinyJAMBU-CTR-PRNG ... ");
+    fflush(stdout);
+
+    /* Reference output */
+    for (posn = 0; posn < sizeof(expected); posn += 16) {
+        unsigned char block[16];
+        test_ctr_prng_block(seed, stream, posn / 16, block);
+        len = sizeof(expected) - posn;
+        memcpy(expected + posn, block, len < 16 ? len : 16);
+    }
+
+    /* Generate everything in one request */
+    tinyjambu_ctr_prng_init(&ctx, seed, stream);
+    memset(actual, 0xAA, sizeof(actual));
+    tinyjambu_ctr_prng_generate(&ctx, actual, sizeof(actual));
+    if (test_memcmp(actual, expected, sizeof(expected)) != 0)
+        ok = 0;
+
+    /* Generate in odd-sized chunks */
+    tinyjambu_ctr_prng_seek(&ctx, 0);
+    memset(actual, 0xAA, sizeof(actual));
+    for (posn = 0, len = 1; posn < sizeof(actual); posn += len, len += 7) {
+        if (len > (sizeof(actual) - posn))
+            len = sizeof(actual) - posn;
+        tinyjambu_ctr_prng_generate(&ctx, actual + posn, len);
+    }
+    if (test_memcmp(actual, expected, sizeof(expected)) != 0)
+        ok = 0;
+
+    /* Skipping and random access */
+    tinyjambu_ctr_prng_seek(&ctx, 5);
+    tinyjambu_ctr_prng_skip(&ctx, 300);
+    memset(actual, 0xAA, sizeof(actual));
+    tinyjambu_ctr_prng_generate(&ctx, actual, 500);
+    if (test_memcmp(actual, expected + 305, 500) != 0)
+        ok = 0;
+    memset(actual, 0xAA, sizeof(actual));
+    tinyjambu_ctr_prng_generate_at(&ctx, 999, actual, 1);
+    tinyjambu_ctr_prng_generate_at(&ctx, 17, actual + 1, 130);
+    if (actual[0] != expected[999] || test_memcmp(actual + 1, expected + 17, 130) != 0)
+        ok = 0;
+
+    /* A different stream identifier must produce different output */
+    tinyjambu_ctr_prng_init(&other, seed, stream + 1);
+    tinyjambu_ctr_prng_generate(&other, actual, 64);
+    if (!memcmp(actual, expected, 64))
+        ok = 0;
+
+    tinyjambu_ctr_prng_free(&ctx);
+    tinyjambu_ctr_prng_free(&other);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    if (!hash_sanity_check())
+        return 1;
+
+    test_prng_bulk(1);
+    test_prng_bulk(35);
+    test_prng_bulk(4096);
+    test_prng_bulk(MAX_BULK_LEN);
+
+    test_prng_hashgen(0, 1);
+    test_prng_hashgen(0, 100);
+    test_prng_hashgen(0, 2000);
+    test_prng_hashgen(0x55, 2000);
+
+    test_prng_buffer();
+    test_prng_async_reseed();
+
+    test_ctr_prng();
+
+    return test_exit_result;
+}
@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#if defined(HAVE_CONFIG_H)
+#include <config.h>
+#endif
+#include "TinyJAMBU.h"
+#include "random/tinyjambu-trng.h"
+#include "test-cipher.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#endif
+#if defined(HAVE_UNISTD_H) && defined(__unix__)
+#include <unistd.h>
+#include <sys/wait.h>
+#define TEST_FORK 1
+#endif
+
+#define NUM_THREADS 8
+#define SAMPLE_LEN 16
+
+static unsigned char samples[NUM_THREADS][SAMPLE_LEN];
+
+/* Generates some data on a thread and records a sample of the output */
+static void *test_random_thread(void *arg)
+{
+    unsigned char *sample = (unsigned char *)arg;
+    unsigned char data[100];
+    int index;
+    for (index = 0; index < 1000; ++index)
+        tinyjambu_random_u32();
+    tinyjambu_random_bytes(data, sizeof(data));
+    tinyjambu_random_bytes(sample, SAMPLE_LEN);
+    return 0;
+}
+
+static void test_random_threads(void)
+{
+    int ok = 1;
+    int i, j;
+
+    printf("Random Threads ... ");
+    fflush(stdout);
+
+    memset(samples, 0, sizeof(samples));
+#if defined(HAVE_PTHREAD)
+    {
+        pthread_t threads[NUM_THREADS];
+        for (i = 0; i < NUM_THREADS; ++i) {
+            if (pthread_create(&threads[i], 0, test_random_thread, samples[i]) != 0)
+                ok = 0;
+        }
+        for (i = 0; i < NUM_THREADS; ++i)
+            pthread_join(threads[i], 0);
+    }
+#else
+    for (i = 0; i < NUM_THREADS; ++i)
+        test_random_thread(samples[i]);
+#endif
+
+    /* Every thread should have produced different output */
+    for (i = 0; i < NUM_THREADS; ++i) {
+        for (j = i + 1; j < NUM_THREADS; ++j) {
+            if (!memcmp(samples[i], samples[j], SAMPLE_LEN))
+                ok = 0;
+        }
+    }
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+#if defined(TEST_FORK)
+
+static void test_random_fork(void)
+{
+    unsigned char parent[SAMPLE_LEN];
+    unsigned char child[SAMPLE_LEN];
+    int fds[2];
+    pid_t pid;
+    int ok = 1;
+
+    printf("Random Fork ... ");
+    fflush(stdout);
+
+    /* Make sure the state exists in the parent before forking */
+    tinyjambu_random_bytes(parent, sizeof(parent));
+
+    /* The child sends the next output back to the parent */
+    if (pipe(fds) < 0) {
+        printf("failed\n");
+        test_exit_result = 1;
+        return;
+    }
+    pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        tinyjambu_random_bytes(child, sizeof(child));
+        if (write(fds[1], child, sizeof(child)) != (ssize_t)sizeof(child))
+            _exit(1);
+        _exit(0);
+    }
+    close(fds[1]);
+    memset(child, 0, sizeof(child));
+    if (pid < 0 || read(fds[0], child, sizeof(child)) != (ssize_t)sizeof(child))
+        ok = 0;
+    close(fds[0]);
+    if (pid > 0)
+        waitpid(pid, 0, 0);
+
+    /* The parent and child must not produce the same output */
+    tinyjambu_random_bytes(parent, sizeof(parent));
+    if (!memcmp(parent, child, sizeof(child)))
+        ok = 0;
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+#endif
+
+static void test_trng_health(void)
+{
+    unsigned char sample[32];
+    unsigned char mixed[32];
+    unsigned index;
+    int ok = 1;
+
+    printf("TRNG Health Tests ... ");
+    fflush(stdout);
+
+    /* Distinct byte values should pass */
+    for (index = 0; index < sizeof(sample); ++index)
+        sample[index] = (unsigned char)(index * 37 + 11);
+    if (!tinyjambu_trng_health_check(sample, sizeof(sample)))
+        ok = 0;
+
+    /* Repeated words should fail */
+    memcpy(sample + sizeof(size_t), sample, sizeof(size_t));
+    if (tinyjambu_trng_health_check(sample, sizeof(sample)))
+        ok = 0;
+
+    /* All-ones words should fail */
+    for (index = 0; index < sizeof(sample); ++index)
+        sample[index] = (unsigned char)(index * 37 + 11);
+    memset(sample + 16, 0xFF, sizeof(size_t));
+    if (tinyjambu_trng_health_check(sample, sizeof(sample)))
+        ok = 0;
+
+    /* Too many copies of a single byte value should fail */
+    for (index = 0; index < sizeof(sample); ++index)
+        sample[index] = (unsigned char)((index & 1) ? 0x5A : index);
+    if (tinyjambu_trng_health_check(sample, sizeof(sample)))
+        ok = 0;
+
+    /* If hardware random numbers are mixed in, then the result must have
+     * changed and it must pass the health tests.  Otherwise no change */
+    memset(mixed, 0, sizeof(mixed));
+    if (tinyjambu_trng_hw_mix(mixed, sizeof(mixed))) {
+        if (!tinyjambu_trng_health_check(mixed, sizeof(mixed)))
+            ok = 0;
+    } else {
+        memset(sample, 0, sizeof(sample));
+        if (memcmp(mixed, sample, sizeof(sample)) != 0)
+            ok = 0;
+    }
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    test_trng_health();
+    test_random_threads();
+#if defined(TEST_FORK)
+    test_random_fork();
+#endif
+
+    return test_exit_result;
+}
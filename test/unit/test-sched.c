@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TinyJAMBU.h"
+#include "test-cipher.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define NUM_JOBS 40
+#define NUM_KEYS 3
+#define MAX_DATA_LEN 300
+#define MAX_AD_LEN 23
+
+typedef struct
+{
+    tinyjambu_128_aead_job_t job;
+    unsigned char npub[TINYJAMBU_NONCE_SIZE];
+    unsigned char ad[MAX_AD_LEN];
+    unsigned char in[MAX_DATA_LEN];
+    unsigned char out[MAX_DATA_LEN];
+    unsigned char tag[TINYJAMBU_TAG_SIZE];
+    unsigned char expected[MAX_DATA_LEN];
+    unsigned char expected_tag[TINYJAMBU_TAG_SIZE];
+    int expected_result;
+    int done;
+
+} TestSchedJob;
+
+static unsigned char keys[NUM_KEYS][TINYJAMBU_128_KEY_SIZE];
+static tinyjambu_128_key_t key_schedules[NUM_KEYS];
+static TestSchedJob jobs[NUM_JOBS];
+static tinyjambu_128_sched_t sched;
+static int resubmitted;
+
+/* Sets up a job with a mixture of lengths, keys, and directions */
+static void setup_job(TestSchedJob *job, int index, int decrypt, int tamper)
+{
+    unsigned char *k = keys[index % NUM_KEYS];
+    size_t adlen = (index * 7) % (MAX_AD_LEN + 1);
+    size_t inlen = (index * 37) % (MAX_DATA_LEN + 1);
+    unsigned char c[MAX_DATA_LEN];
+    unsigned char tag[TINYJAMBU_TAG_SIZE];
+    size_t posn;
+
+    memset(job, 0, sizeof(TestSchedJob));
+    for (posn = 0; posn < sizeof(job->npub); ++posn)
+        job->npub[posn] = (unsigned char)(index + posn);
+    for (posn = 0; posn < adlen; ++posn)
+        job->ad[posn] = (unsigned char)(index * 3 + posn);
+    for (posn = 0; posn < inlen; ++posn)
+        job->in[posn] = (unsigned char)(index * 5 + posn * 11);
+    tinyjambu_128_aead_encrypt_detached
+        (c, tag, job->in, inlen, job->ad, adlen, job->npub, k);
+    if (decrypt) {
+        memcpy(job->expected, job->in, inlen);
+        memcpy(job->in, c, inlen);
+        memcpy(job->tag, tag, sizeof(tag));
+        if (tamper) {
+            job->tag[index % TINYJAMBU_TAG_SIZE] ^= 0x01;
+            memset(job->expected, 0, inlen);
+            job->expected_result = -1;
+        }
+    } else {
+        memcpy(job->expected, c, inlen);
+        memcpy(job->expected_tag, tag, sizeof(tag));
+    }
+
+    job->job.key = &(key_schedules[index % NUM_KEYS]);
+    job->job.npub = job->npub;
+    job->job.ad = job->ad;
+    job->job.adlen = adlen;
+    job->job.in = job->in;
+    job->job.inlen = inlen;
+    job->job.out = job->out;
+    job->job.tag = job->tag;
+    job->job.decrypt = decrypt;
+    job->job.user_data = job;
+    job->job.result = 99;
+}
+
+/* Checks the results of a completed job */
+static int check_job(const TestSchedJob *job)
+{
+    if (job->job.result != job->expected_result)
+        return 0;
+    if (memcmp(job->out, job->expected, job->job.inlen) != 0)
+        return 0;
+    if (!job->job.decrypt &&
+            memcmp(job->tag, job->expected_tag, TINYJAMBU_TAG_SIZE) != 0)
+        return 0;
+    return 1;
+}
+
+static void job_done(tinyjambu_128_aead_job_t *job)
+{
+    TestSchedJob *tjob = (TestSchedJob *)(job->user_data);
+    ++(tjob->done);
+
+    /* Submit the second half of the jobs from within the callback */
+    if (resubmitted < NUM_JOBS / 2) {
+        tinyjambu_128_sched_submit
+            (&sched, &(jobs[NUM_JOBS / 2 + resubmitted].job));
+        ++resubmitted;
+    }
+}
+
+static void setup_all(void)
+{
+    int index;
+    for (index = 0; index < NUM_JOBS; ++index)
+        setup_job(&jobs[index], index, index % 3 != 0, index % 9 == 4);
+}
+
+static void test_callback(void)
+{
+    int index;
+    int ok = 1;
+    size_t count;
+
+    printf("TinyJAMBU-128 scheduler with callbacks ... ");
+    fflush(stdout);
+
+    setup_all();
+    resubmitted = 0;
+    tinyjambu_128_sched_init(&sched, job_done);
+    for (index = 0; index < NUM_JOBS / 2; ++index)
+        tinyjambu_128_sched_submit(&sched, &(jobs[index].job));
+    count = tinyjambu_128_sched_run(&sched);
+    if (count != NUM_JOBS)
+        ok = 0;
+    if (tinyjambu_128_sched_poll(&sched) != 0)
+        ok = 0;
+    for (index = 0; index < NUM_JOBS; ++index) {
+        if (jobs[index].done != 1 || !check_job(&jobs[index]))
+            ok = 0;
+    }
+    tinyjambu_128_sched_free(&sched);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+static void test_poll(void)
+{
+    tinyjambu_128_aead_job_t *job;
+    int index;
+    int ok = 1;
+    size_t count;
+
+    printf("TinyJAMBU-128 scheduler with polling ... ");
+    fflush(stdout);
+
+    /* Process the jobs in reverse order this time */
+    setup_all();
+    tinyjambu_128_sched_init(&sched, 0);
+    for (index = NUM_JOBS - 1; index >= 0; --index)
+        tinyjambu_128_sched_submit(&sched, &(jobs[index].job));
+    count = tinyjambu_128_sched_run(&sched);
+    if (count != NUM_JOBS)
+        ok = 0;
+    while ((job = tinyjambu_128_sched_poll(&sched)) != 0)
+        ++(((TestSchedJob *)(job->user_data))->done);
+    for (index = 0; index < NUM_JOBS; ++index) {
+        if (jobs[index].done != 1 || !check_job(&jobs[index]))
+            ok = 0;
+    }
+
+    /* Running an empty scheduler does nothing */
+    if (tinyjambu_128_sched_run(&sched) != 0)
+        ok = 0;
+    tinyjambu_128_sched_free(&sched);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int index, posn;
+
+    (void)argc;
+    (void)argv;
+
+    for (index = 0; index < NUM_KEYS; ++index) {
+        for (posn = 0; posn < TINYJAMBU_128_KEY_SIZE; ++posn)
+            keys[index][posn] = (unsigned char)(index * 64 + posn * 3 + 1);
+        tinyjambu_128_key_init(&(key_schedules[index]), keys[index]);
+    }
+
+    test_callback();
+    test_poll();
+
+    for (index = 0; index < NUM_KEYS; ++index)
+        tinyjambu_128_key_free(&(key_schedules[index]));
+    return test_exit_result;
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TinyJAMBU.h"
+#include "test-cipher.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define MAX_SECTORS 37
+#define FIRST_SECTOR 0x123456789ULL
+
+static void test_sectors(size_t sector_size, unsigned threads)
+{
+    static size_t const counts[] = {0, 1, 2, 3, 4, 5, 7, 8, 9, MAX_SECTORS};
+    unsigned char key[TINYJAMBU_128_KEY_SIZE];
+    unsigned char nonce[TINYJAMBU_NONCE_SIZE];
+    size_t total = MAX_SECTORS * sector_size;
+    unsigned char *m = (unsigned char *)malloc(total);
+    unsigned char *c1 = (unsigned char *)malloc(total);
+    unsigned char *c2 = (unsigned char *)malloc(total);
+    unsigned char *out = (unsigned char *)malloc(total);
+    unsigned char tags1[MAX_SECTORS * TINYJAMBU_TAG_SIZE];
+    unsigned char tags2[MAX_SECTORS * TINYJAMBU_TAG_SIZE];
+    size_t posn, index, count, bad;
+    int ok = 1;
+
+    printf("TinyJAMBU-128-SIV sectors, %d bytes, %u threads ... ",
+           (int)sector_size, threads);
+    fflush(stdout);
+
+    if (!m || !c1 || !c2 || !out)
+        exit(2);
+    for (posn = 0; posn < sizeof(key); ++posn)
+        key[posn] = (unsigned char)(posn * 5 + 1);
+    for (posn = 0; posn < total; ++posn)
+        m[posn] = (unsigned char)(posn * 17 + (posn >> 9));
+
+    /* Reference output from encrypting each sector separately */
+    for (index = 0; index < MAX_SECTORS; ++index) {
+        tinyjambu_128_siv_sector_nonce(nonce, FIRST_SECTOR + index);
+        tinyjambu_128_siv_encrypt_detached
+            (c1 + index * sector_size, tags1 + index * TINYJAMBU_TAG_SIZE,
+             m + index * sector_size, sector_size, 0, 0, nonce, key);
+    }
+
+    for (index = 0; ok && index < sizeof(counts) / sizeof(counts[0]);
+            ++index) {
+        count = counts[index];
+
+        /* Batched encryption must match the reference */
+        memset(c2, 0xAA, total);
+        memset(tags2, 0xAA, sizeof(tags2));
+        if (tinyjambu_128_siv_encrypt_sectors
+                (c2, tags2, m, sector_size, FIRST_SECTOR, count,
+                 key, threads) != 0)
+            ok = 0;
+        if (memcmp(c1, c2, count * sector_size) != 0 ||
+                memcmp(tags1, tags2, count * TINYJAMBU_TAG_SIZE) != 0)
+            ok = 0;
+
+        /* In-place encryption */
+        memcpy(c2, m, total);
+        tinyjambu_128_siv_encrypt_sectors
+            (c2, tags2, c2, sector_size, FIRST_SECTOR, count, key, threads);
+        if (memcmp(c1, c2, count * sector_size) != 0 ||
+                memcmp(tags1, tags2, count * TINYJAMBU_TAG_SIZE) != 0)
+            ok = 0;
+
+        /* Decryption, both out-of-place and in-place */
+        if (tinyjambu_128_siv_decrypt_sectors
+                (out, c1, tags1, sector_size, FIRST_SECTOR, count,
+                 key, threads) != 0)
+            ok = 0;
+        if (memcmp(out, m, count * sector_size) != 0)
+            ok = 0;
+        if (tinyjambu_128_siv_decrypt_sectors
+                (c2, c2, tags1, sector_size, FIRST_SECTOR, count,
+                 key, threads) != 0)
+            ok = 0;
+        if (memcmp(c2, m, count * sector_size) != 0)
+            ok = 0;
+
+        /* Corrupting one sector only destroys that sector */
+        if (count > 0) {
+            bad = count / 2;
+            memcpy(c2, c1, total);
+            c2[bad * sector_size + sector_size - 1] ^= 0x10;
+            if (tinyjambu_128_siv_decrypt_sectors
+                    (out, c2, tags1, sector_size, FIRST_SECTOR, count,
+                     key, threads) != -1)
+                ok = 0;
+            for (posn = 0; posn < count * sector_size; ++posn) {
+                if ((posn / sector_size) == bad) {
+                    if (out[posn] != 0)
+                        ok = 0;
+                } else if (out[posn] != m[posn]) {
+                    ok = 0;
+                }
+            }
+
+            /* Decrypting at the wrong sector number fails */
+            if (tinyjambu_128_siv_decrypt_sectors
+                    (out, c1, tags1, sector_size, FIRST_SECTOR + 1, count,
+                     key, threads) != -1)
+                ok = 0;
+        }
+    }
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+    free(m);
+    free(c1);
+    free(c2);
+    free(out);
+}
+
+static void test_invalid(void)
+{
+    unsigned char key[TINYJAMBU_128_KEY_SIZE] = {0};
+    unsigned char data[64] = {0};
+    unsigned char tags[TINYJAMBU_TAG_SIZE * 2];
+    int ok = 1;
+
+    printf("TinyJAMBU-128-SIV sectors invalid parameters ... ");
+    fflush(stdout);
+
+    if (tinyjambu_128_siv_encrypt_sectors(data, tags, data, 0, 0, 1, key, 1)
+            != -1)
+        ok = 0;
+    if (tinyjambu_128_siv_encrypt_sectors(data, tags, data, 30, 0, 2, key, 1)
+            != -1)
+        ok = 0;
+    if (tinyjambu_128_siv_decrypt_sectors(data, data, tags, 30, 0, 2, key, 1)
+            != -1)
+        ok = 0;
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    test_sectors(512, 1);
+    test_sectors(512, 4);
+    test_sectors(4096, 1);
+    test_sectors(4096, 3);
+    test_sectors(12, 2);
+    test_invalid();
+    return test_exit_result;
+}
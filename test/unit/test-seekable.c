@@ -0,0 +1,341 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TinyJAMBU.h"
+#include "test-cipher.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define MSG_LEN 50000
+#define BLOCK_SIZE 1000
+#define CACHE_BLOCKS 4
+
+static unsigned char const file_id[TINYJAMBU_SEEKABLE_FILE_ID_SIZE] = {
+    0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67
+};
+
+typedef struct
+{
+    const unsigned char *data;
+    uint64_t size;
+    unsigned reads;
+
+} test_file_t;
+
+static int test_read
+    (void *ctx, unsigned char *buf, size_t len, uint64_t offset)
+{
+    test_file_t *file = (test_file_t *)ctx;
+    ++(file->reads);
+    if (offset > file->size || len > (file->size - offset))
+        return -1;
+    memcpy(buf, file->data + offset, len);
+    return 0;
+}
+
+/* Builds a container from a plaintext message */
+static int test_build
+    (unsigned char *c, const unsigned char *m, size_t mlen,
+     int mode, const unsigned char *key, size_t keylen)
+{
+    uint64_t index, num_blocks;
+    size_t reclen;
+    if (tinyjambu_seekable_init_header
+            (c, mode, keylen, BLOCK_SIZE, mlen, file_id) != 0)
+        return 0;
+    num_blocks = (mlen + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    for (index = 0; index < num_blocks; ++index) {
+        if (tinyjambu_seekable_seal_block
+                (c + tinyjambu_seekable_block_offset(c, index), &reclen,
+                 c, index, m + index * BLOCK_SIZE, key) != 0)
+            return 0;
+    }
+    if (tinyjambu_seekable_seal_block
+            (c + TINYJAMBU_SEEKABLE_HEADER_SIZE, &reclen,
+             c, num_blocks, m, key) != -1)
+        return 0;
+    return 1;
+}
+
+static void test_seekable(int mode, size_t keylen, size_t mlen)
+{
+    unsigned char key[32];
+    unsigned char *m = (unsigned char *)malloc(MSG_LEN);
+    unsigned char *c = (unsigned char *)malloc(MSG_LEN * 2);
+    unsigned char *out = (unsigned char *)malloc(MSG_LEN);
+    unsigned char *cache;
+    size_t cache_size = CACHE_BLOCKS * (BLOCK_SIZE + 64);
+    tinyjambu_seekable_reader_t reader;
+    test_file_t file;
+    uint64_t hits, misses, hits2, misses2;
+    size_t posn, len, offset, nread;
+    int ok = 1;
+    int iter;
+
+    printf("TinyJAMBU-%s seekable, %d-bit key, %d bytes ... ",
+           mode == TINYJAMBU_SEEKABLE_SIV ? "SIV" : "AEAD",
+           (int)(keylen * 8), (int)mlen);
+    fflush(stdout);
+
+    cache = (unsigned char *)malloc(cache_size + 1);
+    if (!m || !c || !out || !cache)
+        exit(2);
+    for (posn = 0; posn < sizeof(key); ++posn)
+        key[posn] = (unsigned char)(posn * 7 + keylen + mode);
+    for (posn = 0; posn < mlen; ++posn)
+        m[posn] = (unsigned char)(posn * 11 + (posn >> 8));
+
+    if (!test_build(c, m, mlen, mode, key, keylen))
+        ok = 0;
+    file.data = c;
+    file.size = tinyjambu_seekable_size(mlen, BLOCK_SIZE);
+    file.reads = 0;
+
+    /* Deliberately misalign the cache to check that it is realigned */
+    if (tinyjambu_seekable_open
+            (&reader, test_read, &file, key, keylen,
+             cache + 1, cache_size) != 0)
+        ok = 0;
+    if (ok && tinyjambu_seekable_length(&reader) != mlen)
+        ok = 0;
+
+    /* Read random ranges and compare against the plaintext */
+    srand(mlen + mode);
+    for (iter = 0; ok && iter < 500; ++iter) {
+        offset = (size_t)(rand() % (mlen + 10));
+        len = (size_t)(rand() % (BLOCK_SIZE * 3));
+        if (tinyjambu_seekable_pread(&reader, out, len, offset, &nread) != 0)
+            ok = 0;
+        if (offset >= mlen) {
+            if (nread != 0)
+                ok = 0;
+        } else {
+            if (nread != (len < mlen - offset ? len : mlen - offset))
+                ok = 0;
+            if (memcmp(out, m + offset, nread) != 0)
+                ok = 0;
+        }
+    }
+
+    /* Re-reading a range that is in the cache does not touch the file */
+    if (ok && mlen > 0) {
+        tinyjambu_seekable_pread(&reader, out, 10, mlen - 10, &nread);
+        tinyjambu_seekable_cache_stats(&reader, &hits, &misses);
+        file.reads = 0;
+        if (tinyjambu_seekable_pread
+                (&reader, out, 10, mlen - 10, &nread) != 0)
+            ok = 0;
+        tinyjambu_seekable_cache_stats(&reader, &hits2, &misses2);
+        if (file.reads != 0 || hits2 <= hits || misses2 != misses)
+            ok = 0;
+        if (memcmp(out, m + mlen - 10, 10) != 0)
+            ok = 0;
+    }
+
+    /* Reading more blocks than the cache holds evicts the oldest */
+    if (ok && mlen >= BLOCK_SIZE * (CACHE_BLOCKS + 1)) {
+        for (posn = 0; posn <= CACHE_BLOCKS; ++posn) {
+            tinyjambu_seekable_pread
+                (&reader, out, 1, posn * BLOCK_SIZE, &nread);
+        }
+        file.reads = 0;
+        tinyjambu_seekable_pread
+            (&reader, out, 1, CACHE_BLOCKS * BLOCK_SIZE, &nread);
+        if (file.reads != 0)
+            ok = 0;
+        tinyjambu_seekable_pread(&reader, out, 1, 0, &nread);
+        if (file.reads != 1 || out[0] != m[0])
+            ok = 0;
+    }
+    tinyjambu_seekable_close(&reader);
+
+    /* Corrupt the middle of the last block.  Other blocks are still
+     * readable but the corrupted block fails to authenticate */
+    if (ok && mlen > 0) {
+        c[file.size - 10] ^= 0x04;
+        if (tinyjambu_seekable_open
+                (&reader, test_read, &file, key, keylen,
+                 cache, cache_size) != 0)
+            ok = 0;
+        if (tinyjambu_seekable_pread(&reader, out, 1, 0, &nread) != 0 &&
+                mlen > BLOCK_SIZE)
+            ok = 0;
+        memset(out, 0xAA, 20);
+        if (tinyjambu_seekable_pread
+                (&reader, out, 20, mlen > 20 ? mlen - 20 : 0, &nread) != -1)
+            ok = 0;
+        if (nread != 0)
+            ok = 0;
+        for (posn = 0; posn < 20; ++posn) {
+            if (out[posn] != 0)
+                ok = 0;
+        }
+        tinyjambu_seekable_close(&reader);
+        c[file.size - 10] ^= 0x04;
+    }
+
+    /* The length in the header is authenticated */
+    if (ok && mlen > 0) {
+        c[12] ^= 0x01;
+        if (tinyjambu_seekable_open
+                (&reader, test_read, &file, key, keylen,
+                 cache, cache_size) == 0) {
+            if (tinyjambu_seekable_pread(&reader, out, 1, 0, &nread) != -1)
+                ok = 0;
+            tinyjambu_seekable_close(&reader);
+        }
+        c[12] ^= 0x01;
+    }
+
+    /* With SIV, a single block can be rewritten in-place */
+    if (ok && mode == TINYJAMBU_SEEKABLE_SIV && mlen > BLOCK_SIZE * 2) {
+        size_t reclen;
+        m[BLOCK_SIZE + 5] ^= 0xFF;
+        if (tinyjambu_seekable_rewrite_block
+                (c + tinyjambu_seekable_block_offset(c, 1), &reclen, c, 1,
+                 m + BLOCK_SIZE, key) != 0)
+            ok = 0;
+        if (reclen != BLOCK_SIZE + TINYJAMBU_TAG_SIZE)
+            ok = 0;
+        tinyjambu_seekable_open
+            (&reader, test_read, &file, key, keylen, cache, cache_size);
+        if (tinyjambu_seekable_pread
+                (&reader, out, BLOCK_SIZE * 2, BLOCK_SIZE / 2, &nread) != 0)
+            ok = 0;
+        if (memcmp(out, m + BLOCK_SIZE / 2, BLOCK_SIZE * 2) != 0)
+            ok = 0;
+        tinyjambu_seekable_close(&reader);
+    }
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+    free(m);
+    free(c);
+    free(out);
+    free(cache);
+}
+
+static void test_invalid(void)
+{
+    unsigned char key[32] = {0};
+    unsigned char c[TINYJAMBU_SEEKABLE_HEADER_SIZE + 64];
+    unsigned char m[16] = {0};
+    unsigned char cache[256];
+    unsigned char saved[TINYJAMBU_SEEKABLE_HEADER_SIZE];
+    tinyjambu_seekable_reader_t reader;
+    test_file_t file;
+    size_t reclen;
+    int ok = 1;
+
+    printf("TinyJAMBU seekable invalid parameters ... ");
+    fflush(stdout);
+
+    if (tinyjambu_seekable_init_header(c, 2, 16, 16, 0, file_id) != -1)
+        ok = 0;
+    if (tinyjambu_seekable_init_header(c, 0, 20, 16, 0, file_id) != -1)
+        ok = 0;
+    if (tinyjambu_seekable_init_header(c, 0, 16, 0, 0, file_id) != -1)
+        ok = 0;
+    if (tinyjambu_seekable_init_header
+            (c, 0, 16, 1, 0x100000001ULL, file_id) != -1)
+        ok = 0;
+
+    if (!test_build(c, m, sizeof(m), TINYJAMBU_SEEKABLE_AEAD, key, 16))
+        ok = 0;
+    file.data = c;
+    file.size = tinyjambu_seekable_size(sizeof(m), BLOCK_SIZE);
+    file.reads = 0;
+
+    /* The key size must match the header */
+    if (tinyjambu_seekable_open
+            (&reader, test_read, &file, key, 32, cache, sizeof(cache)) != -1)
+        ok = 0;
+
+    /* The cache must be able to hold at least one block */
+    if (tinyjambu_seekable_open
+            (&reader, test_read, &file, key, 16, cache, 16) != -1)
+        ok = 0;
+
+    /* The magic number must be correct */
+    c[0] ^= 0x01;
+    if (tinyjambu_seekable_open
+            (&reader, test_read, &file, key, 16, cache, sizeof(cache)) != -1)
+        ok = 0;
+    c[0] ^= 0x01;
+
+    /* Blocks of an AEAD container cannot be rewritten */
+    if (tinyjambu_seekable_rewrite_block
+            (c + TINYJAMBU_SEEKABLE_HEADER_SIZE, &reclen, c, 0, m, key) != -1)
+        ok = 0;
+
+    /* A block size of zero must be rejected rather than divided by */
+    memcpy(saved, c, sizeof(saved));
+    memset(c + 8, 0, 4);
+    if (tinyjambu_seekable_open
+            (&reader, test_read, &file, key, 16, cache, sizeof(cache)) != -1)
+        ok = 0;
+
+    /* The block count must not wrap around for lengths close to 2^64 */
+    memset(c + 8, 0xFF, 4 + 8);
+    if (tinyjambu_seekable_open
+            (&reader, test_read, &file, key, 16, cache, sizeof(cache)) != -1)
+        ok = 0;
+    if (tinyjambu_seekable_seal_block
+            (c + TINYJAMBU_SEEKABLE_HEADER_SIZE, &reclen, c, 0, m, key) != -1)
+        ok = 0;
+    memcpy(c, saved, sizeof(saved));
+
+    /* Short reads of the header are errors */
+    file.size = 10;
+    if (tinyjambu_seekable_open
+            (&reader, test_read, &file, key, 16, cache, sizeof(cache)) != -1)
+        ok = 0;
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    test_seekable(TINYJAMBU_SEEKABLE_AEAD, TINYJAMBU_128_KEY_SIZE, MSG_LEN);
+    test_seekable(TINYJAMBU_SEEKABLE_AEAD, TINYJAMBU_192_KEY_SIZE,
+                  MSG_LEN - 123);
+    test_seekable(TINYJAMBU_SEEKABLE_AEAD, TINYJAMBU_256_KEY_SIZE, 10);
+    test_seekable(TINYJAMBU_SEEKABLE_SIV, TINYJAMBU_128_KEY_SIZE, MSG_LEN);
+    test_seekable(TINYJAMBU_SEEKABLE_SIV, TINYJAMBU_256_KEY_SIZE,
+                  BLOCK_SIZE * 7 + 1);
+    test_seekable(TINYJAMBU_SEEKABLE_AEAD, TINYJAMBU_128_KEY_SIZE, 0);
+    test_invalid();
+    return test_exit_result;
+}
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TinyJAMBU.h"
+#include "test-cipher.h"
+#include <stdio.h>
+#include <string.h>
+
+#define NUM_SESSIONS 1000
+#define NUM_MESSAGES 150
+#define MAX_MESSAGE_LEN 40
+#define NONCE_PREFIX 0xC0DE0001U
+
+static unsigned char plaintext[NUM_MESSAGES][MAX_MESSAGE_LEN];
+static unsigned char ciphertext[NUM_MESSAGES][MAX_MESSAGE_LEN];
+static unsigned char decrypted[NUM_MESSAGES][MAX_MESSAGE_LEN];
+static unsigned char tags[NUM_MESSAGES][TINYJAMBU_TAG_SIZE];
+static tinyjambu_128_session_msg_t msgs[NUM_MESSAGES];
+static uint32_t sessions[NUM_MESSAGES];
+
+/* Derives the test key for a session */
+static void make_key(unsigned char *k, uint32_t session)
+{
+    unsigned index;
+    for (index = 0; index < TINYJAMBU_128_KEY_SIZE; ++index)
+        k[index] = (unsigned char)(session * 17 + index * 5 + (session >> 8));
+}
+
+static void test_session_table(unsigned flags)
+{
+    tinyjambu_128_session_table_t *table;
+    unsigned char k[TINYJAMBU_128_KEY_SIZE];
+    unsigned char npub[TINYJAMBU_NONCE_SIZE];
+    unsigned char expected[MAX_MESSAGE_LEN];
+    unsigned char expected_tag[TINYJAMBU_TAG_SIZE];
+    uint32_t session;
+    size_t index, len;
+    int ok = 1;
+
+    printf("TinyJAMBU-128 session table%s ... ",
+           (flags & TINYJAMBU_SESSION_TABLE_CACHE_SETUP) ?
+                " with cached setup" : "");
+    fflush(stdout);
+
+    table = tinyjambu_128_session_table_create
+        (NUM_SESSIONS, NONCE_PREFIX, flags);
+    if (!table) {
+        printf("failed to create\n");
+        test_exit_result = 1;
+        return;
+    }
+    for (session = 0; session < NUM_SESSIONS; ++session) {
+        make_key(k, session);
+        tinyjambu_128_session_table_set(table, session, k, session * 3);
+    }
+
+    /* Seal a batch of messages of different lengths, with some sessions
+     * appearing more than once in the batch */
+    for (index = 0; index < NUM_MESSAGES; ++index) {
+        len = (index * 7) % (MAX_MESSAGE_LEN + 1);
+        sessions[index] = (uint32_t)((index * 37) % 120);
+        memset(plaintext[index], (int)index, len);
+        msgs[index].in = plaintext[index];
+        msgs[index].inlen = len;
+        msgs[index].out = ciphertext[index];
+        msgs[index].tag = tags[index];
+        msgs[index].ad = plaintext[index];
+        msgs[index].adlen = index % 5;
+        msgs[index].counter = 0;
+        msgs[index].result = -1;
+    }
+    tinyjambu_128_session_table_seal(table, sessions, msgs, NUM_MESSAGES);
+
+    /* Check each message against regular TinyJAMBU-128 */
+    for (index = 0; index < NUM_MESSAGES; ++index) {
+        session = sessions[index];
+        if (msgs[index].result != 0)
+            ok = 0;
+        if (msgs[index].counter < session * 3 ||
+                msgs[index].counter > session * 3 + 1) {
+            ok = 0;
+        }
+        make_key(k, session);
+        tinyjambu_128_session_table_nonce(table, npub, msgs[index].counter);
+        tinyjambu_128_aead_encrypt_detached
+            (expected, expected_tag, msgs[index].in, msgs[index].inlen,
+             msgs[index].ad, msgs[index].adlen, npub, k);
+        if (memcmp(expected, ciphertext[index], msgs[index].inlen) != 0 ||
+                memcmp(expected_tag, tags[index], TINYJAMBU_TAG_SIZE) != 0) {
+            ok = 0;
+        }
+    }
+    for (index = 0; index < NUM_MESSAGES; ++index) {
+        size_t other;
+        for (other = 0; other < index; ++other) {
+            if (sessions[other] == sessions[index] &&
+                    msgs[other].counter == msgs[index].counter) {
+                ok = 0; /* Nonce reuse */
+            }
+        }
+    }
+    if (tinyjambu_128_session_table_counter(table, 500) != 1500)
+        ok = 0;
+
+    /* Open the messages, with one of them corrupted */
+    tags[77][3] ^= 0x20;
+    for (index = 0; index < NUM_MESSAGES; ++index) {
+        msgs[index].in = ciphertext[index];
+        msgs[index].out = decrypted[index];
+        msgs[index].result = -2;
+        memset(decrypted[index], 0xAA, MAX_MESSAGE_LEN);
+    }
+    if (tinyjambu_128_session_table_open
+            (table, sessions, msgs, NUM_MESSAGES) != -1) {
+        ok = 0;
+    }
+    for (index = 0; index < NUM_MESSAGES; ++index) {
+        if (index == 77) {
+            for (len = 0; len < msgs[index].inlen; ++len) {
+                if (decrypted[index][len] != 0)
+                    ok = 0;
+            }
+            if (msgs[index].result != -1)
+                ok = 0;
+        } else {
+            if (msgs[index].result != 0 ||
+                    memcmp(decrypted[index], plaintext[index],
+                           msgs[index].inlen) != 0) {
+                ok = 0;
+            }
+        }
+    }
+
+    /* Clearing a session destroys its key */
+    tinyjambu_128_session_table_clear(table, sessions[0]);
+    msgs[0].out = decrypted[0];
+    if (tinyjambu_128_session_table_open(table, sessions, msgs, 1) != -1)
+        ok = 0;
+
+    tinyjambu_128_session_table_destroy(table);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    test_session_table(0);
+    test_session_table(TINYJAMBU_SESSION_TABLE_CACHE_SETUP);
+    if (tinyjambu_128_session_table_session_size(0) != 24 ||
+            tinyjambu_128_session_table_session_size
+                (TINYJAMBU_SESSION_TABLE_CACHE_SETUP) != 40) {
+        printf("TinyJAMBU-128 session table size ... failed\n");
+        test_exit_result = 1;
+    }
+    return test_exit_result;
+}
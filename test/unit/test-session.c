@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TinyJAMBU.h"
+#include "test-cipher.h"
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_MESSAGE_LEN 37
+#define NUM_MESSAGES 12
+
+static unsigned char const key[TINYJAMBU_256_KEY_SIZE] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+    0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F
+};
+
+static unsigned char const nonce[TINYJAMBU_NONCE_SIZE] = {
+    0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7,
+    0xA8, 0xA9, 0xAA, 0xAB
+};
+
+typedef void (*session_init_t)
+    (tinyjambu_session_t *session, const unsigned char *k,
+     const unsigned char *npub, int role);
+
+/* Fills a message buffer with a pattern that depends upon its number */
+static void make_message(unsigned char *m, size_t len, unsigned number)
+{
+    size_t posn;
+    for (posn = 0; posn < len; ++posn)
+        m[posn] = (unsigned char)(number * 41 + posn * 7);
+}
+
+static void test_exchange(const char *name, session_init_t init)
+{
+    tinyjambu_session_t initiator;
+    tinyjambu_session_t responder;
+    unsigned char m[MAX_MESSAGE_LEN];
+    unsigned char m2[MAX_MESSAGE_LEN];
+    unsigned char c[MAX_MESSAGE_LEN + TINYJAMBU_TAG_SIZE];
+    unsigned char c2[MAX_MESSAGE_LEN + TINYJAMBU_TAG_SIZE];
+    unsigned char ad[4];
+    size_t clen, clen2, mlen;
+    unsigned number;
+    int ok = 1;
+
+    printf("%s session exchange ... ", name);
+    fflush(stdout);
+
+    (*init)(&initiator, key, nonce, TINYJAMBU_SESSION_INITIATOR);
+    (*init)(&responder, key, nonce, TINYJAMBU_SESSION_RESPONDER);
+
+    /* Chat back and forth with messages of different lengths, sending
+     * two messages in a row in the same direction now and then */
+    for (number = 0; number < NUM_MESSAGES * 2; ++number) {
+        tinyjambu_session_t *sender;
+        tinyjambu_session_t *receiver;
+        size_t len = (number * 5) % (MAX_MESSAGE_LEN + 1);
+        if ((number % 3) != 2) {
+            sender = &initiator;
+            receiver = &responder;
+        } else {
+            sender = &responder;
+            receiver = &initiator;
+        }
+        make_message(m, len, number);
+        make_message(ad, sizeof(ad), number + 100);
+        tinyjambu_session_encrypt
+            (sender, c, &clen, m, len, ad, number % sizeof(ad));
+        if (clen != len + TINYJAMBU_TAG_SIZE)
+            ok = 0;
+
+        /* Encrypting the same message again must give a different result
+         * because the state has moved on since the previous message */
+        if (number == 0) {
+            tinyjambu_session_t copy = *sender;
+            tinyjambu_session_encrypt(&copy, c2, &clen2, m, len, ad, 0);
+            if (memcmp(c, c2, clen) == 0)
+                ok = 0;
+        }
+
+        /* Use in-place decryption for every second message */
+        if (number & 1) {
+            memcpy(m2, c, clen);
+            if (tinyjambu_session_decrypt
+                    (receiver, m2, &mlen, m2, clen,
+                     ad, number % sizeof(ad)) != 0) {
+                ok = 0;
+            }
+        } else {
+            if (tinyjambu_session_decrypt
+                    (receiver, m2, &mlen, c, clen,
+                     ad, number % sizeof(ad)) != 0) {
+                ok = 0;
+            }
+        }
+        if (mlen != len || memcmp(m2, m, len) != 0)
+            ok = 0;
+    }
+
+    /* Both parties encrypting at the same time must not share keystream */
+    make_message(m, sizeof(m), 0);
+    tinyjambu_session_encrypt(&initiator, c, &clen, m, sizeof(m), 0, 0);
+    tinyjambu_session_encrypt(&responder, c2, &clen2, m, sizeof(m), 0, 0);
+    if (memcmp(c, c2, sizeof(m)) == 0)
+        ok = 0;
+    if (tinyjambu_session_decrypt(&responder, m2, &mlen, c, clen, 0, 0) != 0)
+        ok = 0;
+    if (tinyjambu_session_decrypt(&initiator, m2, &mlen, c2, clen2, 0, 0) != 0)
+        ok = 0;
+
+    tinyjambu_session_free(&initiator);
+    tinyjambu_session_free(&responder);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+static void test_forgery(const char *name, session_init_t init)
+{
+    tinyjambu_session_t initiator;
+    tinyjambu_session_t responder;
+    tinyjambu_session_t wrong_role;
+    unsigned char m[3][MAX_MESSAGE_LEN];
+    unsigned char c[3][MAX_MESSAGE_LEN + TINYJAMBU_TAG_SIZE];
+    unsigned char m2[MAX_MESSAGE_LEN];
+    unsigned char forged[MAX_MESSAGE_LEN + TINYJAMBU_TAG_SIZE];
+    size_t clen[3], mlen;
+    unsigned number;
+    int ok = 1;
+
+    printf("%s session forgery ... ", name);
+    fflush(stdout);
+
+    (*init)(&initiator, key, nonce, TINYJAMBU_SESSION_INITIATOR);
+    (*init)(&responder, key, nonce, TINYJAMBU_SESSION_RESPONDER);
+    (*init)(&wrong_role, key, nonce, TINYJAMBU_SESSION_INITIATOR);
+    for (number = 0; number < 3; ++number) {
+        make_message(m[number], sizeof(m[number]), number);
+        tinyjambu_session_encrypt
+            (&initiator, c[number], &clen[number],
+             m[number], sizeof(m[number]), 0, 0);
+    }
+
+    /* The sender's own role cannot decrypt its messages */
+    if (tinyjambu_session_decrypt
+            (&wrong_role, m2, &mlen, c[0], clen[0], 0, 0) != -1) {
+        ok = 0;
+    }
+
+    /* Messages out of order must be rejected */
+    if (tinyjambu_session_decrypt
+            (&responder, m2, &mlen, c[1], clen[1], 0, 0) != -1) {
+        ok = 0;
+    }
+    for (mlen = 0; mlen < sizeof(m2); ++mlen) {
+        if (m2[mlen] != 0)
+            ok = 0;
+    }
+
+    /* A forged message must be rejected without disturbing the session */
+    memcpy(forged, c[0], clen[0]);
+    forged[5] ^= 0x40;
+    if (tinyjambu_session_decrypt
+            (&responder, m2, &mlen, forged, clen[0], 0, 0) != -1) {
+        ok = 0;
+    }
+    if (tinyjambu_session_decrypt
+            (&responder, m2, &mlen, c[0], clen[0], (unsigned char *)"x", 1)
+                != -1) {
+        ok = 0;
+    }
+    if (tinyjambu_session_decrypt(&responder, m2, &mlen, c[0], 4, 0, 0) != -1)
+        ok = 0;
+
+    /* The real message is still accepted, but cannot be replayed */
+    if (tinyjambu_session_decrypt
+            (&responder, m2, &mlen, c[0], clen[0], 0, 0) != 0) {
+        ok = 0;
+    }
+    if (mlen != sizeof(m[0]) || memcmp(m2, m[0], mlen) != 0)
+        ok = 0;
+    if (tinyjambu_session_decrypt
+            (&responder, m2, &mlen, c[0], clen[0], 0, 0) != -1) {
+        ok = 0;
+    }
+
+    /* Carry on with the rest of the conversation */
+    for (number = 1; number < 3; ++number) {
+        if (tinyjambu_session_decrypt
+                (&responder, m2, &mlen, c[number], clen[number], 0, 0) != 0) {
+            ok = 0;
+        }
+        if (mlen != sizeof(m[number]) || memcmp(m2, m[number], mlen) != 0)
+            ok = 0;
+    }
+
+    tinyjambu_session_free(&initiator);
+    tinyjambu_session_free(&responder);
+    tinyjambu_session_free(&wrong_role);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    test_exchange("TinyJAMBU-128", tinyjambu_128_session_init);
+    test_exchange("TinyJAMBU-192", tinyjambu_192_session_init);
+    test_exchange("TinyJAMBU-256", tinyjambu_256_session_init);
+    test_forgery("TinyJAMBU-128", tinyjambu_128_session_init);
+    test_forgery("TinyJAMBU-192", tinyjambu_192_session_init);
+    test_forgery("TinyJAMBU-256", tinyjambu_256_session_init);
+    return test_exit_result;
+}
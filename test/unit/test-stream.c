@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2022 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TinyJAMBU.h"
+#include "test-cipher.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define MSG_LEN 200000
+#define CHUNK_SIZE 4096
+
+static unsigned char const prefix[TINYJAMBU_STREAM_PREFIX_SIZE] = {
+    0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76
+};
+
+static void test_stream(size_t keylen, size_t mlen)
+{
+    unsigned char key[32];
+    unsigned char *m = (unsigned char *)malloc(MSG_LEN);
+    unsigned char *c1 = (unsigned char *)malloc(MSG_LEN * 2);
+    unsigned char *c2 = (unsigned char *)malloc(MSG_LEN * 2);
+    unsigned char *out = (unsigned char *)malloc(MSG_LEN * 2);
+    tinyjambu_stream_decryptor_t dec;
+    size_t clen, clen2, len, posn, chunk, total;
+    int ok = 1;
+
+    printf("TinyJAMBU-STREAM, %d-bit key, %d bytes ... ",
+           (int)(keylen * 8), (int)mlen);
+    fflush(stdout);
+
+    if (!m || !c1 || !c2 || !out)
+        exit(2);
+    for (posn = 0; posn < sizeof(key); ++posn)
+        key[posn] = (unsigned char)(posn * 9 + keylen);
+    for (posn = 0; posn < mlen; ++posn)
+        m[posn] = (unsigned char)(posn * 13 + (posn >> 8));
+
+    /* Single-threaded and multi-threaded encryption must agree */
+    if (tinyjambu_stream_encrypt
+            (c1, &clen, m, mlen, prefix, key, keylen, CHUNK_SIZE, 1) != 0)
+        ok = 0;
+    if (clen != tinyjambu_stream_encrypted_size(mlen, CHUNK_SIZE))
+        ok = 0;
+    if (tinyjambu_stream_encrypt
+            (c2, &clen2, m, mlen, prefix, key, keylen, CHUNK_SIZE, 4) != 0)
+        ok = 0;
+    if (clen2 != clen || memcmp(c1, c2, clen) != 0)
+        ok = 0;
+
+    /* In-place encryption */
+    memcpy(c2, m, mlen);
+    if (tinyjambu_stream_encrypt
+            (c2, &clen2, c2, mlen, prefix, key, keylen, CHUNK_SIZE, 4) != 0)
+        ok = 0;
+    if (clen2 != clen || memcmp(c1, c2, clen) != 0)
+        ok = 0;
+
+    /* Multi-threaded and in-place decryption */
+    if (tinyjambu_stream_decrypt(out, &len, c1, clen, key, keylen, 4) != 0)
+        ok = 0;
+    if (len != mlen || memcmp(out, m, mlen) != 0)
+        ok = 0;
+    memcpy(c2, c1, clen);
+    if (tinyjambu_stream_decrypt(c2, &len, c2, clen, key, keylen, 4) != 0)
+        ok = 0;
+    if (len != mlen || memcmp(c2, m, mlen) != 0)
+        ok = 0;
+
+    /* Corrupting a single chunk causes everything to fail */
+    memcpy(c2, c1, clen);
+    c2[clen / 2] ^= 0x40;
+    if (tinyjambu_stream_decrypt(out, &len, c2, clen, key, keylen, 4) != -1)
+        ok = 0;
+    for (posn = 0; posn < mlen; ++posn) {
+        if (out[posn] != 0)
+            ok = 0;
+    }
+
+    /* The chunk size in the header is authenticated */
+    memcpy(c2, c1, clen);
+    c2[7] ^= 0x01;
+    if (tinyjambu_stream_decrypt(out, &len, c2, clen, key, keylen, 1) != -1)
+        ok = 0;
+
+    /* Incremental decryption, one chunk at a time */
+    if (tinyjambu_stream_decrypt_init
+            (&dec, c1, key, keylen) != 0)
+        ok = 0;
+    chunk = tinyjambu_stream_decrypt_chunk_size(&dec);
+    if (chunk != CHUNK_SIZE + TINYJAMBU_TAG_SIZE)
+        ok = 0;
+    posn = TINYJAMBU_STREAM_HEADER_SIZE;
+    total = 0;
+    while (ok && posn < clen) {
+        size_t size = clen - posn;
+        int last = (size <= chunk);
+        if (!last)
+            size = chunk;
+        if (tinyjambu_stream_decrypt_chunk
+                (&dec, out + total, &len, c1 + posn, size, last) != 0)
+            ok = 0;
+        posn += size;
+        total += len;
+    }
+    if (total != mlen || memcmp(out, m, mlen) != 0)
+        ok = 0;
+    if (tinyjambu_stream_decrypt_finish(&dec) != 0)
+        ok = 0;
+    if (tinyjambu_stream_decrypt_chunk
+            (&dec, out, &len, c1 + TINYJAMBU_STREAM_HEADER_SIZE,
+             chunk, 1) != -1)
+        ok = 0;
+    tinyjambu_stream_decrypt_free(&dec);
+
+    /* Truncating at a chunk boundary is detected */
+    if (clen > TINYJAMBU_STREAM_HEADER_SIZE + chunk) {
+        tinyjambu_stream_decrypt_init(&dec, c1, key, keylen);
+        if (tinyjambu_stream_decrypt_chunk
+                (&dec, out, &len, c1 + TINYJAMBU_STREAM_HEADER_SIZE,
+                 chunk, 0) != 0)
+            ok = 0;
+        if (tinyjambu_stream_decrypt_finish(&dec) != -1)
+            ok = 0;
+        if (tinyjambu_stream_decrypt(out, &len, c1,
+                TINYJAMBU_STREAM_HEADER_SIZE + chunk, key, keylen, 1) != -1)
+            ok = 0;
+
+        /* Chunks cannot be reordered */
+        if (tinyjambu_stream_decrypt_chunk
+                (&dec, out, &len, c1 + TINYJAMBU_STREAM_HEADER_SIZE,
+                 chunk, 0) != -1)
+            ok = 0;
+        tinyjambu_stream_decrypt_free(&dec);
+    }
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+    free(m);
+    free(c1);
+    free(c2);
+    free(out);
+}
+
+static void test_invalid(void)
+{
+    unsigned char key[32] = {0};
+    unsigned char c[64];
+    unsigned char m[64];
+    size_t clen, mlen;
+    int ok = 1;
+
+    printf("TinyJAMBU-STREAM invalid parameters ... ");
+    fflush(stdout);
+
+    if (tinyjambu_stream_encrypt(c, &clen, m, 0, prefix, key, 20, 16, 1) != -1)
+        ok = 0;
+    if (tinyjambu_stream_encrypt(c, &clen, m, 0, prefix, key, 16, 0, 1) != -1)
+        ok = 0;
+
+    /* The header must match the key size */
+    if (tinyjambu_stream_encrypt(c, &clen, m, 5, prefix, key, 16, 16, 1) != 0)
+        ok = 0;
+    if (tinyjambu_stream_decrypt(m, &mlen, c, clen, key, 32, 1) != -1)
+        ok = 0;
+    if (tinyjambu_stream_decrypt(m, &mlen, c, 10, key, 16, 1) != -1)
+        ok = 0;
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("failed\n");
+        test_exit_result = 1;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    test_stream(TINYJAMBU_128_KEY_SIZE, MSG_LEN);
+    test_stream(TINYJAMBU_192_KEY_SIZE, MSG_LEN - 3);
+    test_stream(TINYJAMBU_256_KEY_SIZE, CHUNK_SIZE * 20);
+    test_stream(TINYJAMBU_128_KEY_SIZE, 0);
+    test_invalid();
+    return test_exit_result;
+}